@@ -0,0 +1,255 @@
+#include "../src/DkCore/DkBasicLoader.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <benchmark/benchmark.h>
+
+#ifdef WITH_LIBTIFF
+#include <tiffio.h>
+#endif
+
+#include "drif_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+
+enum class BenchFormat {
+    jpg,
+    png,
+    tif_strip,
+    tif_tile,
+    psd,
+    tga,
+    drif,
+};
+
+// gradients with some noise, so that compressed formats do real work
+static QImage syntheticImage(int width, int height)
+{
+    QImage img(width, height, QImage::Format_RGB32);
+    QRandomGenerator rng(width);
+
+    for (int y = 0; y < img.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < img.width(); x++) {
+            int noise = rng.bounded(16);
+            line[x] = qRgb(x * 239 / width + noise, y * 239 / height + noise, (x + y) / 4 % 240 + noise);
+        }
+    }
+
+    return img;
+}
+
+static bool writeTiff(const QString &filePath, const QImage &src, bool tiled)
+{
+#ifdef WITH_LIBTIFF
+    const QImage img = src.convertToFormat(QImage::Format_RGB888);
+    const int tileSize = 256;
+
+    TIFF *tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "w");
+    if (!tiff)
+        return false;
+
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, img.width());
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, img.height());
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+
+    bool success = true;
+
+    if (tiled) {
+        TIFFSetField(tiff, TIFFTAG_TILEWIDTH, tileSize);
+        TIFFSetField(tiff, TIFFTAG_TILELENGTH, tileSize);
+
+        // edge tiles are padded
+        QByteArray tile(tileSize * tileSize * 3, '\0');
+        for (int ty = 0; ty < img.height() && success; ty += tileSize) {
+            for (int tx = 0; tx < img.width() && success; tx += tileSize) {
+                tile.fill('\0');
+                const int tw = std::min(tileSize, img.width() - tx);
+                for (int y = 0; y < tileSize && ty + y < img.height(); y++)
+                    std::memcpy(tile.data() + y * tileSize * 3, img.constScanLine(ty + y) + tx * 3, tw * 3);
+
+                success = TIFFWriteTile(tiff, tile.data(), tx, ty, 0, 0) >= 0;
+            }
+        }
+    } else {
+        TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 16);
+        for (int y = 0; y < img.height() && success; y++)
+            success = TIFFWriteScanline(tiff, const_cast<uchar *>(img.constScanLine(y)), y, 0) >= 0;
+    }
+
+    TIFFClose(tiff);
+    return success;
+#else
+    Q_UNUSED(filePath);
+    Q_UNUSED(src);
+    Q_UNUSED(tiled);
+    return false;
+#endif
+}
+
+// uncompressed RGB composite image without layers
+static bool writePsd(const QString &filePath, const QImage &img)
+{
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    QDataStream ds(&file); // big endian
+    ds.writeRawData("8BPS", 4);
+    ds << quint16(1); // version
+    ds.writeRawData("\0\0\0\0\0\0", 6);
+    ds << quint16(3) << quint32(img.height()) << quint32(img.width());
+    ds << quint16(8) << quint16(3); // depth, RGB
+    ds << quint32(0) << quint32(0) << quint32(0); // color mode data, image resources, layers
+    ds << quint16(0); // raw
+
+    QByteArray plane(img.width(), '\0');
+    for (int c = 0; c < 3; c++) {
+        for (int y = 0; y < img.height(); y++) {
+            const auto *line = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+            for (int x = 0; x < img.width(); x++) {
+                int v = c == 0 ? qRed(line[x]) : c == 1 ? qGreen(line[x]) : qBlue(line[x]);
+                plane[x] = char(v);
+            }
+            ds.writeRawData(plane.constData(), plane.size());
+        }
+    }
+
+    return ds.status() == QDataStream::Ok;
+}
+
+// uncompressed 24 bit, top-left origin
+static bool writeTga(const QString &filePath, const QImage &src)
+{
+    const QImage img = src.convertToFormat(QImage::Format_BGR888);
+
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    QDataStream ds(&file);
+    ds.setByteOrder(QDataStream::LittleEndian);
+    ds << quint8(0) << quint8(0) << quint8(2); // no id, no color map, true color
+    ds << quint16(0) << quint16(0) << quint8(0); // color map spec
+    ds << quint16(0) << quint16(0) << quint16(img.width()) << quint16(img.height());
+    ds << quint8(24) << quint8(0x20);
+
+    for (int y = 0; y < img.height(); y++)
+        ds.writeRawData(reinterpret_cast<const char *>(img.constScanLine(y)), img.width() * 3);
+
+    return ds.status() == QDataStream::Ok;
+}
+
+// pixels followed by a footer, see drif_image.h
+static bool writeDrif(const QString &filePath, const QImage &src)
+{
+    const QImage img = src.convertToFormat(QImage::Format_RGBA8888);
+
+    QFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    for (int y = 0; y < img.height(); y++)
+        file.write(reinterpret_cast<const char *>(img.constScanLine(y)), img.width() * 4);
+
+    const uint32_t footer[] = {DRIF_MAGIC,
+                               DRIF_VER,
+                               uint32_t(img.width()),
+                               uint32_t(img.height()),
+                               uint32_t(DRIF_FMT_RGBA8888)};
+    QByteArray buffer(DRIF_FOOTER_SZ, '\0');
+    std::memcpy(buffer.data(), footer, sizeof(footer));
+
+    return file.write(buffer) == buffer.size();
+}
+
+static QString createImage(BenchFormat format, int width)
+{
+    static QTemporaryDir dir;
+    static std::map<std::pair<BenchFormat, int>, QString> files;
+
+    auto &filePath = files[{format, width}];
+    if (!filePath.isEmpty())
+        return filePath;
+
+    const QImage img = syntheticImage(width, width * 3 / 4);
+    const QString baseName = dir.filePath(QString("img%1_%2").arg(width).arg(static_cast<int>(format)));
+
+    bool written = false;
+    switch (format) {
+    case BenchFormat::jpg:
+        filePath = baseName + ".jpg";
+        written = img.save(filePath, "JPG", 90);
+        break;
+    case BenchFormat::png:
+        filePath = baseName + ".png";
+        written = img.save(filePath, "PNG");
+        break;
+    case BenchFormat::tif_strip:
+    case BenchFormat::tif_tile:
+        filePath = baseName + ".tif";
+        written = writeTiff(filePath, img, format == BenchFormat::tif_tile);
+        break;
+    case BenchFormat::psd:
+        filePath = baseName + ".psd";
+        written = writePsd(filePath, img);
+        break;
+    case BenchFormat::tga:
+        filePath = baseName + ".tga";
+        written = writeTga(filePath, img);
+        break;
+    case BenchFormat::drif:
+        filePath = baseName + ".drif";
+        written = writeDrif(filePath, img);
+        break;
+    }
+
+    if (!written)
+        filePath.clear();
+
+    return filePath;
+}
+
+static void BM_LoadGeneral(benchmark::State &state, BenchFormat format)
+{
+    const QString filePath = createImage(format, static_cast<int>(state.range(0)));
+    if (filePath.isEmpty()) {
+        state.SkipWithError("could not write the synthetic image");
+        return;
+    }
+
+    QSize size;
+    for (auto _ : state) {
+        nmc::DkBasicLoader loader;
+        if (!loader.loadGeneral(filePath)) {
+            state.SkipWithError("could not load the synthetic image");
+            break;
+        }
+        size = loader.image().size();
+        benchmark::DoNotOptimize(loader.image());
+    }
+
+    state.SetItemsProcessed(state.iterations() * size.width() * size.height());
+    state.SetBytesProcessed(state.iterations() * QFileInfo(filePath).size());
+}
+BENCHMARK_CAPTURE(BM_LoadGeneral, jpg, BenchFormat::jpg)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadGeneral, png, BenchFormat::png)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadGeneral, tif_strip, BenchFormat::tif_strip)
+    ->Arg(1024)
+    ->Arg(4096)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadGeneral, tif_tile, BenchFormat::tif_tile)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadGeneral, psd, BenchFormat::psd)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadGeneral, tga, BenchFormat::tga)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadGeneral, drif, BenchFormat::drif)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,68 @@
+#include "../src/DkCore/DkFileInfo.h"
+#include "../src/DkCore/DkSettings.h"
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <memory>
+
+// synthetic directory: mostly images, some other files, files without suffix and links
+static QString createDirectory(int numFiles)
+{
+    static std::map<int, std::unique_ptr<QTemporaryDir>> dirs;
+
+    auto &dir = dirs[numFiles];
+    if (dir)
+        return dir->path();
+
+    dir = std::make_unique<QTemporaryDir>();
+    for (int idx = 0; idx < numFiles; idx++) {
+        QString name = QString("img%1").arg(idx, 7, 10, QChar('0'));
+        if (idx % 100 == 1)
+            name += ".txt";
+        else if (idx % 1000 != 2)
+            name += ".jpg";
+
+        QFile file(dir->filePath(name));
+        if (!file.open(QFile::WriteOnly))
+            break;
+
+        if (idx % 1000 == 3)
+            QFile::link(name, dir->filePath("link" + name));
+    }
+
+    return dir->path();
+}
+
+static void setupFilters()
+{
+    nmc::DkSettingsManager::param().app().browseFilters = {"*.jpg", "*.png", "*.tif"};
+}
+
+static void BM_ReadDirectory(benchmark::State &state)
+{
+    setupFilters();
+    const QString dirPath = createDirectory(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nmc::DkFileInfo::readDirectory(dirPath));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ReadDirectory)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// reference: list with a stat per entry
+static void BM_EntryInfoList(benchmark::State &state)
+{
+    const QString dirPath = createDirectory(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(QDir(dirPath).entryInfoList(QDir::Files, QDir::NoSort));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EntryInfoList)->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,102 @@
+#include "../src/DkCore/DkFileInfo.h"
+#include "../src/DkCore/DkImageLoader.h"
+#include "../src/DkCore/DkSettings.h"
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+#include <benchmark/benchmark.h>
+
+// a large folder: file sizes and modification dates differ so that every sort mode does real work
+static QString createFolder()
+{
+    static QTemporaryDir dir;
+    static bool created = false;
+
+    if (created)
+        return dir.path();
+
+    const int numFiles = 50000;
+    const QDateTime start = QDateTime::currentDateTime().addDays(-1000);
+
+    for (int idx = 0; idx < numFiles; idx++) {
+        // the suffix varies, the index does not determine the order
+        int key = (idx * 7919) % numFiles;
+        QFile file(dir.filePath(QString("IMG_%1.%2").arg(key).arg(idx % 3 ? "jpg" : "png")));
+        if (!file.open(QFile::WriteOnly))
+            break;
+
+        file.write(QByteArray(idx % 251, 'x'));
+        file.setFileTime(start.addSecs((idx * 104729) % (numFiles * 60)), QFileDevice::FileModificationTime);
+    }
+
+    created = true;
+    return dir.path();
+}
+
+static void setupFilters()
+{
+    nmc::DkSettingsManager::param().app().browseFilters = {"*.jpg", "*.png", "*.tif"};
+}
+
+static void BM_ReadFolder(benchmark::State &state)
+{
+    setupFilters();
+    const QString dirPath = createFolder();
+
+    size_t numFiles = 0;
+    for (auto _ : state) {
+        numFiles = nmc::DkFileInfo::readDirectory(dirPath).size();
+    }
+
+    state.SetItemsProcessed(state.iterations() * numFiles);
+}
+BENCHMARK(BM_ReadFolder)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// what opening an image in a new folder costs: listing, containers and sorting
+static void BM_ImageLoaderLoadDir(benchmark::State &state)
+{
+    setupFilters();
+    nmc::DkSettingsManager::param().global().sortMode = nmc::DkSettings::sort_filename;
+    const QString dirPath = createFolder();
+
+    int numImages = 0;
+    for (auto _ : state) {
+        nmc::DkImageLoader loader;
+        loader.loadDir(dirPath);
+        numImages = static_cast<int>(loader.getImages().size());
+    }
+
+    state.SetItemsProcessed(state.iterations() * numImages);
+}
+BENCHMARK(BM_ImageLoaderLoadDir)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ImageLoaderSort(benchmark::State &state)
+{
+    setupFilters();
+    auto &global = nmc::DkSettingsManager::param().global();
+    const int sortMode = static_cast<int>(state.range(0));
+
+    nmc::DkImageLoader loader;
+    loader.loadDir(createFolder());
+    const int numImages = static_cast<int>(loader.getImages().size());
+
+    for (auto _ : state) {
+        // the random order is reproducible, so every iteration sorts the same input
+        state.PauseTiming();
+        global.sortMode = nmc::DkSettings::sort_random;
+        loader.sort();
+        global.sortMode = sortMode;
+        state.ResumeTiming();
+
+        loader.sort();
+    }
+
+    state.SetItemsProcessed(state.iterations() * numImages);
+}
+BENCHMARK(BM_ImageLoaderSort)
+    ->Arg(nmc::DkSettings::sort_filename)
+    ->Arg(nmc::DkSettings::sort_file_size)
+    ->Arg(nmc::DkSettings::sort_date_created)
+    ->Arg(nmc::DkSettings::sort_date_modified)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -1,4 +1,13 @@
+#include "../src/DkCore/DkColorSimd.h"
 #include "../src/DkCore/DkImageStorage.h"
+#include "../src/DkCore/DkMath.h"
+
+#include <QColorSpace>
+#include <QTransform>
+
+#include <cmath>
+#include <vector>
+
 #include <benchmark/benchmark.h>
 
 static void BM_RotateImage(benchmark::State &state)
@@ -70,4 +79,175 @@ BENCHMARK(BM_RotateImage)
     ->Args({4, 225})
     ->Args({4, 315});
 
+static void BM_StraightenCrop(benchmark::State &state)
+{
+    const QImage::Format formats[] = {QImage::Format_RGB888, QImage::Format_RGBA64};
+
+    // 4:3 image with range(0) megapixels
+    const int height = qRound(std::sqrt(state.range(0) * 1e6 * 3 / 4));
+    QImage img{height * 4 / 3, height, formats[state.range(1)]};
+    img.fill(Qt::gray);
+
+    // straighten by 2 degrees and crop to 90%, the usual crop tool result
+    QRectF rect{img.width() * 0.05, img.height() * 0.05, img.width() * 0.9, img.height() * 0.9};
+    QTransform t;
+    t.translate(rect.center().x(), rect.center().y());
+    t.rotate(2);
+    t.translate(-rect.center().x(), -rect.center().y());
+    QPolygonF poly = t.map(QPolygonF({rect.topLeft(), rect.bottomLeft(), rect.bottomRight(), rect.topRight()}));
+    nmc::DkRotatingRect cropRect;
+    cropRect.setPoly(poly);
+
+    state.SetLabel(QString().asprintf("%dx%d format %d", img.width(), img.height(), img.format()).toStdString());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nmc::DkImage::cropToImage(img, cropRect));
+    }
+}
+BENCHMARK(BM_StraightenCrop)
+    ->ArgsProduct({{12, 100}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_GrayScaleImage(benchmark::State &state)
+{
+    const QImage::Format formats[] = {QImage::Format_RGB32,
+                                      QImage::Format_ARGB32,
+                                      QImage::Format_RGBX64,
+                                      QImage::Format_RGBA32FPx4};
+    // ProPhoto has no lookup table and takes the QColorTransform path
+    const QColorSpace spaces[] = {QColorSpace::SRgb,
+                                  QColorSpace::DisplayP3,
+                                  QColorSpace::AdobeRgb,
+                                  QColorSpace::ProPhotoRgb};
+
+    QImage img{2048, 2048, QImage::Format_ARGB32};
+    for (int y = 0; y < img.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < img.width(); x++)
+            line[x] = qRgba(x % 256, y % 256, (x + y) % 256, (x % 2) ? 255 : 128);
+    }
+    img = img.convertToFormat(formats[state.range(0)]);
+    img.setColorSpace(spaces[state.range(1)]);
+
+    state.SetLabel(QString("%1 %2").arg(QString::number(img.format()), img.colorSpace().description()).toStdString());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nmc::DkImage::grayscaleImage(img));
+    }
+    state.SetItemsProcessed(state.iterations() * img.width() * img.height());
+}
+BENCHMARK(BM_GrayScaleImage)
+    ->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2, 3}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// one chunk of the grayscale kernel: decode 8 bit argb, Y, encode to gamma 2.2
+static void BM_GrayScaleRow(benchmark::State &state)
+{
+    auto isa = static_cast<nmc::DkColorSimd::Isa>(state.range(0));
+    if (!nmc::DkColorSimd::isSupported(isa)) {
+        state.SkipWithMessage("instruction set not supported");
+        return;
+    }
+
+    const int n = 512;
+    const int encodeSize = 65535;
+    std::vector<uint8_t> pixels(4 * n);
+    for (int idx = 0; idx < 4 * n; idx++)
+        pixels[idx] = static_cast<uint8_t>(idx * 31);
+
+    std::vector<float> decodeLut(256), encodeLut(encodeSize + 2);
+    for (int idx = 0; idx < 256; idx++)
+        decodeLut[idx] = std::pow(idx / 255.0f, 2.2f);
+    for (int idx = 0; idx <= encodeSize; idx++)
+        encodeLut[idx] = std::pow(idx / float(encodeSize), 1.0f / 2.2f) * encodeSize;
+    encodeLut[encodeSize + 1] = encodeLut[encodeSize];
+
+    std::vector<float> r(n), g(n), b(n), y(n);
+    std::vector<uint16_t> q(n);
+    const float weights[3] = {0.2126729f, 0.7151522f, 0.0721750f};
+    auto decode = nmc::DkColorSimd::decode(isa);
+    auto luma = nmc::DkColorSimd::luma(isa);
+    auto encode = nmc::DkColorSimd::encode(isa);
+
+    for (auto _ : state) {
+        decode(pixels.data(), b.data(), g.data(), r.data(), n, decodeLut.data());
+        luma(r.data(), g.data(), b.data(), y.data(), n, weights);
+        encode(y.data(), q.data(), n, encodeLut.data(), encodeSize);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_GrayScaleRow)->DenseRange(nmc::DkColorSimd::isa_scalar, nmc::DkColorSimd::isa_avx2);
+
+// downscaling dominates: thumbnails and the zoomed out viewport
+static void BM_ResizeImage(benchmark::State &state)
+{
+    const int size = static_cast<int>(state.range(0));
+    const int interpolation = static_cast<int>(state.range(1));
+    const bool correctGamma = state.range(2) != 0;
+
+    QImage img{size, size * 3 / 4, QImage::Format_ARGB32};
+    for (int y = 0; y < img.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < img.width(); x++)
+            line[x] = qRgba(x % 256, y % 256, (x * y) % 256, 255);
+    }
+    img.setColorSpace(QColorSpace::SRgb);
+
+    const QSize newSize = img.size() / 4;
+    state.SetLabel(QString("%1x%2 -> %3x%4")
+                       .arg(img.width())
+                       .arg(img.height())
+                       .arg(newSize.width())
+                       .arg(newSize.height())
+                       .toStdString());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nmc::DkImage::resizeImage(img, newSize, 1.0, interpolation, correctGamma));
+    }
+    state.SetItemsProcessed(state.iterations() * img.width() * img.height());
+}
+BENCHMARK(BM_ResizeImage)
+    ->ArgsProduct({{512, 2048, 8192},
+                   {nmc::DkImage::ipl_nearest,
+                    nmc::DkImage::ipl_area,
+                    nmc::DkImage::ipl_linear,
+                    nmc::DkImage::ipl_cubic,
+                    nmc::DkImage::ipl_lanczos},
+                   {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_Unpremultiply(benchmark::State &state)
+{
+    const QImage::Format formats[] = {QImage::Format_ARGB32_Premultiplied,
+                                      QImage::Format_RGBA64_Premultiplied,
+                                      QImage::Format_RGBA16FPx4_Premultiplied};
+
+    const int size = static_cast<int>(state.range(0));
+    QImage img{size, size, QImage::Format_ARGB32};
+    for (int y = 0; y < img.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < img.width(); x++)
+            line[x] = qRgba(x % 256, y % 256, (x + y) % 256, (x * y) % 256);
+    }
+    img = img.convertToFormat(formats[state.range(1)]);
+
+    state.SetLabel(QString().asprintf("%dx%d format %d", img.width(), img.height(), img.format()).toStdString());
+
+    for (auto _ : state) {
+        // the kernel works in place
+        state.PauseTiming();
+        QImage work = img.copy();
+        state.ResumeTiming();
+
+        nmc::DkImage::unpremultiply(work);
+        benchmark::DoNotOptimize(work.constBits());
+    }
+    state.SetItemsProcessed(state.iterations() * img.width() * img.height());
+}
+BENCHMARK(BM_Unpremultiply)->ArgsProduct({{256, 1024, 4096}, {0, 1, 2}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
 BENCHMARK_MAIN();
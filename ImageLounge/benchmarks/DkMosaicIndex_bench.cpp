@@ -0,0 +1,40 @@
+#include "../src/DkCore/DkMosaicIndex.h"
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// random descriptors, smooth enough to look like downsampled photos
+static QVector<nmc::DkMosaicIndex::Entry> randomEntries(int count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> base(0, 255);
+    std::uniform_int_distribution<int> noise(-20, 20);
+
+    QVector<nmc::DkMosaicIndex::Entry> entries(count);
+    for (auto &e : entries) {
+        int l = base(rng);
+        for (auto &s : e.signature)
+            s = uint8_t(qBound(0, l + noise(rng), 255));
+        e.lab = {float(l), float(128 + noise(rng)), float(128 + noise(rng))};
+    }
+
+    return entries;
+}
+
+static void BM_MosaicAssign(benchmark::State &state)
+{
+    nmc::DkMosaicIndex index(randomEntries(state.range(0), 1));
+    QVector<nmc::DkMosaicIndex::Entry> cells = randomEntries(state.range(1), 2);
+
+    state.SetLabel(QString("%1 images, %2 cells").arg(state.range(0)).arg(state.range(1)).toStdString());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.assign(cells));
+    }
+}
+BENCHMARK(BM_MosaicAssign)
+    ->Args({5000, 2000})
+    ->Args({50000, 7500})
+    ->Args({50000, 30000})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,27 @@
+#include "../plugins/FakeMiniaturesPlugin/src/DkPanTiltBlur.h"
+#include <benchmark/benchmark.h>
+
+#include <QtMath>
+
+// fake miniatures with the dialog's default focus band and blur amount
+static void BM_BlurPanTilt(benchmark::State &state)
+{
+    const int megaPixels = state.range(0);
+    const int width = qRound(qSqrt(megaPixels * 1e6 * 4 / 3));
+    const int height = width * 3 / 4;
+
+    cv::Mat img(height, width, CV_8UC4);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    const cv::Rect focus(0, qRound(0.7117 * height), width, qRound(0.1941 * height));
+    const int kernelSize = qMin(qRound(qSqrt(width * width + height * height) * 0.02), 140);
+
+    state.SetLabel(QString().asprintf("%dx%d kernel %d", width, height, kernelSize).toStdString());
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nmp::blurPanTilt(img, focus, kernelSize));
+    }
+
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+BENCHMARK(BM_BlurPanTilt)->Arg(2)->Arg(12)->Arg(50)->Unit(benchmark::kMillisecond)->UseRealTime();
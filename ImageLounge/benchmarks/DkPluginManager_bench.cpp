@@ -0,0 +1,130 @@
+#include "../src/DkCore/DkPluginManager.h"
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPluginLoader>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <memory>
+
+#ifndef NMC_BENCH_PLUGIN
+#define NMC_BENCH_PLUGIN ""
+#endif
+
+// copies of one plugin library, the plugin manager ignores duplicate file names only
+static QString createPluginDirectory(int numPlugins)
+{
+    static std::map<int, std::unique_ptr<QTemporaryDir>> dirs;
+
+    auto &dir = dirs[numPlugins];
+    if (dir)
+        return dir->path();
+
+    dir = std::make_unique<QTemporaryDir>();
+    QFileInfo src(NMC_BENCH_PLUGIN);
+
+    for (int idx = 0; idx < numPlugins; idx++) {
+        QString name = QString("%1_%2.%3").arg(src.baseName()).arg(idx).arg(src.suffix());
+        if (!QFile::copy(src.absoluteFilePath(), dir->filePath(name)))
+            break;
+    }
+
+    return dir->path();
+}
+
+static bool setupPlugins(benchmark::State &state)
+{
+    if (!QFileInfo(NMC_BENCH_PLUGIN).isFile()) {
+        state.SkipWithError("no plugin library, build with plugins");
+        return false;
+    }
+
+    QCoreApplication::setLibraryPaths({createPluginDirectory(state.range(0))});
+    return true;
+}
+
+// discovery without an index reads the metadata of every library
+static void BM_PluginDiscoveryCold(benchmark::State &state)
+{
+    if (!setupPlugins(state))
+        return;
+
+    auto &manager = nmc::DkPluginManager::instance();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        manager.clear();
+        QFile::remove(nmc::DkPluginManager::indexPath());
+        state.ResumeTiming();
+
+        manager.loadPlugins();
+    }
+
+    state.counters["plugins"] = manager.getPlugins().size();
+}
+BENCHMARK(BM_PluginDiscoveryCold)->Arg(1)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// a valid index avoids opening the libraries
+static void BM_PluginDiscoveryWarm(benchmark::State &state)
+{
+    if (!setupPlugins(state))
+        return;
+
+    auto &manager = nmc::DkPluginManager::instance();
+    manager.clear();
+    manager.loadPlugins();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        manager.clear();
+        state.ResumeTiming();
+
+        manager.loadPlugins();
+    }
+
+    state.counters["plugins"] = manager.getPlugins().size();
+}
+BENCHMARK(BM_PluginDiscoveryWarm)->Arg(1)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// the cost that is deferred to the first use of a plugin
+static void BM_PluginFirstUse(benchmark::State &state)
+{
+    if (!setupPlugins(state))
+        return;
+
+    QDir dir(QCoreApplication::libraryPaths().first());
+    QString path = dir.absoluteFilePath(dir.entryList(QDir::Files).first());
+
+    for (auto _ : state) {
+        nmc::DkPluginContainer plugin(path);
+        benchmark::DoNotOptimize(plugin.load());
+
+        state.PauseTiming();
+        if (plugin.loader())
+            plugin.loader()->unload();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_PluginFirstUse)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char **argv)
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    // keep the user's plugin index untouched
+    QStandardPaths::setTestModeEnabled(true);
+    QApplication app(argc, argv);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
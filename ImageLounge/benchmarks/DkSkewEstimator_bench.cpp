@@ -0,0 +1,67 @@
+#include "../plugins/AffineTransformations/src/DkSkewEstimator.h"
+#include <benchmark/benchmark.h>
+
+#include <QPainter>
+#include <QRandomGenerator>
+
+// a 300 dpi A4 scan: paragraphs of word boxes, rotated by a few degrees
+static QImage createPage(int idx)
+{
+    QImage page(2480, 3508, QImage::Format_RGB32);
+    page.fill(Qt::white);
+
+    QRandomGenerator rng(idx);
+    QPainter p(&page);
+    p.translate(page.width() / 2, page.height() / 2);
+    p.rotate(-3.0 + idx * 0.7);
+    p.translate(-page.width() / 2, -page.height() / 2);
+    p.setPen(Qt::NoPen);
+    p.setBrush(Qt::black);
+
+    for (int y = 300; y < page.height() - 300; y += 60) {
+        if (rng.bounded(8) == 0)
+            continue; // paragraph break
+
+        for (int x = 250; x < page.width() - 250;) {
+            const int w = 40 + rng.bounded(160);
+            p.drawRect(x, y, qMin(w, page.width() - 250 - x), 28);
+            x += w + 25;
+        }
+    }
+
+    return page;
+}
+
+static QVector<QImage> createPages(int numPages)
+{
+    static QVector<QImage> pages;
+    while (pages.size() < numPages)
+        pages << createPage(pages.size());
+
+    return pages.mid(0, numPages);
+}
+
+// batch use: one page after the other vs. the parallel overload
+static void BM_SkewEstimateBatch(benchmark::State &state)
+{
+    const int numPages = static_cast<int>(state.range(0));
+    const bool parallel = state.range(1) != 0;
+    const QVector<QImage> pages = createPages(numPages);
+
+    state.SetLabel(parallel ? "parallel" : "sequential");
+
+    for (auto _ : state) {
+        if (parallel) {
+            benchmark::DoNotOptimize(nmp::DkSkewEstimator::estimate(pages));
+        } else {
+            for (const QImage &page : pages)
+                benchmark::DoNotOptimize(nmp::DkSkewEstimator::estimate(page));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * numPages);
+}
+BENCHMARK(BM_SkewEstimateBatch)
+    ->ArgsProduct({{1, 8}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
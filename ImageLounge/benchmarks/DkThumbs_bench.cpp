@@ -0,0 +1,86 @@
+#include "../src/DkCore/DkSettings.h"
+#include "../src/DkCore/DkThumbs.h"
+#include <QCoreApplication>
+#include <QImage>
+#include <QTemporaryDir>
+#include <benchmark/benchmark.h>
+
+// photos without an exif thumbnail, so every thumbnail needs a full decode
+static QStringList createPhotos()
+{
+    static QTemporaryDir dir;
+    static QStringList files;
+
+    if (!files.isEmpty())
+        return files;
+
+    const int numPhotos = 24;
+    for (int idx = 0; idx < numPhotos; idx++) {
+        QImage img(3000, 2000, QImage::Format_RGB32);
+        for (int y = 0; y < img.height(); y++) {
+            auto *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+            for (int x = 0; x < img.width(); x++)
+                line[x] = qRgb((x + idx * 10) % 256, y % 256, (x * y + idx) % 256);
+        }
+
+        const QString filePath = dir.filePath(QString("photo%1.jpg").arg(idx));
+        if (!img.save(filePath, "JPG", 90))
+            break;
+
+        files << filePath;
+    }
+
+    return files;
+}
+
+// requests all thumbnails like the thumbnail preview does and waits for them
+static int loadThumbnails(const QStringList &files)
+{
+    nmc::DkThumbLoader loader;
+    int numLoaded = 0;
+    int numFinished = 0;
+
+    QObject::connect(&loader, &nmc::DkThumbLoader::thumbnailLoaded, [&]() {
+        numLoaded++;
+        numFinished++;
+    });
+    QObject::connect(&loader, &nmc::DkThumbLoader::thumbnailLoadFailed, [&]() {
+        numFinished++;
+    });
+
+    for (const QString &filePath : files)
+        loader.requestThumbnail(nmc::LoadThumbnailRequest(filePath, nmc::LoadThumbnailOption::none, 256));
+
+    while (numFinished < files.size())
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+
+    return numLoaded;
+}
+
+static void BM_ThumbLoader(benchmark::State &state)
+{
+    const bool diskCache = state.range(0) != 0;
+    nmc::DkSettingsManager::param().resources().thumbDiskCache = diskCache;
+    state.SetLabel(diskCache ? "disk cache" : "no cache");
+
+    const QStringList files = createPhotos();
+    if (files.isEmpty()) {
+        state.SkipWithError("could not write the synthetic photos");
+        return;
+    }
+
+    // the first pass fills the cache
+    if (diskCache)
+        loadThumbnails(files);
+
+    int numLoaded = 0;
+    for (auto _ : state) {
+        numLoaded = loadThumbnails(files);
+    }
+
+    if (numLoaded != files.size())
+        state.SkipWithError("not all thumbnails were loaded");
+
+    state.SetItemsProcessed(state.iterations() * files.size());
+}
+BENCHMARK(BM_ThumbLoader)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,35 @@
+#include "../src/DkCore/DkSettings.h"
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <benchmark/benchmark.h>
+
+// the loaders need an application (image plugins, actions), the offscreen platform works without a display
+int main(int argc, char **argv)
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    // keep the user's settings and thumbnail cache untouched
+    QTemporaryDir home;
+    qputenv("HOME", QFile::encodeName(home.path()));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(QDir(home.path()).filePath(".cache")));
+    QStandardPaths::setTestModeEnabled(true);
+
+    QApplication app(argc, argv);
+    nmc::DkSettingsManager::instance().init();
+
+    // the loaders log every file
+    QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
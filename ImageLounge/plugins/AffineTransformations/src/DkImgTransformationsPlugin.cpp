@@ -41,6 +41,7 @@
 #include <QDoubleSpinBox>
 #include <QMouseEvent>
 #include <QPushButton>
+#include <QtConcurrentRun>
 
 #define PI 3.14159265
 
@@ -197,6 +198,12 @@ DkImgTransformationsViewPort::DkImgTransformationsViewPort(QWidget *parent, Qt::
     init();
 }
 
+DkImgTransformationsViewPort::~DkImgTransformationsViewPort()
+{
+    // the estimate runs code of this plugin
+    mSkewWatcher.waitForFinished();
+}
+
 void DkImgTransformationsViewPort::init()
 {
     mDefaultMode = mode_scale;
@@ -222,7 +229,11 @@ void DkImgTransformationsViewPort::init()
     mRotationCenter = QPoint();
 
     mIntrRect = new DkInteractionRects(this);
-    mSkewEstimator = DkSkewEstimator(this);
+
+    connect(&mSkewWatcher,
+            &QFutureWatcher<DkSkewEstimator::Result>::finished,
+            this,
+            &DkImgTransformationsViewPort::skewEstimated);
 
     setMode(mSelectedMode);
 }
@@ -480,8 +491,8 @@ void DkImgTransformationsViewPort::paintEvent(QPaintEvent *event)
             QColor hCAlpha(50, 50, 50);
             hCAlpha.setAlpha(200);
 
-            QVector<QVector4D> lines = mSkewEstimator.getLines();
-            QVector<int> lineTypes = mSkewEstimator.getLineTypes();
+            const QVector<QVector4D> &lines = mSkew.lines;
+            const QVector<int> &lineTypes = mSkew.lineTypes;
             for (int i = 0; i < lines.size(); i++) {
                 (lineTypes.at(i)) ? linePen.setColor(nmc::DkSettingsManager::param().display().highlightColor)
                                   : linePen.setColor(hCAlpha);
@@ -745,21 +756,35 @@ void DkImgTransformationsViewPort::calculateAutoRotation()
             QImage img = mViewport->getImage();
 
             if (img.width() > 10 && img.height() > 10) {
-                mSkewEstimator.setImage(img);
-                mRotationValue = mSkewEstimator.getSkewAngle();
-                if (mRotationValue < 0)
-                    mRotationValue += 360;
-                emit rotationChanged(mRotationValue);
-                this->repaint();
+                // large scans take a while, keep the GUI responsive
+                if (!mSkewWatcher.isRunning()) {
+                    setCursor(Qt::BusyCursor);
+                    mSkewWatcher.setFuture(QtConcurrent::run([img]() {
+                        return DkSkewEstimator::estimate(img);
+                    }));
+                }
                 return;
             }
         }
     }
 
+    mSkew = DkSkewEstimator::Result();
     mRotationValue = 0;
     emit rotationChanged(mRotationValue);
 }
 
+void DkImgTransformationsViewPort::skewEstimated()
+{
+    setCursor(mDefaultCursor);
+
+    mSkew = mSkewWatcher.result();
+    mRotationValue = mSkew.angle;
+    if (mRotationValue < 0)
+        mRotationValue += 360;
+    emit rotationChanged(mRotationValue);
+    this->repaint();
+}
+
 void DkImgTransformationsViewPort::setPanning(bool checked)
 {
     this->mPanning = checked;
@@ -27,6 +27,7 @@
 
 #pragma once
 
+#include <QFutureWatcher>
 #include <QImage>
 #include <QObject>
 #include <QString>
@@ -97,7 +98,7 @@ class DkImgTransformationsViewPort : public nmc::DkPluginViewPort
 
 public:
     explicit DkImgTransformationsViewPort(QWidget *parent = nullptr, Qt::WindowFlags flags = Qt::WindowFlags());
-    ~DkImgTransformationsViewPort() override = default;
+    ~DkImgTransformationsViewPort() override;
 
     bool isCanceled();
     QImage getTransformedImage();
@@ -150,6 +151,7 @@ protected:
     void paintEvent(QPaintEvent *event) override;
     void init();
     void drawGuide(QPainter *painter, const QPolygonF &p, int paintMode);
+    void skewEstimated();
 
     bool mCancelTriggered;
     bool mPanning;
@@ -170,7 +172,8 @@ protected:
     double mImgRatioAngle;
     QCursor mRotatingCursor;
     bool mRotCropEnabled;
-    DkSkewEstimator mSkewEstimator;
+    QFutureWatcher<DkSkewEstimator::Result> mSkewWatcher;
+    DkSkewEstimator::Result mSkew; // the last estimate, its lines are drawn
     bool mAngleLinesEnabled;
     int mGuideMode;
 };
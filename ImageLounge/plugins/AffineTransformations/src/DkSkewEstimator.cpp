@@ -28,8 +28,9 @@
 #include "DkSkewEstimator.h"
 #include "DkImageStorage.h"
 
-#include <QProgressDialog>
-#include <QRandomGenerator>
+#include <QtConcurrentMap>
+
+#include <utility>
 
 #ifdef WITH_OPENCV
 #include "opencv2/imgproc/imgproc.hpp"
@@ -38,138 +39,247 @@
 namespace nmp
 {
 
-DkSkewEstimator::DkSkewEstimator(QWidget *mainWin)
+void DkSkewEstimator::setImage(QImage inImage)
 {
-    mMainWin = mainWin;
-
-    mSelectedLines.clear();
+    mImg = inImage;
 }
 
-DkSkewEstimator::~DkSkewEstimator() = default;
+double DkSkewEstimator::getSkewAngle()
+{
+    Result r = estimate(mImg);
+
+    mSelectedLines = r.lines;
+    mSelectedLineTypes = r.lineTypes;
 
-void DkSkewEstimator::setImage(QImage inImage)
+    return r.angle;
+}
+
+DkSkewEstimator::Result DkSkewEstimator::estimate(const QImage &img)
 {
-    mMatImg = nmc::DkImage::qImage2Mat(inImage);
-
-    mSepDims = QSize(qRound(inImage.width() / 1430.0 * 49.0), qRound(inImage.height() / 700.0 * 12.0));
-    mDelta = qRound(inImage.width() / 1430.0 * 20.0);
-    mMinLineLength = qRound(inImage.width() / 1430.0 * 20.0);
-    mRotationFactor = 1;
-
-    if (inImage.width() < inImage.height()) {
-        mMatImg = mMatImg.t();
-        mSepDims = QSize(qRound(inImage.width() / 1430.0 * 49.0), qRound(inImage.height() / 700.0 * 12.0));
-        mDelta = qRound(inImage.height() / 1430.0 * 20.0);
-        mMinLineLength = qRound(inImage.height() / 1430.0 * 20.0);
-        mRotationFactor = -1;
+    Result result;
+
+    if (img.isNull())
+        return result;
+
+    cv::Mat gray = nmc::DkImage::qImage2Mat(img);
+
+    if (gray.channels() > 1)
+        cv::cvtColor(gray, gray, cv::COLOR_BGR2GRAY);
+
+    // lines are always estimated in landscape orientation
+    const bool transposed = img.width() < img.height();
+    if (transposed)
+        gray = gray.t();
+
+    cv::Mat coarse = gray;
+    while (qMax(coarse.rows, coarse.cols) > kCoarseSize)
+        cv::pyrDown(coarse, coarse);
+
+    const double scale = (double)gray.cols / coarse.cols;
+    const Params cp = params(coarse, transposed);
+
+    cv::Mat integral, integralSq;
+    cv::integral(coarse, integral, integralSq, CV_64F);
+
+    // both directions are independent
+    const QVector<int> directions = {dir_horizontal, dir_vertical};
+    const QList<QVector<Line>> dirLines = QtConcurrent::blockingMapped<QList<QVector<Line>>>(directions, [&](int dir) {
+        return detectLines(integral, integralSq, cp, dir);
+    });
+
+    QVector<Line> lines;
+    for (const QVector<Line> &l : dirLines)
+        lines += l;
+
+    const double coarseDiagonal = qSqrt(coarse.rows * coarse.rows + coarse.cols * coarse.cols);
+    const double coarseAngle = computeSkewAngle(lines, coarseDiagonal, -30.0, 30.0, 0.1).value_or(0.0);
+
+    // refine lines close to the coarse angle at full resolution
+    const Params fp = params(gray, transposed);
+    QtConcurrent::blockingMap(lines, [&](Line &l) {
+        l.line *= scale;
+        l.weight.setZ(l.weight.z() * scale);
+
+        if (qAbs(l.weight.y() / M_PI * 180 - coarseAngle) < kRefineWindow)
+            refineLine(gray, fp, scale, l);
+    });
+
+    // nothing salient in the refined window: keep the coarse angle
+    result.angle = computeSkewAngle(lines,
+                                    qSqrt(gray.rows * gray.rows + gray.cols * gray.cols),
+                                    coarseAngle - kRefineWindow,
+                                    coarseAngle + kRefineWindow,
+                                    0.01)
+                       .value_or(coarseAngle);
+
+    for (const Line &l : lines) {
+        QVector4D line = l.line;
+        if (transposed)
+            line = QVector4D(line.y(), line.x(), line.w(), line.z());
+
+        result.lines << line;
+        result.lineTypes << (qAbs(l.weight.y() / M_PI * 180 - result.angle) < 0.15 ? 1 : 0);
     }
 
-    if (mSepDims.width() < 1)
-        mSepDims.setWidth(1);
-    if (mSepDims.height() < 1)
-        mSepDims.setHeight(1);
+    return result;
+}
 
-    mMinLineProjLength = mMinLineLength / 4;
+QVector<DkSkewEstimator::Result> DkSkewEstimator::estimate(const QVector<QImage> &imgs)
+{
+    return QtConcurrent::blockingMapped<QVector<Result>>(imgs, [](const QImage &img) {
+        return estimate(img);
+    });
 }
 
-double DkSkewEstimator::getSkewAngle()
+/**
+ * parameters are relative to the image size (a reference width of 1430 px)
+ **/
+DkSkewEstimator::Params DkSkewEstimator::params(const cv::Mat &gray, bool transposed)
 {
-    if (!mMatImg.empty()) {
-        mProgress = new QProgressDialog(QT_TRANSLATE_NOOP("nmc::DkSkewEstimator", "Calculating angle..."),
-                                        QT_TRANSLATE_NOOP("nmc::DkSkewEstimator", "Cancel"),
-                                        0,
-                                        100,
-                                        mMainWin);
-        mProgress->setMinimumDuration(250);
-        mProgress->setMaximum(100);
-        mProgress->setValue(0);
-        mProgress->setWindowModality(Qt::WindowModal);
-        mProgress->setModal(true);
-        mProgress->hide();
-        mProgress->show();
-
-        cv::Mat matGray;
-
-        if (mMatImg.channels() > 1)
-            cv::cvtColor(mMatImg, matGray, cv::COLOR_BGR2GRAY);
-        else
-            matGray = mMatImg;
-
-        cv::Mat integral, integralSq;
-        cv::integral(matGray, integral, integralSq, CV_64F);
-        if (integral.channels() > 1)
-            qDebug() << "Error! integral image has more than one channel";
-
-        cv::Mat separabilityHor = computeSeparability(integral, integralSq, dir_horizontal);
-        if (mProgress->wasCanceled()) {
-            mProgress->deleteLater();
-            return 0;
-        }
+    const int width = transposed ? gray.rows : gray.cols;
+    const int height = transposed ? gray.cols : gray.rows;
+    const int longSide = qMax(width, height);
+
+    Params p;
+    p.sepDims = QSize(qMax(qRound(width / 1430.0 * 49.0), 1), qMax(qRound(height / 700.0 * 12.0), 1));
+    p.delta = qRound(longSide / 1430.0 * 20.0);
+    p.minLineLength = qRound(longSide / 1430.0 * 20.0);
+    p.minLineProjLength = p.minLineLength / 4;
+    p.rotationFactor = transposed ? -1 : 1;
+
+    return p;
+}
 
-        cv::Mat separabilityVer = computeSeparability(integral, integralSq, dir_vertical);
-        if (mProgress->wasCanceled()) {
-            mProgress->deleteLater();
-            return 0;
-        }
+QVector<DkSkewEstimator::Line>
+DkSkewEstimator::detectLines(const cv::Mat &integral, const cv::Mat &integralSq, const Params &p, int direction)
+{
+    cv::Mat separability = computeSeparability(integral, integralSq, p, direction);
 
-        double min, max;
-        cv::minMaxLoc(separabilityHor, &min, &max);
-        cv::Mat edgeMapHor = computeEdgeMap(separabilityHor, kSepThr * max, dir_horizontal);
-        // cv::Mat edgeMapHor = computeEdgeMap(separabilityHor, 0.1, dir_horizontal);
-        if (mProgress->wasCanceled()) {
-            mProgress->deleteLater();
-            return 0;
-        }
+    double min, max;
+    cv::minMaxLoc(separability, &min, &max);
+    cv::Mat edgeMap = computeEdgeMap(separability, kSepThr * max, p, direction);
+
+    return computeWeights(edgeMap, p, direction);
+}
 
-        cv::minMaxLoc(separabilityVer, &min, &max);
-        cv::Mat edgeMapVer = computeEdgeMap(separabilityVer, kSepThr * max, dir_vertical);
-        // cv::Mat edgeMapVer = computeEdgeMap(separabilityVer, 0.1, dir_vertical);
-        if (mProgress->wasCanceled()) {
-            mProgress->deleteLater();
-            return 0;
+/**
+ * fits a line to the edges of the full resolution image.
+ * edges are searched in a small window around the upscaled coarse line.
+ **/
+void DkSkewEstimator::refineLine(const cv::Mat &gray, const Params &p, double scale, Line &line)
+{
+    const bool horizontal = line.direction == dir_horizontal;
+
+    // vertical lines are refined in a transposed roi: u runs along the line, v across
+    const QVector4D &l = line.line;
+    QPointF p1 = horizontal ? QPointF(l.x(), l.y()) : QPointF(l.y(), l.x());
+    QPointF p2 = horizontal ? QPointF(l.z(), l.w()) : QPointF(l.w(), l.z());
+    if (p2.x() < p1.x())
+        std::swap(p1, p2);
+
+    const double slope = (p2.y() - p1.y()) / qMax(p2.x() - p1.x(), 1.0);
+    const int search = qCeil(scale) + kEpsilon;
+
+    // the separability needs a border of half the window size
+    const int marginU = p.sepDims.width() / 2 + p.delta / 2 + 1;
+    const int marginV = p.sepDims.height() / 2 + p.delta / 2 + search + 1;
+
+    cv::Rect roiRect(qFloor(p1.x()) - marginU,
+                     qFloor(qMin(p1.y(), p2.y())) - marginV,
+                     qCeil(p2.x() - p1.x()) + 2 * marginU,
+                     qCeil(qAbs(p2.y() - p1.y())) + 2 * marginV);
+    if (!horizontal)
+        roiRect = cv::Rect(roiRect.y, roiRect.x, roiRect.height, roiRect.width);
+
+    roiRect &= cv::Rect(0, 0, gray.cols, gray.rows);
+    if (roiRect.empty())
+        return;
+
+    cv::Mat roi = horizontal ? gray(roiRect) : cv::Mat(gray(roiRect).t());
+    const QPoint offset = horizontal ? QPoint(roiRect.x, roiRect.y) : QPoint(roiRect.y, roiRect.x);
+
+    cv::Mat integral, integralSq;
+    cv::integral(roi, integral, integralSq, CV_64F);
+    cv::Mat separability = computeSeparability(integral, integralSq, p, dir_horizontal);
+
+    double min, max;
+    cv::minMaxLoc(separability, &min, &max);
+    const double thr = kSepThr * max;
+
+    // strongest edge per column
+    QVector<QPointF> pts;
+    for (int u = qCeil(p1.x()); u <= qFloor(p2.x()); u++) {
+        const int c = u - offset.x();
+        if (c < 0 || c >= separability.cols)
+            continue;
+
+        const int v0 = qRound(p1.y() + (u - p1.x()) * slope) - offset.y();
+        float best = (float)thr;
+        int bestV = -1;
+
+        for (int v = qMax(v0 - search, 0); v <= qMin(v0 + search, separability.rows - 1); v++) {
+            const float val = separability.at<float>(v, c);
+            if (val > best) {
+                best = val;
+                bestV = v;
+            }
         }
 
-        mSelectedLines.clear();
+        if (bestV != -1)
+            pts << QPointF(u, bestV + offset.y());
+    }
 
-        QVector<QVector3D> weightsHor = computeWeights(edgeMapHor, dir_horizontal);
-        qDebug() << weightsHor.size();
-        QVector<QVector3D> weightsVer = computeWeights(edgeMapVer, dir_vertical);
-        qDebug() << weightsVer.size();
-        if (mProgress->wasCanceled()) {
-            mSelectedLines.clear();
-            mProgress->deleteLater();
-            return 0;
+    // least squares fit, then once more without outliers
+    double a = 0, b = 0;
+    for (int iter = 0; iter < 2; iter++) {
+        if (pts.size() < qMax(p.minLineProjLength, 2))
+            return;
+
+        double su = 0, sv = 0, suu = 0, suv = 0;
+        for (const QPointF &pt : pts) {
+            su += pt.x();
+            sv += pt.y();
+            suu += pt.x() * pt.x();
+            suv += pt.x() * pt.y();
         }
 
-        weightsHor += weightsVer;
+        const double n = pts.size();
+        const double den = n * suu - su * su;
+        if (den == 0)
+            return;
 
-        double retAngle = computeSkewAngle(weightsHor,
-                                           qSqrt(matGray.rows * matGray.rows + matGray.cols * matGray.cols));
+        b = (n * suv - su * sv) / den;
+        a = (sv - b * su) / n;
 
-        mProgress->setValue(100);
-        mProgress->deleteLater();
+        QVector<QPointF> inliers;
+        for (const QPointF &pt : pts) {
+            if (qAbs(a + b * pt.x() - pt.y()) <= kEpsilon)
+                inliers << pt;
+        }
+        pts = inliers;
+    }
+
+    const double lineAngle = atan(b);
+    line.weight.setY((float)(horizontal ? -p.rotationFactor * lineAngle : p.rotationFactor * lineAngle));
 
-        return retAngle;
-    } else
-        return 0;
+    const QPointF r1(p1.x(), a + b * p1.x());
+    const QPointF r2(p2.x(), a + b * p2.x());
+    line.line = horizontal ? QVector4D(r1.x(), r1.y(), r2.x(), r2.y()) : QVector4D(r1.y(), r1.x(), r2.y(), r2.x());
 }
 
-cv::Mat DkSkewEstimator::computeSeparability(cv::Mat integral, cv::Mat integralSq, int direction)
+cv::Mat DkSkewEstimator::computeSeparability(const cv::Mat &integral,
+                                             const cv::Mat &integralSq,
+                                             const Params &p,
+                                             int direction)
 {
     cv::Mat separability = cv::Mat::zeros(integral.rows, integral.cols, CV_32FC1);
 
-    int W2 = qCeil(mSepDims.width() / 2);
-    int H2 = qCeil(mSepDims.height() / 2);
+    int W2 = qCeil(p.sepDims.width() / 2);
+    int H2 = qCeil(p.sepDims.height() / 2);
 
     if (direction == dir_horizontal) {
-        int progressStep = integral.rows - 2 * H2 - 2 * qCeil(mDelta / 2);
-        int lastValue = mProgress->value();
-
-        for (int r = H2 + qCeil(mDelta / 2); r < integral.rows - H2 - qCeil(mDelta / 2); r++) {
-            mProgress->setValue(lastValue + qRound(30.0 * (r - H2 - qCeil(mDelta / 2)) / (double)progressStep));
-            if (mProgress->wasCanceled())
-                break;
-            for (int c = W2 + qCeil(mDelta / 2); c < integral.cols - W2 - qCeil(mDelta / 2); c++) {
+        for (int r = H2 + qCeil(p.delta / 2); r < integral.rows - H2 - qCeil(p.delta / 2); r++) {
+            for (int c = W2 + qCeil(p.delta / 2); c < integral.cols - W2 - qCeil(p.delta / 2); c++) {
                 double mean1 = integral.at<double>(r - H2, c - W2) + integral.at<double>(r - 1, c + W2)
                     - integral.at<double>(r - H2, c + W2) - integral.at<double>(r - 1, c - W2);
                 double mean2 = integral.at<double>(r + 1, c - W2) + integral.at<double>(r + H2, c + W2)
@@ -191,15 +301,8 @@ cv::Mat DkSkewEstimator::computeSeparability(cv::Mat integral, cv::Mat integralS
             }
         }
     } else {
-        int progressStep = integral.rows - 2 * W2 - 2 * qCeil(mDelta / 2);
-        int lastValue = mProgress->value();
-
-        for (int r = W2 + qCeil(mDelta / 2); r < integral.rows - W2 - qCeil(mDelta / 2); r++) {
-            mProgress->setValue(lastValue + qRound(30.0 * (r - W2 - qCeil(mDelta / 2)) / (double)progressStep));
-            if (mProgress->wasCanceled())
-                break;
-
-            for (int c = H2 + qCeil(mDelta / 2); c < integral.cols - H2 - qCeil(mDelta / 2); c++) {
+        for (int r = W2 + qCeil(p.delta / 2); r < integral.rows - W2 - qCeil(p.delta / 2); r++) {
+            for (int c = H2 + qCeil(p.delta / 2); c < integral.cols - H2 - qCeil(p.delta / 2); c++) {
                 double mean1 = integral.at<double>(r - W2, c - H2) + integral.at<double>(r + W2, c - 1)
                     - integral.at<double>(r + W2, c - H2) - integral.at<double>(r - W2, c - 1);
                 double mean2 = integral.at<double>(r - W2, c + 1) + integral.at<double>(r + W2, c + H2)
@@ -229,35 +332,27 @@ cv::Mat DkSkewEstimator::computeSeparability(cv::Mat integral, cv::Mat integralS
     return separability;
 }
 
-cv::Mat DkSkewEstimator::computeEdgeMap(cv::Mat separability, double thr, int direction)
+cv::Mat DkSkewEstimator::computeEdgeMap(const cv::Mat &separability, double thr, const Params &p, int direction)
 {
     int tmpStatus;
 
-    int W2 = qCeil(mSepDims.width() / 2);
-    int H2 = qCeil(mSepDims.height() / 2);
+    int W2 = qCeil(p.sepDims.width() / 2);
+    int H2 = qCeil(p.sepDims.height() / 2);
 
     cv::Mat edgeMap = cv::Mat::zeros(separability.rows, separability.cols, CV_8UC1);
 
     if (direction == dir_horizontal) {
-        int progressStep = separability.rows - 2 * H2 - 2 * kMaxK;
-        int lastValue = mProgress->value();
-
-        float *p;
+        const float *sp;
         for (int r = H2 + kMaxK; r < separability.rows - H2 - kMaxK; r++) {
-            mProgress->setValue(lastValue + qRound(5.0 * (r - H2 - kMaxK) / (double)progressStep));
-            if (mProgress->wasCanceled())
-                break;
-
-            p = separability.ptr<float>(r);
+            sp = separability.ptr<float>(r);
             for (int c = W2; c < separability.cols - W2; c++) {
-                if (p[c] > thr) {
+                if (sp[c] > thr) {
                     tmpStatus = 1;
                     for (int k = -kMaxK; k <= kMaxK; k++) {
                         if (k == 0)
                             k++;
-                        float *pK;
-                        pK = separability.ptr<float>(r + k);
-                        if (pK[c] > p[c]) {
+                        const float *pK = separability.ptr<float>(r + k);
+                        if (pK[c] > sp[c]) {
                             tmpStatus = 0;
                             break;
                         }
@@ -272,23 +367,16 @@ cv::Mat DkSkewEstimator::computeEdgeMap(cv::Mat separability, double thr, int di
             }
         }
     } else {
-        int progressStep = separability.rows - 2 * W2 - 2 * kMaxK;
-        int lastValue = mProgress->value();
-
-        float *p;
+        const float *sp;
         for (int r = W2; r < separability.rows - W2; r++) {
-            mProgress->setValue(lastValue + qRound(5.0 * (r - W2 - kMaxK) / (double)progressStep));
-            if (mProgress->wasCanceled())
-                break;
-
-            p = separability.ptr<float>(r);
+            sp = separability.ptr<float>(r);
             for (int c = H2 + kMaxK; c < separability.cols - H2 - kMaxK; c++) {
-                if (p[c] > thr) {
+                if (sp[c] > thr) {
                     tmpStatus = 1;
                     for (int k = -kMaxK; k <= kMaxK; k++) {
                         if (k == 0)
                             k++;
-                        if (p[c + k] > p[c]) {
+                        if (sp[c + k] > sp[c]) {
                             tmpStatus = 0;
                             break;
                         }
@@ -307,12 +395,7 @@ cv::Mat DkSkewEstimator::computeEdgeMap(cv::Mat separability, double thr, int di
     return edgeMap;
 }
 
-int DkSkewEstimator::randInt(int low, int high)
-{
-    return QRandomGenerator::global()->bounded(low, high);
-}
-
-QVector<QVector3D> DkSkewEstimator::computeWeights(cv::Mat edgeMap, int direction)
+QVector<DkSkewEstimator::Line> DkSkewEstimator::computeWeights(const cv::Mat &edgeMap, const Params &p, int direction)
 {
     std::vector<cv::Vec4i> lines;
     QVector4D maxLine = QVector4D();
@@ -321,17 +404,12 @@ QVector<QVector3D> DkSkewEstimator::computeWeights(cv::Mat edgeMap, int directio
                 1,
                 CV_PI / 180,
                 50,
-                mMinLineLength,
+                p.minLineLength,
                 20); // params: rho resolution, theta resolution, threshold, min Line length, max line gap
 
-    QVector<QVector3D> computedWeights = QVector<QVector3D>();
-    int lastValue = mProgress->value();
+    QVector<Line> computedWeights;
 
     for (size_t i = 0; i < lines.size(); i++) {
-        mProgress->setValue(lastValue + qRound(15.0 * (float)i / lines.size()));
-        if (mProgress->wasCanceled())
-            break;
-
         cv::Vec4i l = lines[i];
         QVector3D currMax = QVector3D(0.0, 0.0, 0.0);
 
@@ -352,19 +430,19 @@ QVector<QVector3D> DkSkewEstimator::computeWeights(cv::Mat edgeMap, int directio
             double lineAngle = atan2((l[3] - l[1]), (l[2] - l[0]));
             double slope = qTan(lineAngle);
 
-            while (qAbs(x1 - x2) > mMinLineProjLength && K < kIter) {
+            while (qAbs(x1 - x2) > p.minLineProjLength && K < kIter) {
                 int y1 = qRound(l[1] + (x1 - l[0]) * slope);
                 int y2 = qRound(l[1] + (x2 - l[0]) * slope);
 
                 QVector<int> yrPoss1 = QVector<int>();
-                for (int di = -mDelta; di <= mDelta && y1 + di < edgeMap.rows; di++) {
+                for (int di = -p.delta; di <= p.delta && y1 + di < edgeMap.rows; di++) {
                     if (y1 + di >= 0)
                         if (edgeMap.at<uchar>(y1 + di, x1) == 1)
                             yrPoss1.append(y1 + di);
                 }
 
                 QVector<int> yrPoss2 = QVector<int>();
-                for (int di = -mDelta; di <= mDelta && y2 + di < edgeMap.rows; di++) {
+                for (int di = -p.delta; di <= p.delta && y2 + di < edgeMap.rows; di++) {
                     if (y2 + di >= 0)
                         if (edgeMap.at<uchar>(y2 + di, x2) == 1)
                             yrPoss2.append(y2 + di);
@@ -387,7 +465,7 @@ QVector<QVector3D> DkSkewEstimator::computeWeights(cv::Mat edgeMap, int directio
                             if (sumVal > currMax.x()) {
                                 QPointF centerPoint = QPointF(0.5 * (x1 + x2), 0.5 * (y1 + y2));
                                 currMax = QVector3D((float)sumVal,
-                                                    (float)(-mRotationFactor * lineAngle),
+                                                    (float)(-p.rotationFactor * lineAngle),
                                                     (float)qSqrt((edgeMap.cols * 0.5 - centerPoint.x())
                                                                      * (edgeMap.cols * 0.5 - centerPoint.x())
                                                                  + (edgeMap.rows * 0.5 - centerPoint.y())
@@ -419,19 +497,19 @@ QVector<QVector3D> DkSkewEstimator::computeWeights(cv::Mat edgeMap, int directio
             double lineAngle = atan2((l[2] - l[0]), (l[3] - l[1]));
             double slope = qTan(lineAngle);
 
-            while (qAbs(x1 - x2) > mMinLineProjLength && K < kIter) {
+            while (qAbs(x1 - x2) > p.minLineProjLength && K < kIter) {
                 int y1 = qRound(l[0] + (x1 - l[1]) * slope);
                 int y2 = qRound(l[0] + (x2 - l[1]) * slope);
 
                 QVector<int> yrPoss1 = QVector<int>();
-                for (int di = -mDelta; di <= mDelta && y1 + di < edgeMap.cols; di++) {
+                for (int di = -p.delta; di <= p.delta && y1 + di < edgeMap.cols; di++) {
                     if (y1 + di >= 0)
                         if (edgeMap.at<uchar>(x1, y1 + di) == 1)
                             yrPoss1.append(y1 + di);
                 }
 
                 QVector<int> yrPoss2 = QVector<int>();
-                for (int di = -mDelta; di <= mDelta && y2 + di < edgeMap.cols; di++) {
+                for (int di = -p.delta; di <= p.delta && y2 + di < edgeMap.cols; di++) {
                     if (y2 + di >= 0)
                         if (edgeMap.at<uchar>(x2, y2 + di) == 1)
                             yrPoss2.append(y2 + di);
@@ -454,7 +532,7 @@ QVector<QVector3D> DkSkewEstimator::computeWeights(cv::Mat edgeMap, int directio
                             if (sumVal > currMax.x()) {
                                 QPointF centerPoint = QPointF(0.5 * (x1 + x2), 0.5 * (y1 + y2));
                                 currMax = QVector3D((float)sumVal,
-                                                    (float)(mRotationFactor * lineAngle),
+                                                    (float)(p.rotationFactor * lineAngle),
                                                     (float)qSqrt((edgeMap.rows * 0.5 - centerPoint.x())
                                                                      * (edgeMap.rows * 0.5 - centerPoint.x())
                                                                  + (edgeMap.cols * 0.5 - centerPoint.y())
@@ -472,43 +550,42 @@ QVector<QVector3D> DkSkewEstimator::computeWeights(cv::Mat edgeMap, int directio
             }
         }
 
-        if (currMax.x() > 0) {
-            computedWeights.append(currMax);
-            if (mRotationFactor == -1)
-                maxLine = QVector4D(maxLine.y(), maxLine.x(), maxLine.w(), maxLine.z());
-            mSelectedLines.append(maxLine);
-            mSelectedLineTypes.append(0);
-        }
+        if (currMax.x() > 0)
+            computedWeights.append({currMax, maxLine, direction});
     }
     return computedWeights;
 }
 
-double DkSkewEstimator::computeSkewAngle(QVector<QVector3D> weights, double imgDiagonal)
+std::optional<double> DkSkewEstimator::computeSkewAngle(const QVector<Line> &lines,
+                                                        double imgDiagonal,
+                                                        double from,
+                                                        double to,
+                                                        double step)
 {
-    if (weights.size() < 1)
-        return 0;
+    if (lines.size() < 1)
+        return {};
 
     double maxWeight = 0;
-    for (int i = 0; i < weights.size(); i++)
-        if (weights.at(i).x() > maxWeight)
-            maxWeight = weights.at(i).x();
+    for (const Line &l : lines)
+        if (l.weight.x() > maxWeight)
+            maxWeight = l.weight.x();
 
     double eta = 0.35;
 
     QVector<QVector3D> thrWeights = QVector<QVector3D>();
-    for (int i = 0; i < weights.size(); i++)
-        if (weights.at(i).x() / maxWeight > eta) {
-            thrWeights.append(QVector3D((float)qSqrt((weights.at(i).x() / maxWeight - eta) / (1 - eta)),
-                                        (float)(weights.at(i).y() / M_PI * 180),
-                                        (float)(weights.at(i).z() / imgDiagonal)));
-            // thrWeights.append(QVector3D((weights.at(i).x()/maxWeight - eta) * (weights.at(i).x()/maxWeight - eta),
-            // weights.at(i).y() / M_PI * 180, weights.at(i).z() / imgDiagonal));
+    for (const Line &l : lines)
+        if (l.weight.x() / maxWeight > eta) {
+            thrWeights.append(QVector3D((float)qSqrt((l.weight.x() / maxWeight - eta) / (1 - eta)),
+                                        (float)(l.weight.y() / M_PI * 180),
+                                        (float)(l.weight.z() / imgDiagonal)));
         }
 
-    QVector<QPointF> saliencyVec = QVector<QPointF>();
+    double maxSaliency = 0;
+    double salSkewAngle = 0;
 
-    for (int step = -300; step <= 300; ++step) {
-        double skewAngle = 0.1 * step;
+    const int numSteps = qRound((to - from) / step);
+    for (int idx = 0; idx <= numSteps; ++idx) {
+        double skewAngle = from + idx * step;
         double saliency = 0;
 
         for (int i = 0; i < thrWeights.size(); i++) {
@@ -517,27 +594,14 @@ double DkSkewEstimator::computeSkewAngle(QVector<QVector3D> weights, double imgD
                        / (kSigma * kSigma));
         }
 
-        saliencyVec.append(QPointF(skewAngle, saliency));
-    }
-
-    // for (int i = 0; i < saliencyVec.size(); i++) qDebug() << saliencyVec.at(i);
-
-    double maxSaliency = 0;
-    double salSkewAngle = 0;
-
-    for (int i = 0; i < saliencyVec.size(); i++) {
-        if (maxSaliency < saliencyVec.at(i).y()) {
-            maxSaliency = saliencyVec.at(i).y();
-            salSkewAngle = saliencyVec.at(i).x();
+        if (maxSaliency < saliency) {
+            maxSaliency = saliency;
+            salSkewAngle = skewAngle;
         }
     }
 
-    for (int i = 0; i < weights.size(); i++)
-        if (weights.at(i).x() > eta && qAbs(weights.at(i).y() / M_PI * 180 - salSkewAngle) < 0.15)
-            mSelectedLineTypes.replace(i, 1);
-
     if (maxSaliency == 0)
-        return 0;
+        return {};
 
     return salSkewAngle;
 }
@@ -30,15 +30,15 @@
 #include <QImage>
 #include <QVector3D>
 #include <QVector4D>
+#include <QVector>
+
+#include <optional>
 
 #ifdef WITH_OPENCV
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 #endif
 
-class QProgressDialog;
-class QWidget;
-
 namespace nmp
 {
 
@@ -52,38 +52,70 @@ public:
         dir_end,
     };
 
-    explicit DkSkewEstimator(QWidget *mainWin = nullptr);
-    ~DkSkewEstimator();
+    struct Result {
+        double angle = 0.0; // skew angle in degree
+        QVector<QVector4D> lines; // detected lines in image coordinates
+        QVector<int> lineTypes; // 1 if the line supports the skew angle
+    };
+
+    DkSkewEstimator() = default;
 
     double getSkewAngle();
     QVector<QVector4D> getLines();
     QVector<int> getLineTypes();
     void setImage(QImage inImage);
 
+    /**
+     * Estimates the skew angle coarse to fine. Lines are detected on a downscaled
+     * pyramid level, lines close to the coarse angle are then refined at full resolution.
+     * This function has no GUI dependencies and is thread-safe.
+     **/
+    static Result estimate(const QImage &img);
+
+    /**
+     * Estimates the skew angles of several pages in parallel.
+     **/
+    static QVector<Result> estimate(const QVector<QImage> &imgs);
+
 private:
-    cv::Mat computeSeparability(cv::Mat integral, cv::Mat integralSq, int direction);
-    cv::Mat computeEdgeMap(cv::Mat separability, double thr, int direction);
-    QVector<QVector3D> computeWeights(cv::Mat edgeMap, int direction);
-    double computeSkewAngle(QVector<QVector3D> weights, double imgDiagonal);
-    int randInt(int low, int high);
+    struct Params {
+        QSize sepDims{1, 1};
+        int delta = 0;
+        int minLineLength = 10;
+        int minLineProjLength = 5;
+        int rotationFactor = 1;
+    };
+
+    struct Line {
+        QVector3D weight; // edge strength, angle, distance to the center
+        QVector4D line; // end points
+        int direction = dir_horizontal;
+    };
+
+    static Params params(const cv::Mat &gray, bool transposed);
+    static QVector<Line>
+    detectLines(const cv::Mat &integral, const cv::Mat &integralSq, const Params &p, int direction);
+    static void refineLine(const cv::Mat &gray, const Params &p, double scale, Line &line);
+
+    static cv::Mat
+    computeSeparability(const cv::Mat &integral, const cv::Mat &integralSq, const Params &p, int direction);
+    static cv::Mat computeEdgeMap(const cv::Mat &separability, double thr, const Params &p, int direction);
+    static QVector<Line> computeWeights(const cv::Mat &edgeMap, const Params &p, int direction);
+    // the most salient angle in [from, to], nothing if no line supports any
+    static std::optional<double>
+    computeSkewAngle(const QVector<Line> &lines, double imgDiagonal, double from, double to, double step);
 
     static constexpr int kIter = 200;
     static constexpr double kSigma = 0.3;
     static constexpr double kSepThr = 0.1;
     static constexpr int kEpsilon = 2;
     static constexpr int kMaxK = 7;
+    static constexpr int kCoarseSize = 2000; // longest side of the coarse pyramid level
+    static constexpr double kRefineWindow = 1.0; // lines within this angle (degree) are refined
 
-    QSize mSepDims{0, 0};
-    int mDelta = 0;
-    int mMinLineLength = 10;
-    int mMinLineProjLength = mMinLineLength / 2;
-    int mRotationFactor = 1;
-
+    QImage mImg;
     QVector<QVector4D> mSelectedLines;
     QVector<int> mSelectedLineTypes;
-    cv::Mat mMatImg;
-    QProgressDialog *mProgress;
-    QWidget *mMainWin;
 };
 
 };
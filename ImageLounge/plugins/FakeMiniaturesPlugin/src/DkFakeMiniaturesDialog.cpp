@@ -26,11 +26,9 @@
  *******************************************************************************************************/
 
 #include "DkFakeMiniaturesDialog.h"
+#include "DkPanTiltBlur.h"
 #ifdef WITH_OPENCV
 #include "opencv2/imgproc.hpp"
-#if CV_MAJOR_VERSION >= 5
-#include "opencv2/geometry.hpp"
-#endif
 #endif
 #include "DkImageStorage.h"
 
@@ -50,15 +48,6 @@
 namespace nmp
 {
 
-#ifdef WITH_OPENCV
-// I know - but I just want to get rid of these little issues...
-#if (CV_MAJOR_VERSION > 3)
-constexpr int DIST_C = cv::DIST_C;
-#else
-constexpr int DIST_C = CV_DIST_C;
-#endif
-#endif
-
 /**************************************************************
  * DkFakeMiniaturesDialog: Dialog for creating fake miniatures
  ***************************************************************/
@@ -224,10 +213,11 @@ QImage DkFakeMiniaturesDialog::applyMiniaturesFilter(QImage inImg, QRect qRoi)
 {
 #ifdef WITH_OPENCV
 
+    // the preview is rendered at display resolution, scale the kernel accordingly
     int kernelSize = kernelSizeWidget->getToolValue();
-    if (inImg == scaledImg) {
+    if (inImg.size() != mImg->size()) {
         double diagO = sqrt(mImg->width() * mImg->width() + mImg->height() * mImg->height());
-        double diagP = sqrt(scaledImg.width() * scaledImg.width() + scaledImg.height() * scaledImg.height());
+        double diagP = sqrt(inImg.width() * inImg.width() + inImg.height() * inImg.height());
         kernelSize = qRound(kernelSize * diagP / diagO);
     }
 
@@ -235,27 +225,10 @@ QImage DkFakeMiniaturesDialog::applyMiniaturesFilter(QImage inImg, QRect qRoi)
     float satFactor = saturation / 50.0f + 1;
 
     cv::Mat blurImg = nmc::DkImage::qImage2Mat(inImg);
-    cv::Mat distImg(blurImg.size(), CV_8UC1);
-    distImg = 255;
-    cv::Mat roi(distImg, cv::Rect(qRoi.topLeft().x(), qRoi.topLeft().y(), qRoi.width(), qRoi.height()));
-    roi.setTo(0);
-    // blur plane by plane
-    std::vector<cv::Mat> planes;
-    cv::split(blurImg, planes);
-
-    // dist image based on 'some' threshold
-    // cv::Mat distImg;
-    // cv::threshold(planes.at(0), distImg, 40, 255, THRESH_BINARY);
-
-    cv::distanceTransform(distImg, distImg, DIST_C, 3);
-    cv::normalize(distImg, distImg, 1.0f, 0.0f, cv::NORM_MINMAX);
+    cv::Rect roi(qRoi.topLeft().x(), qRoi.topLeft().y(), qRoi.width(), qRoi.height());
 
-    for (size_t idx = 0; idx < planes.size(); idx++)
-        planes.at(idx) = blurPanTilt(planes.at(idx), distImg, kernelSize); // 140 is the maximal blurring kernel size
-    // planes.at(idx) = distImg;
-
-    cv::merge(planes, blurImg);
-    // return (DkFakeMiniaturesDialog::mat2QImage(blurImg));
+    // everything outside the roi is blurred
+    blurImg = blurPanTilt(blurImg, roi, kernelSize);
 
     if (satFactor > 1) {
         cv::Mat imgHsv;
@@ -263,18 +236,7 @@ QImage DkFakeMiniaturesDialog::applyMiniaturesFilter(QImage inImg, QRect qRoi)
         std::vector<cv::Mat> imgHsvCh;
         split(imgHsv, imgHsvCh);
 
-        for (int row = 0; row < imgHsv.rows; row++) {
-            auto *ptr = imgHsvCh[1].ptr<unsigned char>(row);
-
-            for (int col = 0; col < imgHsv.cols; col++) {
-                float tmp = (float)ptr[col] * satFactor;
-                if (tmp > 255.0f)
-                    tmp = 255.0f;
-                if (tmp < 0)
-                    tmp = 0.0f;
-                ptr[col] = (unsigned char)qRound(tmp);
-            }
-        }
+        imgHsvCh[1].convertTo(imgHsvCh[1], -1, satFactor); // saturates to [0 255]
 
         merge(imgHsvCh, imgHsv);
         cv::Mat tempImg(blurImg);
@@ -297,83 +259,6 @@ QImage DkFakeMiniaturesDialog::applyMiniaturesFilter(QImage inImg, QRect qRoi)
 #endif
 }
 
-#ifdef WITH_OPENCV
-/**
- * blur filter
- * @param src input cv::Mat
- * @param depthImg distance transform based on a roi
- * @param maxKernel maximum blur kernel size
- * @return cv::Mat blurres mat
- **/
-cv::Mat DkFakeMiniaturesDialog::blurPanTilt(cv::Mat src, cv::Mat depthImg, int maxKernel)
-{
-    cv::Mat integralImg;
-
-    cv::Mat blurImg(src.size(), src.depth());
-
-    // a template function would have more 'style' here
-    // const double* itgrl64Ptr = 0;
-
-    // images with an area below 4000*4000 can be compuated using 32 bit
-    cv::integral(src, integralImg, CV_32S);
-    const unsigned int *itgrl32Ptr = integralImg.ptr<unsigned int>();
-
-    for (int rIdx = 0; rIdx < src.rows; rIdx++) {
-        auto *blurPtr = blurImg.ptr<unsigned char>(rIdx); // assuming unsigned char
-        const float *depthPtr = depthImg.ptr<float>(rIdx);
-        const unsigned char *srcPtr = src.ptr<unsigned char>(rIdx);
-
-        for (int cIdx = 0; cIdx < src.cols; cIdx++) {
-            // kernel size depends on the distance transform, the user selected
-            // float dpv = depthPtr[cIdx];
-            float ksf = depthPtr[cIdx] * maxKernel * 0.5f;
-
-            // if (!ks) {
-            //	blurPtr[cIdx] = srcPtr[cIdx];
-            //	continue;
-            // }
-
-            int ks = qRound(ksf);
-            if (ksf > 0 && ksf < 2)
-                ks = 2;
-            else if (ks == 0) { // early skip
-                blurPtr[cIdx] = srcPtr[cIdx];
-                continue;
-            }
-
-            // clip all coordinates
-            int left = qMax(cIdx - ks, 0);
-            int right = qMin(cIdx + ks + 1, src.cols); // note not cols-1 since integral mImg is src.cols+1
-            int bottom = qMax(rIdx - ks, 0); // note top bottom is flipped since -y coords
-            int top = qMin(rIdx + ks + 1, src.rows);
-            int area = (right - left) * (top - bottom);
-
-            top *= integralImg.cols;
-            bottom *= integralImg.cols;
-
-            float tmp = 0.0f;
-
-            // compute mean kernel
-            if (area && itgrl32Ptr && ks > 1)
-                tmp = (float)(*(itgrl32Ptr + top + right) + *(itgrl32Ptr + bottom + left) - *(itgrl32Ptr + top + left)
-                              - *(itgrl32Ptr + bottom + right))
-                    / area;
-            else
-                tmp = srcPtr[cIdx];
-
-            if (tmp < 0)
-                tmp = 0.0f;
-            if (tmp > 255)
-                tmp = 255.0f;
-
-            blurPtr[cIdx] = (uchar)qRound(tmp);
-        }
-    }
-
-    return blurImg;
-}
-#endif
-
 /**
  * on button ok pressed event
  **/
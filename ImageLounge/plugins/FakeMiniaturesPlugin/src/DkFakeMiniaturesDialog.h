@@ -99,10 +99,6 @@ protected:
     void createLayout();
     void showEvent(QShowEvent *event) override;
     void createImgPreview();
-
-#ifdef WITH_OPENCV
-    cv::Mat blurPanTilt(cv::Mat src, cv::Mat depthImg, int maxKernel);
-#endif
 };
 
 class DkPreviewLabel : public QLabel
@@ -0,0 +1,169 @@
+/*******************************************************************************************************
+ DkPanTiltBlur.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2012 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2012 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2012 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkPanTiltBlur.h"
+
+#ifdef WITH_OPENCV
+#include "DkImageProc.h"
+
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace nmp
+{
+
+using nmc::DkWorkRange;
+
+namespace
+{
+
+int distance(int v, int first, int last)
+{
+    return qMax(qMax(first - v, v - last), 0);
+}
+
+/**
+ * computes the integral image of channel c
+ * rows are summed in parallel first, then column slices are accumulated top to bottom
+ **/
+template<typename T>
+void integral(const cv::Mat &src, int c, std::vector<T> &itgrl)
+{
+    const int cn = src.channels();
+    const size_t stride = src.cols + 1;
+
+    std::fill_n(itgrl.begin(), stride, T(0));
+
+    auto rows = DkWorkRange{0, src.rows}.partition();
+    QtConcurrent::blockingMap(rows, [&](const DkWorkRange &slice) {
+        for (int rIdx = slice.begin; rIdx < slice.end; rIdx++) {
+            const unsigned char *srcPtr = src.ptr<unsigned char>(rIdx) + c;
+            T *itgrlPtr = itgrl.data() + (rIdx + 1) * stride;
+
+            T sum = 0;
+            itgrlPtr[0] = 0;
+            for (int cIdx = 0; cIdx < src.cols; cIdx++) {
+                sum += srcPtr[cIdx * cn];
+                itgrlPtr[cIdx + 1] = sum;
+            }
+        }
+    });
+
+    auto cols = DkWorkRange{1, src.cols + 1}.partition();
+    QtConcurrent::blockingMap(cols, [&](const DkWorkRange &slice) {
+        for (int rIdx = 2; rIdx <= src.rows; rIdx++) {
+            T *itgrlPtr = itgrl.data() + rIdx * stride;
+            const T *prevPtr = itgrlPtr - stride;
+
+            for (int cIdx = slice.begin; cIdx < slice.end; cIdx++)
+                itgrlPtr[cIdx] += prevPtr[cIdx];
+        }
+    });
+}
+
+template<typename T>
+void blurPanTilt(const cv::Mat &src, cv::Mat &dst, const cv::Rect &focus, int maxKernel)
+{
+    const int cn = src.channels();
+    const size_t stride = src.cols + 1;
+
+    // the farthest pixel is in one of the corners
+    const int maxDist = qMax(qMax(focus.x, src.cols - focus.br().x), qMax(focus.y, src.rows - focus.br().y));
+    const float kernelScale = maxKernel * 0.5f / maxDist;
+
+    std::vector<T> itgrl(stride * (src.rows + 1));
+
+    for (int c = 0; c < cn; c++) {
+        integral(src, c, itgrl);
+
+        auto rows = DkWorkRange{0, src.rows}.partition();
+        QtConcurrent::blockingMap(rows, [&](const DkWorkRange &slice) {
+            for (int rIdx = slice.begin; rIdx < slice.end; rIdx++) {
+                const unsigned char *srcPtr = src.ptr<unsigned char>(rIdx) + c;
+                unsigned char *blurPtr = dst.ptr<unsigned char>(rIdx) + c;
+                const int rDist = distance(rIdx, focus.y, focus.br().y - 1);
+
+                for (int cIdx = 0; cIdx < src.cols; cIdx++) {
+                    const int dist = qMax(rDist, distance(cIdx, focus.x, focus.br().x - 1));
+                    const float ksf = dist * kernelScale;
+
+                    int ks = qRound(ksf);
+                    if (ksf > 0 && ksf < 2)
+                        ks = 2;
+                    else if (ks == 0) {
+                        blurPtr[cIdx * cn] = srcPtr[cIdx * cn];
+                        continue;
+                    }
+
+                    // clip all coordinates, the integral image has one more row & column
+                    const int left = qMax(cIdx - ks, 0);
+                    const int right = qMin(cIdx + ks + 1, src.cols);
+                    const int top = qMax(rIdx - ks, 0);
+                    const int bottom = qMin(rIdx + ks + 1, src.rows);
+                    const int area = (right - left) * (bottom - top);
+
+                    const T *topPtr = itgrl.data() + top * stride;
+                    const T *bottomPtr = itgrl.data() + bottom * stride;
+                    const T sum = bottomPtr[right] + topPtr[left] - bottomPtr[left] - topPtr[right];
+
+                    blurPtr[cIdx * cn] = cv::saturate_cast<unsigned char>(float(sum) / area);
+                }
+            }
+        });
+    }
+}
+
+}
+
+cv::Mat blurPanTilt(const cv::Mat &src, const cv::Rect &focus, int maxKernel)
+{
+    CV_Assert(src.depth() == CV_8U);
+
+    const cv::Rect f = focus & cv::Rect(0, 0, src.cols, src.rows);
+
+    // an empty focus has no distances, a focus covering the image has nothing to blur
+    if (f.empty() || f.size() == src.size() || maxKernel <= 0)
+        return src.clone();
+
+    cv::Mat blurImg(src.size(), src.type());
+
+    // images with an area below ~4000x4000 can be computed using 32 bit
+    const double maxSum = double(src.rows) * src.cols * std::numeric_limits<unsigned char>::max();
+    if (maxSum <= std::numeric_limits<quint32>::max())
+        blurPanTilt<quint32>(src, blurImg, f, maxKernel);
+    else
+        blurPanTilt<quint64>(src, blurImg, f, maxKernel);
+
+    return blurImg;
+}
+
+}
+#endif
@@ -0,0 +1,51 @@
+/*******************************************************************************************************
+ DkPanTiltBlur.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2012 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2012 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2012 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#ifdef WITH_OPENCV
+#include "opencv2/core/core.hpp"
+#endif
+
+namespace nmp
+{
+
+#ifdef WITH_OPENCV
+/**
+ * tilt-shift blur: a mean filter whose kernel grows with the distance to the focus rectangle
+ * the distance is the (normalized) chessboard distance, i.e. what cv::distanceTransform with DIST_C computes
+ * rows are processed in parallel, integral images use 64 bit sums if 32 bit sums could overflow
+ * @param src 8 bit image with any number of channels
+ * @param focus the rectangle that stays sharp
+ * @param maxKernel kernel size at the pixels farthest from focus
+ * @return cv::Mat blurred image
+ **/
+cv::Mat blurPanTilt(const cv::Mat &src, const cv::Rect &focus, int maxKernel);
+#endif
+
+}
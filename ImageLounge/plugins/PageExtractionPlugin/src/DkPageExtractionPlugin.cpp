@@ -132,10 +132,10 @@ QSharedPointer<nmc::DkImageContainer> DkPageExtractionPlugin::runPlugin(
     if (!mRunIDs.contains(runID) || !imgC)
         return imgC;
 
-    cv::Mat img = nmc::DkImage::qImage2Mat(imgC->image());
     bool alternativeMethod = mMethod == m_bhaskar;
 
-    DkPageSegmentation segM(img, alternativeMethod);
+    // the page is searched at working resolution, so memory stays bounded for large batches
+    DkPageSegmentation segM(imgC->image(), alternativeMethod);
 
     // run the page segmentation
     nmc::DkTimer dt;
@@ -24,10 +24,12 @@
 
 #include "DkPageSegmentation.h"
 
+#include "DkImageStorage.h"
 #include "DkPageSegmentationUtils.h"
 
 #include <QPainter>
 #include <QPainterPath>
+#include <QtConcurrentMap>
 
 #include "opencv2/imgproc/imgproc.hpp"
 #if CV_MAJOR_VERSION >= 5
@@ -45,6 +47,19 @@ DkPageSegmentation::DkPageSegmentation(const cv::Mat &colImg /* = cv::Mat */, bo
     mImg = colImg;
 }
 
+DkPageSegmentation::DkPageSegmentation(const QImage &img, bool alternativeMethod /* = false */)
+    : mAlternativeMethod(alternativeMethod)
+{
+    mImgScale = workingScale(cv::Size(img.width(), img.height()));
+
+    // only the working resolution is converted
+    QImage wImg = img;
+    if (mImgScale != 1.0f)
+        wImg = nmc::DkImage::resizeImage(img, QSize(), mImgScale, nmc::DkImage::ipl_area, false);
+
+    mImg = nmc::DkImage::qImage2Mat(wImg);
+}
+
 cv::Mat DkPageSegmentation::getDebugImg() const
 {
     return mDbgImg; // is NULL if releaseDebug is DK_RELEASE_IMGS
@@ -78,131 +93,145 @@ QImage DkPageSegmentation::getCropped(const QImage &img) const
     return img; // no document page found
 }
 
+float DkPageSegmentation::workingScale(const cv::Size &size) const
+{
+    if (mAlternativeMethod && size.height > 700.0f)
+        return 700.0f / size.height;
+    else if (!mAlternativeMethod && 960.0f / size.width < 0.8f)
+        return 960.0f / size.width;
+
+    return 1.0f;
+}
+
 void DkPageSegmentation::compute()
 {
-    cv::Mat lImg;
-    if (mAlternativeMethod) {
-        if (mScale == 1.0f && mImg.rows > 700.0f)
-            mScale = 700.0f / mImg.rows;
+    if (mScale == 1.0f)
+        mScale = workingScale(mImg.size());
 
+    cv::Mat lImg;
+    if (mAlternativeMethod)
         lImg = findRectanglesAlternative(mImg, mRects);
+    else
+        lImg = findRectangles(mImg, mRects);
+
+    // back to the coordinates of the input image
+    if (mImgScale != 1.0f) {
+        for (DkPolyRect &r : mRects)
+            r.scale(1.0f / mImgScale);
+    }
+
+    qDebug() << "[DkPageSegmentation] " << mRects.size() << " rectangles circles found resize factor: " << mScale;
+}
+
+/**
+ * finds rectangles in a single color plane
+ * @param plane normalized color plane
+ * @param threshLevel 0 uses Canny, all other levels threshold the plane
+ **/
+std::vector<DkPolyRect> DkPageSegmentation::findRectanglesInPlane(const cv::Mat &plane, int threshLevel) const
+{
+    // areas are given for the input image
+    const float areaScale = mScale * mImgScale;
+
+    cv::Mat gray;
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<DkPolyRect> rects;
+
+    // hack: use Canny instead of zero threshold level.
+    // Canny helps to catch squares with gradient shading
+    if (threshLevel == 0) {
+        Canny(plane, gray, kThresh, kThresh * 3, 5);
+        // dilate canny output to remove potential
+        // holes between edge segments
+        dilate(gray, gray, cv::Mat(), cv::Point(-1, -1));
+
+        // DkIP::imwrite("edgeImg.png", gray);
     } else {
-        cv::Mat imgLab;
+        gray = plane >= (threshLevel + 1) * 255 / kNumThresh;
+    }
 
-        if (mScale == 1.0f && 960.0f / mImg.cols < 0.8f)
-            mScale = 960.0f / mImg.cols;
+    // find contours and store them all as a list
+    findContours(gray, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
 
-        cv::cvtColor(mImg, imgLab, cv::COLOR_RGB2Lab); // boost colors
-        lImg = findRectangles(mImg, mRects);
+    if (mLooseDetection) {
+        std::vector<std::vector<cv::Point>> hull;
+        for (int i = 0; i < (int)contours.size(); i++) {
+            double cArea = contourArea(cv::Mat(contours[i]));
+
+            if (fabs(cArea) > kMinArea * areaScale * areaScale
+                && (!kMaxArea || fabs(cArea) < kMaxArea * (areaScale * areaScale))) {
+                std::vector<cv::Point> cHull;
+                cv::convexHull(cv::Mat(contours[i]), cHull, false);
+                hull.push_back(cHull);
+            }
+        }
+
+        contours = hull;
     }
 
-    qDebug() << "[DkPageSegmentation] " << mRects.size() << " rectangles circles found resize factor: " << mScale;
+    std::vector<cv::Point> approx;
+
+    // test each contour
+    for (size_t i = 0; i < contours.size(); i++) {
+        // approxicv::Mate contour with accuracy proportional
+        // to the contour perimeter
+        approxPolyDP(cv::Mat(contours[i]), approx, arcLength(cv::Mat(contours[i]), true) * 0.02, true);
+
+        double cArea = contourArea(cv::Mat(approx));
+
+        // square contours should have 4 vertices after approxicv::Mation
+        // relatively large area (to filter out noisy contours)
+        // and be convex.
+        // Note: absolute value of an area is used because
+        // area may be positive or negative - in accordance with the
+        // contour orientation
+        if (approx.size() == 4 && fabs(cArea) > kMinArea * areaScale * areaScale
+            && (!kMaxArea || fabs(cArea) < kMaxArea * areaScale * areaScale) && isContourConvex(cv::Mat(approx))) {
+            DkPolyRect cr(approx);
+
+            // if cosines of all angles are small
+            // (all angles are ~90 degree)
+            if (/*cr.maxSide() < std::max(tImg.rows, tImg.cols)*maxSideFactor && */
+                (!kMaxSide || cr.maxSide() < kMaxSide * areaScale) && cr.getMaxCosine() < 0.3) {
+                rects.push_back(cr);
+            }
+        }
+    }
+
+    return rects;
 }
 
 cv::Mat DkPageSegmentation::findRectangles(const cv::Mat &img, std::vector<DkPolyRect> &rects) const
 {
-    cv::Mat tImg, gray;
+    cv::Mat tImg;
 
     if (mScale != 1.0f)
         cv::resize(img, tImg, cv::Size(), mScale, mScale, cv::INTER_AREA); // inter nn -> assuming resize to be 1/(2^n)
     else
         tImg = img;
 
-    std::vector<std::vector<cv::Point>> contours;
-
-    cv::Mat gray0(tImg.size(), CV_8UC1);
-    cv::Mat lImg(tImg.size(), CV_8UC1);
-
     // find squares in every color plane of the image
+    std::vector<cv::Mat> planes(3);
     for (int c = 0; c < 3; c++) {
         int ch[] = {c, 0};
-        mixChannels(&tImg, 1, &gray0, 1, ch, 1);
-        cv::normalize(gray0, gray0, 255, 0, cv::NORM_MINMAX);
-
-        if (c == 0) // back-up the luminance channel - we use it as precomputed image for the circle detection
-            lImg = gray0.clone();
-
-        int nT = kNumThresh; //(c == 0) ? numThresh*2 : numThresh;	// more luminance thresholds
-
-        // try several threshold levels
-        for (int l = 0; l < nT; l++) {
-            // hack: use Canny instead of zero threshold level.
-            // Canny helps to catch squares with gradient shading
-            if (l == 0) {
-                Canny(gray0, gray, kThresh, kThresh * 3, 5);
-                // dilate canny output to remove potential
-                // holes between edge segments
-                dilate(gray, gray, cv::Mat(), cv::Point(-1, -1));
-
-                // DkIP::imwrite("edgeImg.png", gray);
-            } else {
-                gray = gray0 >= (l + 1) * 255 / kNumThresh;
-            }
-
-            // find contours and store them all as a list
-            findContours(gray, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
-
-            if (mLooseDetection) {
-                std::vector<std::vector<cv::Point>> hull;
-                for (int i = 0; i < (int)contours.size(); i++) {
-                    double cArea = contourArea(cv::Mat(contours[i]));
+        planes[c] = cv::Mat(tImg.size(), CV_8UC1);
+        mixChannels(&tImg, 1, &planes[c], 1, ch, 1);
+        cv::normalize(planes[c], planes[c], 255, 0, cv::NORM_MINMAX);
+    }
 
-                    if (fabs(cArea) > kMinArea * mScale * mScale
-                        && (!kMaxArea || fabs(cArea) < kMaxArea * (mScale * mScale))) {
-                        std::vector<cv::Point> cHull;
-                        cv::convexHull(cv::Mat(contours[i]), cHull, false);
-                        hull.push_back(cHull);
-                    }
-                }
+    // try several threshold levels, all planes and levels are independent
+    QVector<int> levels;
+    for (int idx = 0; idx < 3 * kNumThresh; idx++)
+        levels << idx;
 
-                contours = hull;
-            }
+    const QVector<std::vector<DkPolyRect>> levelRects = QtConcurrent::blockingMapped<QVector<std::vector<DkPolyRect>>>(
+        levels,
+        [&](int idx) {
+            return findRectanglesInPlane(planes[idx / kNumThresh], idx % kNumThresh);
+        });
 
-            std::vector<cv::Point> approx;
-
-            // DEBUG ------------------------
-            // cv::Mat pImg = image.clone();
-            // cv::cvtColor(pImg, pImg, cv::COLOR_Lab2RGB);
-            // DEBUG ------------------------
-
-            // test each contour
-            for (size_t i = 0; i < contours.size(); i++) {
-                // approxicv::Mate contour with accuracy proportional
-                // to the contour perimeter
-                approxPolyDP(cv::Mat(contours[i]), approx, arcLength(cv::Mat(contours[i]), true) * 0.02, true);
-
-                double cArea = contourArea(cv::Mat(approx));
-
-                // DEBUG ------------------------
-                // if (fabs(cArea) < mMaxArea)
-                //	fillConvexPoly(pImg, &approx[0], (int)approx.size(), DkUtils::blue);
-                // DEBUG ------------------------
-
-                // square contours should have 4 vertices after approxicv::Mation
-                // relatively large area (to filter out noisy contours)
-                // and be convex.
-                // Note: absolute value of an area is used because
-                // area may be positive or negative - in accordance with the
-                // contour orientation
-                if (approx.size() == 4 && fabs(cArea) > kMinArea * mScale * mScale
-                    && (!kMaxArea || fabs(cArea) < kMaxArea * mScale * mScale) && isContourConvex(cv::Mat(approx))) {
-                    DkPolyRect cr(approx);
-                    // moutc << mMinArea*scale*scale << " < " << fabs(cArea) << " < " << mMaxArea*scale*scale << dkendl;
-
-                    // if cosines of all angles are small
-                    // (all angles are ~90 degree)
-                    if (/*cr.maxSide() < std::max(tImg.rows, tImg.cols)*maxSideFactor && */
-                        (!kMaxSide || cr.maxSide() < kMaxSide * mScale) && cr.getMaxCosine() < 0.3) {
-                        rects.push_back(cr);
-                    }
-                }
-            }
-            // DEBUG ------------------------
-            // cv::cvtColor(pImg, pImg, cv::COLOR_RGB2BGR);
-            // DkIP::imwrite("polyImg" + DkUtils::stringify(c) + "-" + DkUtils::stringify(l) + ".png", pImg);
-            // DEBUG ------------------------
-        }
-    }
+    for (const std::vector<DkPolyRect> &lr : levelRects)
+        rects.insert(rects.end(), lr.begin(), lr.end());
 
     for (size_t idx = 0; idx < rects.size(); idx++)
         rects[idx].scale(1.0f / mScale);
@@ -219,7 +248,8 @@ cv::Mat DkPageSegmentation::findRectangles(const cv::Mat &img, std::vector<DkPol
 
     rects = noLargeRects;
 
-    return lImg;
+    // back-up the luminance channel - we use it as precomputed image for the circle detection
+    return planes[0];
 }
 
 cv::Mat DkPageSegmentation::findRectanglesAlternative(const cv::Mat &img, std::vector<DkPolyRect> &rects) const
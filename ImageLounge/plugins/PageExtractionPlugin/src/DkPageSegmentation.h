@@ -36,6 +36,12 @@ class DkPageSegmentation
 {
 public:
     explicit DkPageSegmentation(const cv::Mat &colImg = cv::Mat(), bool alternativeMethod = false);
+
+    /**
+     * The image is downscaled to the working resolution before it is converted to cv::Mat.
+     * Rects are reported in img coordinates. Use this when pages are streamed in batch.
+     **/
+    explicit DkPageSegmentation(const QImage &img, bool alternativeMethod = false);
     virtual ~DkPageSegmentation() = default;
 
     virtual void compute();
@@ -69,9 +75,12 @@ protected:
 
     bool mLooseDetection = false;
     float mScale = 1.0f;
+    float mImgScale = 1.0f; // mImg was downscaled by this factor
     bool mAlternativeMethod = false;
     std::vector<DkPolyRect> mRects;
 
+    float workingScale(const cv::Size &size) const;
+    std::vector<DkPolyRect> findRectanglesInPlane(const cv::Mat &plane, int threshLevel) const;
     virtual cv::Mat findRectangles(const cv::Mat &img, std::vector<DkPolyRect> &squares) const;
     virtual cv::Mat findRectanglesAlternative(const cv::Mat &img, std::vector<DkPolyRect> &squares) const;
     QImage cropToRect(const QImage &img, const nmc::DkRotatingRect &rect, const QColor &bgCol = QColor(0, 0, 0)) const;
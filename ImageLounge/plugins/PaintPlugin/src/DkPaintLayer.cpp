@@ -0,0 +1,104 @@
+/*******************************************************************************************************
+ DkPaintLayer.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2012 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2012 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2012 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkPaintLayer.h"
+
+namespace nmp
+{
+
+/*-----------------------------------DkPaintLayer ---------------------------------------------*/
+
+void DkPaintLayer::reset(const QSize &size)
+{
+    mSize = size;
+    mTiles.clear();
+}
+
+QSize DkPaintLayer::size() const
+{
+    return mSize;
+}
+
+QRect DkPaintLayer::tileRect(const QPoint &tile) const
+{
+    return QRect(tile * tileSize, QSize(tileSize, tileSize)) & QRect(QPoint(), mSize);
+}
+
+QList<QPoint> DkPaintLayer::tiles(const QRect &rect) const
+{
+    const QRect r = rect & QRect(QPoint(), mSize);
+
+    QList<QPoint> tiles;
+    if (r.isEmpty())
+        return tiles;
+
+    for (int row = r.top() / tileSize; row <= r.bottom() / tileSize; row++) {
+        for (int col = r.left() / tileSize; col <= r.right() / tileSize; col++)
+            tiles << QPoint(col, row);
+    }
+
+    return tiles;
+}
+
+void DkPaintLayer::paint(const QRect &rect, const std::function<void(QPainter &)> &draw)
+{
+    for (const QPoint &t : tiles(rect)) {
+        const QRect tr = tileRect(t);
+
+        QImage &tile = mTiles[t];
+        if (tile.isNull()) {
+            tile = QImage(tr.size(), QImage::Format_ARGB32_Premultiplied);
+            tile.fill(Qt::transparent);
+        }
+
+        QPainter painter(&tile);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.translate(-tr.topLeft());
+        draw(painter);
+    }
+}
+
+QRect DkPaintLayer::clear(const QRect &rect)
+{
+    QRect cleared;
+    for (const QPoint &t : tiles(rect)) {
+        mTiles.remove(t);
+        cleared |= tileRect(t);
+    }
+
+    return cleared;
+}
+
+void DkPaintLayer::draw(QPainter &painter, const QRectF &rect) const
+{
+    for (const QPoint &t : tiles(rect.toAlignedRect())) {
+        auto tile = mTiles.constFind(t);
+        if (tile != mTiles.constEnd())
+            painter.drawImage(tileRect(t).topLeft(), *tile);
+    }
+}
+}
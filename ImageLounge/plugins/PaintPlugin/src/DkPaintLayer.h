@@ -0,0 +1,77 @@
+/*******************************************************************************************************
+ DkPaintLayer.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2012 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2012 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2012 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+
+#include <functional>
+
+namespace nmp
+{
+
+/**
+ * Rasterized strokes in image coordinates.
+ * Tiles are allocated when a stroke touches them, so drawing
+ * the layer does not depend on the number of strokes.
+ **/
+class DkPaintLayer
+{
+public:
+    void reset(const QSize &size = QSize());
+    QSize size() const;
+
+    /**
+     * Calls draw for every tile intersecting rect.
+     * The painter is set up for image coordinates.
+     **/
+    void paint(const QRect &rect, const std::function<void(QPainter &)> &draw);
+
+    /**
+     * Clears all tiles intersecting rect.
+     * @return the (tile aligned) area that was cleared
+     **/
+    QRect clear(const QRect &rect);
+
+    /**
+     * Draws all tiles intersecting rect (in image coordinates).
+     **/
+    void draw(QPainter &painter, const QRectF &rect) const;
+
+private:
+    static constexpr int tileSize = 256;
+
+    QRect tileRect(const QPoint &tile) const;
+    QList<QPoint> tiles(const QRect &rect) const;
+
+    QSize mSize;
+    QHash<QPoint, QImage> mTiles;
+};
+}
@@ -131,20 +131,26 @@ QLineF getShorterLine(QPainterPath line, const int thickness)
     return l.toLine();
 }
 
-// blur selected rectangle region
-void getBlur(const QRectF &selection, QPainter *painter, QImage &img, int radius, const QWidget *target)
+// snap the blur selection to pixels without jumping around
+QRect blurRect(const QRectF &selection)
 {
     if (selection.isEmpty())
-        return;
+        return {};
 
-    // snap to pixels without jumping around
     QPoint topLeft(qFloor(selection.left()), qFloor(selection.top()));
     QPoint botRight(qFloor(selection.right()), qFloor(selection.bottom()));
-    QRect selectionScaled{topLeft, botRight};
+    return QRect{topLeft, botRight};
+}
+
+// blur selected rectangle region
+QImage getBlur(const QRect &selection, const QImage &img, int radius, const QWidget *target)
+{
+    if (selection.isEmpty())
+        return {};
 
     // much faster to render into a subimage
     // also gives consistent result between preview and final image
-    QImage blurImg = img.copy(selectionScaled);
+    QImage blurImg = img.copy(selection);
     QPainter blurPainter(&blurImg);
 
     auto *item = new QGraphicsPixmapItem(QPixmap::fromImage(blurImg));
@@ -162,9 +168,7 @@ void getBlur(const QRectF &selection, QPainter *painter, QImage &img, int radius
 
     blurPainter.end();
 
-    blurImg = nmc::DkImage::convertToColorSpaceInPlace(target, blurImg);
-
-    painter->drawImage(selectionScaled, blurImg);
+    return nmc::DkImage::convertToColorSpaceInPlace(target, blurImg);
 }
 
 QSharedPointer<nmc::DkImageContainer> DkPaintPlugin::runPlugin(const QString &runID,
@@ -289,6 +293,23 @@ void DkPaintViewPort::undoLastPaint()
     mPaths.pop_back();
     mPathsPen.pop_back();
     mPathsMode.pop_back();
+
+    // the path was rasterized already, redraw the paths that overlap the cleared tiles
+    if (mPathsBounds.size() > mPaths.size()) {
+        auto *viewport = dynamic_cast<nmc::DkBaseViewPort *>(parent());
+        const QRect dirty = mLayer.clear(mPathsBounds.takeLast());
+        mPathsBlur.pop_back();
+
+        for (int idx = 0; idx < mPathsBounds.size(); idx++) {
+            const QRect r = mPathsBounds.at(idx) & dirty;
+            if (!r.isEmpty()) {
+                mLayer.paint(r, [&](QPainter &painter) {
+                    drawPath(painter, idx, viewport);
+                });
+            }
+        }
+    }
+
     update();
 }
 
@@ -427,45 +448,109 @@ void DkPaintViewPort::mouseReleaseEvent(QMouseEvent *event)
     setCursor(mCurrentCursor);
 }
 
-void DkPaintViewPort::drawPaths(QPainter &painter, nmc::DkBaseViewPort *viewport, bool toImage) const
-{
-    for (int idx = 0; idx < mPaths.size(); idx++) {
-        painter.setPen(mPathsPen.at(idx));
-        if (mPathsMode.at(idx) == mode_arrow) {
-            painter.fillPath(getArrowHead(mPaths.at(idx), mPathsPen.at(idx).width()),
-                             QBrush(mPathsPen.at(idx).color()));
-            painter.drawLine(getShorterLine(mPaths.at(idx), mPathsPen.at(idx).width()));
-        } else if (mPathsMode.at(idx) == mode_square_fill)
-            painter.fillPath(mPaths.at(idx), QBrush(mPathsPen.at(idx).color()));
-        else if (mPathsMode.at(idx) == mode_text) {
-            painter.fillPath(mPaths.at(idx), QBrush(mPathsPen.at(idx).color()));
-            if (!toImage && (idx == mPaths.size() - 1) && (mTextInputActive)) {
-                QPointF p = mPaths.at(idx).boundingRect().bottomRight();
-                painter.setPen(QPen(QBrush(QColor(0, 0, 0, 180)), mPathsPen.at(idx).width(), Qt::DotLine));
-                if (!mHasTextInput)
-                    painter.drawLine(QLineF(mBeginPos, mBeginPos - QPoint(0, mPathsPen.at(idx).width() * 10)));
-                else
-                    painter.drawLine(QLineF(p, p - QPoint(0, mPathsPen.at(idx).width() * 10)));
-            }
-        } else if (mPathsMode.at(idx) == mode_blur) {
-            QImage img = viewport->getImage();
-            QRectF rect = mPaths.at(idx).boundingRect();
-            getBlur(rect, &painter, img, mPathsPen.at(idx).width(), viewport);
-        } else {
-            painter.drawPath(mPaths.at(idx));
-        }
+void DkPaintViewPort::drawPath(QPainter &painter, int idx, nmc::DkBaseViewPort *viewport) const
+{
+    const QPainterPath &path = mPaths.at(idx);
+    const QPen &pen = mPathsPen.at(idx);
+
+    painter.setPen(pen);
+    switch (mPathsMode.at(idx)) {
+    case mode_arrow:
+        painter.fillPath(getArrowHead(path, pen.width()), QBrush(pen.color()));
+        painter.drawLine(getShorterLine(path, pen.width()));
+        break;
+    case mode_square_fill:
+    case mode_text:
+        painter.fillPath(path, QBrush(pen.color()));
+        break;
+    case mode_blur: {
+        // blurred regions of finished paths are computed once
+        const QRect rect = blurRect(path.boundingRect());
+        QImage blurImg;
+        if (idx < mPathsBlur.size())
+            blurImg = mPathsBlur.at(idx);
+        else if (viewport)
+            blurImg = getBlur(rect, viewport->getImage(), pen.width(), viewport);
+
+        if (!blurImg.isNull())
+            painter.drawImage(rect, blurImg);
+        break;
+    }
+    default:
+        painter.drawPath(path);
+        break;
     }
 }
 
-void DkPaintViewPort::paintEvent(QPaintEvent *event)
+void DkPaintViewPort::drawTextCursor(QPainter &painter) const
+{
+    if (!mTextInputActive || mPaths.empty() || mPathsMode.last() != mode_text)
+        return;
+
+    const int width = mPathsPen.last().width();
+    const QPointF p = mHasTextInput ? mPaths.last().boundingRect().bottomRight() : mBeginPos;
+
+    painter.setPen(QPen(QBrush(QColor(0, 0, 0, 180)), width, Qt::DotLine));
+    painter.drawLine(QLineF(p, p - QPoint(0, width * 10)));
+}
+
+QRect DkPaintViewPort::pathBounds(int idx) const
+{
+    const QPainterPath &path = mPaths.at(idx);
+    const QPen &pen = mPathsPen.at(idx);
+
+    QRectF bounds = path.boundingRect();
+    if (mPathsMode.at(idx) == mode_arrow)
+        bounds |= getArrowHead(path, pen.width()).boundingRect();
+
+    // pen, caps and antialiasing
+    const qreal margin = pen.widthF() + 1;
+    return bounds.adjusted(-margin, -margin, margin, margin).toAlignedRect();
+}
+
+/**
+ * rasterizes all paths that are not edited anymore
+ **/
+void DkPaintViewPort::updateLayer(nmc::DkBaseViewPort *viewport)
 {
-    Q_UNUSED(event)
+    const QImage img = viewport->getImage();
+
+    // blurred regions depend on the image
+    if (img.cacheKey() != mLayerImageKey || img.size() != mLayer.size()) {
+        mLayer.reset(img.size());
+        mLayerImageKey = img.cacheKey();
+        mPathsBounds.clear();
+        mPathsBlur.clear();
+    }
+
+    const bool editing = mMouseDown || mTextInputActive;
+    const int numFinished = editing ? mPaths.size() - 1 : mPaths.size();
+
+    for (int idx = mPathsBounds.size(); idx < numFinished; idx++) {
+        QImage blurImg;
+        if (mPathsMode.at(idx) == mode_blur)
+            blurImg = getBlur(blurRect(mPaths.at(idx).boundingRect()), img, mPathsPen.at(idx).width(), viewport);
 
+        mPathsBlur.append(blurImg);
+        mPathsBounds.append(pathBounds(idx));
+
+        mLayer.paint(mPathsBounds.last(), [&](QPainter &painter) {
+            drawPath(painter, idx, viewport);
+        });
+    }
+}
+
+void DkPaintViewPort::paintEvent(QPaintEvent *event)
+{
     auto *viewport = dynamic_cast<nmc::DkBaseViewPort *>(parent());
     if (!viewport)
         return;
 
+    updateLayer(viewport);
+
     QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
 
     // paths are in image coordinates, setup transform like DkViewPort::drawImage()
     painter.setWorldTransform(viewport->getImageMatrix() * viewport->getWorldMatrix());
@@ -473,7 +558,13 @@ void DkPaintViewPort::paintEvent(QPaintEvent *event)
     // this part gives us correct pixel sizes for lines, fonts, images etc
     painter.scale(1.0 / devicePixelRatioF(), 1.0 / devicePixelRatioF());
 
-    drawPaths(painter, viewport, false);
+    // only the visible tiles are drawn
+    mLayer.draw(painter, painter.worldTransform().inverted().mapRect(QRectF(event->rect())));
+
+    for (int idx = mPathsBounds.size(); idx < mPaths.size(); idx++)
+        drawPath(painter, idx, viewport);
+
+    drawTextCursor(painter);
 }
 
 QImage DkPaintViewPort::getPaintedImage()
@@ -484,6 +575,8 @@ QImage DkPaintViewPort::getPaintedImage()
     if (mPaths.empty())
         return {};
 
+    updateLayer(viewport);
+
     QImage img = viewport->getImage();
 
     // we edited in display/target color space, we must render the drawing in that space,
@@ -494,7 +587,11 @@ QImage DkPaintViewPort::getPaintedImage()
 
     QPainter painter(&img);
     painter.setRenderHint(QPainter::Antialiasing);
-    drawPaths(painter, viewport, true);
+    mLayer.draw(painter, img.rect());
+
+    for (int idx = mPathsBounds.size(); idx < mPaths.size(); idx++)
+        drawPath(painter, idx, viewport);
+
     painter.end();
 
     img.convertToColorSpace(srcColorSpace);
@@ -530,6 +627,7 @@ void DkPaintViewPort::textEditFinsh()
         undoLastPaint();
     mTextInputActive = false;
     emit editShowSignal(false);
+    update();
 }
 
 void DkPaintViewPort::clear()
@@ -537,6 +635,10 @@ void DkPaintViewPort::clear()
     mPaths.clear();
     mPathsPen.clear();
     mPathsMode.clear();
+
+    mLayer.reset();
+    mPathsBounds.clear();
+    mPathsBlur.clear();
 }
 
 void DkPaintViewPort::setBrush(const QBrush &brush)
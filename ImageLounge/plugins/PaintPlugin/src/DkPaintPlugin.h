@@ -34,6 +34,7 @@
 #include <QString>
 #include <QToolBar>
 
+#include "DkPaintLayer.h"
 #include "DkPluginInterface.h"
 
 class QSpinBox;
@@ -133,12 +134,20 @@ protected:
     void loadSettings();
     void saveSettings() const;
 
-    void drawPaths(QPainter &painter, nmc::DkBaseViewPort *viewport, bool toImage) const;
+    void drawPath(QPainter &painter, int idx, nmc::DkBaseViewPort *viewport) const;
+    void drawTextCursor(QPainter &painter) const;
+    QRect pathBounds(int idx) const;
+    void updateLayer(nmc::DkBaseViewPort *viewport);
 
     QVector<QPainterPath> mPaths; // list of paths, one per mouse down-drag-up cycle
     QVector<QPen> mPathsPen; // corresponding pen that was used for each path
     QVector<int> mPathsMode; // corresponding mode that was used for each path
 
+    DkPaintLayer mLayer; // finished paths, the last path is drawn directly while it is edited
+    qint64 mLayerImageKey = 0; // image the layer was rendered for
+    QVector<QRect> mPathsBounds; // bounds of each path in mLayer
+    QVector<QImage> mPathsBlur; // blurred region of each mode_blur path in mLayer
+
     QPointF mBeginPos; // starting position of a new painter path (mouse down location mapped to image)
     bool mHasTextInput;
 
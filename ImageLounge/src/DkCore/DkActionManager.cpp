@@ -96,10 +96,8 @@ DkAppManager::DkAppManager(QWidget *parent)
     if (mFirstTime)
         findDefaultSoftware();
 
-    for (int idx = 0; idx < mApps.size(); idx++) {
-        assignIcon(mApps.at(idx));
+    for (int idx = 0; idx < mApps.size(); idx++)
         connect(mApps.at(idx), &QAction::triggered, this, &DkAppManager::openTriggered);
-    }
 }
 
 DkAppManager::~DkAppManager()
@@ -175,12 +173,24 @@ QAction *DkAppManager::createAction(const QString &filePath)
 
     auto *newApp = new QAction(file.baseName(), parent());
     newApp->setToolTip(QDir::fromNativeSeparators(file.filePath()));
-    assignIcon(newApp);
+    if (mIconsAssigned)
+        assignIcon(newApp);
     connect(newApp, &QAction::triggered, this, &DkAppManager::openTriggered);
 
     return newApp;
 }
 
+void DkAppManager::assignIcons()
+{
+    if (mIconsAssigned)
+        return;
+
+    for (QAction *app : std::as_const(mApps))
+        assignIcon(app);
+
+    mIconsAssigned = true;
+}
+
 QAction *DkAppManager::findAction(const QString &appPath) const
 {
     for (int idx = 0; idx < mApps.size(); idx++) {
@@ -422,6 +432,8 @@ QMenu *DkActionManager::createFileMenu(QWidget *parent /* = 0 */)
 QMenu *DkActionManager::createOpenWithMenu(QWidget *parent)
 {
     mOpenWithMenu = new QMenu(QObject::tr("&Open With"), parent);
+    QObject::connect(mOpenWithMenu, &QMenu::aboutToShow, mAppManager, &DkAppManager::assignIcons);
+
     return updateOpenWithMenu();
 }
 
@@ -566,6 +578,7 @@ QMenu *DkActionManager::createPanelMenu(QWidget *parent)
     mPanelMenu->addAction(mPanelActions[menu_panel_metadata_dock]);
     mPanelMenu->addAction(mPanelActions[menu_panel_exif]);
     mPanelMenu->addAction(mPanelActions[menu_panel_history]);
+    mPanelMenu->addAction(mPanelActions[menu_panel_pages]);
     mPanelMenu->addAction(mPanelActions[menu_panel_preview]);
     mPanelMenu->addAction(mPanelActions[menu_panel_thumbview]);
     mPanelMenu->addAction(mPanelActions[menu_panel_scroller]);
@@ -1320,6 +1333,10 @@ void DkActionManager::createActions(QWidget *parent)
     mPanelActions[menu_panel_history]->setShortcut(QKeySequence(shortcut_show_history));
     mPanelActions[menu_panel_history]->setCheckable(true);
 
+    mPanelActions[menu_panel_pages] = new QAction(QObject::tr("&Pages"), parent);
+    mPanelActions[menu_panel_pages]->setStatusTip(QObject::tr("Shows the pages of multi-page images"));
+    mPanelActions[menu_panel_pages]->setCheckable(true);
+
     mPanelActions[menu_panel_log] = new QAction(QObject::tr("Show &Log"), parent);
     mPanelActions[menu_panel_log]->setStatusTip(QObject::tr("Shows the log window"));
     mPanelActions[menu_panel_log]->setShortcut(QKeySequence(shortcut_show_log));
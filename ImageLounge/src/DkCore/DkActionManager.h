@@ -58,6 +58,11 @@ public:
     QAction *createAction(const QString &filePath);
     QAction *findAction(const QString &appPath) const;
 
+    /**
+     * Extracts the application icons, this is deferred until the apps are shown.
+     **/
+    void assignIcons();
+
     enum defaultAppIdx {
         app_photohsop,
         app_picasa,
@@ -89,6 +94,7 @@ protected:
     QVector<QString> mDefaultNames;
     QVector<QAction *> mApps;
     bool mFirstTime = true;
+    bool mIconsAssigned = false;
 };
 
 class DllCoreExport DkActionManager
@@ -193,6 +199,7 @@ public:
         menu_panel_metadata_dock,
         menu_panel_comment,
         menu_panel_history,
+        menu_panel_pages,
         menu_panel_log,
 
         menu_panel_end,
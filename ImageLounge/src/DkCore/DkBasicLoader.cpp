@@ -27,10 +27,13 @@
 
 #include "DkBasicLoader.h"
 
+#include "DkImageCache.h"
 #include "DkImageContainer.h"
 #include "DkImageStorage.h"
 #include "DkMetaData.h"
 #include "DkSettings.h"
+#include "DkSharedImage.h"
+#include "DkTiffPageIndex.h"
 #include "DkTimer.h"
 
 #include <QBuffer>
@@ -43,6 +46,8 @@
 #include <QNetworkReply>
 #include <QObject>
 #include <QRegularExpression>
+#include <QSet>
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 
 #include <qmath.h>
@@ -77,11 +82,125 @@
 #include "qpsdhandler.h"
 #endif // Q_OS_WIN
 
+#include <atomic>
+#include <cstring>
 #include <memory>
+#include <numeric>
 #include <utility>
 
 namespace nmc
 {
+// DkPackedImage --------------------------------------------------------------------
+
+DkPackedImage::DkPackedImage(const QImage &img, const QImage &base)
+    : mSize(img.size())
+    , mFormat(img.format())
+    , mBytesPerLine(img.bytesPerLine())
+    , mColorTable(img.colorTable())
+    , mColorSpace(img.colorSpace())
+{
+    if (base.size() == mSize && base.format() == mFormat && base.bytesPerLine() == mBytesPerLine)
+        mBase = base;
+
+    mStrips.resize((mSize.height() + stripHeight - 1) / stripHeight);
+
+    QList<int> strips(mStrips.size());
+    std::iota(strips.begin(), strips.end(), 0);
+
+    // level 1 is several times faster than the default and compresses edited photos almost as well
+    QByteArray *dst = mStrips.data();
+    QtConcurrent::blockingMap(strips, [&](int strip) {
+        if (sameStrip(img, strip))
+            return;
+
+        int y0 = strip * stripHeight;
+        int rows = qMin(stripHeight, mSize.height() - y0);
+        const auto *data = reinterpret_cast<const char *>(img.constScanLine(y0));
+        dst[strip] = qCompress(QByteArray::fromRawData(data, rows * mBytesPerLine), 1);
+    });
+
+    for (const QByteArray &strip : std::as_const(mStrips))
+        mBytes += strip.size();
+}
+
+bool DkPackedImage::sameStrip(const QImage &img, int strip) const
+{
+    if (mBase.isNull())
+        return false;
+
+    int y0 = strip * stripHeight;
+    int rows = qMin(stripHeight, mSize.height() - y0);
+
+    return memcmp(img.constScanLine(y0), mBase.constScanLine(y0), rows * mBytesPerLine) == 0;
+}
+
+QImage DkPackedImage::unpack() const
+{
+    QImage img(mSize, mFormat);
+    if (img.isNull() || img.bytesPerLine() != mBytesPerLine) {
+        qWarning() << "[DkPackedImage] cannot restore image of size" << mSize;
+        return QImage();
+    }
+
+    img.setColorTable(mColorTable);
+    img.setColorSpace(mColorSpace);
+
+    QList<int> strips(mStrips.size());
+    std::iota(strips.begin(), strips.end(), 0);
+
+    uchar *bits = img.bits();
+    std::atomic<bool> corrupt = false;
+    QtConcurrent::blockingMap(strips, [&](int strip) {
+        int y0 = strip * stripHeight;
+        int rows = qMin(stripHeight, mSize.height() - y0);
+        uchar *dst = bits + y0 * mBytesPerLine;
+
+        if (mStrips[strip].isNull()) {
+            memcpy(dst, mBase.constScanLine(y0), rows * mBytesPerLine);
+            return;
+        }
+
+        QByteArray data = qUncompress(mStrips[strip]);
+        if (data.size() != rows * mBytesPerLine) {
+            corrupt = true;
+            return;
+        }
+
+        memcpy(dst, data.constData(), data.size());
+    });
+
+    if (corrupt) {
+        qWarning() << "[DkPackedImage] cannot restore image, a strip is corrupt";
+        return QImage();
+    }
+
+    return img;
+}
+
+qint64 DkPackedImage::size() const
+{
+    return mBytes;
+}
+
+int DkPackedImage::numStrips() const
+{
+    return mStrips.size();
+}
+
+QByteArray DkPackedImage::strip(int idx) const
+{
+    return mStrips.value(idx);
+}
+
+void DkPackedImage::setStrip(int idx, const QByteArray &data)
+{
+    if (idx < 0 || idx >= mStrips.size())
+        return;
+
+    mBytes += data.size() - mStrips[idx].size();
+    mStrips[idx] = data;
+}
+
 // DkEditImage --------------------------------------------------------------------
 
 DkEditImage::DkEditImage()
@@ -106,7 +225,7 @@ DkEditImage::DkEditImage(const Edits &edits,
 bool DkEditImage::hasImage() const
 {
     // Every edit item has an image, but it may be the old/original one if only metadata has been edited
-    return !mImg.isNull();
+    return mPacked || !mImg.isNull();
 }
 
 bool DkEditImage::hasMetaData() const
@@ -130,13 +249,33 @@ bool DkEditImage::hasNewMetaData() const
 void DkEditImage::setImage(const QImage &img)
 {
     mImg = img;
+    mPacked.reset();
 }
 
 QImage DkEditImage::image() const
 {
+    if (mPacked)
+        return mPacked->unpack();
+
     return mImg;
 }
 
+void DkEditImage::setPacked(const QSharedPointer<DkPackedImage> &packed)
+{
+    mPacked = packed;
+    mImg = QImage();
+}
+
+QSharedPointer<DkPackedImage> DkEditImage::packed() const
+{
+    return mPacked;
+}
+
+bool DkEditImage::isPacked() const
+{
+    return !mPacked.isNull();
+}
+
 QSharedPointer<DkMetaDataT> DkEditImage::metaData() const
 {
     return mMetaData;
@@ -149,7 +288,10 @@ QString DkEditImage::editName() const
 
 int DkEditImage::size() const
 {
-    return qRound(DkImage::getBufferSizeFloat(mImg.size(), mImg.depth()));
+    if (mPacked)
+        return qRound(mPacked->size() / (1024.0 * 1024.0));
+
+    return qRound(mImg.sizeInBytes() / (1024.0 * 1024.0));
 }
 
 // Basic loader and image edit class --------------------------------------------------------------------
@@ -202,6 +344,38 @@ bool DkBasicLoader::isOrientationMirrored(const QImageIOHandler::Transformations
     return false;
 }
 
+int DkBasicLoader::cacheVariant(DkLoadOptions options)
+{
+    int variant = options.testFlag(DkLoadOption::fast) ? 0x1 : 0;
+    variant |= options.testFlag(DkLoadOption::metadata) ? 0x2 : 0;
+    variant |= options.testFlag(DkLoadOption::untransformed) ? 0x4 : 0;
+    variant |= DkSettingsManager::param().metaData().ignoreExifOrientation ? 0x8 : 0;
+    variant |= DkSettingsManager::param().resources().loadRawThumb << 4;
+
+    return variant;
+}
+
+DkImageCache::Entry DkBasicLoader::cacheEntry() const
+{
+    DkImageCache::Entry entry;
+    entry.image = pixmap();
+    entry.editName = lastEdit().editName();
+    entry.numPages = mNumPages;
+    entry.pageIdx = mPageIdx;
+    entry.ignoredOrientation = mFlags.testFlag(Flag::ignored_orientation);
+
+    return entry;
+}
+
+bool DkBasicLoader::publishImage() const
+{
+    // edits are not part of the key
+    if (!mCacheKey.isValid() || !hasImage() || isImageEdited())
+        return false;
+
+    return DkSharedImage::instance().publish(mCacheKey, cacheEntry());
+}
+
 bool DkBasicLoader::loadGeneral(const QString &filePath, DkLoadOptions options)
 {
     return loadGeneral(filePath, QSharedPointer<QByteArray>(), options);
@@ -237,11 +411,6 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArr
     // reset edit history and metadata
     release();
 
-    // tiff page handler
-    if (mPageIdxDirty)
-        if (loadPage())
-            loader = "page";
-
     // mMetaData can never be null due to release()
     Q_ASSERT(mMetaData);
 
@@ -253,9 +422,46 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArr
         // collect all file info now and save it in metadata, we won't have
         // to do a slow fetch when displaying metadata panels
         origFileInfo.stat();
+        mMetaData->setUseSidecar(DkSettingsManager::param().metaData().useXmpSidecar && !origFileInfo.isFromZip());
         mMetaData->readMetaData(origFileInfo, ba);
     }
 
+    // another tab might have decoded this image already
+    DkImageCache::Key cacheKey;
+    if ((options & DkLoadOption::cached) && !(options & DkLoadOption::source)) {
+        int page = mPageIdxDirty ? mPageIdx : 0;
+        cacheKey = DkImageCache::key(fileInfo, page, cacheVariant(options));
+    }
+
+    DkImageCache::Entry cached;
+    bool found = DkImageCache::instance().find(cacheKey, cached);
+
+    // or a synchronized instance
+    if (!found && DkSharedImage::instance().find(cacheKey, cached)) {
+        DkImageCache::instance().insert(cacheKey, cached);
+        found = true;
+    }
+
+    if (found) {
+        mMetaData->setQtValues(cached.image);
+        setEditImage(cached.image, cached.editName);
+        if (cached.ignoredOrientation)
+            mFlags |= Flag::ignored_orientation;
+
+        mNumPages = cached.numPages;
+        mPageIdx = cached.pageIdx;
+        mPageIdxDirty = false;
+        mCacheKey = cacheKey;
+
+        qInfo().noquote() << QStringLiteral("[Loader::cache] \"%1\" %2ms").arg(fileInfo.fileName()).arg(dt.elapsed());
+        return true;
+    }
+
+    // tiff page handler
+    if (mPageIdxDirty)
+        if (loadPage())
+            loader = "page";
+
     static const QList<QByteArray> qtFormats = QImageReader::supportedImageFormats();
     static const QList<QByteArray> drifFormats{"drif", "yuv", "raw"};
     static const QList<QByteArray> rawFormats{"nef",
@@ -404,7 +610,7 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArr
 
     // tiff things
     if (!loader.isNull() && !mPageIdxDirty)
-        indexPages(mFile, ba);
+        indexPages(mFile);
     mPageIdxDirty = false;
 
     // copy QImage::text() data to DkMetaData
@@ -527,6 +733,11 @@ bool DkBasicLoader::loadGeneral(const QString &filePath, QSharedPointer<QByteArr
                            .arg(transformType)
                            .arg(dt.elapsed());
         qInfo().noquote() << info;
+
+        if (cacheKey.isValid() && hasImage()) {
+            mCacheKey = cacheKey;
+            DkImageCache::instance().insert(cacheKey, cacheEntry());
+        }
     } else
         qWarning().noquote() << "[Loader]" << fileInfo.fileName() << mMetaData->getMimeType() << "failed to load";
 
@@ -949,12 +1160,6 @@ void DkBasicLoader::setEditImage(const QImage &img, const QString &editName)
     // delete all hidden edit states
     pruneEditHistory();
 
-    // compute new history size
-    int historySize = 0;
-    for (const DkEditImage &e : mImages) {
-        historySize += e.size();
-    }
-
     // reset exif orientation and thumbnail and after image edit
     if (!mImages.isEmpty()) {
         mMetaData->clearOrientation();
@@ -964,14 +1169,10 @@ void DkBasicLoader::setEditImage(const QImage &img, const QString &editName)
     // new history item with new pixmap (and old or original metadata)
     DkEditImage newImg(DkEditImage::EditType::data, img, mMetaData->copy(), editName);
 
-    if (historySize + newImg.size() > DkSettingsManager::param().resources().historyMemory
-        && mImages.size() > mMinHistorySize) {
-        mImages.removeAt(1);
-        qWarning() << "removing history image because it's too large:" << historySize + newImg.size() << "MB";
-    }
-
     mImages.append(newImg);
     mImageIndex = mImages.size() - 1; // set the index again to the last
+
+    compactHistory();
 }
 
 void DkBasicLoader::setEditMetaData(const QSharedPointer<DkMetaDataT> &metaData,
@@ -981,13 +1182,14 @@ void DkBasicLoader::setEditMetaData(const QSharedPointer<DkMetaDataT> &metaData,
     // delete all hidden edit states
     pruneEditHistory();
 
-    // not removing second history item if oversized (see setEditImage())
-
     // new history item with new metadata (and image, but hasNewImage() will be false)
+    // the image is usually shared with the previous item and does not cost memory
     DkEditImage newImg(DkEditImage::EditType::metadata, img, metaData->copy(), editName);
 
     mImages.append(newImg);
     mImageIndex = mImages.size() - 1; // set the index again to the last
+
+    compactHistory();
 }
 
 void DkBasicLoader::setEditMetaData(const QSharedPointer<DkMetaDataT> &metaData, const QString &editName)
@@ -1010,13 +1212,22 @@ QImage DkBasicLoader::lastImage() const
     // excluding history items with images that only have modified metadata,
     // for example, after rotating there'd be a history item with the rotated image
     // but this rotated pixmap is for the gui only, it should not be saved.
-    for (int idx = mImageIndex; idx >= 0; idx--) {
+    int idx = lastImageIndex();
+    if (idx < 0)
+        return QImage();
+
+    return mImages[idx].image();
+}
+
+int DkBasicLoader::lastImageIndex() const
+{
+    for (int idx = qMin(mImageIndex, int(mImages.size()) - 1); idx >= 0; idx--) {
         if (mImages[idx].hasNewImage()) {
-            return mImages[idx].image();
+            return idx;
         }
     }
 
-    return QImage();
+    return -1;
 }
 
 QImage DkBasicLoader::pixmap() const
@@ -1064,7 +1275,7 @@ QSharedPointer<DkMetaDataT> DkBasicLoader::lastMetaDataEdit() const
     return lastEdit;
 }
 
-bool DkBasicLoader::isImageEdited()
+bool DkBasicLoader::isImageEdited() const
 {
     for (int i = 1, ii = mImageIndex; i <= ii; i++) {
         if (mImages[i].hasNewImage()) {
@@ -1110,6 +1321,97 @@ int DkBasicLoader::historyIndex() const
     return mImageIndex;
 }
 
+qint64 DkBasicLoader::historyMemoryUsage() const
+{
+    QSet<qint64> buffers;
+    QSet<const DkPackedImage *> packed;
+    qint64 bytes = 0;
+
+    for (const DkEditImage &e : mImages) {
+        if (e.isPacked()) {
+            if (!packed.contains(e.packed().get())) {
+                packed.insert(e.packed().get());
+                bytes += e.packed()->size();
+            }
+        } else if (e.hasImage()) {
+            const QImage img = e.image();
+            if (!buffers.contains(img.cacheKey())) {
+                buffers.insert(img.cacheKey());
+                bytes += img.sizeInBytes();
+            }
+        }
+    }
+
+    return bytes;
+}
+
+void DkBasicLoader::compactHistory()
+{
+    const qint64 limit = qRound64(DkSettingsManager::param().resources().historyMemory * 1024.0 * 1024.0);
+    qint64 mem = historyMemoryUsage();
+
+    if (mem <= limit)
+        return;
+
+    DkTimer dt;
+
+    // the original is shared with other tabs (DkImageCache) and the base of all deltas
+    const QImage base = mImages.first().image();
+    QSet<qint64> keep{base.cacheKey(), pixmap().cacheKey(), lastImage().cacheKey()};
+    QHash<qint64, QSharedPointer<DkPackedImage>> packed;
+
+    // oldest states first, all items sharing a buffer get the same packed image
+    for (int idx = 1; idx < mImages.size(); idx++) {
+        DkEditImage &e = mImages[idx];
+        if (e.isPacked() || !e.hasImage())
+            continue;
+
+        const QImage img = e.image();
+        if (keep.contains(img.cacheKey()))
+            continue;
+
+        if (!packed.contains(img.cacheKey())) {
+            if (mem <= limit)
+                continue;
+
+            auto p = QSharedPointer<DkPackedImage>::create(img, base);
+            packed.insert(img.cacheKey(), p);
+            mem -= img.sizeInBytes() - p->size();
+        }
+
+        e.setPacked(packed.value(img.cacheKey()));
+    }
+
+    if (!packed.isEmpty())
+        qInfo() << "[History] compressed" << packed.size() << "states in" << dt;
+
+    // still too large: drop old states like we used to
+    while (mem > limit && mImages.size() > mMinHistorySize && lastImageIndex() > 1) {
+        mImages.removeAt(1);
+        mImageIndex--;
+        mem = historyMemoryUsage();
+        qWarning() << "removing history image because it's too large:" << mem / (1024 * 1024) << "MB";
+    }
+}
+
+bool DkBasicLoader::unpackHistory(int idx)
+{
+    if (idx < 0 || idx >= mImages.size() || !mImages[idx].isPacked())
+        return true;
+
+    const QSharedPointer<DkPackedImage> packed = mImages[idx].packed();
+    const QImage img = packed->unpack();
+    if (img.isNull())
+        return false;
+
+    for (DkEditImage &e : mImages) {
+        if (e.packed() == packed)
+            e.setImage(img);
+    }
+
+    return true;
+}
+
 void DkBasicLoader::setMinHistorySize(int size)
 {
     mMinHistorySize = size;
@@ -1122,8 +1424,16 @@ void DkBasicLoader::setHistoryIndex(int idx)
         return;
     }
 
+    // the displayed and the saveable states must not be decompressed on every access
+    if (!unpackHistory(idx)) {
+        qWarning() << "[DkBasicLoader] I cannot restore history state" << idx << "- keeping the current one";
+        return;
+    }
+
     // Change history index (for image()...)
     mImageIndex = idx;
+    unpackHistory(lastImageIndex());
+    compactHistory();
 
     // Get last history item with modified metadata (up until new history index)
     const QSharedPointer<DkMetaDataT> metaData = lastMetaDataEdit();
@@ -1158,6 +1468,9 @@ bool DkBasicLoader::writeBufferToFile(const QString &fileInfo, const QSharedPoin
     if (!ba || ba->isEmpty())
         return false;
 
+    // the file might be rewritten within the mtime resolution
+    DkImageCache::instance().remove(fileInfo);
+
     QFile file(fileInfo);
     if (!file.open(QIODevice::WriteOnly)) {
         qWarning() << "[DkBasicLoader] failed to open for writing:" << file.error() << file.errorString()
@@ -1174,79 +1487,16 @@ bool DkBasicLoader::writeBufferToFile(const QString &fileInfo, const QSharedPoin
     return true;
 }
 
-void DkBasicLoader::indexPages(const QString &filePath, const QSharedPointer<QByteArray> ba)
+void DkBasicLoader::indexPages(const QString &filePath)
 {
     // reset counters
     mNumPages = 1;
     mPageIdx = 1;
 
-#ifdef WITH_LIBTIFF
-
-    QFileInfo fInfo(filePath);
-
     // for now we just support tiff's
-    if (!fInfo.suffix().contains(QRegularExpression("(tif|tiff)", QRegularExpression::CaseInsensitiveOption)))
-        return;
-
-    // first turn off nasty warning/error dialogs - (we do the GUI : )
-    TIFFErrorHandler oldErrorHandler, oldWarningHandler;
-    oldWarningHandler = TIFFSetWarningHandler(nullptr);
-    oldErrorHandler = TIFFSetErrorHandler(nullptr);
-
-    DkTimer dt;
-    TIFF *tiff = nullptr;
-
-#if defined(Q_OS_WIN)
-    std::istringstream is(ba ? ba->toStdString() : "");
-
-    if (ba)
-        tiff = TIFFStreamOpen("MemTIFF", &is);
-
-    // read from file
-    if (!tiff)
-        tiff = TIFFOpen(filePath.toLatin1(), "r"); // this->mFile was here before - not sure why
-
-    // loading from buffer allows us to load files with non-latin names
-    QSharedPointer<QByteArray> bal;
-    if (!tiff)
-        bal = loadFileToBuffer(filePath);
-    ;
-    std::istringstream isl(bal ? bal->toStdString() : "");
-
-    if (bal)
-        tiff = TIFFStreamOpen("MemTIFF", &isl);
-#else
-    if (ba)
-        qWarning() << "[TIFF] Loading from buffer is unsupported";
-
-    tiff = TIFFOpen(filePath.toLatin1(), "r"); // this->mFile was here before - not sure why
-#endif
-
-    if (!tiff)
-        return;
-
-    // libtiff example
-    int dircount = 0;
-
-    do {
-        dircount++;
-
-    } while (TIFFReadDirectory(tiff));
-
-    mNumPages = dircount;
-
-    if (mNumPages > 1)
-        mPageIdx = 1;
-
-    qDebug() << dircount << " TIFF directories... " << dt;
-    TIFFClose(tiff);
-
-    TIFFSetWarningHandler(oldWarningHandler);
-    TIFFSetWarningHandler(oldErrorHandler);
-#else
-    Q_UNUSED(filePath)
-    Q_UNUSED(ba)
-#endif
+    auto index = DkTiffPageIndex::index(filePath);
+    if (index)
+        mNumPages = index->numPages();
 }
 
 bool DkBasicLoader::loadPage(int skipIdx)
@@ -1264,76 +1514,24 @@ bool DkBasicLoader::loadPage(int skipIdx)
 
 bool DkBasicLoader::loadPageAt(int pageIdx)
 {
-    bool imgLoaded = false;
-
-#ifdef WITH_LIBTIFF
-
     // <= 1 since first page is loaded using qt
     if (pageIdx > mNumPages || pageIdx < 1)
-        return imgLoaded;
+        return false;
 
-    // first turn off nasty warning/error dialogs - (we do the GUI : )
-    TIFFErrorHandler oldErrorHandler, oldWarningHandler;
-    oldWarningHandler = TIFFSetWarningHandler(nullptr);
-    oldErrorHandler = TIFFSetErrorHandler(nullptr);
+    // the index is cached, this does not walk the directories again
+    auto index = DkTiffPageIndex::index(mFile);
+    if (!index)
+        return false;
 
     DkTimer dt;
-    TIFF *tiff = TIFFOpen(mFile.toLatin1(), "r");
-
-#if defined(Q_OS_WIN)
-
-    // loading from buffer allows us to load files with non-latin names
-    QSharedPointer<QByteArray> ba;
-    if (!tiff)
-        ba = loadFileToBuffer(mFile);
-
-    std::istringstream is(ba ? ba->toStdString() : "");
-    if (ba)
-        tiff = TIFFStreamOpen("MemTIFF", &is);
-#endif
-
-    if (!tiff)
-        return imgLoaded;
-
-    uint32_t width = 0;
-    uint32_t height = 0;
-
-    // go to current directory
-    for (int idx = 1; idx < pageIdx; idx++) {
-        if (!TIFFReadDirectory(tiff))
-            return false;
-    }
-    TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
-    TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
-
-    // init the qImage
-    QImage img = QImage(width, height, QImage::Format_ARGB32);
-
-    const int stopOnError = 1;
-    imgLoaded = TIFFReadRGBAImageOriented(tiff,
-                                          width,
-                                          height,
-                                          reinterpret_cast<uint32_t *>(img.bits()),
-                                          ORIENTATION_TOPLEFT,
-                                          stopOnError)
-        != 0;
-
-    if (imgLoaded) {
-        for (uint32_t y = 0; y < height; ++y)
-            convert32BitOrder(img.scanLine(y), width);
-    }
-
-    TIFFClose(tiff);
-
-    TIFFSetWarningHandler(oldWarningHandler);
-    TIFFSetWarningHandler(oldErrorHandler);
+    QImage img = index->readPage(pageIdx);
+    if (img.isNull())
+        return false;
 
+    qDebug() << "[TIFF] page" << pageIdx << "loaded in" << dt;
     setEditImage(img, tr("Original Image"));
-#else
-    Q_UNUSED(pageIdx);
-#endif
 
-    return imgLoaded;
+    return true;
 }
 
 bool DkBasicLoader::setPageIdx(int skipIdx)
@@ -1410,11 +1608,13 @@ QString DkBasicLoader::save(const QString &filePath, const QImage &img, int comp
  * @param img image to be written to file buffer
  * @param ba in-memory file buffer containing resulting file
  * @param compression compression flag for QImageWriter
+ * @param metaData saved with the image instead of the loader's metadata, it is edited
  */
 bool DkBasicLoader::saveToBuffer(const QString &filePath,
                                  const QImage &img,
                                  QSharedPointer<QByteArray> &ba,
-                                 int compression) const
+                                 int compression,
+                                 QSharedPointer<DkMetaDataT> metaData) const
 {
     bool bufferCreated = false;
 
@@ -1424,7 +1624,8 @@ bool DkBasicLoader::saveToBuffer(const QString &filePath,
     }
     // copy current metadata object: mMetaData pointer may be reset in the background in the process
     // and then it won't be saved because !isLoaded()... [2022-08, pse]
-    QSharedPointer<DkMetaDataT> metaData = mMetaData;
+    if (!metaData)
+        metaData = mMetaData;
 
     bool saved = false;
 
@@ -1528,7 +1729,9 @@ void DkBasicLoader::saveThumbToMetaData(const QString &filePath, QSharedPointer<
  * @brief writes metadata to the file on disk, if it's marked as dirty
  *
  * This routine will write new metadata to the file on disk if metadata is marked dirty.
- * It does this by first loading the file into a buffer (unless a non-empty buffer is passed),
+ * If possible, only the metadata is written (see DkMetaDataT::saveMetaDataInPlace())
+ * and the now outdated buffer is cleared.
+ * Otherwise, it first loads the file into a buffer (unless a non-empty buffer is passed),
  * then it calls the MetaData module to save the exif data to that buffer
  * and finally, it writes the modified buffer to the file on disk.
  * The MetaData module has an overload which does basically the same thing.
@@ -1543,7 +1746,21 @@ void DkBasicLoader::saveMetaData(const QString &filePath, QSharedPointer<QByteAr
     if (!ba)
         ba = QSharedPointer<QByteArray>(new QByteArray());
 
-    if (ba->isEmpty() && mMetaData->isDirty()) {
+    if (!mMetaData->isDirty())
+        return;
+
+    // Leave the image data alone if the format allows it
+    try {
+        if (mMetaData->saveMetaDataInPlace(filePath)) {
+            // the buffer is shared with the container, it is read again when needed
+            ba->clear();
+            return;
+        }
+    } catch (...) {
+        qInfo() << "could not update metadata in place...";
+    }
+
+    if (ba->isEmpty()) {
         ba = loadFileToBuffer(filePath);
     }
 
@@ -1580,6 +1797,7 @@ void DkBasicLoader::release()
     mImages.clear(); // clear history
     mImageIndex = -1;
     mFlags = Flag::none;
+    mCacheKey = DkImageCache::Key();
 
     // Unload metadata
     mMetaData = QSharedPointer<DkMetaDataT>(new DkMetaDataT());
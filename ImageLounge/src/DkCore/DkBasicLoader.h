@@ -27,6 +27,7 @@
 
 #pragma once
 
+#include <QColorSpace>
 #include <QFutureWatcher>
 #include <QImageReader>
 #include <QNetworkAccessManager>
@@ -37,6 +38,7 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #endif
 
+#include "DkImageCache.h"
 #include "nmc_config.h"
 
 class QNetworkReply;
@@ -46,6 +48,47 @@ namespace nmc
 {
 class DkMetaDataT;
 
+/**
+ * Compressed pixels of a hidden history state.
+ *
+ * The image is split into strips of rows. Strips that equal the
+ * original image are not stored at all, so local edits (e.g. painting)
+ * cost little more than the region they changed.
+ **/
+class DllCoreExport DkPackedImage
+{
+public:
+    DkPackedImage(const QImage &img, const QImage &base);
+
+    /**
+     * Decompresses the pixels.
+     * @return a null image if a strip does not decompress to its size
+     **/
+    QImage unpack() const;
+    qint64 size() const;
+
+    /**
+     * Compressed rows of the image, null if they equal the base image.
+     **/
+    int numStrips() const;
+    QByteArray strip(int idx) const;
+    void setStrip(int idx, const QByteArray &data);
+
+private:
+    static constexpr int stripHeight = 64;
+
+    bool sameStrip(const QImage &img, int strip) const;
+
+    QImage mBase;
+    QSize mSize;
+    QImage::Format mFormat;
+    qsizetype mBytesPerLine;
+    QVector<QRgb> mColorTable;
+    QColorSpace mColorSpace;
+    QVector<QByteArray> mStrips; // null if equal to base
+    qint64 mBytes = 0;
+};
+
 class DllCoreExport DkEditImage
 {
 public:
@@ -71,9 +114,18 @@ public:
     QSharedPointer<DkMetaDataT> metaData() const;
     int size() const;
 
+    /**
+     * Replace the pixels with a compressed copy, image() decompresses it on every call.
+     * Entries sharing a buffer should share the packed image too.
+     **/
+    void setPacked(const QSharedPointer<DkPackedImage> &packed);
+    QSharedPointer<DkPackedImage> packed() const;
+    bool isPacked() const;
+
 protected:
     QSharedPointer<DkMetaDataT> mMetaData;
     QImage mImg;
+    QSharedPointer<DkPackedImage> mPacked;
     QString mEditName;
     bool mNewImg;
     bool mNewMetaData;
@@ -155,6 +207,7 @@ enum class DkLoadOption {
     metadata = 0x2, // Load metadata, needed for correct orientation & RAW preview
     untransformed = 0x4, // Disable any transformation (for embedded thumb generation)
     source = 0x8, // Always read original file data, no caches or conversions
+    cached = 0x10, // Share the decoded image with other loaders (see DkImageCache)
     normal = fast | metadata, // Reasonable default, settings may force-disable RAW preview
     highquality = metadata, // Highest quality, settings may force-enable RAW preview
 };
@@ -267,7 +320,8 @@ public:
     bool saveToBuffer(const QString &filePath,
                       const QImage &img,
                       QSharedPointer<QByteArray> &ba,
-                      int compression = -1) const;
+                      int compression = -1,
+                      QSharedPointer<DkMetaDataT> metaData = {}) const;
     void saveThumbToMetaData(const QString &filePath, QSharedPointer<QByteArray> &ba);
     void saveMetaData(const QString &filePath, QSharedPointer<QByteArray> &ba);
 
@@ -279,6 +333,12 @@ public:
 
     QSharedPointer<DkMetaDataT> getMetaData() const;
 
+    /**
+     * Hands the loaded image to synchronized instances (see DkSharedImage).
+     * Call it for the displayed image only, prefetched images would evict it.
+     **/
+    bool publishImage() const;
+
     /**
      * Return the last edit image (most recent edit), excluding metadata edits
      */
@@ -294,7 +354,7 @@ public:
         return pixmap();
     }
 
-    bool isImageEdited();
+    bool isImageEdited() const;
     bool isMetaDataEdited();
 
     /**
@@ -324,6 +384,11 @@ public:
     void setHistoryIndex(int idx);
     int historyIndex() const;
 
+    /**
+     * Bytes held by the edit history, shared buffers are counted once.
+     **/
+    qint64 historyMemoryUsage() const;
+
     static QSharedPointer<QByteArray> loadFileToBuffer(const QString &filePath);
     bool writeBufferToFile(const QString &fileInfo, const QSharedPointer<QByteArray> ba) const;
 
@@ -416,16 +481,24 @@ protected:
                  bool fast = false) const;
 
     /**
-     * Get page count for multi-page files (currently TIFF)
+     * Get page count for multi-page files (currently TIFF), see DkTiffPageIndex
      */
-    void indexPages(const QString &filePath, const QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
+    void indexPages(const QString &filePath);
 
     /**
      * Convert ARGB buffer to ABGR
      */
     void convert32BitOrder(void *buffer, uint32_t width) const;
 
+    /**
+     * Combines options and settings that change the decoded image into a DkImageCache key
+     */
+    static int cacheVariant(DkLoadOptions options);
+
+    DkImageCache::Entry cacheEntry() const;
+
     QString mFile;
+    DkImageCache::Key mCacheKey; // of the loaded image, invalid if it is not cacheable
     int mNumPages;
     int mPageIdx;
     bool mPageIdxDirty;
@@ -437,6 +510,14 @@ protected:
 
 private:
     QSharedPointer<DkMetaDataT> lastMetaDataEdit() const;
+    int lastImageIndex() const;
+
+    /**
+     * Compress hidden states until the history fits into Resources::historyMemory.
+     * Old states are only dropped if compression is not sufficient.
+     **/
+    void compactHistory();
+    bool unpackHistory(int idx);
 };
 
 namespace tga
@@ -0,0 +1,273 @@
+/*******************************************************************************************************
+ DkColorSimd.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkColorSimd.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DK_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DK_TARGET(isa) // msvc emits any intrinsic without target flags
+#else
+#define DK_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace nmc
+{
+
+namespace
+{
+
+void lumaScalar(const float *r, const float *g, const float *b, float *y, int n, const float *weights)
+{
+    const float wr = weights[0], wg = weights[1], wb = weights[2];
+    for (int i = 0; i < n; i++)
+        y[i] = wr * r[i] + wg * g[i] + wb * b[i];
+}
+
+void decodeScalar(const uint8_t *src, float *c0, float *c1, float *c2, int n, const float *lut)
+{
+    for (int i = 0; i < n; i++, src += 4) {
+        c0[i] = lut[src[0]];
+        c1[i] = lut[src[1]];
+        c2[i] = lut[src[2]];
+    }
+}
+
+void encodeScalar(const float *v, uint16_t *q, int n, const float *lut, int lutSize)
+{
+    const float scale = static_cast<float>(lutSize);
+    for (int i = 0; i < n; i++) {
+        float x = v[i] * scale;
+        x = x > 0.0f ? x : 0.0f; // also catches NaN
+        x = x < scale ? x : scale;
+
+        const int idx = static_cast<int>(x);
+        const float a = lut[idx];
+        q[i] = static_cast<uint16_t>(a + (x - idx) * (lut[idx + 1] - a) + 0.5f);
+    }
+}
+
+#ifdef DK_SIMD_X86
+
+DK_TARGET("sse4.1")
+void lumaSse41(const float *r, const float *g, const float *b, float *y, int n, const float *weights)
+{
+    const __m128 wr = _mm_set1_ps(weights[0]);
+    const __m128 wg = _mm_set1_ps(weights[1]);
+    const __m128 wb = _mm_set1_ps(weights[2]);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 sum = _mm_mul_ps(wr, _mm_loadu_ps(r + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(wg, _mm_loadu_ps(g + i)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(wb, _mm_loadu_ps(b + i)));
+        _mm_storeu_ps(y + i, sum);
+    }
+
+    lumaScalar(r + i, g + i, b + i, y + i, n - i, weights);
+}
+
+DK_TARGET("avx2,fma")
+void lumaAvx2(const float *r, const float *g, const float *b, float *y, int n, const float *weights)
+{
+    const __m256 wr = _mm256_set1_ps(weights[0]);
+    const __m256 wg = _mm256_set1_ps(weights[1]);
+    const __m256 wb = _mm256_set1_ps(weights[2]);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 sum = _mm256_mul_ps(wr, _mm256_loadu_ps(r + i));
+        sum = _mm256_fmadd_ps(wg, _mm256_loadu_ps(g + i), sum);
+        sum = _mm256_fmadd_ps(wb, _mm256_loadu_ps(b + i), sum);
+        _mm256_storeu_ps(y + i, sum);
+    }
+
+    lumaScalar(r + i, g + i, b + i, y + i, n - i, weights);
+}
+
+DK_TARGET("avx2,fma")
+void decodeAvx2(const uint8_t *src, float *c0, float *c1, float *c2, int n, const float *lut)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // x86 is little endian, byte k of a pixel is bits [8k, 8k + 8)
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 4 * i));
+        const __m256i i0 = _mm256_and_si256(px, mask);
+        const __m256i i1 = _mm256_and_si256(_mm256_srli_epi32(px, 8), mask);
+        const __m256i i2 = _mm256_and_si256(_mm256_srli_epi32(px, 16), mask);
+
+        _mm256_storeu_ps(c0 + i, _mm256_i32gather_ps(lut, i0, 4));
+        _mm256_storeu_ps(c1 + i, _mm256_i32gather_ps(lut, i1, 4));
+        _mm256_storeu_ps(c2 + i, _mm256_i32gather_ps(lut, i2, 4));
+    }
+
+    decodeScalar(src + 4 * i, c0 + i, c1 + i, c2 + i, n - i, lut);
+}
+
+// lambdas do not inherit the target attribute, hence the helper
+DK_TARGET("avx2,fma")
+inline __m256i encode8(const float *v, const float *lut, __m256 scale)
+{
+    __m256 x = _mm256_mul_ps(_mm256_loadu_ps(v), scale);
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), scale); // max returns zero for NaN
+
+    const __m256i idx = _mm256_cvttps_epi32(x);
+    const __m256 f = _mm256_sub_ps(x, _mm256_cvtepi32_ps(idx));
+    const __m256 a = _mm256_i32gather_ps(lut, idx, 4);
+    const __m256 b = _mm256_i32gather_ps(lut + 1, idx, 4);
+
+    // no fma, the result must match the scalar variant
+    const __m256 y = _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(b, a)));
+    return _mm256_cvttps_epi32(_mm256_add_ps(y, _mm256_set1_ps(0.5f)));
+}
+
+DK_TARGET("avx2,fma")
+void encodeAvx2(const float *v, uint16_t *q, int n, const float *lut, int lutSize)
+{
+    const __m256 s = _mm256_set1_ps(static_cast<float>(lutSize));
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // packus works per 128 bit lane, restore the order afterwards
+        __m256i packed = _mm256_packus_epi32(encode8(v + i, lut, s), encode8(v + i + 8, lut, s));
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(q + i), packed);
+    }
+
+    encodeScalar(v + i, q + i, n - i, lut, lutSize);
+}
+
+DkColorSimd::Isa cpuIsa()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse41 = info[2] & (1 << 19);
+    const bool fma = info[2] & (1 << 12);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+
+    bool avx2 = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = info[1] & (1 << 5);
+    }
+
+    // the OS must save the ymm registers too
+    const bool ymm = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports("sse4.1");
+    const bool fma = __builtin_cpu_supports("fma");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+    const bool ymm = true; // covered by __builtin_cpu_supports
+#endif
+
+    if (avx2 && fma && ymm)
+        return DkColorSimd::isa_avx2;
+    if (sse41)
+        return DkColorSimd::isa_sse41;
+
+    return DkColorSimd::isa_scalar;
+}
+
+#endif // DK_SIMD_X86
+
+}
+
+DkColorSimd::Isa DkColorSimd::detectIsa()
+{
+#ifdef DK_SIMD_X86
+    static const Isa isa = cpuIsa();
+    return isa;
+#else
+    return isa_scalar;
+#endif
+}
+
+bool DkColorSimd::isSupported(Isa isa)
+{
+    return isa >= isa_scalar && isa <= detectIsa();
+}
+
+DkColorSimd::LumaFn DkColorSimd::luma(Isa isa)
+{
+    if (!isSupported(isa))
+        isa = detectIsa();
+
+    switch (isa) {
+#ifdef DK_SIMD_X86
+    case isa_avx2:
+        return lumaAvx2;
+    case isa_sse41:
+        return lumaSse41;
+#endif
+    default:
+        return lumaScalar;
+    }
+}
+
+DkColorSimd::DecodeFn DkColorSimd::decode(Isa isa)
+{
+    if (!isSupported(isa))
+        isa = detectIsa();
+
+    switch (isa) {
+#ifdef DK_SIMD_X86
+    case isa_avx2:
+        return decodeAvx2;
+#endif
+    default:
+        return decodeScalar;
+    }
+}
+
+DkColorSimd::EncodeFn DkColorSimd::encode(Isa isa)
+{
+    if (!isSupported(isa))
+        isa = detectIsa();
+
+    switch (isa) {
+#ifdef DK_SIMD_X86
+    case isa_avx2:
+        return encodeAvx2;
+#endif
+    default:
+        return encodeScalar;
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+/*******************************************************************************************************
+ DkColorSimd.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#include <cstdint>
+
+#include "nmc_config.h"
+
+namespace nmc
+{
+
+/**
+ * Row helpers for color conversions.
+ *
+ * Every helper has a scalar, SSE4.1 and AVX2 (+FMA) variant. The variant
+ * is picked at runtime, so the binary does not need to be compiled for a
+ * specific CPU. Channels are passed planar, which keeps the SIMD variants
+ * free of shuffles. Table lookups need gathers, so their SSE4.1 variant is
+ * the scalar one.
+ **/
+class DllCoreExport DkColorSimd
+{
+public:
+    enum Isa {
+        isa_scalar = 0,
+        isa_sse41,
+        isa_avx2,
+
+        isa_end
+    };
+
+    // y = weights[0] * r + weights[1] * g + weights[2] * b
+    using LumaFn = void (*)(const float *r, const float *g, const float *b, float *y, int n, const float *weights);
+
+    // splits 4 byte pixels into planes: c0[i] = lut[src[4 * i]], c1 from byte 1, c2 from byte 2
+    using DecodeFn = void (*)(const uint8_t *src, float *c0, float *c1, float *c2, int n, const float *lut);
+
+    // q = round(lut(clamp(v, 0, 1) * lutSize)) interpolated linearly, NaN maps to lut[0]
+    // lut holds lutSize + 1 samples in [0, 65535] followed by a copy of the last one
+    using EncodeFn = void (*)(const float *v, uint16_t *q, int n, const float *lut, int lutSize);
+
+    /**
+     * Returns the best instruction set supported by this CPU.
+     **/
+    static Isa detectIsa();
+
+    /**
+     * Returns true if isa can be used on this CPU.
+     **/
+    static bool isSupported(Isa isa);
+
+    static LumaFn luma(Isa isa = detectIsa());
+    static DecodeFn decode(Isa isa = detectIsa());
+    static EncodeFn encode(Isa isa = detectIsa());
+};
+
+}
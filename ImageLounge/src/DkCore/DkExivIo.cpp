@@ -0,0 +1,321 @@
+/*******************************************************************************************************
+ DkExivIo.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkExivIo.h"
+
+#include <QDebug>
+#include <QFileDevice>
+#include <QIODevice>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace nmc
+{
+DkExivIo::DkExivIo(const DkFileInfo &fileInfo)
+    : mFileInfo(fileInfo)
+    , mPath(fileInfo.path().toStdString())
+{
+}
+
+DkExivIo::~DkExivIo()
+{
+    close();
+}
+
+int DkExivIo::open()
+{
+    // exiv2 opens the io again before reading previews
+    if (mDevice) {
+        mPos = 0;
+        mEof = false;
+        return 0;
+    }
+
+    mDevice = mFileInfo.getIODevice();
+    if (!mDevice) {
+        mError = 1;
+        return 1;
+    }
+
+    mSequential = mDevice->isSequential();
+    mSize = mDevice->size();
+    mPos = 0;
+    mEof = false;
+    mError = 0;
+
+    // without a size, exiv2 cannot parse formats that store offsets
+    if (mSequential && mSize <= 0) {
+        fetch(-1);
+        mSize = mFetched.size();
+    }
+
+    return 0;
+}
+
+int DkExivIo::close()
+{
+    munmap();
+    mDevice.reset();
+    mFetched.clear();
+    mPos = 0;
+    mEof = false;
+
+    return 0;
+}
+
+DkExivIo::IoSize DkExivIo::write(const Exiv2::byte *, IoSize)
+{
+    return 0;
+}
+
+DkExivIo::IoSize DkExivIo::write(Exiv2::BasicIo &)
+{
+    return 0;
+}
+
+int DkExivIo::putb(Exiv2::byte)
+{
+    return EOF;
+}
+
+void DkExivIo::transfer(Exiv2::BasicIo &)
+{
+    // metadata is written to in-memory copies (see DkMetaDataT::saveMetaData)
+    throw std::runtime_error("DkExivIo is read-only");
+}
+
+Exiv2::DataBuf DkExivIo::read(IoSize rcount)
+{
+    Exiv2::DataBuf buf(rcount);
+
+#if EXIV2_TEST_VERSION(0, 28, 0)
+    buf.resize(read(buf.data(), rcount));
+#else
+    buf.size_ = read(buf.pData_, rcount);
+#endif
+
+    return buf;
+}
+
+DkExivIo::IoSize DkExivIo::read(Exiv2::byte *buf, IoSize rcount)
+{
+    if (!mDevice || rcount <= 0)
+        return 0;
+
+    qint64 numRead = 0;
+    auto *data = reinterpret_cast<char *>(buf);
+
+    if (mSequential) {
+        fetch(qMin(mPos + qint64(rcount), mSize));
+        numRead = std::min(qint64(rcount), qMax(mFetched.size() - mPos, qint64(0)));
+        std::memcpy(data, mFetched.constData() + mPos, size_t(numRead));
+    } else if (mDevice->pos() == mPos || mDevice->seek(mPos)) {
+        numRead = qMax(readDevice(data, qint64(rcount)), qint64(0));
+    }
+
+    mPos += numRead;
+    mEof = numRead < qint64(rcount);
+
+    return IoSize(numRead);
+}
+
+int DkExivIo::getb()
+{
+    Exiv2::byte b = 0;
+    if (read(&b, 1) != 1)
+        return EOF;
+
+    return b;
+}
+
+int DkExivIo::seek(IoOffset offset, Position pos)
+{
+    qint64 newPos = qint64(offset);
+    if (pos == Exiv2::BasicIo::cur)
+        newPos += mPos;
+    else if (pos == Exiv2::BasicIo::end)
+        newPos += mSize;
+
+    // same as Exiv2::MemIo
+    if (newPos < 0)
+        return 1;
+
+    if (newPos > mSize) {
+        mEof = true;
+        return 1;
+    }
+
+    mPos = newPos;
+    mEof = false;
+
+    return 0;
+}
+
+Exiv2::byte *DkExivIo::mmap(bool isWriteable)
+{
+    if (isWriteable)
+        throw std::runtime_error("DkExivIo is read-only");
+
+    if (mMapped)
+        return mMapped;
+
+    if (!mDevice)
+        return nullptr;
+
+    // e.g. previews that are stored in TIFF sub-IFDs
+    if (auto *file = qobject_cast<QFileDevice *>(mDevice.get())) {
+        mMapped = file->map(0, mSize);
+        mFileMapped = mMapped != nullptr;
+    }
+
+    // exiv2 trusts size() when it accesses mapped memory
+    if (!mMapped && mSequential) {
+        if (fetch(mSize))
+            mMapped = reinterpret_cast<uchar *>(mFetched.data());
+    } else if (!mMapped && mDevice->seek(0)) {
+        mMapBuffer.resize(mSize);
+        if (readDevice(mMapBuffer.data(), mSize) == mSize)
+            mMapped = reinterpret_cast<uchar *>(mMapBuffer.data());
+    }
+
+    if (mMapped)
+        mBytesMapped += mSize;
+
+    return mMapped;
+}
+
+int DkExivIo::munmap()
+{
+    if (mFileMapped) {
+        if (auto *file = qobject_cast<QFileDevice *>(mDevice.get()))
+            file->unmap(mMapped);
+    }
+
+    mMapped = nullptr;
+    mFileMapped = false;
+    mMapBuffer.clear();
+
+    return 0;
+}
+
+DkExivIo::IoSize DkExivIo::tell() const
+{
+    return IoSize(mPos);
+}
+
+size_t DkExivIo::size() const
+{
+    return size_t(mSize);
+}
+
+bool DkExivIo::isopen() const
+{
+    return mDevice != nullptr;
+}
+
+int DkExivIo::error() const
+{
+    return mError;
+}
+
+bool DkExivIo::eof() const
+{
+    return mEof;
+}
+
+#if EXIV2_TEST_VERSION(0, 28, 0)
+const std::string &DkExivIo::path() const noexcept
+#else
+std::string DkExivIo::path() const
+#endif
+{
+    return mPath;
+}
+
+#ifdef EXV_UNICODE_PATH
+std::wstring DkExivIo::wpath() const
+{
+    return mFileInfo.path().toStdWString();
+}
+#endif
+
+#if EXIV2_TEST_VERSION(0, 27, 4)
+void DkExivIo::populateFakeData()
+{
+}
+#endif
+
+qint64 DkExivIo::bytesRead() const
+{
+    return mBytesRead;
+}
+
+qint64 DkExivIo::bytesMapped() const
+{
+    return mBytesMapped;
+}
+
+qint64 DkExivIo::readDevice(char *data, qint64 maxSize)
+{
+    qint64 numRead = mDevice->read(data, maxSize);
+    if (numRead < 0) {
+        qWarning() << "[DkExivIo] failed to read" << mFileInfo.fileName() << mDevice->errorString();
+        mError = 1;
+        return -1;
+    }
+
+    mBytesRead += numRead;
+    return numRead;
+}
+
+/**
+ * Inflates sequential devices up to end (or completely if end < 0).
+ * Chunks keep the number of (de)compression calls low for byte-wise reads.
+ **/
+bool DkExivIo::fetch(qint64 end)
+{
+    const qint64 chunkSize = 64 * 1024;
+
+    while (end < 0 || mFetched.size() < end) {
+        qint64 numBytes = end < 0 ? chunkSize : qMax(end - mFetched.size(), chunkSize);
+        qint64 oldSize = mFetched.size();
+        mFetched.resize(oldSize + numBytes);
+
+        qint64 numRead = readDevice(mFetched.data() + oldSize, numBytes);
+        mFetched.resize(oldSize + qMax(numRead, qint64(0)));
+
+        if (numRead <= 0)
+            return false;
+    }
+
+    return true;
+}
+}
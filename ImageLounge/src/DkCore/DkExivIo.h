@@ -0,0 +1,146 @@
+/*******************************************************************************************************
+ DkExivIo.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#include "DkFileInfo.h"
+#include "DkMetaData.h" // exiv2 headers
+
+#include <QByteArray>
+
+#include <exiv2/basicio.hpp>
+#include <exiv2/version.hpp>
+
+#include <memory>
+#include <string>
+
+#include "nmc_config.h"
+
+class QIODevice;
+
+namespace nmc
+{
+/**
+ * Read-only Exiv2 i/o on top of DkFileInfo::getIODevice().
+ *
+ * Exiv2 seeks to and reads the structures it parses, so reading the metadata
+ * of a large TIFF or RAW pulls the header and the IFDs only. Zip members
+ * cannot seek; their bytes are inflated once up to the furthest position
+ * Exiv2 asked for, which is the header for most formats.
+ *
+ * The device is opened lazily in open() and released in close(), so previews
+ * that are extracted later reopen the file instead of keeping it locked.
+ **/
+class DllCoreExport DkExivIo : public Exiv2::BasicIo
+{
+public:
+#if EXIV2_TEST_VERSION(0, 28, 0)
+    using Ptr = Exiv2::BasicIo::UniquePtr;
+    using IoSize = size_t;
+    using IoOffset = int64_t;
+#else
+    using Ptr = Exiv2::BasicIo::AutoPtr; // ImageFactory::open takes no unique_ptr
+    using IoSize = long;
+#if defined(_MSC_VER)
+    using IoOffset = int64_t;
+#else
+    using IoOffset = long;
+#endif
+#endif
+
+    explicit DkExivIo(const DkFileInfo &fileInfo);
+    ~DkExivIo() override;
+
+    DkExivIo(const DkExivIo &) = delete;
+    DkExivIo &operator=(const DkExivIo &) = delete;
+
+    int open() override;
+    int close() override;
+
+    IoSize write(const Exiv2::byte *data, IoSize wcount) override;
+    IoSize write(Exiv2::BasicIo &src) override;
+    int putb(Exiv2::byte data) override;
+    void transfer(Exiv2::BasicIo &src) override;
+
+    Exiv2::DataBuf read(IoSize rcount) override;
+    IoSize read(Exiv2::byte *buf, IoSize rcount) override;
+    int getb() override;
+    int seek(IoOffset offset, Position pos) override;
+
+    Exiv2::byte *mmap(bool isWriteable = false) override;
+    int munmap() override;
+
+    IoSize tell() const override;
+    size_t size() const override;
+    bool isopen() const override;
+    int error() const override;
+    bool eof() const override;
+
+#if EXIV2_TEST_VERSION(0, 28, 0)
+    const std::string &path() const noexcept override;
+#else
+    std::string path() const override;
+#endif
+#ifdef EXV_UNICODE_PATH
+    std::wstring wpath() const override;
+#endif
+
+#if EXIV2_TEST_VERSION(0, 27, 4)
+    void populateFakeData() override;
+#endif
+
+    /// bytes pulled from the device since construction, mapped files are not counted
+    qint64 bytesRead() const;
+    /// bytes that were handed to Exiv2 with mmap()
+    qint64 bytesMapped() const;
+
+private:
+    qint64 readDevice(char *data, qint64 maxSize);
+    bool fetch(qint64 end);
+
+    DkFileInfo mFileInfo;
+    std::string mPath;
+
+    std::unique_ptr<QIODevice> mDevice;
+    bool mSequential = false;
+    QByteArray mFetched; // inflated prefix of sequential devices
+
+    qint64 mPos = 0;
+    qint64 mSize = 0;
+    bool mEof = false;
+    int mError = 0;
+
+    uchar *mMapped = nullptr;
+    bool mFileMapped = false;
+    QByteArray mMapBuffer;
+
+    qint64 mBytesRead = 0;
+    qint64 mBytesMapped = 0;
+};
+
+}
@@ -29,10 +29,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DkUtils.h"
 
 #include <QDir>
+#include <QDirIterator>
+#include <QHash>
 #include <QRegularExpression>
 #include <QStringBuilder>
+#include <QtConcurrentFilter>
+
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#endif
 
 #ifdef WITH_QUAZIP
+#include "DkZipSession.h"
 #include <quazip/JlCompress.h>
 #endif
 
@@ -54,6 +62,30 @@ namespace nmc
 // - note: would prefer to scope to class but breaks plugins linking on Qt5/gcc
 static constexpr QStringView ZipMarker = u"#/";
 
+/**
+ * Reads a member with a pooled handle of its session.
+ **/
+class DkZipMemberFile : public QuaZipFile
+{
+public:
+    DkZipMemberFile(QSharedPointer<DkZipSession> session, QuaZip *zip)
+        : QuaZipFile(zip)
+        , mSession(session)
+        , mZip(zip)
+    {
+    }
+
+    ~DkZipMemberFile() override
+    {
+        close();
+        mSession->release(mZip);
+    }
+
+private:
+    QSharedPointer<DkZipSession> mSession;
+    QuaZip *mZip;
+};
+
 DkFileInfo::ZipData::ZipData(const QString &encodedFilePath)
 {
     qsizetype index = encodedFilePath.indexOf(ZipMarker);
@@ -101,28 +133,14 @@ QString DkFileInfo::ZipData::encodePath(const QString &zipFilePath, const QStrin
 
 void DkFileInfo::ZipData::readMetaData()
 {
-    // FIXME: this is a bit slow on large zipfiles, readZipArchive() could cache it,
-    // or it can be eliminated by passing DkFileInfo around instead of paths
-    qDebug() << "[FileInfo] zip: slow metadata parsing:" << mZipMemberPath;
-
-    QuaZip zip(mZipFilePath);
-    if (!zip.open(QuaZip::mdUnzip)) {
-        qWarning() << "[FileInfo] zip: open failed:" << mZipFilePath << zip.getZipError();
-        return;
-    }
-
-    if (!zip.setCurrentFile(mZipMemberPath)) {
-        qWarning() << "[FileInfo] zip: locate failed:" << mZipFilePath << zip.getZipError();
-        return;
-    }
-
-    QuaZipFileInfo64 info;
-    if (!zip.getCurrentFileInfo(&info)) {
-        qWarning() << "[FileInfo] zip: decompress failed:" << mZipFilePath << zip.getZipError();
+    QSharedPointer<DkZipSession> session = DkZipSession::session(mZipFilePath);
+    const QuaZipFileInfo64 *info = session ? session->member(mZipMemberPath) : nullptr;
+    if (!info) {
+        qWarning() << "[FileInfo] zip: locate failed:" << mZipFilePath << mZipMemberPath;
         return;
     }
 
-    setMetaData(info);
+    setMetaData(*info);
 }
 #endif
 
@@ -227,7 +245,14 @@ std::unique_ptr<QIODevice> DkFileInfo::getIODevice() const
 
     if (isFromZip()) {
 #ifdef WITH_QUAZIP
-        io = std::make_unique<QuaZipFile>(d->mZipData.zipFilePath(), d->mZipData.zipMemberPath());
+        QSharedPointer<DkZipSession> session = DkZipSession::session(d->mZipData.zipFilePath());
+        QuaZip *zip = session ? session->acquire(d->mZipData.zipMemberPath()) : nullptr;
+        if (!zip) {
+            qWarning() << "[FileInfo] failed to open i/o" << path();
+            return io;
+        }
+
+        io = std::make_unique<DkZipMemberFile>(session, zip);
 #endif
     } else {
         io = std::make_unique<QFile>(path());
@@ -475,23 +500,14 @@ DkFileInfoList filterInfoList(const QString &query, const DkFileInfoList &list)
 
 DkFileInfoList DkFileInfo::readZipArchive(const QString &zipPath)
 {
-    QuaZip zip(zipPath);
-    if (!zip.open(QuaZip::mdUnzip)) {
-        qWarning() << "[FileInfo] zip: open failed:" << zipPath << zip.getZipError();
-        zip.getZipError();
+    QSharedPointer<DkZipSession> session = DkZipSession::session(zipPath);
+    if (!session)
         return {};
-    }
 
     DkFileInfoList fileInfoList;
-    QuaZipFileInfo64 info;
-    int idx = 0;
-
-    for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile()) {
-        if (!zip.getCurrentFileInfo(&info)) {
-            qWarning() << "[FileInfo] zip: getCurrentFile failed @index:" << idx << zipPath << zip.getZipError();
-            continue;
-        }
+    fileInfoList.reserve(session->members().size());
 
+    for (const QuaZipFileInfo64 &info : session->members()) {
         // ignore MacOS metadata, could be parsed with adouble interface from netatalk
         if (info.name.startsWith("__MACOSX/._"))
             continue;
@@ -501,13 +517,58 @@ DkFileInfoList DkFileInfo::readZipArchive(const QString &zipPath)
             continue;
 
         fileInfoList += DkFileInfo(new SharedData(zipPath, info));
-        idx++;
     }
 
     return fileInfoList;
 }
 #endif
 
+/**
+ * Lists the files of a directory without calling stat() on them.
+ * @param files regular files, their metadata is read on demand
+ * @param unresolved symlinks & entries of unknown type which need a stat() to decide
+ **/
+static void listFiles(const QString &dirPath, DkFileInfoList &files, DkFileInfoList &unresolved)
+{
+    QString prefix = QDir(dirPath).absolutePath();
+    if (!prefix.endsWith('/'))
+        prefix += '/';
+
+#ifdef Q_OS_UNIX
+    // readdir() reports the type for most filesystems, so we get by with getdents()
+    DIR *dir = opendir(QFile::encodeName(dirPath).constData());
+    if (!dir) {
+        qWarning() << "[readDirectory] cannot open:" << dirPath;
+        return;
+    }
+
+    while (const dirent *entry = readdir(dir)) {
+        // hidden files, "." and ".." are ignored like QDir does
+        if (entry->d_name[0] == '.')
+            continue;
+
+        DkFileInfo info(prefix + QFile::decodeName(entry->d_name));
+        if (entry->d_type == DT_REG)
+            files.append(info);
+        else if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN)
+            unresolved.append(info);
+    }
+
+    closedir(dir);
+#else
+    // the iterator gets the metadata along with the names (e.g. FindFirstFile)
+    QDirIterator it(dirPath, QDir::Files);
+    while (it.hasNext()) {
+        it.next();
+        DkFileInfo info(it.fileInfo());
+        if (info.isSymLink())
+            unresolved.append(info);
+        else
+            files.append(info);
+    }
+#endif
+}
+
 DkFileInfoList DkFileInfo::readDirectory(const QString &dirPath, const QString &nameFilter)
 {
     DkTimer dt;
@@ -515,21 +576,6 @@ DkFileInfoList DkFileInfo::readDirectory(const QString &dirPath, const QString &
     if (dirPath.isEmpty())
         return {};
 
-    DkFileInfoList unfiltered;
-
-#if WITH_QUAZIP
-    if (DkFileInfo(dirPath).isZipFile()) {
-        unfiltered = readZipArchive(dirPath);
-    } else
-#endif
-    {
-        // all files, unfiltered, unsorted
-        const QFileInfoList list = QDir(dirPath).entryInfoList(QDir::Files, QDir::NoSort);
-        unfiltered.reserve(list.count());
-        for (auto &fileInfo : list)
-            unfiltered.append(DkFileInfo(fileInfo));
-    }
-
     // seems better to use a hashtable here; ~50 extensions are possible without kimageformats
     const QStringList &fileFilters = DkSettingsManager::param().app().browseFilters;
     const QStringList &containerFilters = DkSettingsManager::param().app().containerRawFilters.split(u' ');
@@ -541,21 +587,46 @@ DkFileInfoList DkFileInfo::readDirectory(const QString &dirPath, const QString &
         suffixes.insert(QString(filter).replace("*.", ""));
     }
 
+    DkFileInfoList unfiltered;
+    DkFileInfoList unresolved; // needs i/o to decide
+
+#if WITH_QUAZIP
+    if (DkFileInfo(dirPath).isZipFile()) {
+        unfiltered = readZipArchive(dirPath);
+    } else
+#endif
+    {
+        // all files, unfiltered, unsorted
+        listFiles(dirPath, unfiltered, unresolved);
+    }
+
     DkFileInfoList filtered;
 
-    // filter by suffix
+    // filter by suffix, files without suffix are checked with the others below
     for (auto &fileInfo : std::as_const(unfiltered)) {
-        DkFileInfo tmpInfo = fileInfo;
-        if (tmpInfo.isSymLink() && !tmpInfo.resolveSymLink())
-            continue;
+        const QString suffix = fileInfo.suffix().toLower();
+        if (suffix.isEmpty())
+            unresolved.append(fileInfo);
+        else if (suffixes.contains(suffix))
+            filtered.append(fileInfo);
+    }
 
-        const QString suffix = tmpInfo.suffix().toLower();
-        if (suffix.isEmpty() && !DkUtils::isLoadableByContent(tmpInfo)) // reads file header, maybe slow
-            continue;
-        else if (!suffixes.contains(suffix))
-            continue;
+    // resolve links and read file headers, this may be slow on network drives so we do it in parallel
+    if (!unresolved.isEmpty()) {
+        filtered += QtConcurrent::blockingFiltered(unresolved, [&suffixes](const DkFileInfo &fileInfo) {
+            DkFileInfo tmpInfo = fileInfo;
+            if (tmpInfo.isSymLink() && !tmpInfo.resolveSymLink())
+                return false;
+
+            if (!tmpInfo.isFile())
+                return false;
+
+            const QString suffix = tmpInfo.suffix().toLower();
+            if (suffix.isEmpty())
+                return DkUtils::isLoadableByContent(tmpInfo); // reads file header
 
-        filtered.append(fileInfo);
+            return suffixes.contains(suffix);
+        });
     }
 
     // filter with keywords, regexp, or glob
@@ -64,8 +64,8 @@ public:
      * @param nameFilter additional filter on file name
      * @return list of presumed supported files in no particular order
      *
-     * @note checks the header of files with no suffix, which may get slow
-     *       for large directories.
+     * @note files are not stat()ed unless they are links or have no suffix,
+     *       the headers of files with no suffix are checked in parallel.
      **/
     static DkFileInfoList readDirectory(const QString &dirPath, const QString &nameFilter = {});
 
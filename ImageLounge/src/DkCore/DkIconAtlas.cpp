@@ -0,0 +1,432 @@
+/*******************************************************************************************************
+ DkIconAtlas.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkIconAtlas.h"
+
+#include "DkSettings.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <QSvgRenderer>
+
+#include <algorithm>
+#include <cstring>
+
+namespace nmc
+{
+
+namespace
+{
+const quint32 kMagic = 0x4e4d4941; // NMIA
+const quint16 kVersion = 1;
+const int kAtlasWidth = 512;
+
+// raw premultiplied pixels, a PNG round trip would alter semi-transparent pixels
+void writeImage(QDataStream &ds, const QImage &img)
+{
+    QByteArray pixels(reinterpret_cast<const char *>(img.constBits()), static_cast<int>(img.sizeInBytes()));
+    ds << static_cast<qint32>(img.width()) << static_cast<qint32>(img.height())
+       << static_cast<qint32>(img.bytesPerLine()) << qCompress(pixels, 1);
+}
+
+QImage readImage(QDataStream &ds)
+{
+    qint32 width = 0;
+    qint32 height = 0;
+    qint32 bytesPerLine = 0;
+    QByteArray pixels;
+    ds >> width >> height >> bytesPerLine >> pixels;
+    pixels = qUncompress(pixels);
+
+    if (width <= 0 || height <= 0 || static_cast<qint64>(bytesPerLine) * height != pixels.size())
+        return QImage();
+
+    QImage img(width, height, QImage::Format_ARGB32_Premultiplied);
+    if (img.isNull() || img.bytesPerLine() != bytesPerLine)
+        return QImage();
+
+    memcpy(img.bits(), pixels.constData(), pixels.size());
+
+    return img;
+}
+}
+
+DkIconAtlas &DkIconAtlas::instance()
+{
+    static DkIconAtlas inst(defaultPath());
+    return inst;
+}
+
+DkIconAtlas::DkIconAtlas(const QString &filePath, qint64 maxPixels)
+    : mFilePath(filePath)
+    , mMaxPixels(maxPixels)
+{
+}
+
+QString DkIconAtlas::defaultPath()
+{
+    return QFileInfo(DefaultSettings().fileName()).absolutePath() + "/icons.atlas";
+}
+
+QString DkIconAtlas::key(const QString &svgPath, const QSize &size, qreal dpr, const QColor &color)
+{
+    return QString("%1|%2x%3|%4|%5")
+        .arg(svgPath)
+        .arg(size.width())
+        .arg(size.height())
+        .arg(dpr)
+        .arg(color.isValid() ? color.name(QColor::HexArgb) : "none");
+}
+
+qint64 DkIconAtlas::Entry::pixels() const
+{
+    QSize s = image.isNull() ? rect.size() : image.size();
+    return static_cast<qint64>(s.width()) * s.height();
+}
+
+QByteArray DkIconAtlas::contentHash(const QString &svgPath)
+{
+    // stat instead of reading & hashing files on every lookup
+    if (!svgPath.startsWith(":")) {
+        QFileInfo info(svgPath);
+        if (!info.exists())
+            return QByteArray();
+
+        return QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + "|" + QByteArray::number(info.size());
+    }
+
+    {
+        QMutexLocker locker(&mMutex);
+        auto hash = mResourceHashes.constFind(svgPath);
+        if (hash != mResourceHashes.constEnd())
+            return *hash;
+    }
+
+    // resources do not change while running, they are hashed once
+    QFile file(svgPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QByteArray hash = QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5);
+
+    QMutexLocker locker(&mMutex);
+    mResourceHashes.insert(svgPath, hash);
+
+    return hash;
+}
+
+QImage DkIconAtlas::render(const QString &svgPath, const QSize &size, qreal dpr, const QColor &color)
+{
+    QImage img(size, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+
+    {
+        QPainter painter(&img);
+        QSvgRenderer(svgPath).render(&painter, img.rect());
+
+        if (color.isValid()) {
+            painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+            painter.fillRect(img.rect(), color);
+        }
+    }
+
+    img.setDevicePixelRatio(dpr);
+
+    return img;
+}
+
+QImage DkIconAtlas::icon(const QString &svgPath, const QSize &size, qreal dpr, const QColor &color)
+{
+    if (size.isEmpty())
+        return QImage();
+
+    QString k = key(svgPath, size, dpr, color);
+    QByteArray hash = contentHash(svgPath);
+
+    {
+        QMutexLocker locker(&mMutex);
+        loadIntern();
+
+        auto entry = mEntries.find(k);
+        if (entry != mEntries.end() && entry->hash == hash) {
+            entry->used = ++mLookups;
+
+            if (!entry->image.isNull())
+                return entry->image;
+
+            QImage img = mAtlas.copy(entry->rect);
+            img.setDevicePixelRatio(entry->dpr);
+            return img;
+        }
+    }
+
+    // other threads keep using the atlas while we render
+    QImage img = render(svgPath, size, dpr, color);
+
+    QMutexLocker locker(&mMutex);
+    insert(k, Entry{hash, dpr, QRect(), img, ++mLookups});
+    mRendered++;
+
+    return img;
+}
+
+void DkIconAtlas::insert(const QString &key, const Entry &entry)
+{
+    auto old = mEntries.constFind(key);
+    if (old != mEntries.constEnd())
+        mPixels -= old->pixels();
+
+    mEntries.insert(key, entry);
+    mPixels += entry.pixels();
+    mDirty = true;
+
+    // drop the least recently used icons, the new one is kept
+    while (mPixels > mMaxPixels && mEntries.size() > 1) {
+        auto oldest = mEntries.end();
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it.key() != key && (oldest == mEntries.end() || it->used < oldest->used))
+                oldest = it;
+        }
+
+        mPixels -= oldest->pixels();
+        mEntries.erase(oldest);
+    }
+}
+
+void DkIconAtlas::setTheme(const QString &theme)
+{
+    QMutexLocker locker(&mMutex);
+    loadIntern();
+
+    if (theme == mTheme)
+        return;
+
+    if (!mEntries.isEmpty())
+        qInfo() << "[DkIconAtlas] theme changed, dropping" << mEntries.size() << "icons";
+
+    mTheme = theme;
+    mEntries.clear();
+    mAtlas = QImage();
+    mPixels = 0;
+    mDirty = true;
+}
+
+bool DkIconAtlas::load()
+{
+    QMutexLocker locker(&mMutex);
+    return loadIntern();
+}
+
+bool DkIconAtlas::loadIntern()
+{
+    if (mLoaded)
+        return true;
+    mLoaded = true;
+
+    QFile file(mFilePath);
+    if (!file.exists())
+        return false;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[DkIconAtlas] cannot read" << mFilePath << file.errorString();
+        return false;
+    }
+
+    // a single read, the index & image are parsed from memory
+    QByteArray data = file.readAll();
+    QDataStream ds(data);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    ds >> magic >> version;
+
+    if (magic != kMagic || version != kVersion) {
+        qInfo() << "[DkIconAtlas] ignoring outdated atlas" << mFilePath;
+        return false;
+    }
+
+    QString theme;
+    qint32 numEntries = 0;
+    ds >> theme >> numEntries;
+
+    QHash<QString, Entry> entries;
+    for (int idx = 0; idx < numEntries && ds.status() == QDataStream::Ok; idx++) {
+        QString k;
+        Entry e;
+        ds >> k >> e.hash >> e.dpr >> e.rect;
+        entries.insert(k, e);
+    }
+
+    QImage atlas = readImage(ds);
+
+    if (ds.status() != QDataStream::Ok || (numEntries > 0 && atlas.isNull())) {
+        qWarning() << "[DkIconAtlas] corrupted atlas" << mFilePath;
+        return false;
+    }
+
+    // setTheme() may have been called before
+    if (!mTheme.isEmpty() && theme != mTheme) {
+        mDirty = true;
+        return false;
+    }
+
+    mTheme = theme;
+    mAtlas = atlas;
+    mEntries = entries;
+
+    mPixels = 0;
+    for (const Entry &e : std::as_const(mEntries))
+        mPixels += e.pixels();
+
+    return true;
+}
+
+QImage DkIconAtlas::pack(QHash<QString, QRect> &rects) const
+{
+    struct Item {
+        QString key;
+        QSize size;
+    };
+
+    QVector<Item> items;
+    int width = kAtlasWidth;
+    for (auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it) {
+        QSize s = it->image.isNull() ? it->rect.size() : it->image.size();
+        items << Item{it.key(), s};
+        width = qMax(width, s.width());
+    }
+
+    // shelf packing, tallest first
+    std::sort(items.begin(), items.end(), [](const Item &l, const Item &r) {
+        return l.size.height() > r.size.height();
+    });
+
+    QPoint pos;
+    int shelfHeight = 0;
+    for (const Item &item : std::as_const(items)) {
+        if (pos.x() + item.size.width() > width) {
+            pos = QPoint(0, pos.y() + shelfHeight);
+            shelfHeight = 0;
+        }
+
+        rects.insert(item.key, QRect(pos, item.size));
+        pos.rx() += item.size.width();
+        shelfHeight = qMax(shelfHeight, item.size.height());
+    }
+
+    QImage atlas(width, qMax(pos.y() + shelfHeight, 1), QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+
+    QPainter painter(&atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+    for (auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it) {
+        QPoint target = rects.value(it.key()).topLeft();
+
+        if (it->image.isNull()) {
+            painter.drawImage(target, mAtlas, it->rect);
+        } else {
+            QImage img = it->image;
+            img.setDevicePixelRatio(1.0); // pack pixels
+            painter.drawImage(target, img);
+        }
+    }
+
+    return atlas;
+}
+
+bool DkIconAtlas::save()
+{
+    QMutexLocker locker(&mMutex);
+
+    if (!mDirty)
+        return true;
+
+    QHash<QString, QRect> rects;
+    QImage atlas = pack(rects);
+
+    QByteArray data;
+    {
+        QDataStream ds(&data, QIODevice::WriteOnly);
+        ds << kMagic << kVersion << mTheme << static_cast<qint32>(mEntries.size());
+
+        for (auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it)
+            ds << it.key() << it->hash << it->dpr << rects.value(it.key());
+
+        writeImage(ds, atlas);
+    }
+
+    QSaveFile file(mFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[DkIconAtlas] cannot write" << mFilePath << file.errorString();
+        return false;
+    }
+
+    file.write(data);
+
+    if (!file.commit()) {
+        qWarning() << "[DkIconAtlas] cannot write" << mFilePath << file.errorString();
+        return false;
+    }
+
+    // the packed atlas replaces the icons rendered in this session
+    mAtlas = atlas;
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+        it->rect = rects.value(it.key());
+        it->image = QImage();
+    }
+    mDirty = false;
+
+    return true;
+}
+
+int DkIconAtlas::numIcons() const
+{
+    QMutexLocker locker(&mMutex);
+    return mEntries.size();
+}
+
+int DkIconAtlas::numRendered() const
+{
+    QMutexLocker locker(&mMutex);
+    return mRendered;
+}
+
+qint64 DkIconAtlas::numPixels() const
+{
+    QMutexLocker locker(&mMutex);
+    return mPixels;
+}
+
+}
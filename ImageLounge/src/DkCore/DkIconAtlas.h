@@ -0,0 +1,137 @@
+/*******************************************************************************************************
+ DkIconAtlas.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+#include "nmc_config.h"
+
+namespace nmc
+{
+
+/**
+ * Persistent cache of rendered svg icons.
+ *
+ * All icons are packed into one image which is stored with its index in a
+ * single file next to the settings. Entries are keyed by svg path, size,
+ * device pixel ratio and color. On lookup, resources are checked against
+ * their content hash and files against their modification time, so changed
+ * svgs are rendered again. A theme change drops all entries.
+ *
+ * If the icons exceed maxPixels, the least recently used ones are dropped.
+ * New icons are kept in memory and written by save() (on exit).
+ **/
+class DllCoreExport DkIconAtlas
+{
+public:
+    /**
+     * The atlas of the application, stored in defaultPath().
+     **/
+    static DkIconAtlas &instance();
+
+    explicit DkIconAtlas(const QString &filePath, qint64 maxPixels = 2048 * 2048);
+
+    // singleton-like, not copyable
+    DkIconAtlas(DkIconAtlas const &) = delete;
+    void operator=(DkIconAtlas const &) = delete;
+
+    static QString defaultPath();
+
+    /**
+     * Returns the icon from the atlas, or renders and adds it.
+     * Rendering does not block other threads that use the atlas.
+     * @param size in device pixels
+     * @param color the svg is filled with color, if invalid it is rendered as is
+     **/
+    QImage icon(const QString &svgPath, const QSize &size, qreal dpr, const QColor &color);
+
+    /**
+     * Renders the svg without the atlas.
+     **/
+    static QImage render(const QString &svgPath, const QSize &size, qreal dpr, const QColor &color);
+
+    /**
+     * Drops all icons if the theme differs from the theme the atlas was created with.
+     * @param theme identifies everything that changes icons but is not part of the key
+     **/
+    void setTheme(const QString &theme);
+
+    /**
+     * Reads the atlas file (once).
+     **/
+    bool load();
+
+    /**
+     * Writes the atlas if icons were added or dropped.
+     **/
+    bool save();
+
+    int numIcons() const;
+    int numRendered() const;
+    qint64 numPixels() const;
+
+private:
+    struct Entry {
+        QByteArray hash; // content hash of resources, modification time of files
+        qreal dpr = 1.0;
+        QRect rect; // in mAtlas
+        QImage image; // rendered in this session, not packed yet
+        quint64 used = 0; // last lookup, not stored
+
+        qint64 pixels() const;
+    };
+
+    static QString key(const QString &svgPath, const QSize &size, qreal dpr, const QColor &color);
+    bool loadIntern();
+    QByteArray contentHash(const QString &svgPath);
+    void insert(const QString &key, const Entry &entry);
+    QImage pack(QHash<QString, QRect> &rects) const;
+
+    mutable QMutex mMutex;
+    QString mFilePath;
+    QString mTheme;
+    QImage mAtlas;
+    QHash<QString, Entry> mEntries;
+    QHash<QString, QByteArray> mResourceHashes; // resources do not change while running
+    qint64 mMaxPixels = 0;
+    qint64 mPixels = 0;
+    quint64 mLookups = 0;
+    bool mLoaded = false;
+    bool mDirty = false;
+    int mRendered = 0;
+};
+
+}
@@ -0,0 +1,194 @@
+/*******************************************************************************************************
+ DkImageCache.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkImageCache.h"
+
+#include "DkFileInfo.h"
+#include "DkSettings.h"
+
+#include <QDateTime>
+#include <QDebug>
+
+namespace nmc
+{
+bool DkImageCache::Key::isValid() const
+{
+    return !path.isEmpty() && size >= 0;
+}
+
+bool DkImageCache::Key::operator==(const Key &o) const
+{
+    return path == o.path && modified == o.modified && size == o.size && page == o.page && variant == o.variant;
+}
+
+DkImageCache &DkImageCache::instance()
+{
+    static DkImageCache inst;
+    return inst;
+}
+
+DkImageCache::Key DkImageCache::key(const DkFileInfo &file, int page, int variant)
+{
+    Key key;
+
+    if (!file.exists())
+        return key;
+
+    key.path = file.path();
+    key.modified = file.lastModified().toMSecsSinceEpoch();
+    key.size = file.size();
+    key.page = page;
+    key.variant = variant;
+
+    return key;
+}
+
+bool DkImageCache::find(const Key &key, Entry &entry)
+{
+    if (!key.isValid())
+        return false;
+
+    QMutexLocker locker(&mMutex);
+
+    auto it = mNodes.find(key);
+    if (it == mNodes.end())
+        return false;
+
+    it->lastUsed = ++mTick;
+    entry = it->entry;
+
+    return true;
+}
+
+void DkImageCache::insert(const Key &key, const Entry &entry)
+{
+    if (!key.isValid() || entry.image.isNull())
+        return;
+
+    qint64 bytes = entry.image.sizeInBytes();
+
+    QMutexLocker locker(&mMutex);
+
+    qint64 limit = maxMemory();
+    if (bytes > limit)
+        return;
+
+    auto it = mNodes.find(key);
+    if (it != mNodes.end())
+        mMemory -= it->bytes;
+
+    mNodes.insert(key, Node{entry, bytes, ++mTick});
+    mMemory += bytes;
+
+    trim(limit);
+}
+
+void DkImageCache::remove(const QString &filePath)
+{
+    QMutexLocker locker(&mMutex);
+
+    for (auto it = mNodes.begin(); it != mNodes.end();) {
+        if (it.key().path == filePath) {
+            mMemory -= it->bytes;
+            it = mNodes.erase(it);
+        } else
+            ++it;
+    }
+}
+
+void DkImageCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+
+    mNodes.clear();
+    mMemory = 0;
+}
+
+void DkImageCache::setMaxMemory(qint64 bytes)
+{
+    QMutexLocker locker(&mMutex);
+
+    mMaxMemory = bytes;
+    trim(maxMemory());
+}
+
+qint64 DkImageCache::maxMemory() const
+{
+    if (mMaxMemory >= 0)
+        return mMaxMemory;
+
+    return qRound64(DkSettingsManager::param().resources().cacheMemory * 1024.0 * 1024.0);
+}
+
+qint64 DkImageCache::memoryUsage() const
+{
+    QMutexLocker locker(&mMutex);
+    return mMemory;
+}
+
+qint64 DkImageCache::pinnedMemory(const QSet<qint64> &ignore) const
+{
+    QMutexLocker locker(&mMutex);
+
+    qint64 bytes = 0;
+    for (const Node &n : mNodes) {
+        if (!n.entry.image.isDetached() && !ignore.contains(n.entry.image.cacheKey()))
+            bytes += n.bytes;
+    }
+
+    return bytes;
+}
+
+int DkImageCache::size() const
+{
+    QMutexLocker locker(&mMutex);
+    return mNodes.size();
+}
+
+void DkImageCache::trim(qint64 limit)
+{
+    while (mMemory > limit && !mNodes.isEmpty()) {
+        // evicting images that are still displayed does not free memory, so drop unused ones first
+        auto victim = mNodes.end();
+        bool victimUnused = false;
+
+        for (auto it = mNodes.begin(); it != mNodes.end(); ++it) {
+            bool unused = it->entry.image.isDetached();
+
+            if (victim == mNodes.end() || (unused && !victimUnused)
+                || (unused == victimUnused && it->lastUsed < victim->lastUsed)) {
+                victim = it;
+                victimUnused = unused;
+            }
+        }
+
+        qDebug() << "[DkImageCache]" << victim.key().path << "evicted";
+        mMemory -= victim->bytes;
+        mNodes.erase(victim);
+    }
+}
+}
@@ -0,0 +1,135 @@
+/*******************************************************************************************************
+ DkImageCache.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+#include "nmc_config.h"
+
+namespace nmc
+{
+class DkFileInfo;
+
+/**
+ * Process-wide cache of decoded images.
+ *
+ * All tabs share this cache, so a file that is open in several tabs is
+ * decoded and stored once. QImage is implicitly shared, the containers and
+ * the cache hold the same pixel data.
+ *
+ * Entries are identified by path, modification time, size and page. The
+ * total size of all entries is limited by Resources::cacheMemory. When the
+ * limit is exceeded, the least recently used entries that are not displayed
+ * anymore are evicted first.
+ **/
+class DllCoreExport DkImageCache
+{
+public:
+    struct Key {
+        QString path;
+        qint64 modified = 0;
+        qint64 size = -1;
+        int page = 0;
+        int variant = 0; // load options that change the decoded image
+
+        bool isValid() const;
+        bool operator==(const Key &o) const;
+
+        friend size_t qHash(const Key &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.path, key.modified, key.size, key.page, key.variant);
+        }
+    };
+
+    struct Entry {
+        QImage image;
+        QString editName;
+        int numPages = 1;
+        int pageIdx = 1;
+        bool ignoredOrientation = false;
+    };
+
+    static DkImageCache &instance();
+
+    /**
+     * Returns the cache key of a file, it is invalid if the file does not exist.
+     **/
+    static Key key(const DkFileInfo &file, int page, int variant);
+
+    bool find(const Key &key, Entry &entry);
+    void insert(const Key &key, const Entry &entry);
+
+    /**
+     * Removes all entries of filePath (e.g. if it was deleted).
+     **/
+    void remove(const QString &filePath);
+    void clear();
+
+    /**
+     * Memory limit in bytes, -1 follows Resources::cacheMemory.
+     **/
+    void setMaxMemory(qint64 bytes);
+    qint64 maxMemory() const;
+
+    /**
+     * Bytes of all cached images.
+     **/
+    qint64 memoryUsage() const;
+
+    /**
+     * Bytes of cached images that are still used elsewhere (e.g. by a tab)
+     * and hence would not be freed by evicting them. Images whose QImage::cacheKey()
+     * is in ignore are skipped, a tab passes the images it accounts for itself.
+     **/
+    qint64 pinnedMemory(const QSet<qint64> &ignore = {}) const;
+
+    int size() const;
+
+private:
+    DkImageCache() = default;
+    DkImageCache(const DkImageCache &) = delete; // NOLINT
+
+    struct Node {
+        Entry entry;
+        qint64 bytes = 0;
+        quint64 lastUsed = 0;
+    };
+
+    void trim(qint64 limit);
+
+    mutable QMutex mMutex;
+    QHash<Key, Node> mNodes;
+    qint64 mMemory = 0;
+    qint64 mMaxMemory = -1;
+    quint64 mTick = 0;
+};
+}
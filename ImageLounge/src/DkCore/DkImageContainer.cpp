@@ -30,6 +30,7 @@
 #include "DkBasicLoader.h"
 #include "DkImageStorage.h"
 #include "DkMetaData.h"
+#include "DkMetaDataWriter.h"
 #include "DkSettings.h"
 #include "DkTimer.h"
 #include "DkUtils.h"
@@ -190,7 +191,7 @@ float DkImageContainer::getMemoryUsage() const
         return 0;
 
     float memSize = mFileBuffer ? mFileBuffer->size() / (1024.0f * 1024.0f) : 0;
-    memSize += DkImage::getBufferSizeFloat(mLoader->image().size(), mLoader->image().depth());
+    memSize += mLoader->image().sizeInBytes() / (1024.0f * 1024.0f);
 
     return memSize;
 }
@@ -414,7 +415,7 @@ QSharedPointer<DkBasicLoader> DkImageContainer::loadImageIntern(const QString &f
                                                                 const QSharedPointer<QByteArray> fileBuffer)
 {
     try {
-        loader->loadGeneral(filePath, fileBuffer, DkLoadOption::highquality);
+        loader->loadGeneral(filePath, fileBuffer, DkLoadOption::highquality | DkLoadOption::cached);
     } catch (...) {
         qWarning() << "Unhandled exception in loadGeneral()";
     }
@@ -545,6 +546,10 @@ void DkImageContainerT::checkForFileUpdates()
 
 bool DkImageContainerT::loadImageThreaded(bool force)
 {
+    // do not read the file while its metadata is written
+    if (DkMetaDataWriter::instance().isPending(filePath()))
+        DkMetaDataWriter::instance().waitForFinished();
+
     // check file for updates
     // without this, checkForFileUpdates() will see the modification and
     // reload the image; all this does is prevent the old image from showing
@@ -598,6 +603,7 @@ void DkImageContainerT::fetchFile()
             &DkImageContainerT::bufferLoaded,
             Qt::UniqueConnection);
     mBufferWatcher.setFuture(QtConcurrent::run([file = mFileInfo] {
+        DkTracePhase phase("read file");
         return loadFileToBuffer(file);
     }));
 }
@@ -643,6 +649,7 @@ void DkImageContainerT::fetchImage()
             Qt::UniqueConnection);
 
     mImageWatcher.setFuture(QtConcurrent::run([&] {
+        DkTracePhase phase("decode image");
         return loadImageIntern(filePath(), mLoader, mFileBuffer);
     }));
 }
@@ -934,5 +941,29 @@ void DkImageContainerT::setRating(int rating)
     }
     QString msg = (rating == 0) ? QObject::tr("Clear rating") : QObject::tr("Set rating to %1").arg(rating);
     setMetaData(metaDataInfo, msg);
+    saveMetaDataQueued();
+}
+
+/**
+ * Writes metadata edits in the background if the user enabled it.
+ * The edit is committed right away, so the user is not asked to
+ * save when navigating to the next image (see issue #799).
+ **/
+void DkImageContainerT::saveMetaDataQueued()
+{
+    if (!DkSettingsManager::param().metaData().saveMetaDataInstantly || !exists())
+        return;
+
+    // pixel edits must be saved with the image
+    QSharedPointer<DkMetaDataT> metaData = getMetaData();
+    if (!metaData || !metaData->isDirty() || getLoader()->isImageEdited())
+        return;
+
+    // we are about to change the file ourselves
+    mFileUpdateTimer.stop();
+
+    DkMetaDataWriter::instance().enqueue(fileInfo(), metaData);
+    metaData->clearExifState();
+    setEdited(false);
 }
 }
@@ -161,6 +161,7 @@ public:
     bool saveImageThreaded(const QString &filePath, const QImage saveImg, int compression = -1);
     bool saveImageThreaded(const QString &filePath, int compression = -1);
     void saveMetaDataThreaded(const QString &filePath);
+    void saveMetaDataQueued();
 
     QSharedPointer<DkBasicLoader> getLoader() override;
     static QSharedPointer<DkImageContainerT> fromImageContainer(QSharedPointer<DkImageContainer> imgC);
@@ -29,6 +29,7 @@
 
 #include "DkActionManager.h"
 #include "DkDialog.h"
+#include "DkImageCache.h"
 #include "DkImageStorage.h"
 #include "DkMessageBox.h"
 #include "DkMetaData.h"
@@ -803,6 +804,9 @@ void DkImageLoader::imageLoaded(bool loaded /* = false */)
     if (!loaded)
         return;
 
+    // synchronized instances are about to open the displayed image, prefetched images are not shared
+    mCurrentImage->getLoader()->publishImage();
+
     emit imageUpdatedSignal(mCurrentImage);
 
     if (mCurrentImage) {
@@ -1655,6 +1659,18 @@ void DkImageLoader::updateCacher(QSharedPointer<DkImageContainerT> imgC)
     double mem = 0;
     double totalMem = 0;
 
+    // decoded images are shared by all tabs (DkImageCache), so the budget is global:
+    // images that other tabs still hold cannot be freed for prefetching.
+    // this tab's images are counted below, so they must not be subtracted twice
+    QSet<qint64> ownImages;
+    for (const auto &cImg : std::as_const(mImages)) {
+        if (cImg->hasImage())
+            ownImages.insert(cImg->getLoader()->pixmap().cacheKey());
+    }
+
+    double pinnedMem = DkImageCache::instance().pinnedMemory(ownImages) / (1024.0 * 1024.0);
+    double cacheMem = DkSettingsManager::param().resources().cacheMemory - pinnedMem;
+
     if (cIdx == -1) {
         qWarning() << "WARNING: image not found for caching!";
         return;
@@ -1686,20 +1702,19 @@ void DkImageLoader::updateCacher(QSharedPointer<DkImageContainerT> imgC)
             continue;
         }
         // fully load the next image
-        else if (idx == cIdx + 1 && mem < DkSettingsManager::param().resources().cacheMemory
+        else if (idx == cIdx + 1 && mem < cacheMem
                  && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
             cImg->loadImageThreaded();
             qDebug() << "[Cacher] " << cImg->filePath() << " fully cached...";
         } else if (idx > cIdx && idx < cIdx + DkSettingsManager::param().resources().maxImagesCached - 2
-                   && mem < DkSettingsManager::param().resources().cacheMemory
-                   && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
+                   && mem < cacheMem && mImages.at(idx)->getLoadState() == DkImageContainerT::not_loaded) {
             // dt.getIvl();
             mImages.at(idx)->fetchFile(); // TODO: crash detected here
             qDebug() << "[Cacher] " << cImg->filePath() << " file fetched...";
         }
     }
 
-    qDebug() << "[Cacher] created in" << dt << "(" << mem + totalMem << "MB)";
+    qDebug() << "[Cacher] created in" << dt << "(" << mem + totalMem << "MB, shared:" << pinnedMem << "MB)";
 }
 
 void DkImageLoader::sort()
@@ -28,6 +28,8 @@
 #include "DkImageStorage.h"
 
 #include "DkActionManager.h"
+#include "DkColorSimd.h"
+#include "DkIconAtlas.h"
 #include "DkImageProc.h"
 #include "DkMath.h"
 #include "DkNativeImage.h"
@@ -38,11 +40,11 @@
 #include <QColorSpace>
 #include <QFloat16>
 #include <QFontDatabase>
+#include <QGuiApplication>
 #include <QIconEngine>
 #include <QPainter>
 #include <QPixmap>
 #include <QPixmapCache>
-#include <QSvgRenderer>
 #include <QTextDocument>
 #include <QtConcurrentMap>
 #include <QtConcurrentRun>
@@ -52,7 +54,10 @@
 #include "opencv2/imgproc/imgproc.hpp"
 #endif
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <vector>
 
 #if defined(Q_OS_WIN) && !defined(SOCK_STREAM)
 #include <winsock2.h> // needed since libraw 0.16
@@ -386,6 +391,255 @@ QImage rotateImageCVMat(const QImage &imgIn, cv::RotateFlags rot, int type)
 }
 #endif
 
+#ifdef WITH_OPENCV
+
+// affine resampling that only computes the destination pixels
+class DkAffineKernel : public DkKernelBase
+{
+    friend class DkKernelBase;
+
+public:
+    Q_DISABLE_COPY(DkAffineKernel)
+    DkAffineKernel() = delete;
+    ~DkAffineKernel() override = default;
+
+    /**
+     * @param srcToDst maps source to destination coordinates, like QPainter's world transform
+     * @param size destination size, pixels that map outside of the source are filled
+     * @param smooth bilinear filtering, nearest neighbor otherwise
+     * @param alpha add an alpha channel if the source has none
+     */
+    DkAffineKernel(const QImage &src,
+                   const QTransform &srcToDst,
+                   const QSize &size,
+                   const QColor &fill,
+                   bool smooth,
+                   bool alpha)
+        : mSrc{DkNativeImage::fromConstImage(src)}
+        , mDstToSrc{srcToDst.inverted()}
+        , mSize{size}
+        , mFillColor{fill}
+        , mSmooth{smooth}
+        , mAlpha{alpha}
+    {
+    }
+
+protected:
+    static constexpr int kTileSize = 64; // the rotated source footprint of a tile stays in L2
+
+    const DkNativeImage mSrc;
+    DkNativeImage mDst{};
+    const QTransform mDstToSrc;
+    const QSize mSize;
+    const QColor mFillColor;
+    const bool mSmooth;
+    const bool mAlpha;
+    RgbaFloat mFill{};
+
+    template<typename SrcFmt>
+    static RgbaFloat load(const cv::Mat &src, int x, int y, const RgbaFloat &fill)
+    {
+        if (x < 0 || y < 0 || x >= src.cols || y >= src.rows) {
+            return fill;
+        }
+        return SrcFmt::loadFloat(src.ptr<typename SrcFmt::ChannelType>(y) + x * SrcFmt::Channels);
+    }
+
+    // the taps are weighted by alpha (premultiplied in registers only), so transparent pixels do not bleed
+    template<typename SrcFmt>
+    static RgbaFloat sample(const cv::Mat &src, double sx, double sy, const RgbaFloat &fill)
+    {
+        const int x = static_cast<int>(std::floor(sx));
+        const int y = static_cast<int>(std::floor(sy));
+        const float fx = static_cast<float>(sx - x);
+        const float fy = static_cast<float>(sy - y);
+
+        const RgbaFloat taps[4] = {load<SrcFmt>(src, x, y, fill),
+                                   load<SrcFmt>(src, x + 1, y, fill),
+                                   load<SrcFmt>(src, x, y + 1, fill),
+                                   load<SrcFmt>(src, x + 1, y + 1, fill)};
+        const float weights[4] = {(1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy};
+
+        float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+        for (int idx = 0; idx < 4; idx++) {
+            const float w = weights[idx] * taps[idx].a;
+            r += w * taps[idx].r;
+            g += w * taps[idx].g;
+            b += w * taps[idx].b;
+            a += w;
+        }
+
+        if (a <= 0.0f) {
+            return {0.0f, 0.0f, 0.0f, 0.0f};
+        }
+
+        const float invA = 1.0f / a;
+        return {r * invA, g * invA, b * invA, a};
+    }
+
+    template<typename SrcFmt, typename DstFmt>
+    static bool kernel(const std::any &arg, const DkWorkRange &range)
+    {
+        using DstType = typename DstFmt::ChannelType;
+
+        auto &self = *(std::any_cast<DkAffineKernel *>(arg));
+        const auto &src = self.mSrc.constMat();
+        auto &dst = self.mDst.mat();
+        const QTransform &t = self.mDstToSrc;
+        const RgbaFloat fill = self.mFill;
+
+        Q_ASSERT(SrcFmt::isCompatibleWith(src));
+        Q_ASSERT(DstFmt::isCompatibleWith(dst));
+
+        // store() truncates
+        constexpr float bias = std::is_floating_point_v<DstType> ? 0.0f : 0.5f / DstFmt::Scale;
+
+        // the range is in tile rows, tiles keep the source reads local for any angle
+        for (int tileRow = range.begin; tileRow < range.end; ++tileRow) {
+            const int y0 = tileRow * kTileSize;
+            const int y1 = std::min(y0 + kTileSize, dst.rows);
+
+            for (int x0 = 0; x0 < dst.cols; x0 += kTileSize) {
+                const int x1 = std::min(x0 + kTileSize, dst.cols);
+
+                for (int y = y0; y < y1; ++y) {
+                    // map pixel centers
+                    double sx = t.m11() * (x0 + 0.5) + t.m21() * (y + 0.5) + t.dx() - 0.5;
+                    double sy = t.m12() * (x0 + 0.5) + t.m22() * (y + 0.5) + t.dy() - 0.5;
+
+                    auto *out = dst.ptr<DstType>(y) + x0 * DstFmt::Channels;
+                    for (int x = x0; x < x1; ++x, sx += t.m11(), sy += t.m12(), out += DstFmt::Channels) {
+                        RgbaFloat c;
+                        if (self.mSmooth) {
+                            c = sample<SrcFmt>(src, sx, sy, fill);
+                        } else {
+                            c = load<SrcFmt>(src, qRound(sx), qRound(sy), fill);
+                        }
+
+                        DstFmt::store(out, RgbaFloat{c.r + bias, c.g + bias, c.b + bias, c.a + bias});
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    static constexpr FmtMap kMapSame = {{{ImgFmt::Gray8, ImgFmt::Gray8},
+                                         {ImgFmt::Gray16, ImgFmt::Gray16},
+                                         {ImgFmt::BGR888, ImgFmt::BGR888},
+                                         {ImgFmt::RGB888, ImgFmt::RGB888},
+                                         {ImgFmt::ARGB32, ImgFmt::ARGB32},
+                                         {ImgFmt::RGBA8888, ImgFmt::RGBA8888},
+                                         {ImgFmt::RGBA64, ImgFmt::RGBA64},
+                                         {ImgFmt::RGBAFP32, ImgFmt::RGBAFP32}}};
+
+    static constexpr FmtMap kMapAlpha = {{{ImgFmt::Gray8, ImgFmt::ARGB32},
+                                          {ImgFmt::Gray16, ImgFmt::RGBA64},
+                                          {ImgFmt::BGR888, ImgFmt::ARGB32},
+                                          {ImgFmt::RGB888, ImgFmt::RGBA8888},
+                                          {ImgFmt::ARGB32, ImgFmt::ARGB32},
+                                          {ImgFmt::RGBA8888, ImgFmt::RGBA8888},
+                                          {ImgFmt::RGBA64, ImgFmt::RGBA64},
+                                          {ImgFmt::RGBAFP32, ImgFmt::RGBAFP32}}};
+
+    static constexpr int kCaps = cap_gray | cap_bgr | cap_rgb;
+    static constexpr DispatchTable kTableSame = makeTable<DkAffineKernel>(kMapSame);
+    static constexpr DispatchTable kTableAlpha = makeTable<DkAffineKernel>(kMapAlpha);
+
+public:
+    // returns false if the source format is not supported
+    bool run() override
+    {
+        const QImage &src = mSrc.img();
+
+        // QImage::Format_RGB32 etc. are handled like their alpha variants, so ask Qt
+        const bool srcAlpha = src.hasAlphaChannel();
+        const bool addAlpha = mAlpha && !srcAlpha;
+
+        auto map = addAlpha ? kMapAlpha : kMapSame;
+        auto table = addAlpha ? kTableAlpha : kTableSame;
+
+        auto dstFormat = findFormat(map, qtImageFormatToNative(src.format()));
+        if (dstFormat == ImgFmt::Invalid || mSize.isEmpty()) {
+            return false;
+        }
+
+        // gray color spaces cannot be assigned to rgb images
+        const bool grayToRgb = src.pixelFormat().colorModel() == QPixelFormat::Grayscale && addAlpha;
+        if (grayToRgb && src.colorSpace().isValid()) {
+            return false;
+        }
+
+        QImage::Format qtFormat = addAlpha ? nativeFormatToQtFormat(dstFormat) : src.format();
+        QImage dst{mSize, qtFormat};
+        if (dst.isNull()) {
+            return false;
+        }
+
+        dst.setColorSpace(src.colorSpace());
+        dst.setDotsPerMeterX(src.dotsPerMeterX());
+        dst.setDotsPerMeterY(src.dotsPerMeterY());
+        dst.setDevicePixelRatio(src.devicePixelRatio());
+        for (const QString &key : src.textKeys()) {
+            dst.setText(key, src.text(key));
+        }
+
+        mFill = {float(mFillColor.redF()), float(mFillColor.greenF()), float(mFillColor.blueF()), 1.0f};
+        if (dst.pixelFormat().colorModel() == QPixelFormat::Grayscale) {
+            mFill.r = qGray(mFillColor.rgb()) / 255.0f; // gray formats store the red channel
+        }
+        if (dst.hasAlphaChannel()) {
+            mFill.a = float(mFillColor.alphaF());
+        }
+
+        mDst = DkNativeImage::fromImage(std::move(dst));
+
+        const int numTileRows = (mSize.height() + kTileSize - 1) / kTileSize;
+        return dispatch(table, kCaps, src.format(), this, {0, numTileRows});
+    }
+
+    QImage result() const override
+    {
+        return mDst.img();
+    }
+};
+
+#endif // WITH_OPENCV
+
+/**
+ * Resample the part of src that maps into a size image.
+ * Returns a null image if the format is not supported natively.
+ **/
+static QImage affineImage(const QImage &src,
+                          const QTransform &srcToDst,
+                          const QSize &size,
+                          const QColor &fill,
+                          bool smooth,
+                          bool alpha)
+{
+#ifdef WITH_OPENCV
+    // other formats would be converted first, QPainter is faster for those
+    if (qtImageFormatToNative(src.format()) == ImgFmt::Invalid) {
+        return {};
+    }
+
+    if (!srcToDst.isAffine() || !srcToDst.isInvertible()) {
+        return {};
+    }
+
+    DkAffineKernel kernel{src, srcToDst, size, fill, smooth, alpha};
+    return kernel.run() ? kernel.result() : QImage{};
+#else
+    Q_UNUSED(src);
+    Q_UNUSED(srcToDst);
+    Q_UNUSED(size);
+    Q_UNUSED(fill);
+    Q_UNUSED(smooth);
+    Q_UNUSED(alpha);
+    return {};
+#endif
+}
+
 QImage DkImage::rotateImage(const QImage &img, double angle)
 {
     angle = std::fmod(angle, 360);
@@ -488,15 +742,23 @@ QImage DkImage::rotateImage(const QImage &img, double angle)
 #endif
     }
 
+    QTransform tx;
+    tx.rotate(angle);
+
+    // like QImage::transformed() the rotated image is moved to the origin
+    QSize size = tx.mapRect(img.rect()).size();
+    QTransform srcToDst = QImage::trueMatrix(tx, img.width(), img.height());
+    QImage rotated = affineImage(img, srcToDst, size, Qt::transparent, true, true);
+    if (!rotated.isNull()) {
+        return rotated;
+    }
+
     // we need this or else we get RGBA image with gray colorspace (Qt bug??)
     QImage tmp = img;
     if (tmp.pixelFormat().colorModel() == QPixelFormat::Grayscale && tmp.colorSpace().isValid()) {
         tmp.convertToColorSpace(QColorSpace::SRgb);
     }
 
-    QTransform tx;
-    tx.rotate(angle);
-
     tmp = tmp.transformed(tx, Qt::SmoothTransformation);
     unpremultiply(tmp);
     return tmp;
@@ -520,17 +782,216 @@ public:
     }
 
 protected:
+    static constexpr int kChunkSize = 512; // pixels per chunk, the planar buffers stay in L1
+    static constexpr int kLutSize = 4096; // interpolated decoding table for 16 bit and float input
+    static constexpr int kEncodeSize = 65535; // interpolated encoding table, one entry per output value
+    static constexpr float kExactBelow = 16.0f / kEncodeSize; // gamma is steep for dark values, encode them exactly
+
     const DkNativeImage mSrc;
     DkNativeImage mDst{};
-    QColorTransform mSrcToLinear{};
+    QColorTransform mSrcToLinear{}; // color spaces we have no tables for
+
+    // sRGB, Display P3, Adobe RGB & linear variants skip QColorTransform
+    bool mUseLut = false;
+    std::array<float, 3> mWeights{}; // linear rgb to Y (D65)
+    QColorSpace::TransferFunction mTransfer = QColorSpace::TransferFunction::Linear;
+    float mGamma = 1.0f;
+    std::array<float, 256> mLut8{};
+    std::vector<float> mLut;
+    DkColorSimd::LumaFn mLuma = nullptr;
+    DkColorSimd::DecodeFn mDecode = nullptr;
+    DkColorSimd::EncodeFn mEncode = nullptr;
+
+    bool initLut(const QColorSpace &cs)
+    {
+        switch (cs.primaries()) {
+        case QColorSpace::Primaries::SRgb:
+            mWeights = {0.2126729f, 0.7151522f, 0.0721750f};
+            break;
+        case QColorSpace::Primaries::DciP3D65:
+            mWeights = {0.2289746f, 0.6917385f, 0.0792869f};
+            break;
+        case QColorSpace::Primaries::AdobeRgb:
+            mWeights = {0.2973450f, 0.6273636f, 0.0752915f};
+            break;
+        default:
+            return false;
+        }
+
+        mTransfer = cs.transferFunction();
+        switch (mTransfer) {
+        case QColorSpace::TransferFunction::SRgb:
+        case QColorSpace::TransferFunction::Linear:
+            break;
+        case QColorSpace::TransferFunction::Gamma:
+            mGamma = cs.gamma();
+            break;
+        default:
+            return false;
+        }
+
+        for (int idx = 0; idx < 256; idx++) {
+            mLut8[idx] = toLinearExact(idx / 255.0f);
+        }
+
+        // the extra entry saves a bounds check when interpolating 1.0
+        mLut.resize(kLutSize + 1);
+        for (int idx = 0; idx < kLutSize; idx++) {
+            mLut[idx] = toLinearExact(idx / float(kLutSize - 1));
+        }
+        mLut[kLutSize] = mLut[kLutSize - 1];
+
+        mLuma = DkColorSimd::luma();
+        mDecode = DkColorSimd::decode();
+        mEncode = DkColorSimd::encode();
+
+        return true;
+    }
+
+    // negative values (extended range float) are mirrored like Qt does
+    float toLinearExact(float v) const
+    {
+        float a = std::abs(v);
+        switch (mTransfer) {
+        case QColorSpace::TransferFunction::SRgb:
+            a = a <= 0.04045f ? a / 12.92f : std::pow((a + 0.055f) / 1.055f, 2.4f);
+            break;
+        case QColorSpace::TransferFunction::Gamma:
+            a = std::pow(a, mGamma);
+            break;
+        default:;
+        }
+        return std::copysign(a, v);
+    }
+
+    template<typename T>
+    float toLinear(T v) const
+    {
+        if constexpr (std::is_same_v<T, uint8_t>) {
+            return mLut8[v];
+        } else {
+            if constexpr (std::is_same_v<T, float>) {
+                if (!(v >= 0.0f && v <= 1.0f)) {
+                    return toLinearExact(v); // HDR or NaN
+                }
+            }
+
+            constexpr float toIndex = (kLutSize - 1) / (std::is_floating_point_v<T> ? 1.0f : 65535.0f);
+            float x = v * toIndex;
+            int idx = static_cast<int>(x);
+            float f = x - idx;
+            return mLut[idx] + f * (mLut[idx + 1] - mLut[idx]);
+        }
+    }
+
+    // Y [0,1] to gamma 2.2 in [0,65535], not rounded so that interpolating stays within 1/2 LSB
+    static const std::vector<float> &encodeLut()
+    {
+        static const std::vector<float> lut = [] {
+            // the extra entry saves a bounds check when interpolating 1.0
+            std::vector<float> l(kEncodeSize + 2);
+            for (int idx = 0; idx <= kEncodeSize; idx++) {
+                l[idx] = static_cast<float>(std::pow(idx / double(kEncodeSize), 1.0 / 2.2) * kEncodeSize);
+            }
+            l[kEncodeSize + 1] = l[kEncodeSize];
+            return l;
+        }();
+        return lut;
+    }
 
     template<typename SrcFmt, typename DstFmt>
     static bool kernel(const std::any &arg, const DkWorkRange &range)
+    {
+        auto &self = *(std::any_cast<DkGrayScaleKernel *>(arg));
+        return self.mUseLut ? kernelLut<SrcFmt, DstFmt>(self, range) : kernelTransform<SrcFmt, DstFmt>(self, range);
+    }
+
+    // decode to planar linear rgb chunks, then decoding (8 bit argb), Y and encoding run vectorized
+    template<typename SrcFmt, typename DstFmt>
+    static bool kernelLut(DkGrayScaleKernel &self, const DkWorkRange &range)
+    {
+        using SrcType = typename SrcFmt::ChannelType;
+        using DstType = typename DstFmt::ChannelType;
+
+        const auto &src = self.mSrc.constMat();
+        auto &dst = self.mDst.mat();
+
+        Q_ASSERT(SrcFmt::isCompatibleWith(src));
+        Q_ASSERT(DstFmt::isCompatibleWith(dst));
+        Q_ASSERT(src.size == dst.size);
+        Q_ASSERT(range.isWithin(0, src.rows));
+
+        constexpr bool isBgr = SrcFmt::Type == ImgType::bgr;
+        constexpr int rIdx = isBgr ? 2 : 0;
+        constexpr int bIdx = isBgr ? 0 : 2;
+        constexpr bool linearOut = std::is_same_v<DstType, float>;
+        constexpr float invScale = 1.0f / SrcFmt::Scale;
+
+        alignas(32) float r[kChunkSize], g[kChunkSize], b[kChunkSize], y[kChunkSize];
+        alignas(32) uint16_t q[kChunkSize];
+        const auto &encode = encodeLut();
+
+        for (int row = range.begin; row < range.end; ++row) {
+            const auto *srcPtr = src.ptr<SrcType>(row);
+            auto *dstPtr = dst.ptr<DstType>(row);
+
+            for (int col = 0; col < src.cols; col += kChunkSize) {
+                const int n = std::min(kChunkSize, src.cols - col);
+
+                const SrcType *pixel = srcPtr + col * SrcFmt::Channels;
+                if constexpr (std::is_same_v<SrcType, uint8_t> && SrcFmt::Channels == 4) {
+                    self.mDecode(pixel, isBgr ? b : r, g, isBgr ? r : b, n, self.mLut8.data());
+                } else {
+                    for (int idx = 0; idx < n; idx++, pixel += SrcFmt::Channels) {
+                        r[idx] = self.toLinear(pixel[rIdx]);
+                        g[idx] = self.toLinear(pixel[1]);
+                        b[idx] = self.toLinear(pixel[bIdx]);
+                    }
+                }
+
+                self.mLuma(r, g, b, y, n, self.mWeights.data());
+                if constexpr (!linearOut) {
+                    self.mEncode(y, q, n, encode.data(), kEncodeSize);
+                }
+
+                pixel = srcPtr + col * SrcFmt::Channels;
+                DstType *out = dstPtr + col * DstFmt::Channels;
+                for (int idx = 0; idx < n; idx++, pixel += SrcFmt::Channels, out += DstFmt::Channels) {
+                    DstType v;
+                    if constexpr (linearOut) {
+                        v = y[idx];
+                    } else if (y[idx] < kExactBelow) {
+                        float yc = y[idx] > 0.0f ? y[idx] : 0.0f;
+                        v = static_cast<DstType>(std::pow(yc, 1.0f / 2.2f) * 65535.0f + 0.5f);
+                    } else {
+                        v = q[idx];
+                    }
+
+                    out[0] = v;
+                    if constexpr (DstFmt::Channels == 4) {
+                        float a = 1.0f;
+                        if constexpr (SrcFmt::Channels == 4) {
+                            a = pixel[3] * invScale;
+                        }
+                        out[1] = out[2] = v;
+                        if constexpr (linearOut) {
+                            out[3] = a;
+                        } else {
+                            out[3] = static_cast<DstType>(a * DstFmt::Scale + 0.5f);
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    template<typename SrcFmt, typename DstFmt>
+    static bool kernelTransform(DkGrayScaleKernel &self, const DkWorkRange &range)
     {
         using SrcType = typename SrcFmt::ChannelType;
         using DstType = typename DstFmt::ChannelType;
 
-        auto &self = *(std::any_cast<DkGrayScaleKernel *>(arg));
         const auto &src = self.mSrc.constMat();
         auto &dst = self.mDst.mat();
         auto &srcToLinear = self.mSrcToLinear;
@@ -615,7 +1076,10 @@ public:
             srcColorSpace = QColorSpace{QColorSpace::SRgb}; // FIXME: DkImage::defaultColorSpace(img)
         }
 
-        mSrcToLinear = srcColorSpace.transformationToColorSpace(QColorSpace::SRgbLinear);
+        mUseLut = initLut(srcColorSpace);
+        if (!mUseLut) {
+            mSrcToLinear = srcColorSpace.transformationToColorSpace(QColorSpace::SRgbLinear);
+        }
 
         bool usesAlpha = DkImage::alphaChannelUsed(mSrc.img());
 
@@ -1213,6 +1677,13 @@ QImage DkImage::cropToImage(const QImage &src, const DkRotatingRect &rect, const
         }
     }
 
+    // resample the crop area only
+    QSize outSize{qRound(cImgSize.x()), qRound(cImgSize.y())};
+    QImage out = affineImage(src, tForm, outSize, fillColor, rotated, fillColor.alpha() < 255);
+    if (!out.isNull()) {
+        return out;
+    }
+
     // try to keep the pixel format; add alpha channel if fill color is transparent
     QImage::Format outFormat = src.format();
     if (fillColor.alpha() < 255) {
@@ -1224,7 +1695,7 @@ QImage DkImage::cropToImage(const QImage &src, const DkRotatingRect &rect, const
         outFormat = QImage::Format_ARGB32;
     }
 
-    QImage img = QImage(qRound(cImgSize.x()), qRound(cImgSize.y()), outFormat);
+    QImage img = QImage(outSize, outFormat);
     img.setColorSpace(src.colorSpace());
 
     if (outFormat == QImage::Format_Mono || outFormat == QImage::Format_MonoLSB) {
@@ -1986,15 +2457,9 @@ QPixmap DkImage::loadIcon(const QString &filePath, const QColor &col, const QSiz
 
 QPixmap DkImage::loadFromSvg(const QString &filePath, const QSize &size)
 {
-    QSharedPointer<QSvgRenderer> svg(new QSvgRenderer(filePath));
-
-    QPixmap pm(size);
-    pm.fill(QColor(0, 0, 0, 0)); // clear background
-
-    QPainter p(&pm);
-    svg->render(&p);
-
-    return pm;
+    // render for the highest screen resolution, the pixmap keeps its logical size
+    qreal dpr = qGuiApp ? qGuiApp->devicePixelRatio() : 1.0;
+    return QPixmap::fromImage(DkIconAtlas::instance().icon(filePath, size * dpr, dpr, QColor()));
 }
 
 class DkSvgIconEngine : public QIconEngine
@@ -2026,11 +2491,22 @@ private:
 
     void paint(QPainter *painter, const QRect &bounds, QIcon::Mode mode, QIcon::State state) override
     {
-        QPixmap pix = pixmap(bounds.size(), mode, state);
+        qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+        QPixmap pix = scaledPixmap(bounds.size() * dpr, mode, state, dpr);
         painter->drawPixmap(bounds, pix);
     }
 
     QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override
+    {
+        return scaledPixmap(size, mode, state, 1.0);
+    }
+
+    // size is in device pixels, QIcon sets the final device pixel ratio
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QPixmap scaledPixmap(const QSize &size, QIcon::Mode mode, QIcon::State state, qreal scale) override
+#else
+    QPixmap scaledPixmap(const QSize &size, QIcon::Mode mode, QIcon::State state, qreal scale)
+#endif
     {
         //  we don't support these modes yet, so don't render or cache them
         if (mode == QIcon::Mode::Active || mode == QIcon::Mode::Selected)
@@ -2050,11 +2526,12 @@ private:
         if (mode == QIcon::Mode::Disabled)
             color = Qt::gray; // TODO: pull from theme
 
-        QString key = QStringLiteral("icon.%1.%2.%3.%4.%5.%6")
+        QString key = QStringLiteral("icon.%1.%2.%3.%4.%5.%6.%7")
                           .arg(filePath)
                           .arg(color.name())
                           .arg(size.width())
                           .arg(size.height())
+                          .arg(scale)
                           .arg(mode)
                           .arg(state);
 
@@ -2062,16 +2539,8 @@ private:
         if (QPixmapCache::find(key, &pix))
             return pix;
 
-        pix = QPixmap(size);
-        pix.fill(Qt::transparent);
-
-        {
-            QPainter painter(&pix);
-            QSvgRenderer(filePath).render(&painter, pix.rect());
-
-            painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-            painter.fillRect(pix.rect(), color);
-        }
+        // rendered icons persist in the atlas
+        pix = QPixmap::fromImage(DkIconAtlas::instance().icon(filePath, size, scale, color));
 
         QPixmapCache::insert(key, pix);
 
@@ -0,0 +1,1300 @@
+/*******************************************************************************************************
+ DkJpegTransform.cpp
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkJpegTransform.h"
+
+#include <QObject>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace nmc
+{
+
+namespace
+{
+// JPEG markers we care about
+enum Marker {
+    m_sof0 = 0xC0,
+    m_sof1 = 0xC1,
+    m_sof15 = 0xCF,
+    m_dht = 0xC4,
+    m_dac = 0xCC,
+    m_rst0 = 0xD0,
+    m_rst7 = 0xD7,
+    m_soi = 0xD8,
+    m_eoi = 0xD9,
+    m_sos = 0xDA,
+    m_dqt = 0xDB,
+    m_dnl = 0xDC,
+    m_dri = 0xDD,
+    m_app0 = 0xE0,
+    m_app15 = 0xEF,
+    m_com = 0xFE,
+    m_tem = 0x01,
+};
+
+// zig-zag index -> natural (row major) index
+const int zigzag[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+                        41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+                        30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// transform matrices (row major) in the order of DkJpegTransform::Transform
+const int transformMatrices[DkJpegTransform::transform_end][4] = {
+    {1, 0, 0, 1}, // none
+    {-1, 0, 0, 1}, // flip h
+    {1, 0, 0, -1}, // flip v
+    {0, 1, 1, 0}, // transpose
+    {0, -1, -1, 0}, // transverse
+    {0, -1, 1, 0}, // rotate 90
+    {-1, 0, 0, -1}, // rotate 180
+    {0, 1, -1, 0}, // rotate 270
+};
+
+int ceilDiv(int a, int b)
+{
+    return (a + b - 1) / b;
+}
+
+int numBits(int v)
+{
+    int n = 0;
+    while (v) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+}
+
+struct Segment {
+    int marker = 0;
+    int start = 0; // position of the 0xFF byte
+    int data = 0; // payload position (after the length field)
+    int length = 0; // payload length
+    int end = 0; // position after the segment
+};
+
+/**
+ * Read the marker segment at pos.
+ * Standalone markers (SOI, EOI, RSTn) have no payload.
+ **/
+bool readSegment(const uchar *d, int size, int pos, Segment &s)
+{
+    if (pos >= size || d[pos] != 0xFF)
+        return false;
+
+    s.start = pos;
+
+    // skip fill bytes
+    while (pos < size && d[pos] == 0xFF)
+        pos++;
+
+    if (pos >= size)
+        return false;
+
+    s.marker = d[pos++];
+
+    if (s.marker == m_soi || s.marker == m_eoi || s.marker == m_tem || (s.marker >= m_rst0 && s.marker <= m_rst7)) {
+        s.data = pos;
+        s.length = 0;
+        s.end = pos;
+        return true;
+    }
+
+    if (pos + 2 > size)
+        return false;
+
+    int len = (d[pos] << 8) | d[pos + 1];
+    if (len < 2 || pos + len > size)
+        return false;
+
+    s.data = pos + 2;
+    s.length = len - 2;
+    s.end = pos + len;
+
+    return true;
+}
+
+class HuffDecoder
+{
+public:
+    bool build(const uchar *counts, const uchar *symbols, int numSymbols)
+    {
+        mDefined = false;
+        std::memset(mLookup, 0, sizeof(mLookup));
+
+        int code = 0;
+        int k = 0;
+
+        for (int l = 1; l <= 16; l++) {
+            mValPtr[l] = k;
+            mMinCode[l] = code;
+
+            for (int i = 0; i < counts[l - 1]; i++) {
+                // more codes than bits (over-subscribed), this would index past mLookup
+                if (k >= numSymbols || code >= (1 << l))
+                    return false;
+
+                if (l <= lookup_bits) {
+                    int shift = lookup_bits - l;
+                    for (int j = 0; j < (1 << shift); j++)
+                        mLookup[(code << shift) | j] = static_cast<uint16_t>((l << 8) | symbols[k]);
+                }
+
+                mVals[k] = symbols[k];
+                k++;
+                code++;
+            }
+
+            mMaxCode[l] = counts[l - 1] ? code - 1 : -1;
+            code <<= 1;
+        }
+
+        mDefined = true;
+        return true;
+    }
+
+    bool isDefined() const
+    {
+        return mDefined;
+    }
+
+    static const int lookup_bits = 9;
+
+    uint16_t mLookup[1 << lookup_bits] = {};
+    int mMaxCode[17] = {};
+    int mMinCode[17] = {};
+    int mValPtr[17] = {};
+    uchar mVals[256] = {};
+    bool mDefined = false;
+};
+
+class BitReader
+{
+public:
+    BitReader(const uchar *data, int pos, int size)
+        : mData(data)
+        , mPos(pos)
+        , mSize(size)
+    {
+    }
+
+    void fill()
+    {
+        while (mCount <= 56) {
+            uint64_t b = 0;
+
+            if (!mMarker && mPos < mSize) {
+                b = mData[mPos];
+                if (b == 0xFF) {
+                    int next = mPos + 1 < mSize ? mData[mPos + 1] : -1;
+                    if (next == 0x00) {
+                        mPos += 2;
+                    } else {
+                        // never consume markers
+                        mMarker = true;
+                        b = 0;
+                        mPadded++;
+                    }
+                } else
+                    mPos++;
+            } else
+                mPadded++;
+
+            mBuffer |= b << (56 - mCount);
+            mCount += 8;
+        }
+    }
+
+    int bits(int n)
+    {
+        if (n == 0)
+            return 0;
+
+        if (mCount < n)
+            fill();
+
+        int v = static_cast<int>(mBuffer >> (64 - n));
+        mBuffer <<= n;
+        mCount -= n;
+        return v;
+    }
+
+    int decode(const HuffDecoder &t)
+    {
+        if (mCount < 16)
+            fill();
+
+        uint16_t e = t.mLookup[mBuffer >> (64 - HuffDecoder::lookup_bits)];
+        if (e) {
+            int len = e >> 8;
+            mBuffer <<= len;
+            mCount -= len;
+            return e & 0xFF;
+        }
+
+        for (int l = HuffDecoder::lookup_bits + 1; l <= 16; l++) {
+            int code = static_cast<int>(mBuffer >> (64 - l));
+            if (code <= t.mMaxCode[l]) {
+                mBuffer <<= l;
+                mCount -= l;
+                return t.mVals[t.mValPtr[l] + code - t.mMinCode[l]];
+            }
+        }
+
+        return -1;
+    }
+
+    static int extend(int v, int s)
+    {
+        return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+    }
+
+    // true if we decoded past the end of the entropy coded segment
+    bool overrun() const
+    {
+        return mCount < mPadded * 8;
+    }
+
+    /**
+     * Discard remaining bits and skip the next RSTn marker.
+     **/
+    bool restart()
+    {
+        mBuffer = 0;
+        mCount = 0;
+        mPadded = 0;
+        mMarker = false;
+
+        while (mPos + 1 < mSize) {
+            if (mData[mPos] == 0xFF && mData[mPos + 1] >= m_rst0 && mData[mPos + 1] <= m_rst7) {
+                mPos += 2;
+                return true;
+            }
+            mPos++;
+        }
+
+        return false;
+    }
+
+    /**
+     * Position of the next marker that is not a restart marker.
+     **/
+    int nextMarker() const
+    {
+        int pos = mPos;
+        while (pos + 1 < mSize) {
+            int m = mData[pos + 1];
+            if (mData[pos] == 0xFF && m != 0x00 && m != 0xFF && !(m >= m_rst0 && m <= m_rst7))
+                return pos;
+            pos++;
+        }
+
+        return mSize;
+    }
+
+private:
+    const uchar *mData;
+    int mPos;
+    int mSize;
+    uint64_t mBuffer = 0;
+    int mCount = 0;
+    int mPadded = 0;
+    bool mMarker = false;
+};
+
+class HuffEncoder
+{
+public:
+    /**
+     * Create optimal code lengths (max 16 bits) for the symbol statistics.
+     * See JPEG spec K.2 and libjpeg's jpeg_gen_optimal_table()
+     **/
+    void build(const std::vector<long> &stats)
+    {
+        long freq[257];
+        int codeSize[257] = {};
+        int others[257];
+        int bits[33] = {};
+
+        for (int i = 0; i < 256; i++)
+            freq[i] = stats[i];
+        freq[256] = 1; // reserve one code point, no code of all 1s
+        std::fill(others, others + 257, -1);
+
+        for (;;) {
+            // smallest nonzero frequency (largest symbol for ties)
+            int c1 = -1;
+            long v = 1000000000L;
+            for (int i = 0; i <= 256; i++) {
+                if (freq[i] && freq[i] <= v) {
+                    v = freq[i];
+                    c1 = i;
+                }
+            }
+
+            int c2 = -1;
+            v = 1000000000L;
+            for (int i = 0; i <= 256; i++) {
+                if (freq[i] && freq[i] <= v && i != c1) {
+                    v = freq[i];
+                    c2 = i;
+                }
+            }
+
+            if (c2 < 0)
+                break;
+
+            freq[c1] += freq[c2];
+            freq[c2] = 0;
+
+            codeSize[c1]++;
+            while (others[c1] >= 0) {
+                c1 = others[c1];
+                codeSize[c1]++;
+            }
+            others[c1] = c2;
+
+            codeSize[c2]++;
+            while (others[c2] >= 0) {
+                c2 = others[c2];
+                codeSize[c2]++;
+            }
+        }
+
+        for (int i = 0; i <= 256; i++) {
+            if (codeSize[i])
+                bits[codeSize[i]]++;
+        }
+
+        // limit code lengths to 16 bits
+        for (int i = 32; i > 16; i--) {
+            while (bits[i] > 0) {
+                int j = i - 2;
+                while (bits[j] == 0)
+                    j--;
+
+                bits[i] -= 2;
+                bits[i - 1]++;
+                bits[j + 1] += 2;
+                bits[j]--;
+            }
+        }
+
+        // remove the reserved code point
+        int i = 16;
+        while (bits[i] == 0)
+            i--;
+        bits[i]--;
+
+        for (int l = 1; l <= 16; l++)
+            mCounts[l - 1] = static_cast<uchar>(bits[l]);
+
+        mNumSymbols = 0;
+        for (int l = 1; l <= 32; l++) {
+            for (int s = 0; s < 256; s++) {
+                if (codeSize[s] == l)
+                    mSymbols[mNumSymbols++] = static_cast<uchar>(s);
+            }
+        }
+
+        // canonical codes
+        std::memset(mSize, 0, sizeof(mSize));
+        int code = 0;
+        int k = 0;
+        for (int l = 1; l <= 16; l++) {
+            for (int c = 0; c < mCounts[l - 1]; c++) {
+                mCode[mSymbols[k]] = code++;
+                mSize[mSymbols[k]] = l;
+                k++;
+            }
+            code <<= 1;
+        }
+    }
+
+    uchar mCounts[16] = {};
+    uchar mSymbols[256] = {};
+    int mNumSymbols = 0;
+    int mCode[256] = {};
+    int mSize[256] = {};
+};
+
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray &dst)
+        : mDst(dst)
+    {
+    }
+
+    void put(int code, int size)
+    {
+        mBuffer = (mBuffer << size) | (static_cast<uint32_t>(code) & ((1u << size) - 1));
+        mCount += size;
+
+        while (mCount >= 8) {
+            uchar b = static_cast<uchar>(mBuffer >> (mCount - 8));
+            mDst.append(static_cast<char>(b));
+            if (b == 0xFF)
+                mDst.append('\0');
+            mCount -= 8;
+        }
+    }
+
+    void flush()
+    {
+        // pad with 1-bits
+        if (mCount > 0)
+            put(0x7F, 8 - mCount);
+        mBuffer = 0;
+    }
+
+private:
+    QByteArray &mDst;
+    uint64_t mBuffer = 0;
+    int mCount = 0;
+};
+
+struct CoefComponent {
+    int blocksW = 0; // padded to full MCUs
+    int blocksH = 0;
+    int dcTable = 0;
+    int acTable = 0;
+    bool decoded = false;
+    int quant[64] = {}; // natural order
+    std::vector<int16_t> coefs;
+
+    int16_t *block(int bx, int by)
+    {
+        return &coefs[(static_cast<size_t>(by) * blocksW + bx) * 64];
+    }
+};
+
+// Appends a big endian 16 bit value
+void appendWord(QByteArray &dst, int v)
+{
+    dst.append(static_cast<char>((v >> 8) & 0xFF));
+    dst.append(static_cast<char>(v & 0xFF));
+}
+
+void appendMarker(QByteArray &dst, int marker, int payloadLength)
+{
+    dst.append(static_cast<char>(0xFF));
+    dst.append(static_cast<char>(marker));
+    appendWord(dst, payloadLength + 2);
+}
+
+}
+
+// DkJpegTransform --------------------------------------------------------------------
+DkJpegTransform::Transform DkJpegTransform::fromAngle(int angle)
+{
+    angle %= 360;
+    if (angle < 0)
+        angle += 360;
+
+    switch (angle) {
+    case 0:
+        return transform_none;
+    case 90:
+        return transform_rotate_90;
+    case 180:
+        return transform_rotate_180;
+    case 270:
+        return transform_rotate_270;
+    }
+
+    return transform_end;
+}
+
+DkJpegTransform::Transform DkJpegTransform::fromOrientation(int degrees, bool mirrored)
+{
+    // the loader rotates first and flips afterwards
+    Transform r = fromAngle(degrees);
+    if (r == transform_end || !mirrored)
+        return r;
+
+    DkJpegTransform t;
+    t.addTransform(r);
+    t.addTransform(transform_flip_h);
+
+    return t.transform();
+}
+
+void DkJpegTransform::toOrientation(Transform t, int &degrees, bool &mirrored)
+{
+    switch (t) {
+    case transform_flip_h:
+        degrees = 0;
+        mirrored = true;
+        break;
+    case transform_flip_v:
+        degrees = 180;
+        mirrored = true;
+        break;
+    case transform_transpose:
+        degrees = 90;
+        mirrored = true;
+        break;
+    case transform_transverse:
+        degrees = 270;
+        mirrored = true;
+        break;
+    case transform_rotate_90:
+        degrees = 90;
+        mirrored = false;
+        break;
+    case transform_rotate_180:
+        degrees = 180;
+        mirrored = false;
+        break;
+    case transform_rotate_270:
+        degrees = 270;
+        mirrored = false;
+        break;
+    default:
+        degrees = 0;
+        mirrored = false;
+    }
+}
+
+bool DkJpegTransform::isJpeg(const QByteArray &data)
+{
+    return data.size() > 2 && static_cast<uchar>(data[0]) == 0xFF && static_cast<uchar>(data[1]) == m_soi;
+}
+
+bool DkJpegTransform::setSource(const QByteArray &data)
+{
+    mSource.clear();
+    mComponents.clear();
+    mSize = QSize();
+    mCrop = QRect();
+    std::memcpy(mMatrix, transformMatrices[transform_none], sizeof(mMatrix));
+
+    if (!isJpeg(data))
+        return fail(QObject::tr("not a JPEG file"));
+
+    const auto *d = reinterpret_cast<const uchar *>(data.constData());
+    int len = static_cast<int>(data.size());
+    int pos = 2;
+    Segment s;
+
+    while (readSegment(d, len, pos, s)) {
+        pos = s.end;
+
+        if (s.marker == m_sos || s.marker == m_eoi)
+            break;
+
+        if (s.marker < 0xC0 || s.marker > m_sof15 || s.marker == m_dht || s.marker == m_dac || s.marker == 0xC8)
+            continue;
+
+        if (s.marker != m_sof0 && s.marker != m_sof1)
+            return fail(QObject::tr("only sequential Huffman JPEGs can be transformed losslessly"));
+
+        const uchar *p = d + s.data;
+        int nf = s.length >= 6 ? p[5] : 0;
+
+        if (s.length < 6 + nf * 3 || nf < 1 || nf > 4)
+            return fail(QObject::tr("corrupted frame header"));
+
+        if (p[0] != 8)
+            return fail(QObject::tr("only 8 bit JPEGs are supported"));
+
+        mSofMarker = s.marker;
+        mSize = QSize((p[3] << 8) | p[4], (p[1] << 8) | p[2]);
+        mHmax = 1;
+        mVmax = 1;
+
+        for (int idx = 0; idx < nf; idx++) {
+            Component c;
+            c.id = p[6 + idx * 3];
+            c.h = p[7 + idx * 3] >> 4;
+            c.v = p[7 + idx * 3] & 0x0F;
+            c.tq = p[8 + idx * 3] & 0x03;
+
+            if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4)
+                return fail(QObject::tr("illegal sampling factors"));
+
+            // sampling factors are meaningless for a single component
+            if (nf == 1)
+                c.h = c.v = 1;
+
+            mHmax = qMax(mHmax, c.h);
+            mVmax = qMax(mVmax, c.v);
+            mComponents << c;
+        }
+
+        if (mSize.isEmpty())
+            return fail(QObject::tr("JPEGs with DNL markers are not supported"));
+
+        mSource = data;
+        return true;
+    }
+
+    return fail(QObject::tr("no frame header found"));
+}
+
+void DkJpegTransform::setTrim(bool trim)
+{
+    mTrim = trim;
+}
+
+bool DkJpegTransform::addTransform(Transform t)
+{
+    if (t < 0 || t >= transform_end || !mCrop.isNull())
+        return false;
+
+    const int *a = transformMatrices[t];
+    const int *b = mMatrix;
+
+    int m[4] = {a[0] * b[0] + a[1] * b[2],
+                a[0] * b[1] + a[1] * b[3],
+                a[2] * b[0] + a[3] * b[2],
+                a[2] * b[1] + a[3] * b[3]};
+
+    std::memcpy(mMatrix, m, sizeof(mMatrix));
+
+    return true;
+}
+
+bool DkJpegTransform::setCrop(const QRect &rect)
+{
+    if (rect.isNull()) {
+        mCrop = QRect();
+        return true;
+    }
+
+    QSize mcu = mcuSize();
+    if (!QRect(QPoint(), transformedSize()).contains(rect) || rect.isEmpty())
+        return fail(QObject::tr("crop rectangle is outside the image"));
+
+    if (rect.x() % mcu.width() || rect.y() % mcu.height())
+        return fail(QObject::tr("crop rectangle is not aligned to %1x%2 blocks").arg(mcu.width()).arg(mcu.height()));
+
+    mCrop = rect;
+
+    return true;
+}
+
+DkJpegTransform::Transform DkJpegTransform::transform() const
+{
+    for (int idx = 0; idx < transform_end; idx++) {
+        if (std::memcmp(mMatrix, transformMatrices[idx], sizeof(mMatrix)) == 0)
+            return static_cast<Transform>(idx);
+    }
+
+    return transform_end;
+}
+
+QRect DkJpegTransform::crop() const
+{
+    return mCrop;
+}
+
+QSize DkJpegTransform::sourceSize() const
+{
+    return mSize;
+}
+
+QSize DkJpegTransform::transformedSize() const
+{
+    QSize s = trimmedSourceSize();
+    return isTransposed() ? s.transposed() : s;
+}
+
+QSize DkJpegTransform::size() const
+{
+    return mCrop.isNull() ? transformedSize() : mCrop.size();
+}
+
+QSize DkJpegTransform::mcuSize() const
+{
+    if (mComponents.size() <= 1)
+        return QSize(8, 8);
+
+    QSize s(8 * mHmax, 8 * mVmax);
+    return isTransposed() ? s.transposed() : s;
+}
+
+bool DkJpegTransform::isPerfect() const
+{
+    int mcuW = mComponents.size() <= 1 ? 8 : 8 * mHmax;
+    int mcuH = mComponents.size() <= 1 ? 8 : 8 * mVmax;
+
+    return !(isMirroredX() && mSize.width() % mcuW) && !(isMirroredY() && mSize.height() % mcuH);
+}
+
+bool DkJpegTransform::isIdentity() const
+{
+    return transform() == transform_none && (mCrop.isNull() || mCrop == QRect(QPoint(), mSize));
+}
+
+QString DkJpegTransform::errorString() const
+{
+    return mError;
+}
+
+bool DkJpegTransform::fail(const QString &msg)
+{
+    mError = msg;
+    return false;
+}
+
+bool DkJpegTransform::isTransposed() const
+{
+    return mMatrix[0] == 0;
+}
+
+bool DkJpegTransform::isMirroredX() const
+{
+    // source = M^T * dst
+    return isTransposed() ? mMatrix[2] < 0 : mMatrix[0] < 0;
+}
+
+bool DkJpegTransform::isMirroredY() const
+{
+    return isTransposed() ? mMatrix[1] < 0 : mMatrix[3] < 0;
+}
+
+QSize DkJpegTransform::trimmedSourceSize() const
+{
+    QSize s = mSize;
+    int mcuW = mComponents.size() <= 1 ? 8 : 8 * mHmax;
+    int mcuH = mComponents.size() <= 1 ? 8 : 8 * mVmax;
+
+    if (!mTrim)
+        return s;
+
+    if (isMirroredX())
+        s.setWidth(s.width() - s.width() % mcuW);
+    if (isMirroredY())
+        s.setHeight(s.height() - s.height() % mcuH);
+
+    return s;
+}
+
+bool DkJpegTransform::apply(QByteArray &dst)
+{
+    if (mSource.isEmpty() || mComponents.isEmpty())
+        return fail(QObject::tr("no source image"));
+
+    bool mirrorX = isMirroredX();
+    bool mirrorY = isMirroredY();
+    bool transposed = isTransposed();
+    int numComps = static_cast<int>(mComponents.size());
+    int mcuW = numComps == 1 ? 8 : 8 * mHmax;
+    int mcuH = numComps == 1 ? 8 : 8 * mVmax;
+
+    QSize srcSize = trimmedSourceSize();
+    if (srcSize.isEmpty())
+        return fail(QObject::tr("the image is smaller than a single block"));
+
+    if ((mirrorX && srcSize.width() % mcuW) || (mirrorY && srcSize.height() % mcuH))
+        return fail(QObject::tr("the transform is not perfect, edge blocks need to be trimmed"));
+
+    // decode all DCT coefficients --------------------------------------------------------------------
+    const auto *d = reinterpret_cast<const uchar *>(mSource.constData());
+    int len = static_cast<int>(mSource.size());
+
+    int mcusX = ceilDiv(mSize.width(), mcuW);
+    int mcusY = ceilDiv(mSize.height(), mcuH);
+
+    std::vector<CoefComponent> comps(numComps);
+    for (int idx = 0; idx < numComps; idx++) {
+        comps[idx].blocksW = mcusX * mComponents[idx].h;
+        comps[idx].blocksH = mcusY * mComponents[idx].v;
+        comps[idx].coefs.assign(static_cast<size_t>(comps[idx].blocksW) * comps[idx].blocksH * 64, 0);
+    }
+
+    int quant[4][64] = {};
+    bool quantDefined[4] = {};
+    HuffDecoder dcTables[4];
+    HuffDecoder acTables[4];
+    int restartInterval = 0;
+    bool scanned = false;
+
+    // APPn & COM segments that are copied to the output
+    QVector<QPair<int, int>> keep;
+
+    int pos = 2;
+    Segment s;
+
+    while (readSegment(d, len, pos, s)) {
+        pos = s.end;
+        const uchar *p = d + s.data;
+
+        if (s.marker == m_eoi)
+            break;
+
+        if (((s.marker >= m_app0 && s.marker <= m_app15) || s.marker == m_com) && !scanned) {
+            keep << qMakePair(s.start, s.end);
+        } else if (s.marker == m_dqt) {
+            int i = 0;
+            while (i < s.length) {
+                int pq = p[i] >> 4;
+                int tq = p[i] & 0x0F;
+                int n = pq ? 129 : 65;
+
+                if (tq > 3 || i + n > s.length)
+                    return fail(QObject::tr("corrupted quantization table"));
+
+                for (int k = 0; k < 64; k++)
+                    quant[tq][zigzag[k]] = pq ? (p[i + 1 + 2 * k] << 8) | p[i + 2 + 2 * k] : p[i + 1 + k];
+
+                quantDefined[tq] = true;
+                i += n;
+            }
+        } else if (s.marker == m_dht) {
+            int i = 0;
+            while (i + 17 <= s.length) {
+                int tc = p[i] >> 4;
+                int th = p[i] & 0x0F;
+                const uchar *counts = p + i + 1;
+
+                int n = 0;
+                for (int k = 0; k < 16; k++)
+                    n += counts[k];
+
+                if (tc > 1 || th > 3 || n > 256 || i + 17 + n > s.length)
+                    return fail(QObject::tr("corrupted Huffman table"));
+
+                HuffDecoder &t = tc == 0 ? dcTables[th] : acTables[th];
+                if (!t.build(counts, p + i + 17, n))
+                    return fail(QObject::tr("corrupted Huffman table"));
+
+                i += 17 + n;
+            }
+        } else if (s.marker == m_dri) {
+            if (s.length < 2)
+                return fail(QObject::tr("corrupted restart interval"));
+            restartInterval = (p[0] << 8) | p[1];
+        } else if (s.marker == m_dnl) {
+            return fail(QObject::tr("JPEGs with DNL markers are not supported"));
+        } else if (s.marker == m_sos) {
+            scanned = true;
+
+            int ns = s.length > 0 ? p[0] : 0;
+            if (ns < 1 || ns > 4 || s.length < 4 + ns * 2)
+                return fail(QObject::tr("corrupted scan header"));
+
+            int ss = p[1 + ns * 2];
+            int se = p[2 + ns * 2];
+            int ahal = p[3 + ns * 2];
+            if (ss != 0 || se != 63 || ahal != 0)
+                return fail(QObject::tr("only sequential scans are supported"));
+
+            QVector<int> scanComps;
+            int blocksPerMcu = 0;
+            for (int idx = 0; idx < ns; idx++) {
+                int id = p[1 + idx * 2];
+                int ci = -1;
+                for (int k = 0; k < numComps; k++) {
+                    if (mComponents[k].id == id)
+                        ci = k;
+                }
+
+                if (ci < 0 || comps[ci].decoded)
+                    return fail(QObject::tr("illegal component in scan"));
+
+                CoefComponent &c = comps[ci];
+                c.dcTable = p[2 + idx * 2] >> 4;
+                c.acTable = p[2 + idx * 2] & 0x0F;
+
+                int tq = mComponents[ci].tq;
+                if (c.dcTable > 3 || c.acTable > 3 || !dcTables[c.dcTable].isDefined()
+                    || !acTables[c.acTable].isDefined() || !quantDefined[tq])
+                    return fail(QObject::tr("missing tables for scan"));
+
+                std::memcpy(c.quant, quant[tq], sizeof(c.quant));
+                c.decoded = true;
+                scanComps << ci;
+                blocksPerMcu += mComponents[ci].h * mComponents[ci].v;
+            }
+
+            if (blocksPerMcu > 10 && ns > 1)
+                return fail(QObject::tr("too many blocks per MCU"));
+
+            // non-interleaved scans are not padded to full MCUs
+            int scanMcusX = mcusX;
+            int scanMcusY = mcusY;
+            if (ns == 1) {
+                const Component &c = mComponents[scanComps[0]];
+                scanMcusX = ceilDiv(ceilDiv(mSize.width() * c.h, mHmax), 8);
+                scanMcusY = ceilDiv(ceilDiv(mSize.height() * c.v, mVmax), 8);
+            }
+
+            BitReader br(d, pos, len);
+            int pred[4] = {};
+            int todo = restartInterval;
+            int numMcus = scanMcusX * scanMcusY;
+
+            for (int mcu = 0; mcu < numMcus; mcu++) {
+                if (restartInterval) {
+                    if (todo == 0) {
+                        if (!br.restart())
+                            return fail(QObject::tr("missing restart marker"));
+                        std::fill(pred, pred + 4, 0);
+                        todo = restartInterval;
+                    }
+                    todo--;
+                }
+
+                int mx = mcu % scanMcusX;
+                int my = mcu / scanMcusX;
+
+                for (int si = 0; si < static_cast<int>(scanComps.size()); si++) {
+                    int ci = scanComps[si];
+                    CoefComponent &c = comps[ci];
+                    int bw = ns == 1 ? 1 : mComponents[ci].h;
+                    int bh = ns == 1 ? 1 : mComponents[ci].v;
+
+                    for (int v = 0; v < bh; v++) {
+                        for (int h = 0; h < bw; h++) {
+                            int16_t *block = c.block(mx * bw + h, my * bh + v);
+
+                            int t = br.decode(dcTables[c.dcTable]);
+                            if (t < 0 || t > 15)
+                                return fail(QObject::tr("corrupted entropy coded data"));
+
+                            int diff = t ? BitReader::extend(br.bits(t), t) : 0;
+                            pred[si] += diff;
+                            block[0] = static_cast<int16_t>(pred[si]);
+
+                            for (int k = 1; k < 64;) {
+                                int rs = br.decode(acTables[c.acTable]);
+                                if (rs < 0)
+                                    return fail(QObject::tr("corrupted entropy coded data"));
+
+                                int r = rs >> 4;
+                                int sz = rs & 0x0F;
+
+                                if (sz) {
+                                    k += r;
+                                    if (k > 63)
+                                        return fail(QObject::tr("corrupted entropy coded data"));
+                                    block[zigzag[k]] = static_cast<int16_t>(BitReader::extend(br.bits(sz), sz));
+                                    k++;
+                                } else if (r == 15) {
+                                    k += 16;
+                                } else
+                                    break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (br.overrun())
+                return fail(QObject::tr("the file is truncated"));
+
+            pos = br.nextMarker();
+        }
+    }
+
+    for (const CoefComponent &c : comps) {
+        if (!c.decoded)
+            return fail(QObject::tr("the file is truncated"));
+    }
+
+    // transform --------------------------------------------------------------------
+    // output coefficient index -> source index & sign
+    int coefIdx[64];
+    int coefSign[64];
+    for (int v = 0; v < 8; v++) {
+        for (int u = 0; u < 8; u++) {
+            int su = transposed ? v : u;
+            int sv = transposed ? u : v;
+            coefIdx[v * 8 + u] = sv * 8 + su;
+            coefSign[v * 8 + u] = ((mirrorX && (su & 1)) != (mirrorY && (sv & 1))) ? -1 : 1;
+        }
+    }
+
+    QSize outSize = size();
+    QRect crop = mCrop.isNull() ? QRect(QPoint(), outSize) : mCrop;
+    int outHmax = transposed ? mVmax : mHmax;
+    int outVmax = transposed ? mHmax : mVmax;
+    int outMcuW = numComps == 1 ? 8 : 8 * outHmax;
+    int outMcuH = numComps == 1 ? 8 : 8 * outVmax;
+
+    QVector<Component> outComps = mComponents;
+    QVector<int> srcBlocksW(numComps);
+    QVector<int> srcBlocksH(numComps);
+    QVector<int> cropBx(numComps);
+    QVector<int> cropBy(numComps);
+
+    for (int idx = 0; idx < numComps; idx++) {
+        const Component &c = mComponents[idx];
+        if (transposed)
+            std::swap(outComps[idx].h, outComps[idx].v);
+
+        // exact block counts for mirrored dimensions (these are MCU aligned)
+        srcBlocksW[idx] = srcSize.width() / mcuW * c.h;
+        srcBlocksH[idx] = srcSize.height() / mcuH * c.v;
+        cropBx[idx] = crop.x() / outMcuW * outComps[idx].h;
+        cropBy[idx] = crop.y() / outMcuH * outComps[idx].v;
+    }
+
+    // copies the source block of output block (bx, by)
+    auto fetchBlock = [&](int ci, int bx, int by, int16_t *out) {
+        bx += cropBx[ci];
+        by += cropBy[ci];
+
+        int sx = transposed ? by : bx;
+        int sy = transposed ? bx : by;
+
+        if (mirrorX)
+            sx = srcBlocksW[ci] - 1 - sx;
+        if (mirrorY)
+            sy = srcBlocksH[ci] - 1 - sy;
+
+        CoefComponent &c = comps[ci];
+        if (sx < 0 || sy < 0 || sx >= c.blocksW || sy >= c.blocksH) {
+            std::memset(out, 0, 64 * sizeof(int16_t));
+            return;
+        }
+
+        const int16_t *src = c.block(sx, sy);
+        for (int k = 0; k < 64; k++)
+            out[k] = static_cast<int16_t>(coefSign[k] * src[coefIdx[k]]);
+    };
+
+    // one interleaved scan if possible
+    int blocksPerMcu = 0;
+    for (const Component &c : outComps)
+        blocksPerMcu += c.h * c.v;
+
+    QVector<QVector<int>> scans;
+    if (numComps > 1 && blocksPerMcu <= 10) {
+        QVector<int> all;
+        for (int idx = 0; idx < numComps; idx++)
+            all << idx;
+        scans << all;
+    } else {
+        for (int idx = 0; idx < numComps; idx++)
+            scans << QVector<int>{idx};
+    }
+
+    int outMcusX = ceilDiv(outSize.width(), outMcuW);
+    int outMcusY = ceilDiv(outSize.height(), outMcuH);
+
+    // calls fn(component, block) for all blocks of a scan in coding order
+    auto forEachBlock = [&](const QVector<int> &scan, auto fn) {
+        int nx = outMcusX;
+        int ny = outMcusY;
+
+        if (scan.size() == 1) {
+            const Component &c = outComps[scan[0]];
+            nx = ceilDiv(ceilDiv(outSize.width() * c.h, outHmax), 8);
+            ny = ceilDiv(ceilDiv(outSize.height() * c.v, outVmax), 8);
+        }
+
+        int16_t block[64];
+        for (int my = 0; my < ny; my++) {
+            for (int mx = 0; mx < nx; mx++) {
+                for (int ci : scan) {
+                    int bw = scan.size() == 1 ? 1 : outComps[ci].h;
+                    int bh = scan.size() == 1 ? 1 : outComps[ci].v;
+
+                    for (int v = 0; v < bh; v++) {
+                        for (int h = 0; h < bw; h++) {
+                            fetchBlock(ci, mx * bw + h, my * bh + v, block);
+                            fn(ci, block);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    // Huffman statistics: table 0 for the first component, table 1 for all others
+    std::vector<long> dcStats[2] = {std::vector<long>(256, 0), std::vector<long>(256, 0)};
+    std::vector<long> acStats[2] = {std::vector<long>(256, 0), std::vector<long>(256, 0)};
+
+    for (const QVector<int> &scan : scans) {
+        int pred[4] = {};
+
+        forEachBlock(scan, [&](int ci, const int16_t *block) {
+            int t = ci == 0 ? 0 : 1;
+            int diff = block[0] - pred[ci];
+            pred[ci] = block[0];
+            dcStats[t][numBits(qAbs(diff))]++;
+
+            int r = 0;
+            for (int k = 1; k < 64; k++) {
+                int v = block[zigzag[k]];
+                if (v == 0) {
+                    r++;
+                    continue;
+                }
+
+                while (r > 15) {
+                    acStats[t][0xF0]++;
+                    r -= 16;
+                }
+
+                acStats[t][(r << 4) + numBits(qAbs(v))]++;
+                r = 0;
+            }
+
+            if (r > 0)
+                acStats[t][0x00]++;
+        });
+    }
+
+    int numTables = numComps > 1 ? 2 : 1;
+    HuffEncoder dcEnc[2];
+    HuffEncoder acEnc[2];
+    for (int t = 0; t < numTables; t++) {
+        dcEnc[t].build(dcStats[t]);
+        acEnc[t].build(acStats[t]);
+    }
+
+    // write the file --------------------------------------------------------------------
+    dst.clear();
+    dst.reserve(mSource.size());
+    dst.append(static_cast<char>(0xFF));
+    dst.append(static_cast<char>(m_soi));
+
+    for (const QPair<int, int> &k : keep)
+        dst.append(mSource.constData() + k.first, k.second - k.first);
+
+    // quantization tables (transposed along with the blocks)
+    bool extended = false;
+    for (int tq = 0; tq < 4; tq++) {
+        int ci = -1;
+        for (int idx = 0; idx < numComps && ci < 0; idx++) {
+            if (mComponents[idx].tq == tq)
+                ci = idx;
+        }
+
+        if (ci < 0)
+            continue;
+
+        int q[64];
+        bool precise = false;
+        for (int k = 0; k < 64; k++) {
+            q[k] = comps[ci].quant[coefIdx[k]];
+            precise |= q[k] > 255;
+        }
+
+        extended |= precise;
+        appendMarker(dst, m_dqt, precise ? 129 : 65);
+        dst.append(static_cast<char>((precise ? 0x10 : 0x00) | tq));
+        for (int k = 0; k < 64; k++) {
+            if (precise)
+                appendWord(dst, q[zigzag[k]]);
+            else
+                dst.append(static_cast<char>(q[zigzag[k]]));
+        }
+    }
+
+    // frame header - baseline only allows 8 bit quantization tables
+    appendMarker(dst, extended && mSofMarker == m_sof0 ? m_sof1 : mSofMarker, 6 + numComps * 3);
+    dst.append(static_cast<char>(8));
+    appendWord(dst, outSize.height());
+    appendWord(dst, outSize.width());
+    dst.append(static_cast<char>(numComps));
+    for (const Component &c : outComps) {
+        dst.append(static_cast<char>(c.id));
+        dst.append(static_cast<char>((c.h << 4) | c.v));
+        dst.append(static_cast<char>(c.tq));
+    }
+
+    // Huffman tables
+    for (int t = 0; t < numTables; t++) {
+        for (int tc = 0; tc < 2; tc++) {
+            const HuffEncoder &e = tc == 0 ? dcEnc[t] : acEnc[t];
+            appendMarker(dst, m_dht, 17 + e.mNumSymbols);
+            dst.append(static_cast<char>((tc << 4) | t));
+            dst.append(reinterpret_cast<const char *>(e.mCounts), 16);
+            dst.append(reinterpret_cast<const char *>(e.mSymbols), e.mNumSymbols);
+        }
+    }
+
+    for (const QVector<int> &scan : scans) {
+        appendMarker(dst, m_sos, 4 + static_cast<int>(scan.size()) * 2);
+        dst.append(static_cast<char>(scan.size()));
+        for (int ci : scan) {
+            int t = ci == 0 ? 0 : 1;
+            dst.append(static_cast<char>(outComps[ci].id));
+            dst.append(static_cast<char>((t << 4) | t));
+        }
+        dst.append(static_cast<char>(0));
+        dst.append(static_cast<char>(63));
+        dst.append(static_cast<char>(0));
+
+        BitWriter bw(dst);
+        int pred[4] = {};
+
+        forEachBlock(scan, [&](int ci, const int16_t *block) {
+            int t = ci == 0 ? 0 : 1;
+            const HuffEncoder &dc = dcEnc[t];
+            const HuffEncoder &ac = acEnc[t];
+
+            int diff = block[0] - pred[ci];
+            pred[ci] = block[0];
+
+            int nb = numBits(qAbs(diff));
+            bw.put(dc.mCode[nb], dc.mSize[nb]);
+            if (nb)
+                bw.put(diff < 0 ? diff - 1 : diff, nb);
+
+            int r = 0;
+            for (int k = 1; k < 64; k++) {
+                int v = block[zigzag[k]];
+                if (v == 0) {
+                    r++;
+                    continue;
+                }
+
+                while (r > 15) {
+                    bw.put(ac.mCode[0xF0], ac.mSize[0xF0]);
+                    r -= 16;
+                }
+
+                nb = numBits(qAbs(v));
+                int sym = (r << 4) + nb;
+                bw.put(ac.mCode[sym], ac.mSize[sym]);
+                bw.put(v < 0 ? v - 1 : v, nb);
+                r = 0;
+            }
+
+            if (r > 0)
+                bw.put(ac.mCode[0x00], ac.mSize[0x00]);
+        });
+
+        bw.flush();
+    }
+
+    dst.append(static_cast<char>(0xFF));
+    dst.append(static_cast<char>(m_eoi));
+
+    return true;
+}
+
+}
@@ -0,0 +1,187 @@
+/*******************************************************************************************************
+ DkJpegTransform.h
+ Created on:	18.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include "nmc_config.h"
+
+namespace nmc
+{
+
+/**
+ * Lossless JPEG transformations (rotation, flips and crop).
+ *
+ * The entropy coded DCT coefficients are decoded, rearranged and
+ * encoded again with optimized Huffman tables. Pixels are never
+ * decoded, so the result is bit-exact to the source.
+ *
+ * Only sequential (baseline & extended) Huffman JPEGs are supported.
+ * Transforms that would move partial edge MCUs are rejected unless
+ * trimming is enabled. Crops must start on an MCU boundary of the
+ * transformed image.
+ **/
+class DllCoreExport DkJpegTransform
+{
+public:
+    enum Transform {
+        transform_none = 0,
+        transform_flip_h, // mirror left/right
+        transform_flip_v, // mirror top/bottom
+        transform_transpose, // mirror across the main diagonal
+        transform_transverse, // mirror across the anti-diagonal
+        transform_rotate_90, // clockwise
+        transform_rotate_180,
+        transform_rotate_270,
+
+        transform_end
+    };
+
+    DkJpegTransform() = default;
+
+    /**
+     * Map a clockwise rotation angle to a transform.
+     * @return transform_end if the angle is not a multiple of 90
+     **/
+    static Transform fromAngle(int angle);
+
+    /**
+     * Map the orientation reported by DkMetaDataT to a transform.
+     * @param degrees see DkMetaDataT::getOrientationDegrees()
+     * @param mirrored see DkMetaDataT::isOrientationMirrored()
+     **/
+    static Transform fromOrientation(int degrees, bool mirrored);
+
+    /**
+     * Split a transform into a clockwise rotation followed by a horizontal flip.
+     * This is the inverse of fromOrientation().
+     **/
+    static void toOrientation(Transform t, int &degrees, bool &mirrored);
+
+    /**
+     * Returns true if the data starts with a JPEG SOI marker.
+     **/
+    static bool isJpeg(const QByteArray &data);
+
+    /**
+     * Set the JPEG file buffer and parse its header.
+     * This resets transform and crop.
+     * @return false if the file cannot be transformed losslessly
+     **/
+    bool setSource(const QByteArray &data);
+
+    /**
+     * Drop partial edge MCUs that would otherwise end up on the top/left border.
+     * Must be set before setCrop().
+     **/
+    void setTrim(bool trim);
+
+    /**
+     * Apply t after the transforms added so far.
+     * @return false if a crop was set already
+     **/
+    bool addTransform(Transform t);
+
+    /**
+     * Crop the transformed image.
+     * @param rect in transformed coordinates, x/y must be MCU aligned
+     * @return false if the rect is not aligned or outside the image
+     **/
+    bool setCrop(const QRect &rect);
+
+    Transform transform() const;
+    QRect crop() const;
+    QSize sourceSize() const;
+
+    /**
+     * Size of the transformed image (without crop).
+     **/
+    QSize transformedSize() const;
+
+    /**
+     * Size of the image written by apply().
+     **/
+    QSize size() const;
+
+    /**
+     * MCU size of the transformed image, crops must be aligned to it.
+     **/
+    QSize mcuSize() const;
+
+    /**
+     * Returns true if the transform can be applied without trimming.
+     **/
+    bool isPerfect() const;
+
+    /**
+     * Returns true if apply() would not change the image.
+     **/
+    bool isIdentity() const;
+
+    /**
+     * Transform the source and write a new JPEG file to dst.
+     * APPn and COM segments (e.g. EXIF, ICC) are copied unchanged.
+     **/
+    bool apply(QByteArray &dst);
+
+    QString errorString() const;
+
+    struct Component {
+        int id = 0;
+        int h = 1;
+        int v = 1;
+        int tq = 0;
+    };
+
+private:
+    bool fail(const QString &msg);
+    bool isTransposed() const;
+    bool isMirroredX() const;
+    bool isMirroredY() const;
+    QSize trimmedSourceSize() const;
+
+    QByteArray mSource;
+    QString mError;
+
+    // frame header
+    QSize mSize;
+    int mSofMarker = 0;
+    QVector<Component> mComponents;
+    int mHmax = 1;
+    int mVmax = 1;
+
+    // D4 group element as matrix: dst = M * src (centered coordinates)
+    int mMatrix[4] = {1, 0, 0, 1};
+    QRect mCrop;
+    bool mTrim = false;
+};
+}
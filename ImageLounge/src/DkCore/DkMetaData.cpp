@@ -27,6 +27,7 @@
 
 #include "DkMetaData.h"
 
+#include "DkExivIo.h"
 #include "DkImageStorage.h"
 #include "DkSettings.h"
 #include "DkTimer.h"
@@ -34,6 +35,7 @@
 
 #include <QApplication>
 #include <QBuffer>
+#include <QFile>
 #include <QImage>
 #include <QObject>
 #include <QRegularExpression>
@@ -41,6 +43,106 @@
 
 #include <iostream>
 
+namespace
+{
+// identifiers of the JPEG APP1 segments, including the terminating null
+const char exifId[] = "Exif\0";
+const char xmpId[] = "http://ns.adobe.com/xap/1.0/";
+const char xmpExtensionId[] = "http://ns.adobe.com/xmp/extension/";
+
+// payload of a JPEG segment in the file
+struct JpegSegment {
+    qint64 offset = -1;
+    int size = 0;
+};
+
+/**
+ * Reads the JPEG markers up to the first scan and locates the EXIF & XMP segments.
+ * Returns an empty buffer if the file is not a JPEG or cannot be updated in place.
+ **/
+QByteArray readJpegHeader(QIODevice &io, JpegSegment &exif, JpegSegment &xmp)
+{
+    QByteArray header = io.read(2);
+    if (header != QByteArray("\xff\xd8", 2))
+        return {};
+
+    while (true) {
+        QByteArray marker = io.read(2);
+        if (marker.size() != 2 || uchar(marker[0]) != 0xff)
+            return {};
+
+        header += marker;
+
+        // start of scan - the image data follows
+        if (uchar(marker[1]) == 0xda)
+            return header;
+
+        QByteArray length = io.read(2);
+        if (length.size() != 2)
+            return {};
+
+        const int size = (uchar(length[0]) << 8 | uchar(length[1])) - 2;
+        if (size < 0)
+            return {};
+
+        const qint64 offset = io.pos();
+        QByteArray payload = io.read(size);
+        if (payload.size() != size)
+            return {};
+
+        header += length;
+        header += payload;
+
+        if (uchar(marker[1]) != 0xe1)
+            continue;
+
+        if (payload.startsWith(QByteArray::fromRawData(exifId, sizeof(exifId)))) {
+            if (exif.offset >= 0)
+                return {};
+            exif = {offset, size};
+        } else if (payload.startsWith(QByteArray::fromRawData(xmpId, sizeof(xmpId)))) {
+            if (xmp.offset >= 0)
+                return {};
+            xmp = {offset, size};
+        } else if (payload.startsWith(QByteArray::fromRawData(xmpExtensionId, sizeof(xmpExtensionId)))) {
+            // extended XMP is split across segments
+            return {};
+        }
+    }
+}
+
+/**
+ * Pads an XMP packet with whitespace (which is what the packet wrapper is made for).
+ **/
+bool padXmpPacket(std::string &packet, size_t size)
+{
+    if (packet.size() > size)
+        return false;
+
+    std::string padding(size - packet.size(), ' ');
+    for (size_t idx = 99; idx < padding.size(); idx += 100)
+        padding[idx] = '\n';
+
+    size_t pos = packet.rfind("<?xpacket end=");
+    packet.insert(pos == std::string::npos ? packet.size() : pos, padding);
+
+    return true;
+}
+
+QByteArray toByteArray(const Exiv2::DataBuf &buf)
+{
+#if ((((EXIV2_MAJOR_VERSION) << 16) + ((EXIV2_MINOR_VERSION) << 8) + (EXIV2_PATCH_VERSION)) >= (28 << 8))
+    if (buf.empty())
+        return {};
+    return QByteArray(reinterpret_cast<const char *>(buf.c_data()), static_cast<int>(buf.size()));
+#else
+    if (!buf.pData_)
+        return {};
+    return QByteArray(reinterpret_cast<const char *>(buf.pData_), static_cast<int>(buf.size_));
+#endif
+}
+}
+
 namespace nmc
 {
 // DkMetaDataT --------------------------------------------------------------------
@@ -60,12 +162,17 @@ QSharedPointer<DkMetaDataT> DkMetaDataT::copy() const
     QSharedPointer<DkMetaDataT> metaDataN(new DkMetaDataT());
     metaDataN->mFileInfo = mFileInfo;
     metaDataN->mExifState = mExifState;
+    metaDataN->mUseSidecar = mUseSidecar;
 
     if (mExifImg.get() != nullptr) {
         // ImageFactory::create(type) may crash even if old Image object has that type
         try {
             // Load new Exiv2::Image object
-            metaDataN->mExifImg = Exiv2::ImageFactory::create(mExifImg->imageType());
+            // a sidecar can hold the metadata of formats exiv2 cannot create (e.g. RAW)
+            auto type = mExifImg->imageType();
+            if (mUseSidecar && !(mExifImg->checkMode(Exiv2::mdExif) & Exiv2::amWrite))
+                type = Exiv2::ImageType::xmp;
+            metaDataN->mExifImg = Exiv2::ImageFactory::create(type);
             // Copy any data from old object that we are going to save back to the image
             metaDataN->mExifImg->setExifData(mExifImg->exifData());
             metaDataN->mExifImg->setXmpData(mExifImg->xmpData());
@@ -91,18 +198,14 @@ void DkMetaDataT::update(QSharedPointer<DkMetaDataT> other)
     }
     // Copy metadata from other to this
     mExifImg->setMetadata(*other->mExifImg);
+    invalidateTags();
 }
 
 void DkMetaDataT::readMetaData(const DkFileInfo &file, QSharedPointer<QByteArray> ba)
 {
     mExifState = no_data;
-
-    if (mUseSidecar) {
-        loadSidecar(file.path());
-        return;
-    }
-
     mFileInfo = file;
+    invalidateTags();
 
     try {
         if (!ba || ba->isEmpty()) {
@@ -112,9 +215,8 @@ void DkMetaDataT::readMetaData(const DkFileInfo &file, QSharedPointer<QByteArray
                 return;
             }
 
-            // FIXME: this does not support unicode file names on windows
-            // we could use DkFileInfo::getIoDevice() and subclass Exiv2::BasicIo
-            mExifImg = Exiv2::ImageFactory::open(qUtf8Printable(tmpFileInfo.path()));
+            // exiv2 reads the ranges it parses only, this works for zip members & unicode paths too
+            mExifImg = Exiv2::ImageFactory::open(DkExivIo::Ptr(new DkExivIo(tmpFileInfo)));
         } else {
             mExifImg = Exiv2::ImageFactory::open(reinterpret_cast<const byte *>(ba->constData()), ba->size());
         }
@@ -139,6 +241,16 @@ void DkMetaDataT::readMetaData(const DkFileInfo &file, QSharedPointer<QByteArray
             return;
         }
 
+        // values of the sidecar override those embedded in the file
+        if (mUseSidecar) {
+            std::unique_ptr<Exiv2::Image> xmpImg = loadSidecar(file.path());
+            if (xmpImg) {
+                Exiv2::XmpData &xmpData = mExifImg->xmpData();
+                for (const Exiv2::Xmpdatum &md : xmpImg->xmpData())
+                    xmpData[md.key()] = md.value();
+            }
+        }
+
         if (mExifImg->exifData().empty() && mExifImg->xmpData().empty() && mExifImg->iptcData().empty()
             && mExifImg->iptcData().empty()) {
             qDebug() << "[Exiv2] metadata is empty";
@@ -171,6 +283,13 @@ bool DkMetaDataT::saveMetaData(const DkFileInfo &fileInfo, bool force)
     if (mExifState != loaded && mExifState != dirty)
         return false;
 
+    try {
+        if (saveMetaDataInPlace(fileInfo))
+            return true;
+    } catch (...) {
+        qWarning() << "[DkMetaDataT] in-place update failed:" << fileInfo.fileName();
+    }
+
     QSharedPointer<QByteArray> ba;
     {
         std::unique_ptr<QIODevice> io = fileInfo.getIODevice();
@@ -284,6 +403,97 @@ bool DkMetaDataT::saveMetaData(QSharedPointer<QByteArray> &ba, bool force)
     // Replace old exif object with new one and clear "dirty" flag
     mExifImg.swap(exifImgN);
     mExifState = loaded;
+    invalidateTags();
+
+    return true;
+}
+
+/**
+ * @brief saveMetaDataInPlace() writes the metadata without rewriting the image data.
+ *
+ * If useSidecar() is set, the XMP sidecar is written instead of the file.
+ * Otherwise, the EXIF & XMP segments of JPEGs are overwritten in place if the
+ * new records fit into the old ones - which is usually the case when changing
+ * ratings or descriptions. Only the JPEG header is read, so this is cheap on
+ * network drives too.
+ *
+ * @param fileInfo file to be updated
+ * @return false if the file has to be rewritten by saveMetaData()
+ */
+bool DkMetaDataT::saveMetaDataInPlace(const DkFileInfo &fileInfo)
+{
+    if ((mExifState != loaded && mExifState != dirty) || !mExifImg || fileInfo.isFromZip())
+        return false;
+
+    if (mUseSidecar)
+        return saveSidecar(fileInfo.path());
+
+    QFile file(fileInfo.path());
+    if (!file.open(QFile::ReadWrite))
+        return false;
+
+    JpegSegment exifSegment;
+    JpegSegment xmpSegment;
+    QByteArray header = readJpegHeader(file, exifSegment, xmpSegment);
+    if (header.isEmpty())
+        return false;
+
+    // the metadata currently stored in the file
+    const auto *data = reinterpret_cast<const byte *>(header.constData());
+    std::unique_ptr<Exiv2::Image> fileImg = Exiv2::ImageFactory::open(data, header.size());
+    if (!fileImg)
+        return false;
+
+    fileImg->readMetadata();
+
+    // IPTC lives in the photoshop segment which we do not touch
+    if (toByteArray(Exiv2::IptcParser::encode(fileImg->iptcData()))
+        != toByteArray(Exiv2::IptcParser::encode(mExifImg->iptcData())))
+        return false;
+
+    QByteArray exif;
+    Exiv2::Blob oldExif;
+    Exiv2::Blob newExif;
+    Exiv2::ByteOrder bo = fileImg->byteOrder() != Exiv2::invalidByteOrder ? fileImg->byteOrder() : Exiv2::littleEndian;
+    Exiv2::ExifParser::encode(oldExif, bo, fileImg->exifData());
+    Exiv2::ExifParser::encode(newExif, bo, mExifImg->exifData());
+
+    if (newExif != oldExif) {
+        if (exifSegment.offset < 0 || newExif.empty() || newExif.size() + sizeof(exifId) > size_t(exifSegment.size))
+            return false;
+
+        exif = QByteArray(exifId, sizeof(exifId));
+        exif += QByteArray(reinterpret_cast<const char *>(newExif.data()), static_cast<int>(newExif.size()));
+        // readers ignore unreferenced bytes after the TIFF structure
+        exif.append(exifSegment.size - exif.size(), '\0');
+    }
+
+    QByteArray xmp;
+    std::string oldXmp;
+    std::string newXmp;
+    const uint16_t flags = Exiv2::XmpParser::useCompactFormat | Exiv2::XmpParser::omitAllFormatting;
+    if (Exiv2::XmpParser::encode(oldXmp, fileImg->xmpData(), flags) != 0
+        || Exiv2::XmpParser::encode(newXmp, mExifImg->xmpData(), flags) != 0)
+        return false;
+
+    if (newXmp != oldXmp) {
+        if (xmpSegment.offset < 0 || newXmp.empty() || !padXmpPacket(newXmp, xmpSegment.size - sizeof(xmpId)))
+            return false;
+
+        xmp = QByteArray(xmpId, sizeof(xmpId)) + QByteArray::fromStdString(newXmp);
+    }
+
+    auto write = [&file](const JpegSegment &segment, const QByteArray &data) {
+        return data.isEmpty() || (file.seek(segment.offset) && file.write(data) == data.size());
+    };
+
+    if (!write(exifSegment, exif) || !write(xmpSegment, xmp)) {
+        qWarning() << "[DkMetaDataT] in-place update failed:" << fileInfo.fileName() << file.errorString();
+        return false;
+    }
+
+    qInfo() << "[DkMetaDataT]" << fileInfo.fileName() << "updated in place," << exif.size() + xmp.size() << "bytes";
+    mExifState = loaded;
 
     return true;
 }
@@ -384,47 +594,25 @@ int DkMetaDataT::getRating() const
     if (mExifState != loaded && mExifState != dirty)
         return -1;
 
-    float exifRating = -1;
-    float xmpRating = -1;
-    float fRating = 0;
-
-    const Exiv2::ExifData &exifData = mExifImg->exifData(); // Exif.Image.Rating  - short
-    const Exiv2::XmpData &xmpData = mExifImg->xmpData(); // Xmp.xmp.Rating - text
+    auto rating = [this](const QString &key) {
+        QString value;
+        if (!indexedValue(key, value) || value.isEmpty())
+            return -1.0f;
 
-    // get Rating of Exif Tag
-    if (!exifData.empty()) {
-        const auto key = Exiv2::ExifKey("Exif.Image.Rating");
-        const auto pos = exifData.findKey(key);
+        // multiple components are separated by spaces, the first one is the rating
+        return value.section(' ', 0, 0).toFloat();
+    };
 
-        if (pos != exifData.end() && pos->count() != 0) {
-            auto v = pos->getValue();
-            exifRating = v->toFloat();
-        }
-    }
+    float exifRating = rating("Exif.Image.Rating"); // short
+    float fRating = 0;
 
-    // get Rating of Xmp Tag
     // NOTE: -1 is a valid xmp rating (means rejected) but we ignore that
-    if (!xmpData.empty()) {
-        auto key = Exiv2::XmpKey("Xmp.xmp.Rating");
-        auto pos = xmpData.findKey(key);
-
-        // xmp Rating tag
-        if (pos != xmpData.end() && pos->count() != 0) {
-            auto v = pos->getValue();
-            xmpRating = v->toFloat();
-        }
+    float xmpRating = rating("Xmp.xmp.Rating"); // text
 
-        // if xmpRating not found, try to find MicrosoftPhoto Rating tag
-        if (xmpRating == -1) {
-            // FIXME: this fallback is incorrect as it gives rating percent
-            key = Exiv2::XmpKey("Xmp.MicrosoftPhoto.Rating");
-            pos = xmpData.findKey(key);
-            if (pos != xmpData.end() && pos->count() != 0) {
-                auto v = pos->getValue();
-                xmpRating = v->toFloat();
-            }
-        }
-    }
+    // if xmpRating not found, try to find MicrosoftPhoto Rating tag
+    // FIXME: this fallback is incorrect as it gives rating percent
+    if (xmpRating == -1)
+        xmpRating = rating("Xmp.MicrosoftPhoto.Rating");
 
     if (xmpRating == -1.0f && exifRating != -1.0f)
         fRating = exifRating;
@@ -464,6 +652,9 @@ QString DkMetaDataT::getNativeExifValue(const QString &key, bool humanReadable)
     if (mExifState != loaded && mExifState != dirty)
         return info;
 
+    if (!humanReadable && indexedValue(key, info))
+        return info;
+
     const Exiv2::ExifData &exifData = mExifImg->exifData();
 
     if (!exifData.empty()) {
@@ -509,6 +700,9 @@ QString DkMetaDataT::getXmpValue(const QString &key) const
     if (mExifState != loaded && mExifState != dirty)
         return info;
 
+    if (indexedValue(key, info))
+        return info;
+
     const Exiv2::XmpData &xmpData = mExifImg->xmpData();
 
     if (!xmpData.empty()) {
@@ -537,6 +731,11 @@ QString DkMetaDataT::getExifValue(const QString &key) const
     if (mExifState != loaded && mExifState != dirty)
         return info;
 
+    // Exif.Image takes precedence over Exif.Photo
+    QString photoInfo;
+    if (indexedValue("Exif.Image." + key, info) && indexedValue("Exif.Photo." + key, photoInfo))
+        return info.isEmpty() ? photoInfo : info;
+
     const Exiv2::ExifData &exifData = mExifImg->exifData();
     std::string sKey = key.toStdString();
 
@@ -577,6 +776,9 @@ QString DkMetaDataT::getIptcValue(const QString &key) const
     if (mExifState != loaded && mExifState != dirty)
         return info;
 
+    if (indexedValue(key, info))
+        return info;
+
     const Exiv2::IptcData &iptcData = mExifImg->iptcData();
 
     if (!iptcData.empty()) {
@@ -598,6 +800,145 @@ QString DkMetaDataT::getIptcValue(const QString &key) const
     return info;
 }
 
+QVector<DkMetaDataT::Tag> DkMetaDataT::tags() const
+{
+    QMutexLocker locker(&mTagMutex);
+    if (!mTagsValid)
+        buildTags();
+
+    return mTags;
+}
+
+/**
+ * @brief Looks up the Exiv2 value string of key in the value index.
+ *
+ * Exiv2's findKey() is a linear search, so looking up all tags that way is quadratic.
+ *
+ * @param key Exif, IPTC or XMP key
+ * @param value empty if the tag does not exist
+ * @return false if the tag was too large to be indexed
+ */
+bool DkMetaDataT::indexedValue(const QString &key, QString &value) const
+{
+    QMutexLocker locker(&mTagMutex);
+    if (!mValuesValid)
+        buildValueIndex();
+
+    if (mValueIndex.largeKeys.contains(key))
+        return false;
+
+    value = mValueIndex.rawValues.value(key);
+    return true;
+}
+
+// mTagMutex must be locked
+void DkMetaDataT::buildTags() const
+{
+    mTags.clear();
+    mTagsValid = true;
+
+    if (!mExifImg || (mExifState != loaded && mExifState != dirty))
+        return;
+
+    const DkMetaDataHelper &helper = DkMetaDataHelper::getInstance();
+
+    auto addTag = [&](const QString &key, TagFamily family, const QString &readable) {
+        QString lastKey = key.section('.', -1);
+
+        Tag tag;
+        tag.key = key;
+        tag.name = helper.translateKey(lastKey);
+        tag.value = helper.formatSpecialValue(lastKey, readable);
+        tag.family = family;
+        mTags << tag;
+    };
+
+    try {
+        const Exiv2::ExifData &exifData = mExifImg->exifData();
+        const Exiv2::IptcData &iptcData = mExifImg->iptcData();
+        const Exiv2::XmpData &xmpData = mExifImg->xmpData();
+
+        mTags.reserve(static_cast<int>(exifData.count() + iptcData.size() + xmpData.count()));
+
+        for (const Exiv2::Exifdatum &md : exifData) {
+            QString key = QString::fromStdString(md.key());
+            QString readable;
+
+            // diem: this is about performance - adobe obviously embeds whole images into tiff exiv data
+            if (md.count() >= 2000) {
+                readable = QObject::tr("<data too large to display>");
+            } else if (md.count() == 0) {
+                // nothing to display
+            } else if (key == QLatin1String("Exif.Photo.UserComment")) {
+                readable = QString::fromStdString(static_cast<const Exiv2::CommentValue &>(md.value()).comment());
+            } else {
+                std::stringstream ss;
+                ss << md;
+                readable = exiv2ToQString(ss.str());
+            }
+
+            addTag(key, family_exif, readable);
+        }
+
+        for (const Exiv2::Iptcdatum &md : iptcData)
+            addTag(QString::fromStdString(md.key()), family_iptc, md.count() != 0 ? exiv2ToQString(md.toString()) : "");
+
+        for (const Exiv2::Xmpdatum &md : xmpData)
+            addTag(QString::fromStdString(md.key()), family_xmp, md.count() != 0 ? exiv2ToQString(md.toString()) : "");
+
+    } catch (...) {
+        qWarning() << "[DkMetaDataT] could not list metadata of" << mFileInfo.fileName();
+    }
+}
+
+// mTagMutex must be locked
+void DkMetaDataT::buildValueIndex() const
+{
+    mValueIndex = ValueIndex();
+    mValuesValid = true;
+
+    if (!mExifImg || (mExifState != loaded && mExifState != dirty))
+        return;
+
+    // like findKey(), the first tag with a value wins - nothing is translated or formatted here
+    auto addValue = [&](const Exiv2::Metadatum &md, const QString &key) {
+        if (md.count() == 0 || mValueIndex.rawValues.contains(key) || mValueIndex.largeKeys.contains(key))
+            return;
+
+        if (md.count() >= 2000)
+            mValueIndex.largeKeys.insert(key);
+        else if (key == QLatin1String("Exif.Photo.UserComment"))
+            mValueIndex.rawValues.insert(
+                key,
+                QString::fromStdString(static_cast<const Exiv2::CommentValue &>(md.value()).comment()));
+        else
+            mValueIndex.rawValues.insert(key, exiv2ToQString(md.toString()));
+    };
+
+    try {
+        for (const Exiv2::Exifdatum &md : mExifImg->exifData())
+            addValue(md, QString::fromStdString(md.key()));
+
+        for (const Exiv2::Iptcdatum &md : mExifImg->iptcData())
+            addValue(md, QString::fromStdString(md.key()));
+
+        for (const Exiv2::Xmpdatum &md : mExifImg->xmpData())
+            addValue(md, QString::fromStdString(md.key()));
+
+    } catch (...) {
+        qWarning() << "[DkMetaDataT] could not index metadata of" << mFileInfo.fileName();
+    }
+}
+
+void DkMetaDataT::invalidateTags()
+{
+    QMutexLocker locker(&mTagMutex);
+    mTags.clear();
+    mTagsValid = false;
+    mValueIndex = ValueIndex();
+    mValuesValid = false;
+}
+
 void DkMetaDataT::getFileMetaData(QStringList &fileKeys, QStringList &fileValues) const
 {
     fileKeys.append(QObject::tr("Filename"));
@@ -820,6 +1161,10 @@ bool DkMetaDataT::isWriteable() const
         return false;
     }
 
+    // the sidecar is written instead of the file
+    if (mUseSidecar)
+        return true;
+
     // all formats that can read/write EXIF can also read/write the other types they may contain (see man exiv2),
     // so we need not worry about truncating metadata
     Exiv2::AccessMode mode = mExifImg->checkMode(Exiv2::mdExif);
@@ -1070,6 +1415,7 @@ void DkMetaDataT::setThumbnail(const QImage &thumb)
 
         mExifImg->setExifData(exifData);
         mExifState = dirty;
+        invalidateTags();
 
     } catch (...) {
         qWarning() << "[Exiv2] could not save the thumbnail";
@@ -1221,6 +1567,7 @@ void DkMetaDataT::setOrientation(int o)
     mExifImg->setExifData(exifData);
 
     mExifState = dirty;
+    invalidateTags();
 }
 
 bool DkMetaDataT::setDescription(const QString &description)
@@ -1298,6 +1645,7 @@ bool DkMetaDataT::setRating(int r)
         mExifImg->setXmpData(xmpData);
 
         mExifState = dirty;
+        invalidateTags();
     } catch (...) {
         qWarning() << "[Exiv2] could not set exif/xmp data";
         return false;
@@ -1369,6 +1717,7 @@ bool DkMetaDataT::setExifValue(const QString &key, const QString &value)
     }
 
     mExifState = dirty;
+    invalidateTags();
     return true;
 }
 
@@ -1381,17 +1730,20 @@ QString DkMetaDataT::exiv2ToQString(std::string exifString)
 
     const size_t input_size = exifString.size();
 
-    if (QString::fromStdString(exifString).startsWith(prefix_ascii1, Qt::CaseInsensitive)) {
+    // only the start is needed to check the prefixes (values can be huge)
+    const QString start = QString::fromLatin1(exifString.c_str(), static_cast<int>(qMin<size_t>(input_size, 32)));
+
+    if (start.startsWith(prefix_ascii1, Qt::CaseInsensitive)) {
         const size_t prefix1_size = strlen(prefix_ascii1);
         if (input_size > prefix1_size) {
             info = QString::fromLocal8Bit(exifString.c_str() + prefix1_size, int(input_size - prefix1_size));
         }
-    } else if (QString::fromStdString(exifString).startsWith(prefix_ascii2, Qt::CaseInsensitive)) {
+    } else if (start.startsWith(prefix_ascii2, Qt::CaseInsensitive)) {
         const size_t prefix2_size = strlen(prefix_ascii2);
         if (input_size > prefix2_size) {
             info = QString::fromLocal8Bit(exifString.c_str() + prefix2_size, int(input_size - prefix2_size));
         }
-    } else if (QString::fromStdString(exifString).startsWith(prefix_Unicode, Qt::CaseInsensitive)) {
+    } else if (start.startsWith(prefix_Unicode, Qt::CaseInsensitive)) {
         const size_t prefixunicode_size = strlen(prefix_Unicode);
         if (input_size > prefixunicode_size) {
             info = QString::fromUtf8(exifString.c_str() + prefixunicode_size, int(input_size - prefixunicode_size));
@@ -1470,6 +1822,7 @@ bool DkMetaDataT::saveRectToXMP(const DkRotatingRect &rect, const QSize &size)
     try {
         mExifImg->setXmpData(xmpData);
         mExifState = dirty;
+        invalidateTags();
 
         qInfo() << r << "written to XMP";
 
@@ -1490,6 +1843,7 @@ bool DkMetaDataT::clearXMPRect()
         setXMPValue(xmpData, "Xmp.crs.HasCrop", "False");
         mExifImg->setXmpData(xmpData);
         mExifState = dirty;
+        invalidateTags();
     } catch (...) {
         return false;
     }
@@ -1523,41 +1877,57 @@ DkRotatingRect DkMetaDataT::getXMPRect(const QSize &size) const
     return DkRotatingRect(rr);
 }
 
+QString DkMetaDataT::sidecarPath(const QString &filePath)
+{
+    // Create the path to the XMP file (photo.nef -> photo.xmp)
+    QString ext = QFileInfo(filePath).suffix();
+    return filePath.left(filePath.length() - ext.length() - 1) + ".xmp";
+}
+
 std::unique_ptr<Exiv2::Image> DkMetaDataT::loadSidecar(const QString &filePath) const
 {
     std::unique_ptr<Exiv2::Image> xmpImg;
 
-    // TODO: check if the file type supports xmp
-
-    // Create the path to the XMP file:
-    QString dir = filePath;
-    QString ext = QFileInfo(filePath).suffix();
-    QString xmpPath = dir.left(dir.length() - ext.length() - 1);
-    QString xmpExt = ".xmp";
-    QString xmpFilePath = xmpPath + xmpExt;
-
-    QFileInfo xmpFileInfo = QFileInfo(xmpFilePath);
+    QString xmpFilePath = sidecarPath(filePath);
+    if (!QFileInfo::exists(xmpFilePath))
+        return xmpImg;
 
     qDebug() << "XMP sidecar path: " << xmpFilePath;
 
-    if (xmpFileInfo.exists()) {
-        try {
-            xmpImg = Exiv2::ImageFactory::open(xmpFilePath.toStdString());
-            xmpImg->readMetadata();
-        } catch (...) {
-            qWarning() << "Could not read xmp from: " << xmpFilePath;
-        }
+    try {
+        xmpImg = Exiv2::ImageFactory::open(xmpFilePath.toStdString());
+        xmpImg->readMetadata();
+    } catch (...) {
+        qWarning() << "Could not read xmp from: " << xmpFilePath;
+        xmpImg.reset();
     }
-    if (!xmpImg.get()) {
-        // We can only load sidecar files whose paths use std::string literals (no unicode here)
-        // Create a new XMP sidecar, unfortunately this one has fewer attributes than the adobe version:
-        xmpImg = Exiv2::ImageFactory::create(Exiv2::ImageType::xmp, xmpFilePath.toStdString());
 
+    return xmpImg;
+}
+
+bool DkMetaDataT::saveSidecar(const QString &filePath)
+{
+    QString xmpFilePath = sidecarPath(filePath);
+
+    try {
+        std::unique_ptr<Exiv2::Image> xmpImg = loadSidecar(filePath);
+
+        // unfortunately a new sidecar has fewer attributes than the adobe version
+        if (!xmpImg)
+            xmpImg = Exiv2::ImageFactory::create(Exiv2::ImageType::xmp, xmpFilePath.toStdString());
+
+        // the sidecar converts exif & iptc to xmp when writing
         xmpImg->setMetadata(*mExifImg);
-        xmpImg->writeMetadata(); // we need that to add xmp afterwards - but why?
+        xmpImg->writeMetadata();
+    } catch (...) {
+        qWarning() << "[DkMetaDataT] could not write sidecar:" << xmpFilePath;
+        return false;
     }
 
-    return xmpImg;
+    qInfo() << "[DkMetaDataT] metadata saved to" << QFileInfo(xmpFilePath).fileName();
+    mExifState = loaded;
+
+    return true;
 }
 
 bool DkMetaDataT::setXMPValue(Exiv2::XmpData &xmpData, QString xmpKey, QString xmpValue)
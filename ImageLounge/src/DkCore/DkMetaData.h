@@ -27,9 +27,13 @@
 
 #pragma once
 
+#include <QHash>
 #include <QMap>
+#include <QMutex>
+#include <QSet>
 #include <QSharedPointer>
 #include <QStringList>
+#include <QVector>
 
 #ifdef HAVE_EXIV2_HPP
 #include <exiv2/exiv2.hpp>
@@ -77,9 +81,32 @@ public:
         or_valid = 0,
     };
 
+    enum TagFamily {
+        family_exif,
+        family_iptc,
+        family_xmp,
+    };
+
+    struct Tag {
+        QString key; // e.g. Exif.Image.Orientation
+        QString name; // translated last part of the key
+        QString value; // human readable, formatted for display
+        TagFamily family = family_exif;
+    };
+
+    /**
+     * @brief All Exif, IPTC and XMP tags in a single pass.
+     *
+     * The snapshot is built lazily on first use and rebuilt after the
+     * metadata was edited. The value getters do not need it, they use
+     * an index of the unformatted values.
+     */
+    QVector<Tag> tags() const;
+
     void readMetaData(const DkFileInfo &file, QSharedPointer<QByteArray> ba = QSharedPointer<QByteArray>());
     bool saveMetaData(const DkFileInfo &file, bool force = false);
     bool saveMetaData(QSharedPointer<QByteArray> &ba, bool force = false);
+    bool saveMetaDataInPlace(const DkFileInfo &file);
 
     /**
      * @brief Test if flip is needed after rotation
@@ -151,7 +178,19 @@ public:
     bool setXMPValue(Exiv2::XmpData &xmpData, QString xmpKey, QString xmpValue);
 
 protected:
+    struct ValueIndex {
+        QHash<QString, QString> rawValues; // key -> Exiv2 value string of the first tag with that key
+        QSet<QString> largeKeys; // too large to be indexed
+    };
+
+    void buildTags() const;
+    void buildValueIndex() const;
+    bool indexedValue(const QString &key, QString &value) const;
+    void invalidateTags();
+
     std::unique_ptr<Exiv2::Image> loadSidecar(const QString &filePath) const;
+    bool saveSidecar(const QString &filePath);
+    static QString sidecarPath(const QString &filePath);
 
     enum {
         not_loaded,
@@ -167,6 +206,12 @@ protected:
 
     int mExifState = not_loaded;
     bool mUseSidecar = false;
+
+    mutable QMutex mTagMutex;
+    mutable QVector<Tag> mTags;
+    mutable bool mTagsValid = false;
+    mutable ValueIndex mValueIndex;
+    mutable bool mValuesValid = false;
 };
 
 class DllCoreExport DkMetaDataHelper
@@ -0,0 +1,155 @@
+/*******************************************************************************************************
+ DkMetaDataWriter.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkMetaDataWriter.h"
+
+#include "DkMetaData.h"
+
+#include <QDebug>
+#include <QtConcurrentRun>
+
+namespace nmc
+{
+DkMetaDataWriter &DkMetaDataWriter::instance()
+{
+    static DkMetaDataWriter inst;
+    return inst;
+}
+
+void DkMetaDataWriter::enqueue(const DkFileInfo &file, QSharedPointer<DkMetaDataT> metaData)
+{
+    if (!metaData)
+        return;
+
+    // the caller keeps editing its instance
+    QSharedPointer<DkMetaDataT> md = metaData->copy();
+
+    QMutexLocker locker(&mMutex);
+
+    bool replaced = false;
+    for (Job &job : mJobs) {
+        if (job.file.path() == file.path()) {
+            job.metaData = md;
+            replaced = true;
+            break;
+        }
+    }
+
+    if (!replaced)
+        mJobs.append(Job{file, md});
+
+    start();
+}
+
+void DkMetaDataWriter::start()
+{
+    // called with mMutex locked
+    if (mRunning || mHold || mJobs.isEmpty())
+        return;
+
+    mRunning = true;
+    mFuture = QtConcurrent::run([this] {
+        run();
+    });
+}
+
+bool DkMetaDataWriter::isPending(const QString &filePath) const
+{
+    QMutexLocker locker(&mMutex);
+
+    if (mActiveFile == filePath)
+        return true;
+
+    for (const Job &job : mJobs) {
+        if (job.file.path() == filePath)
+            return true;
+    }
+
+    return false;
+}
+
+void DkMetaDataWriter::waitForFinished()
+{
+    while (true) {
+        QFuture<void> future;
+        {
+            QMutexLocker locker(&mMutex);
+            if (!mRunning)
+                return;
+            future = mFuture;
+        }
+        future.waitForFinished();
+    }
+}
+
+void DkMetaDataWriter::setHold(bool hold)
+{
+    QMutexLocker locker(&mMutex);
+    mHold = hold;
+    start();
+}
+
+int DkMetaDataWriter::numWrites() const
+{
+    QMutexLocker locker(&mMutex);
+    return mNumWrites;
+}
+
+void DkMetaDataWriter::run()
+{
+    while (true) {
+        Job job;
+        {
+            QMutexLocker locker(&mMutex);
+            mActiveFile.clear();
+
+            if (mJobs.isEmpty() || mHold) {
+                mRunning = false;
+                return;
+            }
+
+            job = mJobs.takeFirst();
+            mActiveFile = job.file.path();
+        }
+
+        bool saved = false;
+        try {
+            saved = job.metaData->saveMetaData(job.file, true);
+        } catch (...) {
+            // saved is false anyway
+        }
+
+        if (!saved) {
+            qWarning() << "[DkMetaDataWriter] could not save metadata:" << job.file.fileName();
+            continue;
+        }
+
+        QMutexLocker locker(&mMutex);
+        mNumWrites++;
+    }
+}
+}
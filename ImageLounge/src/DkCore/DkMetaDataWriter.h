@@ -0,0 +1,99 @@
+/*******************************************************************************************************
+ DkMetaDataWriter.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "DkFileInfo.h"
+
+namespace nmc
+{
+class DkMetaDataT;
+
+/**
+ * Writes metadata edits (e.g. ratings) in the background.
+ *
+ * Jobs are processed one after another. Enqueueing a file that is
+ * still pending replaces its job, so rating a file several times in a
+ * row results in a single write.
+ **/
+class DllCoreExport DkMetaDataWriter
+{
+public:
+    static DkMetaDataWriter &instance();
+
+    /**
+     * Queue a copy of metaData to be saved to file.
+     **/
+    void enqueue(const DkFileInfo &file, QSharedPointer<DkMetaDataT> metaData);
+
+    /**
+     * Returns true if the file is queued or currently written.
+     **/
+    bool isPending(const QString &filePath) const;
+
+    /**
+     * Blocks until all queued jobs are written.
+     **/
+    void waitForFinished();
+
+    /**
+     * Holds back writing while edits are collected (e.g. rating a selection).
+     * Queued jobs are written once the writer is released.
+     **/
+    void setHold(bool hold);
+
+    /**
+     * Returns the number of files written since startup.
+     **/
+    int numWrites() const;
+
+private:
+    DkMetaDataWriter() = default;
+    DkMetaDataWriter(const DkMetaDataWriter &) = delete; // NOLINT
+
+    void start();
+    void run();
+
+    struct Job {
+        DkFileInfo file;
+        QSharedPointer<DkMetaDataT> metaData;
+    };
+
+    mutable QMutex mMutex;
+    QList<Job> mJobs;
+    QString mActiveFile;
+    QFuture<void> mFuture;
+    bool mRunning = false;
+    bool mHold = false;
+    int mNumWrites = 0;
+};
+}
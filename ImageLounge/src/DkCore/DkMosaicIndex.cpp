@@ -0,0 +1,452 @@
+/*******************************************************************************************************
+ DkMosaicIndex.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkMosaicIndex.h"
+
+#include "DkThumbs.h"
+#include "DkTimer.h"
+#include "DkUtils.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QImage>
+#include <QSaveFile>
+#include <QtConcurrentMap>
+
+#ifdef WITH_OPENCV
+#include "opencv2/imgproc/imgproc.hpp"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+namespace nmc
+{
+
+namespace
+{
+constexpr quint32 kMagic = 0x444b4d49; // DkMI
+constexpr quint32 kVersion = 1;
+
+constexpr int kNumCandidates = 16; // per cell in the first round of the assignment, doubled per round
+constexpr float kChromaWeight = 0.5f; // of the mean a/b difference, per signature pixel
+
+struct Match {
+    float distance = 0.0f;
+    int cell = 0;
+    int entry = 0;
+
+    bool operator<(const Match &o) const
+    {
+        if (distance != o.distance)
+            return distance < o.distance;
+        if (cell != o.cell)
+            return cell < o.cell;
+        return entry < o.entry;
+    }
+};
+
+int signatureSum(const DkMosaicIndex::Entry &e)
+{
+    return std::accumulate(e.signature.begin(), e.signature.end(), 0);
+}
+
+// the luminance term alone is >= |difference of the signature sums|, which is used for pruning
+float distance(const DkMosaicIndex::Entry &a, const DkMosaicIndex::Entry &b)
+{
+    int l = 0;
+    for (int idx = 0; idx < DkMosaicIndex::kSignatureLength; idx++)
+        l += std::abs(a.signature[idx] - b.signature[idx]);
+
+    float chroma = std::abs(a.lab[1] - b.lab[1]) + std::abs(a.lab[2] - b.lab[2]);
+    return l + kChromaWeight * DkMosaicIndex::kSignatureLength * chroma;
+}
+
+#ifdef WITH_OPENCV
+DkMosaicIndex::Entry fromRgb(const cv::Mat &rgb)
+{
+    Q_ASSERT(rgb.rows == DkMosaicIndex::kSignatureSize && rgb.cols == DkMosaicIndex::kSignatureSize);
+
+    cv::Mat lab;
+    cv::cvtColor(rgb, lab, cv::COLOR_RGB2Lab);
+
+    DkMosaicIndex::Entry e;
+    cv::Scalar mean = cv::mean(lab);
+    e.lab = {float(mean[0]), float(mean[1]), float(mean[2])};
+
+    for (int y = 0; y < lab.rows; y++) {
+        const auto *ptr = lab.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < lab.cols; x++)
+            e.signature[y * lab.cols + x] = ptr[x][0];
+    }
+
+    return e;
+}
+#endif
+
+std::optional<DkMosaicIndex::Entry> describeFile(const QString &filePath)
+{
+    std::optional<LoadThumbnailResult> thumb = loadThumbnail(LoadThumbnailRequest{filePath});
+    if (!thumb)
+        return {};
+
+    std::optional<DkMosaicIndex::Entry> e = DkMosaicIndex::describe(thumb->thumb);
+    if (!e)
+        return {};
+
+    QFileInfo info(filePath);
+    e->filePath = filePath;
+    e->lastModified = info.lastModified().toMSecsSinceEpoch();
+    e->fileSize = info.size();
+
+    return e;
+}
+}
+
+DkMosaicIndex::DkMosaicIndex(const QVector<Entry> &entries)
+    : mEntries(entries)
+{
+}
+
+QStringList DkMosaicIndex::findImages(const QString &dirPath, const QStringList &fileFilters, const QStringList &ignore)
+{
+    QStringList files;
+    QDirIterator it(dirPath, fileFilters, QDir::Files, QDirIterator::Subdirectories);
+
+    while (it.hasNext()) {
+        QString filePath = it.next();
+
+        bool skip = std::any_of(ignore.begin(), ignore.end(), [&](const QString &i) {
+            return !i.isEmpty() && filePath.contains(i);
+        });
+
+        if (!skip)
+            files.append(filePath);
+    }
+
+    files.sort();
+    return files;
+}
+
+QString DkMosaicIndex::cachePath(const QString &dirPath)
+{
+    QString dir = DkUtils::getAppDataPath() + "/mosaic";
+    QByteArray key = QCryptographicHash::hash(QDir(dirPath).absolutePath().toUtf8(), QCryptographicHash::Md5);
+    return dir + "/" + key.toHex() + ".idx";
+}
+
+std::optional<DkMosaicIndex::Entry> DkMosaicIndex::describe(const QImage &img)
+{
+#ifdef WITH_OPENCV
+    if (img.isNull())
+        return {};
+
+    int side = qMin(img.width(), img.height());
+    QRect center((img.width() - side) / 2, (img.height() - side) / 2, side, side);
+    QImage square = img.copy(center).convertToFormat(QImage::Format_RGB888);
+
+    try {
+        cv::Mat rgb(square.height(), square.width(), CV_8UC3, square.bits(), square.bytesPerLine());
+        cv::Mat small;
+        cv::resize(rgb, small, cv::Size(kSignatureSize, kSignatureSize), 0.0, 0.0, cv::INTER_AREA);
+        return fromRgb(small);
+    } catch (const cv::Exception &e) {
+        qWarning() << "[DkMosaicIndex] cannot describe image:" << e.what();
+    }
+#else
+    Q_UNUSED(img);
+#endif
+    return {};
+}
+
+QVector<DkMosaicIndex::Entry> DkMosaicIndex::describeCells(const QImage &img, const QSize &numCells)
+{
+    QVector<Entry> cells;
+#ifdef WITH_OPENCV
+    if (img.isNull() || numCells.isEmpty())
+        return cells;
+
+    QImage rgbImg = img.convertToFormat(QImage::Format_RGB888);
+    cv::Mat rgb(rgbImg.height(), rgbImg.width(), CV_8UC3, rgbImg.bits(), rgbImg.bytesPerLine());
+
+    // one resize for all cells, every cell becomes a signature
+    cv::Mat small;
+    cv::Size size(numCells.width() * kSignatureSize, numCells.height() * kSignatureSize);
+    cv::resize(rgb, small, size, 0.0, 0.0, cv::INTER_AREA);
+
+    cells.reserve(numCells.width() * numCells.height());
+    for (int r = 0; r < numCells.height(); r++) {
+        for (int c = 0; c < numCells.width(); c++) {
+            cv::Rect roi(c * kSignatureSize, r * kSignatureSize, kSignatureSize, kSignatureSize);
+            cells.append(fromRgb(small(roi)));
+        }
+    }
+#else
+    Q_UNUSED(img);
+    Q_UNUSED(numCells);
+#endif
+    return cells;
+}
+
+bool DkMosaicIndex::update(const QStringList &files, const std::function<bool(int, int)> &progress)
+{
+    DkTimer dt;
+
+    QHash<QString, const Entry *> known;
+    for (const Entry &e : std::as_const(mEntries))
+        known.insert(e.filePath, &e);
+
+    QVector<std::optional<Entry>> described(files.size());
+    QVector<int> todo;
+
+    for (int idx = 0; idx < files.size(); idx++) {
+        const Entry *e = known.value(files[idx]);
+        QFileInfo info(files[idx]);
+
+        if (e && e->lastModified == info.lastModified().toMSecsSinceEpoch() && e->fileSize == info.size())
+            described[idx] = *e;
+        else
+            todo.append(idx);
+    }
+
+    std::atomic<int> numDone{0};
+    std::atomic<bool> cancelled{false};
+
+    QtConcurrent::blockingMap(todo, [&](int idx) {
+        if (cancelled)
+            return;
+
+        described[idx] = describeFile(files[idx]);
+
+        if (progress && !progress(++numDone, todo.size()))
+            cancelled = true;
+    });
+
+    if (cancelled)
+        return false;
+
+    QVector<Entry> entries;
+    entries.reserve(files.size());
+    for (const auto &e : std::as_const(described)) {
+        if (e)
+            entries.append(*e);
+    }
+    mEntries = entries;
+
+    qInfo() << "[DkMosaicIndex]" << todo.size() << "of" << files.size() << "images described in" << dt;
+
+    return true;
+}
+
+QVector<int> DkMosaicIndex::assign(const QVector<Entry> &cells) const
+{
+    QVector<int> result(cells.size(), -1);
+    if (mEntries.isEmpty())
+        return result;
+
+    // entries sorted by signature sum allow to stop searching early
+    QVector<int> order(mEntries.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    QVector<int> sums(mEntries.size());
+    for (int idx = 0; idx < mEntries.size(); idx++)
+        sums[idx] = signatureSum(mEntries[idx]);
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return sums[a] < sums[b] || (sums[a] == sums[b] && a < b);
+    });
+
+    QVector<int> sortedSums(order.size());
+    for (int idx = 0; idx < order.size(); idx++)
+        sortedSums[idx] = sums[order[idx]];
+
+    std::vector<char> used(mEntries.size(), 0);
+    int numUnused = mEntries.size();
+
+    // k nearest unused (or any if repeats are allowed) entries, searching outwards from the cell's sum
+    auto nearest = [&](int cell, bool unique, int k) {
+        const Entry &c = cells[cell];
+        const int key = signatureSum(c);
+
+        std::priority_queue<Match> best; // largest distance on top
+        int hi = std::lower_bound(sortedSums.begin(), sortedSums.end(), key) - sortedSums.begin();
+        int lo = hi - 1;
+
+        while (lo >= 0 || hi < sortedSums.size()) {
+            int loBound = lo >= 0 ? key - sortedSums[lo] : INT_MAX;
+            int hiBound = hi < sortedSums.size() ? sortedSums[hi] - key : INT_MAX;
+            int pos = loBound <= hiBound ? lo-- : hi++;
+
+            if (int(best.size()) == k && qMin(loBound, hiBound) >= best.top().distance)
+                break;
+
+            int entry = order[pos];
+            if (unique && used[entry])
+                continue;
+
+            best.push({distance(c, mEntries[entry]), cell, entry});
+            if (int(best.size()) > k)
+                best.pop();
+        }
+
+        QVector<Match> matches;
+        matches.reserve(int(best.size()));
+        for (; !best.empty(); best.pop())
+            matches.append(best.top());
+
+        return matches;
+    };
+
+    QVector<int> open(cells.size());
+    std::iota(open.begin(), open.end(), 0);
+
+    for (int round = 0; !open.isEmpty(); round++) {
+        // repeat entries only if all of them are used
+        const bool unique = numUnused > 0;
+        const int k = kNumCandidates << qMin(round, 6);
+
+        QVector<QVector<Match>> candidates = QtConcurrent::blockingMapped<QVector<QVector<Match>>>(open, [&](int cell) {
+            return nearest(cell, unique, k);
+        });
+
+        QVector<Match> all;
+        for (const auto &c : std::as_const(candidates))
+            all.append(c);
+        std::sort(all.begin(), all.end());
+
+        // greedy, the best matches are assigned first
+        for (const Match &m : std::as_const(all)) {
+            if (result[m.cell] != -1 || (unique && used[m.entry]))
+                continue;
+
+            result[m.cell] = m.entry;
+            if (!used[m.entry]) {
+                used[m.entry] = 1;
+                numUnused--;
+            }
+        }
+
+        QVector<int> stillOpen;
+        for (int cell : std::as_const(open)) {
+            if (result[cell] == -1)
+                stillOpen.append(cell);
+        }
+        open = stillOpen;
+    }
+
+    return result;
+}
+
+bool DkMosaicIndex::load(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream ds(&file);
+    quint32 magic = 0, version = 0;
+    qint32 signatureSize = 0, numEntries = 0;
+    ds >> magic >> version >> signatureSize >> numEntries;
+
+    if (magic != kMagic || version != kVersion || signatureSize != kSignatureSize || numEntries < 0) {
+        qWarning() << "[DkMosaicIndex] ignoring incompatible index" << filePath;
+        return false;
+    }
+
+    // the count is not trusted: every entry needs at least its signature on disk
+    if (numEntries > (file.size() - file.pos()) / kSignatureLength) {
+        qWarning() << "[DkMosaicIndex] index is corrupt" << filePath;
+        return false;
+    }
+
+    QVector<Entry> entries;
+    entries.reserve(numEntries);
+
+    for (int idx = 0; idx < numEntries && ds.status() == QDataStream::Ok; idx++) {
+        Entry e;
+        ds >> e.filePath >> e.lastModified >> e.fileSize >> e.lab[0] >> e.lab[1] >> e.lab[2];
+        if (ds.readRawData(reinterpret_cast<char *>(e.signature.data()), kSignatureLength) != kSignatureLength)
+            ds.setStatus(QDataStream::ReadPastEnd);
+        entries.append(e);
+    }
+
+    if (ds.status() != QDataStream::Ok) {
+        qWarning() << "[DkMosaicIndex] index is corrupt" << filePath;
+        return false;
+    }
+
+    mEntries = entries;
+    return true;
+}
+
+bool DkMosaicIndex::save(const QString &filePath) const
+{
+    const QString dir = QFileInfo(filePath).absolutePath();
+    if (!QDir().mkpath(dir)) {
+        qWarning() << "[DkMosaicIndex] I could not create" << dir;
+        return false;
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[DkMosaicIndex] cannot write" << filePath << file.errorString();
+        return false;
+    }
+
+    QDataStream ds(&file);
+    ds << kMagic << kVersion << qint32(kSignatureSize) << qint32(mEntries.size());
+
+    for (const Entry &e : mEntries) {
+        ds << e.filePath << e.lastModified << e.fileSize << e.lab[0] << e.lab[1] << e.lab[2];
+        ds.writeRawData(reinterpret_cast<const char *>(e.signature.data()), kSignatureLength);
+    }
+
+    return file.commit();
+}
+
+const QVector<DkMosaicIndex::Entry> &DkMosaicIndex::entries() const
+{
+    return mEntries;
+}
+
+int DkMosaicIndex::size() const
+{
+    return mEntries.size();
+}
+
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************************************
+ DkMosaicIndex.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+#include "nmc_config.h"
+
+class QImage;
+
+namespace nmc
+{
+
+/**
+ * Tile descriptors of an image database for photo mosaics.
+ *
+ * Every image is described once by the mean Lab color and the luminance of its
+ * center square, downsampled to kSignatureSize x kSignatureSize. Descriptors are
+ * computed in parallel and persisted, so rebuilding the index only touches new
+ * or modified files. Mosaic cells are then matched against all descriptors at once.
+ **/
+class DllCoreExport DkMosaicIndex
+{
+public:
+    static constexpr int kSignatureSize = 8;
+    static constexpr int kSignatureLength = kSignatureSize * kSignatureSize;
+
+    struct Entry {
+        QString filePath;
+        qint64 lastModified = 0; // ms since epoch
+        qint64 fileSize = 0;
+        std::array<float, 3> lab{}; // mean L, a, b (8 bit OpenCV Lab)
+        std::array<uint8_t, kSignatureLength> signature{}; // L, row major
+    };
+
+    DkMosaicIndex() = default;
+    explicit DkMosaicIndex(const QVector<Entry> &entries);
+
+    /**
+     * Find image files in dirPath and its sub directories.
+     * @param ignore files are skipped if their path contains any of these
+     * @return sorted absolute file paths
+     **/
+    static QStringList findImages(const QString &dirPath, const QStringList &fileFilters, const QStringList &ignore);
+
+    /**
+     * Default location of the persisted index of a database directory, save() creates it.
+     **/
+    static QString cachePath(const QString &dirPath);
+
+    /**
+     * Describe the center square of img.
+     **/
+    static std::optional<Entry> describe(const QImage &img);
+
+    /**
+     * Describe the cells of a numCells grid that covers img.
+     * @return descriptors in row major order
+     **/
+    static QVector<Entry> describeCells(const QImage &img, const QSize &numCells);
+
+    /**
+     * Index files. Descriptors of unchanged files are kept, the others are computed in parallel.
+     * Files that are not listed are removed from the index.
+     * @param progress called from worker threads with (done, total), return false to cancel
+     * @return false if cancelled, the index is unchanged then
+     **/
+    bool update(const QStringList &files, const std::function<bool(int, int)> &progress = {});
+
+    /**
+     * Assign an entry to every cell. Entries are used only once as long as there
+     * are enough of them, cells with the best matches are served first.
+     * @return entry index per cell, -1 if the index is empty
+     **/
+    QVector<int> assign(const QVector<Entry> &cells) const;
+
+    bool load(const QString &filePath);
+    bool save(const QString &filePath) const;
+
+    const QVector<Entry> &entries() const;
+    int size() const;
+
+private:
+    QVector<Entry> mEntries;
+};
+
+}
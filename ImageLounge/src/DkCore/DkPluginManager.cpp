@@ -38,6 +38,8 @@
 #include <QAction>
 #include <QDir>
 #include <QHeaderView>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonValue>
 #include <QLibraryInfo>
 #include <QLineEdit>
@@ -48,6 +50,7 @@
 #include <QPluginLoader>
 #include <QPushButton>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QSortFilterProxyModel>
 #include <QTableView>
 #include <QTextEdit>
@@ -156,11 +159,24 @@ QVector<DkLibrary> DkLibrary::loadDependencies() const
 }
 
 // DkPluginContainer --------------------------------------------------------------------
-DkPluginContainer::DkPluginContainer(const QString &pluginPath)
+DkPluginContainer::DkPluginContainer(const QString &pluginPath, const QJsonObject &indexEntry)
 {
     mPluginPath = pluginPath;
-    mLoader = QSharedPointer<QPluginLoader>(new QPluginLoader(mPluginPath));
-    loadJson();
+
+    // reading the metadata does not load the library, the index saves us from opening it at all
+    if (matches(indexEntry)) {
+        int type = indexEntry.value("type").toInt();
+        if (type > type_unknown && type < type_end)
+            mType = static_cast<PluginType>(type);
+
+        for (const QJsonValue &val : indexEntry.value("actions").toArray()) {
+            QJsonObject action = val.toObject();
+            mActions << ActionInfo{action.value("text").toString(), action.value("runId").toString()};
+        }
+
+        loadJson(indexEntry.value("metaData").toObject());
+    } else
+        loadJson(QPluginLoader(mPluginPath).metaData());
 }
 
 DkPluginContainer::~DkPluginContainer() = default;
@@ -177,6 +193,10 @@ void DkPluginContainer::setActive(bool active)
 {
     mActive = active;
 
+    // a plugin that was never used has nothing to hide
+    if (!isLoaded())
+        return;
+
     DkPluginInterface *p = plugin();
     if (p && p->interfaceType() == DkPluginInterface::interface_viewport) {
         DkViewPortInterface *vPlugin = pluginViewPort();
@@ -195,11 +215,22 @@ bool DkPluginContainer::isActive() const
 
 bool DkPluginContainer::isLoaded() const
 {
-    return mLoader->isLoaded();
+    return mLoader && mLoader->isLoaded();
 }
 
+/**
+ * Loads the library, creates the plugin's actions and updates the plugin index.
+ * This is called on first use.
+ **/
 bool DkPluginContainer::load()
 {
+    if (isLoaded())
+        return true;
+
+    // do not retry on every access
+    if (mLoadFailed)
+        return false;
+
     DkTimer dt;
 
     if (!isValid()) {
@@ -209,8 +240,10 @@ bool DkPluginContainer::load()
             if (mPluginPath.contains("dll"))
 #endif
                 qInfo() << "Invalid: " << mPluginPath;
+        mLoadFailed = true;
         return false;
     } else {
+        mLoader = QSharedPointer<QPluginLoader>(new QPluginLoader(mPluginPath));
         QString fn = QFileInfo(mLoader->fileName()).fileName();
 
 #ifdef Q_OS_WIN
@@ -224,6 +257,7 @@ bool DkPluginContainer::load()
             qInfo() << "name: " << mPluginName;
             qInfo() << "modified: " << mDateModified.toString("dd-MM-yyyy");
             qInfo() << "error: " << mLoader->errorString();
+            mLoadFailed = true;
             return false;
         }
     }
@@ -238,46 +272,147 @@ bool DkPluginContainer::load()
         mType = type_simple;
     else {
         qWarning() << "could not initialize: " << mPluginPath << "unknown interface";
+        mLoadFailed = true;
         return false;
     }
 
     if (mType != type_unknown) {
         // init actions
         plugin()->createActions(DkUtils::getMainWindow());
+
+        mActions.clear();
+        for (const QAction *action : plugin()->pluginActions())
+            mActions << ActionInfo{action->text(), action->data().toString()};
+
         createMenu();
     }
 
+    DkPluginManager::instance().updateIndex(*this);
+
     qInfo() << mPluginPath << "loaded in" << dt;
     return true;
 }
 
 bool DkPluginContainer::uninstall()
 {
-    mLoader->unload();
+    if (mLoader)
+        mLoader->unload();
     // NOTE: dependencies are not removed yet -> they might be used by other plugins
 
     return QFile::remove(mPluginPath);
 }
 
+/**
+ * Creates the plugin menu.
+ * Until the plugin is loaded, the menu holds placeholders of the indexed actions.
+ **/
 void DkPluginContainer::createMenu()
 {
-    DkPluginInterface *p = plugin();
-
     // empty menu if we do not have any actions
-    if (!p || p->pluginActions().empty())
+    if (mActions.empty())
         return;
 
-    mPluginMenu = new QMenu(pluginName(), DkUtils::getMainWindow());
+    if (!mPluginMenu)
+        mPluginMenu = new QMenu(pluginName(), DkUtils::getMainWindow());
+
+    // placeholders are deleted later since one of them might be loading the plugin right now
+    for (QAction *action : mPluginMenu->actions()) {
+        if (action->parent() == mPluginMenu) {
+            mPluginMenu->removeAction(action);
+            action->deleteLater();
+        }
+    }
+
+    if (isLoaded()) {
+        DkPluginInterface *p = plugin();
+        if (!p)
+            return;
+
+        for (auto action : p->pluginActions()) {
+            mPluginMenu->addAction(action);
+            connect(action, &QAction::triggered, this, &DkPluginContainer::run, Qt::UniqueConnection);
+        }
+
+        DkActionManager::instance().assignCustomShortcuts(p->pluginActions().toVector());
+        return;
+    }
 
-    for (auto action : p->pluginActions()) {
+    for (const ActionInfo &info : std::as_const(mActions)) {
+        auto *action = new QAction(info.text, mPluginMenu);
+        action->setData(info.runId);
         mPluginMenu->addAction(action);
-        connect(action, &QAction::triggered, this, &DkPluginContainer::run, Qt::UniqueConnection);
+        connect(action, &QAction::triggered, this, [this, runId = info.runId]() {
+            triggerAction(runId);
+        });
     }
 }
 
-void DkPluginContainer::loadJson()
+void DkPluginContainer::triggerAction(const QString &runId)
+{
+    // loading replaces the placeholders with the plugin's actions
+    DkPluginInterface *p = plugin();
+    if (!p)
+        return;
+
+    for (QAction *action : p->pluginActions()) {
+        if (action->data().toString() == runId) {
+            action->trigger();
+            return;
+        }
+    }
+
+    qWarning() << "[DkPluginContainer]" << mPluginName << "has no action" << runId;
+}
+
+DkPluginContainer::PluginType DkPluginContainer::type()
 {
-    QJsonObject metaData = mLoader->metaData();
+    // not indexed yet
+    if (mType == type_unknown && isValid())
+        load();
+
+    return mType;
+}
+
+QVector<DkPluginContainer::ActionInfo> DkPluginContainer::actions() const
+{
+    return mActions;
+}
+
+QJsonObject DkPluginContainer::indexEntry() const
+{
+    QJsonArray actions;
+    for (const ActionInfo &info : mActions)
+        actions << QJsonObject{{"text", info.text}, {"runId", info.runId}};
+
+    QFileInfo fileInfo(mPluginPath);
+
+    return QJsonObject{
+        {"path", mPluginPath},
+        {"modified", static_cast<double>(fileInfo.lastModified().toMSecsSinceEpoch())},
+        {"size", static_cast<double>(fileInfo.size())},
+        {"metaData", mMetaData},
+        {"type", mType},
+        {"actions", actions},
+    };
+}
+
+/**
+ * Returns true if the index entry was created for the current version of the plugin file.
+ **/
+bool DkPluginContainer::matches(const QJsonObject &indexEntry) const
+{
+    if (indexEntry.isEmpty() || indexEntry.value("path").toString() != mPluginPath)
+        return false;
+
+    QFileInfo fileInfo(mPluginPath);
+
+    return indexEntry.value("modified").toDouble() == static_cast<double>(fileInfo.lastModified().toMSecsSinceEpoch())
+        && indexEntry.value("size").toDouble() == static_cast<double>(fileInfo.size());
+}
+
+void DkPluginContainer::loadJson(const QJsonObject &metaData)
+{
+    mMetaData = metaData;
     QStringList keys = metaData.keys();
 
     for (const QString &key : keys) {
@@ -468,10 +603,10 @@ QSharedPointer<QPluginLoader> DkPluginContainer::loader() const
     return mLoader;
 }
 
-DkPluginInterface *DkPluginContainer::plugin() const
+DkPluginInterface *DkPluginContainer::plugin()
 {
-    // is everything fine here??
-    if (!mLoader)
+    // the library is loaded on first use
+    if (!load())
         return nullptr;
 
     DkPluginInterface *pi = qobject_cast<DkPluginInterface *>(mLoader->instance());
@@ -484,33 +619,31 @@ DkPluginInterface *DkPluginContainer::plugin() const
     return pi;
 }
 
-DkBatchPluginInterface *DkPluginContainer::batchPlugin() const
+DkBatchPluginInterface *DkPluginContainer::batchPlugin()
 {
-    // is everything fine here??
-    if (!mLoader)
+    if (!load())
         return nullptr;
 
     return qobject_cast<DkBatchPluginInterface *>(mLoader->instance());
 }
 
-DkViewPortInterface *DkPluginContainer::pluginViewPort() const
+DkViewPortInterface *DkPluginContainer::pluginViewPort()
 {
-    // is everything fine here??
-    if (!mLoader)
+    if (!load())
         return nullptr;
 
     return qobject_cast<DkViewPortInterface *>(mLoader->instance());
 }
 
-QString DkPluginContainer::actionNameToRunId(const QString &actionName) const
+QString DkPluginContainer::actionNameToRunId(const QString &actionName)
 {
-    if (!plugin())
+    // loads the plugin if it is not indexed yet
+    if (type() == type_unknown)
         return QString();
 
-    QList<QAction *> actions = plugin()->pluginActions();
-    for (const QAction *a : actions) {
-        if (a->text() == actionName)
-            return a->data().toString();
+    for (const ActionInfo &info : std::as_const(mActions)) {
+        if (info.text == actionName)
+            return info.runId;
     }
 
     return QString();
@@ -1139,6 +1272,10 @@ void DkPluginManager::loadPlugins()
 
     DkTimer dt;
 
+    readIndex();
+    QHash<QString, QJsonObject> oldIndex = mIndex;
+    mIndex.clear();
+
     QStringList loadedPluginFileNames = QStringList();
     QStringList libPaths = QCoreApplication::libraryPaths();
     libPaths.append(QCoreApplication::applicationDirPath() + "/plugins");
@@ -1169,7 +1306,11 @@ void DkPluginManager::loadPlugins()
 #endif
             QString shortFileName = fileName.split("/").last();
             if (!loadedPluginFileNames.contains(shortFileName)) { // prevent double loading of the same plugin
-                if (singlePluginLoad(pluginsDir.absoluteFilePath(fileName)))
+                QString filePath = pluginsDir.absoluteFilePath(fileName);
+                if (oldIndex.contains(filePath))
+                    mIndex.insert(filePath, oldIndex.value(filePath));
+
+                if (singlePluginLoad(filePath))
                     loadedPluginFileNames.append(shortFileName);
             }
             // else
@@ -1177,28 +1318,103 @@ void DkPluginManager::loadPlugins()
         }
     }
 
+    // entries of removed plugins are dropped
+    if (mIndex != oldIndex)
+        saveIndex();
+
     std::sort(mPlugins.begin(), mPlugins.end()); // , &DkPluginContainer::operator<);
-    qInfo() << mPlugins.size() << "plugins loaded in" << dt;
+    qInfo() << mPlugins.size() << "plugins found in" << dt;
 
     if (mPlugins.empty())
         qInfo() << "I was searching these paths" << libPaths;
 }
 
 /**
- * Loads one plugin from file fileName
- * @param fileName
+ * Adds the plugin at filePath without loading its library.
+ * The library is loaded on first use (see DkPluginContainer::load).
+ * @param filePath
  **/
 bool DkPluginManager::singlePluginLoad(const QString &filePath)
 {
     if (isBlackListed(filePath))
         return false;
 
-    DkTimer dt;
-    QSharedPointer<DkPluginContainer> plugin = QSharedPointer<DkPluginContainer>(new DkPluginContainer(filePath));
-    if (plugin->load())
+    QSharedPointer<DkPluginContainer> plugin(new DkPluginContainer(filePath, mIndex.value(filePath)));
+
+    // remember files that are no plugins too, so that we do not have to read them again
+    QJsonObject entry = plugin->indexEntry();
+    if (mIndex.value(filePath) != entry)
+        updateIndex(*plugin);
+
+    if (plugin->isValid())
         mPlugins.append(plugin);
 
-    return plugin->isLoaded();
+    return plugin->isValid();
+}
+
+/**
+ * Stores the plugin's metadata, type and actions in the plugin index.
+ **/
+void DkPluginManager::updateIndex(const DkPluginContainer &plugin)
+{
+    QJsonObject entry = plugin.indexEntry();
+    if (mIndex.value(plugin.pluginPath()) == entry)
+        return;
+
+    mIndex.insert(plugin.pluginPath(), entry);
+    saveIndex();
+}
+
+QString DkPluginManager::indexPath()
+{
+    return DkUtils::getAppDataPath() + "/plugins.json";
+}
+
+void DkPluginManager::readIndex()
+{
+    mIndex.clear();
+
+    QFile file(indexPath());
+    if (!file.exists())
+        return;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[DkPluginManager] cannot read plugin index:" << file.errorString();
+        return;
+    }
+
+    QJsonParseError error;
+    QJsonObject root = QJsonDocument::fromJson(file.readAll(), &error).object();
+
+    if (error.error != QJsonParseError::NoError || root.value("version").toInt() != 1) {
+        qInfo() << "[DkPluginManager] ignoring outdated plugin index" << indexPath();
+        return;
+    }
+
+    for (const QJsonValue &val : root.value("plugins").toArray()) {
+        QJsonObject entry = val.toObject();
+        mIndex.insert(entry.value("path").toString(), entry);
+    }
+}
+
+void DkPluginManager::saveIndex() const
+{
+    QJsonArray plugins;
+    for (const QJsonObject &entry : mIndex)
+        plugins << entry;
+
+    QJsonObject root{{"version", 1}, {"plugins", plugins}};
+
+    QSaveFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[DkPluginManager] cannot write plugin index:" << file.errorString();
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+
+    if (!file.commit())
+        qWarning() << "[DkPluginManager] cannot write plugin index:" << file.errorString();
 }
 
 QSharedPointer<DkPluginContainer> DkPluginManager::getPluginByName(const QString &pluginName) const
@@ -1226,11 +1442,8 @@ QVector<QSharedPointer<DkPluginContainer>> DkPluginManager::getBasicPlugins() co
     QVector<QSharedPointer<DkPluginContainer>> plugins;
 
     for (auto plugin : mPlugins) {
-        DkPluginInterface *p = plugin->plugin();
-
-        if (p && p->interfaceType() == DkPluginInterface::interface_basic) {
+        if (plugin->type() == DkPluginContainer::type_simple)
             plugins.append(plugin);
-        }
     }
 
     return plugins;
@@ -1241,13 +1454,10 @@ QVector<QSharedPointer<DkPluginContainer>> DkPluginManager::getBatchPlugins() co
     QVector<QSharedPointer<DkPluginContainer>> plugins;
 
     for (auto plugin : mPlugins) {
-        DkPluginInterface *p = plugin->plugin();
+        DkPluginContainer::PluginType type = plugin->type();
 
-        if (p
-            && (p->interfaceType() == DkPluginInterface::interface_basic
-                || p->interfaceType() == DkPluginInterface::interface_batch)) {
+        if (type == DkPluginContainer::type_simple || type == DkPluginContainer::type_batch)
             plugins.append(plugin);
-        }
     }
 
     return plugins;
@@ -1479,13 +1689,19 @@ void DkPluginActionManager::addPluginsToMenu()
     QStringList pluginMenu = QStringList();
 
     for (auto plugin : loadedPlugins) {
-        DkPluginInterface *pi = plugin->plugin();
+        // plugins that are not in the index yet are loaded to find their actions
+        if (plugin->type() == DkPluginContainer::type_unknown)
+            continue;
+
+        if (!plugin->pluginMenu())
+            plugin->createMenu();
 
-        if (pi && plugin->pluginMenu()) {
-            QList<QAction *> actions = pi->createActions(DkUtils::getMainWindow());
+        if (plugin->pluginMenu()) {
+            if (plugin->isLoaded())
+                plugin->plugin()->createActions(DkUtils::getMainWindow());
             mPluginSubMenus.append(plugin->pluginMenu());
             mMenu->addMenu(plugin->pluginMenu());
-        } else if (pi) {
+        } else {
             auto *a = new QAction(plugin->pluginName(), this);
             a->setData(plugin->id());
             mPluginActions.append(a);
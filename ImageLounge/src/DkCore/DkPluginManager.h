@@ -30,6 +30,8 @@
 #include <QAbstractTableModel>
 #include <QDate>
 #include <QDialog>
+#include <QHash>
+#include <QJsonObject>
 #include <QLabel>
 #include <QLibrary>
 #include <QMap>
@@ -87,12 +89,18 @@ protected:
     QVector<DkLibrary> loadDependencies() const;
 };
 
+/**
+ * A plugin library.
+ *
+ * The container is created from the plugin's JSON metadata (or its entry
+ * in the plugin index), the library itself is loaded on first use.
+ **/
 class DllCoreExport DkPluginContainer : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit DkPluginContainer(const QString &pluginPath);
+    explicit DkPluginContainer(const QString &pluginPath, const QJsonObject &indexEntry = QJsonObject());
     ~DkPluginContainer() override;
 
     enum PluginType {
@@ -106,6 +114,11 @@ public:
 
     friend bool operator<(const QSharedPointer<DkPluginContainer> &l, const QSharedPointer<DkPluginContainer> &r);
 
+    struct ActionInfo {
+        QString text;
+        QString runId;
+    };
+
     void setActive(bool active = true);
     bool isActive() const;
 
@@ -114,6 +127,16 @@ public:
     bool load();
     bool uninstall();
 
+    /**
+     * Type & actions are known once the plugin was loaded, the index keeps
+     * them so that the library is not loaded before it is actually used.
+     **/
+    PluginType type();
+    QVector<ActionInfo> actions() const;
+
+    QJsonObject indexEntry() const;
+    bool matches(const QJsonObject &indexEntry) const;
+
     // attributes
     QString pluginPath() const;
     QString pluginName() const;
@@ -129,12 +152,13 @@ public:
     QDate dateModified() const;
 
     QMenu *pluginMenu() const;
+    void createMenu();
 
     QSharedPointer<QPluginLoader> loader() const;
-    DkPluginInterface *plugin() const;
-    DkBatchPluginInterface *batchPlugin() const;
-    DkViewPortInterface *pluginViewPort() const;
-    QString actionNameToRunId(const QString &actionName) const;
+    DkPluginInterface *plugin();
+    DkBatchPluginInterface *batchPlugin();
+    DkViewPortInterface *pluginViewPort();
+    QString actionNameToRunId(const QString &actionName);
 
 signals:
     void runPlugin(DkViewPortInterface *viewport, bool close) const;
@@ -158,15 +182,18 @@ protected:
 
     bool mActive = false;
     bool mIsValid = false;
+    bool mLoadFailed = false;
 
     PluginType mType = type_unknown;
+    QVector<ActionInfo> mActions;
+    QJsonObject mMetaData;
 
     QMenu *mPluginMenu = nullptr;
 
     QSharedPointer<QPluginLoader> mLoader = QSharedPointer<QPluginLoader>();
 
-    void createMenu();
-    void loadJson();
+    void triggerAction(const QString &runId);
+    void loadJson(const QJsonObject &metaData);
     void loadMetaData(const QJsonValue &val);
 };
 
@@ -230,6 +257,8 @@ public:
     void loadPlugins();
 
     bool singlePluginLoad(const QString &filePath);
+    void updateIndex(const DkPluginContainer &plugin);
+    static QString indexPath();
 
     QVector<QSharedPointer<DkPluginContainer>> getBasicPlugins() const;
     QVector<QSharedPointer<DkPluginContainer>> getBatchPlugins() const;
@@ -246,7 +275,11 @@ public:
 private:
     DkPluginManager();
 
+    void readIndex();
+    void saveIndex() const;
+
     QVector<QSharedPointer<DkPluginContainer>> mPlugins;
+    QHash<QString, QJsonObject> mIndex; // plugin path -> index entry
 };
 
 // Plug-in manager dialog for enabling/disabling plug-ins and downloading new ones
@@ -27,11 +27,14 @@
 
 #include "DkProcess.h"
 
+#include "DkBasicLoader.h"
 #include "DkImageContainer.h"
 #include "DkImageStorage.h"
+#include "DkJpegTransform.h"
 #include "DkMath.h"
 #include "DkMetaData.h"
 #include "DkPluginManager.h"
+#include "DkSettings.h"
 #include "DkTimer.h"
 #include "DkUtils.h"
 
@@ -383,6 +386,50 @@ bool DkBatchTransform::compute(QSharedPointer<DkImageContainer> container, QStri
     return true;
 }
 
+bool DkBatchTransform::computeLossless(DkJpegTransform &transform, QStringList &logStrings) const
+{
+    if (!isActive())
+        return true;
+
+    // these need the decoded image
+    if (isResizeActive() || mCropFromMetadata)
+        return false;
+
+    if (mAngle != 0) {
+        DkJpegTransform::Transform t = DkJpegTransform::fromAngle(mAngle);
+        if (t == DkJpegTransform::transform_end || !transform.addTransform(t))
+            return false;
+
+        logStrings.append(QObject::tr("%1 image rotated %2 degrees (lossless).").arg(name()).arg(mAngle));
+    }
+
+    if (cropFromRectangle()) {
+        QRect imgRect(QPoint(), transform.transformedSize());
+        QRect r = mCropRect.intersected(imgRect);
+
+        if (mCropRectCenter && r.width() < imgRect.width())
+            r.moveLeft((imgRect.width() - r.width()) / 2);
+
+        if (mCropRectCenter && r.height() < imgRect.height())
+            r.moveTop((imgRect.height() - r.height()) / 2);
+
+        // crops that are not aligned to JPEG blocks need re-encoding
+        if (!transform.setCrop(r))
+            return false;
+
+        logStrings.append(QObject::tr("%1 image %2 x %3 cropped to x%4 y%5 w%6 h%7 (lossless)")
+                              .arg(name())
+                              .arg(imgRect.width())
+                              .arg(imgRect.height())
+                              .arg(r.x())
+                              .arg(r.y())
+                              .arg(r.width())
+                              .arg(r.height()));
+    }
+
+    return true;
+}
+
 bool DkBatchTransform::prepareProperties(const QSize &imgSize,
                                          QSize &size,
                                          float &scaleFactor,
@@ -824,6 +871,9 @@ bool DkBatchProcess::process()
 {
     mLogStrings.append(QObject::tr("processing %1").arg(mSaveInfo.inputFilePath()));
 
+    if (processLossless())
+        return mFailure == 0;
+
     QSharedPointer<DkImageContainer> imgC(new DkImageContainer(DkFileInfo(mSaveInfo.inputFilePath())));
 
     if (!imgC->loadImage() || imgC->image().isNull()) {
@@ -886,6 +936,124 @@ bool DkBatchProcess::process()
     return true;
 }
 
+/**
+ * Rotates/crops JPEGs without decoding and re-encoding them.
+ * This keeps the image data bit-exact and is limited by I/O only.
+ * @return false if the process chain needs the decoded image
+ **/
+bool DkBatchProcess::processLossless()
+{
+    static const QStringList jpegSuffixes = {"jpg", "jpeg", "jpe"};
+
+    if (!jpegSuffixes.contains(mSaveInfo.inputFileInfo().suffix().toLower())
+        || !jpegSuffixes.contains(mSaveInfo.outputFileInfo().suffix().toLower()))
+        return false;
+
+    if (mSaveInfo.mode() & DkSaveInfo::mode_do_not_save_output)
+        return false;
+
+    QSharedPointer<QByteArray> ba = DkBasicLoader::loadFileToBuffer(mSaveInfo.inputFilePath());
+    if (!ba || ba->isEmpty())
+        return false;
+
+    DkJpegTransform transform;
+    if (!transform.setSource(*ba))
+        return false;
+
+    QSharedPointer<DkMetaDataT> md(new DkMetaDataT());
+    md->readMetaData(mSaveInfo.inputFilePath(), ba);
+
+    // the loader applies the EXIF orientation - so we bake it into the image data
+    bool bakeOrientation = false;
+    int degrees = md->getOrientationDegrees();
+    if (!DkSettingsManager::param().metaData().ignoreExifOrientation && degrees != DkMetaDataT::or_invalid
+        && degrees != DkMetaDataT::or_not_set) {
+        DkJpegTransform::Transform t = DkJpegTransform::fromOrientation(degrees, md->isOrientationMirrored());
+        if (t == DkJpegTransform::transform_end)
+            return false;
+
+        transform.addTransform(t);
+        bakeOrientation = t != DkJpegTransform::transform_none;
+    }
+
+    QStringList logStrings;
+    for (const QSharedPointer<DkAbstractBatch> &batch : mProcessFunctions) {
+        if (batch && !batch->computeLossless(transform, logStrings))
+            return false;
+    }
+
+    // nothing to transform, the user might want to re-encode
+    if (transform.isIdentity())
+        return false;
+
+    QSharedPointer<QByteArray> out(new QByteArray());
+    if (!transform.apply(*out)) {
+        qInfo() << "[Batch] no lossless transform for" << mSaveInfo.inputFileInfo().fileName() << "-"
+                << transform.errorString();
+        return false;
+    }
+
+    mLogStrings << logStrings;
+
+    if (!prepareDeleteExisting()) {
+        mFailure++;
+        return true;
+    }
+
+    if (updateMetaData(md.data()))
+        mLogStrings.append(QObject::tr("Original filename added to Exif"));
+
+    if (bakeOrientation || mSaveInfo.clearOrientation())
+        md->clearOrientation();
+
+    QSize size = transform.size();
+    if (!md->getExifValue("PixelXDimension").isEmpty()) {
+        md->setExifValue("Exif.Photo.PixelXDimension", QString::number(size.width()));
+        md->setExifValue("Exif.Photo.PixelYDimension", QString::number(size.height()));
+    }
+
+    // transform the (tiny) EXIF thumbnail along with the image
+    QImage thumb = md->getThumbnail();
+    if (!thumb.isNull()) {
+        int angle = 0;
+        bool mirrored = false;
+        DkJpegTransform::toOrientation(transform.transform(), angle, mirrored);
+
+        thumb = DkImage::rotateImage(thumb, angle);
+        if (mirrored)
+            thumb = DkImage::flipImage(thumb, Qt::Horizontal);
+
+        QRect cr = transform.crop();
+        if (!cr.isNull()) {
+            double sx = (double)thumb.width() / transform.transformedSize().width();
+            double sy = (double)thumb.height() / transform.transformedSize().height();
+            thumb = thumb.copy(qRound(cr.x() * sx),
+                               qRound(cr.y() * sy),
+                               qRound(cr.width() * sx),
+                               qRound(cr.height() * sy));
+        }
+
+        md->setThumbnail(thumb);
+    }
+
+    md->saveMetaData(out, true);
+
+    QFile file(mSaveInfo.outputFilePath());
+    if (file.open(QFile::WriteOnly) && file.write(*out) == out->size()) {
+        mLogStrings.append(QObject::tr("%1 saved (lossless)...").arg(mSaveInfo.outputFilePath()));
+    } else {
+        mLogStrings.append(QObject::tr("Could not save: %1").arg(mSaveInfo.outputFilePath()));
+        mLogStrings.append(file.errorString());
+        mFailure++;
+    }
+    file.close();
+
+    if (!deleteOrRestoreExisting())
+        mFailure++;
+
+    return true;
+}
+
 bool DkBatchProcess::renameFile()
 {
     if (QFileInfo(mSaveInfo.outputFilePath()).exists()) {
@@ -42,6 +42,7 @@ namespace nmc
 
 // nomacs defines
 class DkImageContainer;
+class DkJpegTransform;
 class DkPluginContainer;
 class DkMetaDataT;
 
@@ -72,6 +73,15 @@ public:
     {
         return true;
     };
+
+    /**
+     * Apply the batch to a JPEG without decoding it (see DkJpegTransform).
+     * @return false if the batch needs the decoded image
+     **/
+    virtual bool computeLossless(DkJpegTransform &, QStringList &) const
+    {
+        return !isActive();
+    };
     virtual bool isActive() const
     {
         return false;
@@ -175,6 +185,7 @@ public:
                        bool correctGamma = false);
 
     bool compute(QSharedPointer<DkImageContainer> container, QStringList &logStrings) const override;
+    bool computeLossless(DkJpegTransform &transform, QStringList &logStrings) const override;
     QString name() const override;
     bool isActive() const override;
 
@@ -229,6 +240,7 @@ public:
 
 protected:
     bool process();
+    bool processLossless();
     bool prepareDeleteExisting();
     bool deleteOrRestoreExisting();
     bool deleteOriginalFile();
@@ -393,6 +393,9 @@ void DkSettings::load(QSettings &settings, bool defaults)
     tmpShow = settings.value("showHistoryDock", app_p.showHistoryDock).toBitArray();
     if (tmpShow.size() == app_p.showHistoryDock.size())
         app_p.showHistoryDock = tmpShow;
+    tmpShow = settings.value("showPageDock", app_p.showPageDock).toBitArray();
+    if (tmpShow.size() == app_p.showPageDock.size())
+        app_p.showPageDock = tmpShow;
     tmpShow = settings.value("showLogDock", app_p.showLogDock).toBitArray();
     if (tmpShow.size() == app_p.showLogDock.size())
         app_p.showLogDock = tmpShow;
@@ -400,6 +403,7 @@ void DkSettings::load(QSettings &settings, bool defaults)
     app_p.hideAllPanels = settings.value("hideAllPanels", app_p.hideAllPanels).toBool();
     app_p.closeOnEsc = settings.value("closeOnEsc", app_p.closeOnEsc).toBool();
     app_p.closeOnMiddleMouse = settings.value("closeOnMiddleMouse", app_p.closeOnMiddleMouse).toBool();
+    app_p.singleInstance = settings.value("singleInstance", app_p.singleInstance).toBool();
     app_p.showRecentFiles = settings.value("showRecentFiles", app_p.showRecentFiles).toBool();
     app_p.useLogFile = settings.value("useLogFile", app_p.useLogFile).toBool();
     app_p.defaultJpgQuality = settings.value("defaultJpgQuality", app_p.defaultJpgQuality).toInt();
@@ -507,6 +511,8 @@ void DkSettings::load(QSettings &settings, bool defaults)
 
     meta_p.ignoreExifOrientation = settings.value("ignoreExifOrientation", meta_p.ignoreExifOrientation).toBool();
     meta_p.saveExifOrientation = settings.value("saveExifOrientation", meta_p.saveExifOrientation).toBool();
+    meta_p.saveMetaDataInstantly = settings.value("saveMetaDataInstantly", meta_p.saveMetaDataInstantly).toBool();
+    meta_p.useXmpSidecar = settings.value("useXmpSidecar", meta_p.useXmpSidecar).toBool();
 
     settings.endGroup();
     // SlideShow Settings --------------------------------------------------------------------
@@ -537,6 +543,7 @@ void DkSettings::load(QSettings &settings, bool defaults)
     sync_p.syncAbsoluteTransform = settings.value("syncAbsoluteTransform", sync_p.syncAbsoluteTransform).toBool();
     sync_p.switchModifier = settings.value("switchModifier", sync_p.switchModifier).toBool();
     sync_p.syncActions = settings.value("syncActions", sync_p.syncActions).toBool();
+    sync_p.shareImages = settings.value("shareImages", sync_p.shareImages).toBool();
 
     settings.endGroup();
     // Resource Settings --------------------------------------------------------------------
@@ -684,6 +691,8 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("showEditDock", app_p.showEditDock);
     if (force || app_p.showHistoryDock != app_d.showHistoryDock)
         settings.setValue("showHistoryDock", app_p.showHistoryDock);
+    if (force || app_p.showPageDock != app_d.showPageDock)
+        settings.setValue("showPageDock", app_p.showPageDock);
     if (force || app_p.showLogDock != app_d.showLogDock)
         settings.setValue("showLogDock", app_p.showLogDock);
     if (force || app_p.hideAllPanels != app_d.hideAllPanels)
@@ -694,6 +703,8 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("closeOnEsc", app_p.closeOnEsc);
     if (force || app_p.closeOnMiddleMouse != app_d.closeOnMiddleMouse)
         settings.setValue("closeOnMiddleMouse", app_p.closeOnMiddleMouse);
+    if (force || app_p.singleInstance != app_d.singleInstance)
+        settings.setValue("singleInstance", app_p.singleInstance);
     if (force || app_p.showRecentFiles != app_d.showRecentFiles)
         settings.setValue("showRecentFiles", app_p.showRecentFiles);
     if (force || app_p.useLogFile != app_d.useLogFile)
@@ -850,6 +861,10 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("ignoreExifOrientation", meta_p.ignoreExifOrientation);
     if (force || meta_p.saveExifOrientation != meta_d.saveExifOrientation)
         settings.setValue("saveExifOrientation", meta_p.saveExifOrientation);
+    if (force || meta_p.saveMetaDataInstantly != meta_d.saveMetaDataInstantly)
+        settings.setValue("saveMetaDataInstantly", meta_p.saveMetaDataInstantly);
+    if (force || meta_p.useXmpSidecar != meta_d.useXmpSidecar)
+        settings.setValue("useXmpSidecar", meta_p.useXmpSidecar);
 
     settings.endGroup();
     // SlideShow Settings --------------------------------------------------------------------
@@ -890,6 +905,8 @@ void DkSettings::save(QSettings &settings, bool force)
         settings.setValue("switchModifier", sync_p.switchModifier);
     if (force || sync_p.syncActions != sync_d.syncActions)
         settings.setValue("syncActions", sync_p.syncActions);
+    if (force || sync_p.shareImages != sync_d.shareImages)
+        settings.setValue("shareImages", sync_p.shareImages);
 
     settings.endGroup();
     // Resource Settings --------------------------------------------------------------------
@@ -987,10 +1004,12 @@ void DkSettings::setToDefaultSettings()
     app_p.showMetaDataDock = QBitArray(mode_end, false);
     app_p.showEditDock = QBitArray(mode_end, false);
     app_p.showHistoryDock = QBitArray(mode_end, false);
+    app_p.showPageDock = QBitArray(mode_end, false);
     app_p.showLogDock = QBitArray(mode_end, false);
     app_p.advancedSettings = false;
     app_p.closeOnEsc = false;
     app_p.closeOnMiddleMouse = false;
+    app_p.singleInstance = false;
     app_p.hideAllPanels = false;
     app_p.showRecentFiles = true;
     app_p.browseFilters = QStringList();
@@ -1096,6 +1115,8 @@ void DkSettings::setToDefaultSettings()
 
     meta_p.saveExifOrientation = true;
     meta_p.ignoreExifOrientation = false;
+    meta_p.saveMetaDataInstantly = false;
+    meta_p.useXmpSidecar = false;
 
     sync_p.checkForUpdates = !isPortable(); // installed version should only check for updates by default
     sync_p.disableUpdateInteraction = isPortable(); // installed version should only check for updates by default
@@ -1103,6 +1124,7 @@ void DkSettings::setToDefaultSettings()
     sync_p.lastUpdateCheck = QDate(2018, 7, 14); // ; )
     sync_p.syncAbsoluteTransform = true;
     sync_p.syncActions = false;
+    sync_p.shareImages = true;
 
     resources_p.cacheMemory = 256;
     resources_p.historyMemory = 128;
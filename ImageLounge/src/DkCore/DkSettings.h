@@ -183,6 +183,7 @@ public:
         QBitArray showMetaDataDock;
         QBitArray showEditDock;
         QBitArray showHistoryDock;
+        QBitArray showPageDock;
         QBitArray showLogDock;
         bool showRecentFiles;
         bool useLogFile;
@@ -192,6 +193,7 @@ public:
         bool advancedSettings;
         bool closeOnEsc;
         bool closeOnMiddleMouse;
+        bool singleInstance; // forward files to a running instance
         bool hideAllPanels;
 
         int defaultJpgQuality;
@@ -316,10 +318,13 @@ public:
         bool syncAbsoluteTransform;
         bool switchModifier;
         bool syncActions;
+        bool shareImages; // hand decoded images to synchronized instances
     };
     struct MetaData {
         bool ignoreExifOrientation;
         bool saveExifOrientation;
+        bool saveMetaDataInstantly;
+        bool useXmpSidecar;
     };
 
     struct Resources {
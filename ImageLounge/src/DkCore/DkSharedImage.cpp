@@ -0,0 +1,278 @@
+/*******************************************************************************************************
+ DkSharedImage.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkSharedImage.h"
+
+#include <QColorSpace>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSharedMemory>
+#include <QStandardPaths>
+
+#include <cstring>
+
+namespace nmc
+{
+
+namespace
+{
+const quint32 sharedImageMagic = 0x4e4d5349; // NMSI
+const quint32 sharedImageVersion = 1;
+
+// layout: header size (quint32), header, pixels starting at pixelOffset()
+qint64 pixelOffset(qint64 headerSize)
+{
+    const qint64 alignment = 64;
+    return (qint64(sizeof(quint32)) + headerSize + alignment - 1) / alignment * alignment;
+}
+
+void releaseSegment(void *info)
+{
+    delete static_cast<std::shared_ptr<QSharedMemory> *>(info);
+}
+}
+
+DkSharedImage &DkSharedImage::instance()
+{
+    static DkSharedImage inst;
+    return inst;
+}
+
+QString DkSharedImage::segmentKey(const DkImageCache::Key &key)
+{
+    QByteArray id;
+    QDataStream ds(&id, QIODevice::WriteOnly);
+    ds << key.path << key.modified << key.size << qint32(key.page) << qint32(key.variant);
+
+    return "nomacs-image-" + QCryptographicHash::hash(id, QCryptographicHash::Md5).toHex();
+}
+
+QString DkSharedImage::registryPath()
+{
+    // the runtime location is private to the user (session)
+    QString path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (path.isEmpty())
+        path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+
+    return QDir(path).filePath("nomacs-images");
+}
+
+void DkSharedImage::setEnabled(bool enabled)
+{
+    if (enabled && !isEnabled())
+        removeStaleSegments();
+
+    QMutexLocker locker(&mMutex);
+
+    mEnabled = enabled;
+    if (!enabled)
+        mPublished.clear();
+}
+
+bool DkSharedImage::isEnabled() const
+{
+    QMutexLocker locker(&mMutex);
+    return mEnabled;
+}
+
+bool DkSharedImage::publish(const DkImageCache::Key &key, const DkImageCache::Entry &entry)
+{
+    const QImage &img = entry.image;
+
+    if (!key.isValid() || img.isNull())
+        return false;
+
+    QMutexLocker locker(&mMutex);
+
+    if (!mEnabled)
+        return false;
+
+    for (const Segment &p : std::as_const(mPublished)) {
+        if (p.key == key)
+            return true;
+    }
+
+    // the lock is held while the segment is published, see removeStaleSegments()
+    const QString name = segmentKey(key);
+    auto lock = std::make_shared<QLockFile>(QDir(registryPath()).filePath(name + ".lock"));
+    lock->setStaleLockTime(0); // stale only if the publisher is gone
+
+    if (!QDir().mkpath(registryPath()) || !lock->tryLock(0))
+        qWarning() << "[DkSharedImage] cannot register" << name << "- it is not cleaned up after a crash";
+
+    QByteArray header;
+    QDataStream ds(&header, QIODevice::WriteOnly);
+    ds << sharedImageMagic << sharedImageVersion;
+    ds << qint32(img.width()) << qint32(img.height()) << qint32(img.format()) << qint64(img.bytesPerLine());
+    ds << entry.editName << qint32(entry.numPages) << qint32(entry.pageIdx) << entry.ignoredOrientation;
+    ds << img.colorSpace().iccProfile();
+
+    const qint64 offset = pixelOffset(header.size());
+
+    auto mem = std::make_shared<QSharedMemory>(name);
+    if (!mem->create(offset + img.sizeInBytes())) {
+        qWarning() << "[DkSharedImage] cannot publish" << key.path << mem->errorString();
+        return false;
+    }
+
+    mem->lock();
+    char *dst = static_cast<char *>(mem->data());
+    const quint32 headerSize = header.size();
+    std::memcpy(dst, &headerSize, sizeof(headerSize));
+    std::memcpy(dst + sizeof(headerSize), header.constData(), header.size());
+    std::memcpy(dst + offset, img.constBits(), img.sizeInBytes());
+    mem->unlock();
+
+    mPublished.append(Segment{key, lock, mem});
+    while (mPublished.size() > mMaxPublished)
+        mPublished.removeFirst();
+
+    return true;
+}
+
+bool DkSharedImage::find(const DkImageCache::Key &key, DkImageCache::Entry &entry) const
+{
+    if (!key.isValid() || !isEnabled())
+        return false;
+
+    auto mem = std::make_shared<QSharedMemory>(segmentKey(key));
+    if (!mem->attach(QSharedMemory::ReadOnly))
+        return false;
+
+    const qint64 size = mem->size();
+    const auto *src = static_cast<const char *>(mem->constData());
+
+    quint32 magic = 0, version = 0;
+    qint32 width = 0, height = 0, format = 0, numPages = 1, pageIdx = 1;
+    qint64 bytesPerLine = 0, offset = 0;
+    QString editName;
+    bool ignoredOrientation = false;
+    QByteArray icc;
+
+    mem->lock();
+    quint32 headerSize = 0;
+    if (size >= qint64(sizeof(headerSize)))
+        std::memcpy(&headerSize, src, sizeof(headerSize));
+
+    if (headerSize > 0 && qint64(sizeof(headerSize)) + headerSize <= size) {
+        QDataStream ds(QByteArray::fromRawData(src + sizeof(headerSize), headerSize));
+        ds >> magic >> version;
+        ds >> width >> height >> format >> bytesPerLine;
+        ds >> editName >> numPages >> pageIdx >> ignoredOrientation;
+        ds >> icc;
+        offset = pixelOffset(headerSize);
+    }
+    mem->unlock();
+
+    if (magic != sharedImageMagic || version != sharedImageVersion) {
+        qWarning() << "[DkSharedImage] ignoring incompatible segment for" << key.path;
+        return false;
+    }
+
+    if (width <= 0 || height <= 0 || format <= QImage::Format_Invalid || format >= QImage::NImageFormats
+        || offset + bytesPerLine * height > size) {
+        qWarning() << "[DkSharedImage] ignoring corrupted segment for" << key.path;
+        return false;
+    }
+
+    // the image keeps the segment mapped
+    QImage img(reinterpret_cast<const uchar *>(src + offset),
+               width,
+               height,
+               bytesPerLine,
+               static_cast<QImage::Format>(format),
+               releaseSegment,
+               new std::shared_ptr<QSharedMemory>(mem));
+
+    if (!icc.isEmpty())
+        img.setColorSpace(QColorSpace::fromIccProfile(icc));
+
+    entry.image = img;
+    entry.editName = editName;
+    entry.numPages = numPages;
+    entry.pageIdx = pageIdx;
+    entry.ignoredOrientation = ignoredOrientation;
+
+    return true;
+}
+
+void DkSharedImage::release(const DkImageCache::Key &key)
+{
+    QMutexLocker locker(&mMutex);
+
+    for (int idx = 0; idx < mPublished.size(); idx++) {
+        if (mPublished[idx].key == key) {
+            mPublished.removeAt(idx);
+            break;
+        }
+    }
+}
+
+void DkSharedImage::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mPublished.clear();
+}
+
+int DkSharedImage::numPublished() const
+{
+    QMutexLocker locker(&mMutex);
+    return mPublished.size();
+}
+
+int DkSharedImage::removeStaleSegments()
+{
+    QDir dir(registryPath());
+    const QStringList files = dir.entryList({"nomacs-image-*.lock"}, QDir::Files);
+
+    int numRemoved = 0;
+    for (const QString &fileName : files) {
+        QLockFile lock(dir.filePath(fileName));
+        lock.setStaleLockTime(0);
+
+        // we only get the lock if the publisher is gone
+        if (!lock.tryLock(0))
+            continue;
+
+        // the last detach removes the segment, instances that still map it keep it alive
+        QSharedMemory mem(QFileInfo(fileName).completeBaseName());
+        if (mem.attach(QSharedMemory::ReadOnly))
+            mem.detach();
+
+        lock.unlock();
+        numRemoved++;
+        qInfo() << "[DkSharedImage] removed stale segment" << fileName;
+    }
+
+    return numRemoved;
+}
+}
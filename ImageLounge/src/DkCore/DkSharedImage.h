@@ -0,0 +1,113 @@
+/*******************************************************************************************************
+ DkSharedImage.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#include "DkImageCache.h"
+
+#include <QList>
+#include <QMutex>
+
+#include <memory>
+
+#include "nmc_config.h"
+
+class QLockFile;
+class QSharedMemory;
+
+namespace nmc
+{
+/**
+ * Hands decoded images to other local instances.
+ *
+ * While enabled (i.e. this instance is synchronized), the loader publishes
+ * decoded images in shared memory segments named after their cache key.
+ * Another instance that opens the same file maps the segment read-only
+ * instead of decoding the file again.
+ *
+ * Only the displayed image is published (see DkBasicLoader::publishImage)
+ * and only the most recent ones are kept. A segment lives until the
+ * publisher releases it and all images that were mapped from it are gone.
+ * Every published segment has a lock file in registryPath(), segments of
+ * publishers that crashed are removed by removeStaleSegments().
+ **/
+class DllCoreExport DkSharedImage
+{
+public:
+    static DkSharedImage &instance();
+
+    /**
+     * Returns the name of the segment that holds the image of key.
+     **/
+    static QString segmentKey(const DkImageCache::Key &key);
+
+    static QString registryPath();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /**
+     * Copies the image of entry into a new segment, returns false if
+     * disabled or if the segment cannot be created.
+     **/
+    bool publish(const DkImageCache::Key &key, const DkImageCache::Entry &entry);
+
+    /**
+     * Maps an image published by any instance, the image refers to the
+     * read-only segment and is copied on write.
+     **/
+    bool find(const DkImageCache::Key &key, DkImageCache::Entry &entry) const;
+
+    void release(const DkImageCache::Key &key);
+    void clear();
+
+    int numPublished() const;
+
+    /**
+     * Removes the segments of instances that crashed, returns their number.
+     * It is called whenever sharing is enabled.
+     **/
+    int removeStaleSegments();
+
+private:
+    DkSharedImage() = default;
+    DkSharedImage(const DkSharedImage &) = delete; // NOLINT
+
+    mutable QMutex mMutex;
+    bool mEnabled = false;
+    struct Segment {
+        DkImageCache::Key key;
+        std::shared_ptr<QLockFile> lock; // released after the segment
+        std::shared_ptr<QSharedMemory> mem;
+    };
+
+    QList<Segment> mPublished; // oldest first
+
+    static constexpr int mMaxPublished = 2;
+};
+}
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DkThemeManager.h"
 
+#include "DkIconAtlas.h"
 #include "DkSettings.h"
 #include "DkTimer.h"
 #include "DkUtils.h"
@@ -791,6 +792,9 @@ void DkThemeManager::applyTheme()
 
     mOurPaletteChange = false;
 
+    // icons rendered with other colors are outdated
+    DkIconAtlas::instance().setTheme(getCurrentThemeName() + "|" + d.iconColor.name(QColor::HexArgb));
+
     qInfo() << "theme applied in:" << dt;
 
     emit themeApplied();
@@ -91,7 +91,6 @@ std::optional<LoadThumbnailResult> loadThumbnail(const LoadThumbnailRequest &req
     DkTimer dt{};
 
     auto metaData = std::make_unique<DkMetaDataT>();
-    QSharedPointer<QByteArray> ba{};
     DkFileInfo fileInfo(request.filePath);
 
     if (fileInfo.isSymLink() && !fileInfo.resolveSymLink()) {
@@ -116,19 +115,10 @@ std::optional<LoadThumbnailResult> loadThumbnail(const LoadThumbnailRequest &req
     }
 
     if (!fullThumb) {
-        if (fileInfo.isFromZip()) {
-            std::unique_ptr<QIODevice> io = fileInfo.getIODevice();
-            if (io)
-                ba.reset(new QByteArray(io->readAll()));
-        }
-
         // read the thumbnail from the exif data
+        // zip members are inflated only as far as exiv2 reads, the full image loader reads them if needed
         try {
-            if (!ba || ba->isEmpty()) {
-                metaData->readMetaData(thumbPath);
-            } else {
-                metaData->readMetaData(thumbPath, ba);
-            }
+            metaData->readMetaData(fileInfo);
         } catch (...) {
             // this should never happen since we handle exceptions in metaData
             qWarning() << "[Thumbnail] unexpected exception when reading exif thumbnail";
@@ -143,7 +133,7 @@ std::optional<LoadThumbnailResult> loadThumbnail(const LoadThumbnailRequest &req
             && !DkImage::isResizeDownsampling(exifThumb->thumb.size(), request.size, request.constraint);
         if (loadFull) {
             exifThumb = {};
-            fullThumb = loadThumbnailFromFullImage(thumbPath, ba, loadOptions);
+            fullThumb = loadThumbnailFromFullImage(thumbPath, {}, loadOptions);
         }
 
         if (!fullThumb && !exifThumb) {
@@ -0,0 +1,516 @@
+/*******************************************************************************************************
+ DkTiffPageIndex.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#include "DkTiffPageIndex.h"
+
+#include "DkFileInfo.h"
+#include "DkTimer.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+
+#ifdef WITH_LIBTIFF
+#include <tiffio.h>
+#endif
+
+#include <cstdarg>
+#include <cstring>
+
+namespace
+{
+#ifdef WITH_LIBTIFF
+/**
+ * Read-only view of a TIFF file for TIFFClientOpen().
+ **/
+struct TiffMemory {
+    const uchar *data = nullptr;
+    qint64 size = 0;
+    qint64 pos = 0;
+};
+
+tsize_t tiffRead(thandle_t handle, tdata_t buf, tsize_t size)
+{
+    auto *m = static_cast<TiffMemory *>(handle);
+    qint64 n = qBound<qint64>(0, size, m->size - m->pos);
+    memcpy(buf, m->data + m->pos, n);
+    m->pos += n;
+
+    return static_cast<tsize_t>(n);
+}
+
+tsize_t tiffWrite(thandle_t, tdata_t, tsize_t)
+{
+    return 0;
+}
+
+toff_t tiffSeek(thandle_t handle, toff_t offset, int whence)
+{
+    auto *m = static_cast<TiffMemory *>(handle);
+    qint64 pos = static_cast<qint64>(offset);
+
+    if (whence == SEEK_CUR)
+        pos += m->pos;
+    else if (whence == SEEK_END)
+        pos += m->size;
+
+    if (pos < 0)
+        return static_cast<toff_t>(-1);
+
+    m->pos = pos;
+    return static_cast<toff_t>(pos);
+}
+
+int tiffClose(thandle_t)
+{
+    return 0;
+}
+
+toff_t tiffSize(thandle_t handle)
+{
+    return static_cast<toff_t>(static_cast<TiffMemory *>(handle)->size);
+}
+
+int tiffMap(thandle_t handle, tdata_t *base, toff_t *size)
+{
+    auto *m = static_cast<TiffMemory *>(handle);
+    *base = const_cast<uchar *>(m->data); // opened read-only
+    *size = static_cast<toff_t>(m->size);
+
+    return 1;
+}
+
+void tiffUnmap(thandle_t, tdata_t, toff_t)
+{
+}
+
+#if TIFFLIB_VERSION >= 20221213
+int tiffMessage(TIFF *, void *, const char *module, const char *fmt, va_list ap)
+{
+    // callers report failures, the details are for debugging
+    qDebug().noquote() << "[TIFF]" << module << QString::vasprintf(fmt, ap);
+    return 1;
+}
+#endif
+
+/**
+ * Opens a TIFF from a memory mapped file or from a buffer.
+ **/
+class TiffReader
+{
+public:
+    TiffReader(const QString &filePath, const QSharedPointer<QByteArray> &buffer);
+    ~TiffReader();
+    TiffReader(const TiffReader &) = delete; // NOLINT
+
+    TIFF *tiff() const
+    {
+        return mTiff;
+    }
+
+private:
+    QFile mFile;
+    QSharedPointer<QByteArray> mBuffer;
+    TiffMemory mMemory;
+    TIFF *mTiff = nullptr;
+};
+
+TiffReader::TiffReader(const QString &filePath, const QSharedPointer<QByteArray> &buffer)
+    : mBuffer(buffer)
+{
+    if (!mBuffer) {
+        mFile.setFileName(filePath);
+        if (!mFile.open(QIODevice::ReadOnly))
+            return;
+
+        mMemory.data = mFile.map(0, mFile.size());
+        mMemory.size = mFile.size();
+
+        // e.g. network shares might not support mapping
+        if (!mMemory.data)
+            mBuffer = QSharedPointer<QByteArray>::create(mFile.readAll());
+    }
+
+    if (mBuffer) {
+        mMemory.data = reinterpret_cast<const uchar *>(mBuffer->constData());
+        mMemory.size = mBuffer->size();
+    }
+
+#if TIFFLIB_VERSION >= 20221213
+    // libtiff >= 4.5 takes handlers per file, the process-wide handlers are left alone
+    TIFFOpenOptions *options = TIFFOpenOptionsAlloc();
+    TIFFOpenOptionsSetErrorHandlerExtR(options, tiffMessage, nullptr);
+    TIFFOpenOptionsSetWarningHandlerExtR(options, tiffMessage, nullptr);
+
+    mTiff = TIFFClientOpenExt(QFile::encodeName(filePath).constData(),
+                              "r",
+                              &mMemory,
+                              tiffRead,
+                              tiffWrite,
+                              tiffSeek,
+                              tiffClose,
+                              tiffSize,
+                              tiffMap,
+                              tiffUnmap,
+                              options);
+
+    TIFFOpenOptionsFree(options);
+#else
+    mTiff = TIFFClientOpen(QFile::encodeName(filePath).constData(),
+                           "r",
+                           &mMemory,
+                           tiffRead,
+                           tiffWrite,
+                           tiffSeek,
+                           tiffClose,
+                           tiffSize,
+                           tiffMap,
+                           tiffUnmap);
+#endif
+}
+
+// libtiff writes ABGR
+uint32_t toArgb(uint32_t p)
+{
+    return (p & 0xff00ff00) | ((p & 0x00ff0000) >> 16) | ((p & 0x000000ff) << 16);
+}
+
+TiffReader::~TiffReader()
+{
+    // close before the file is unmapped
+    if (mTiff)
+        TIFFClose(mTiff);
+}
+#endif // WITH_LIBTIFF
+}
+
+namespace nmc
+{
+DkTiffPageIndex::DkTiffPageIndex(const QString &filePath)
+    : mFilePath(filePath)
+{
+    DkFileInfo file(filePath);
+    mModified = file.lastModified();
+    mSize = file.size();
+    mFromZip = file.isFromZip();
+}
+
+QSharedPointer<const DkTiffPageIndex> DkTiffPageIndex::index(const QString &filePath)
+{
+    static constexpr int maxIndexes = 8;
+    static QMutex mutex;
+    static QList<QSharedPointer<DkTiffPageIndex>> indexes; // most recent first
+
+    if (!isTiff(filePath))
+        return {};
+
+    {
+        QMutexLocker locker(&mutex);
+
+        for (int idx = 0; idx < indexes.size(); idx++) {
+            if (indexes[idx]->filePath() != filePath)
+                continue;
+
+            QSharedPointer<DkTiffPageIndex> index = indexes.takeAt(idx);
+            if (index->isOutdated())
+                break;
+
+            indexes.prepend(index);
+            return index;
+        }
+    }
+
+    // walking the directories can take a while, do not block other files
+    QSharedPointer<DkTiffPageIndex> index(new DkTiffPageIndex(filePath));
+    if (!index->build())
+        return {};
+
+    QMutexLocker locker(&mutex);
+    indexes.prepend(index);
+    while (indexes.size() > maxIndexes)
+        indexes.removeLast();
+
+    return index;
+}
+
+bool DkTiffPageIndex::isTiff(const QString &filePath)
+{
+    const QString suffix = DkFileInfo(filePath).suffix().toLower();
+    return suffix == "tif" || suffix == "tiff";
+}
+
+bool DkTiffPageIndex::isOutdated() const
+{
+    DkFileInfo file(mFilePath);
+    return file.lastModified() != mModified || file.size() != mSize;
+}
+
+QSharedPointer<QByteArray> DkTiffPageIndex::buffer() const
+{
+    if (!mFromZip)
+        return {};
+
+    // the member is read again once no page is being read
+    QMutexLocker locker(&mBufferMutex);
+    QSharedPointer<QByteArray> buffer = mBuffer.toStrongRef();
+    if (!buffer) {
+        auto io = DkFileInfo(mFilePath).getIODevice();
+        buffer = QSharedPointer<QByteArray>::create(io ? io->readAll() : QByteArray());
+        mBuffer = buffer;
+    }
+
+    return buffer;
+}
+
+bool DkTiffPageIndex::build()
+{
+#ifdef WITH_LIBTIFF
+    DkTimer dt;
+
+    TiffReader reader(mFilePath, buffer());
+    TIFF *tiff = reader.tiff();
+    if (!tiff)
+        return false;
+
+    auto imageSize = [tiff]() {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+        TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+
+        return QSize(static_cast<int>(width), static_cast<int>(height));
+    };
+
+    do {
+        uint32_t subfileType = 0;
+        uint16_t compression = 0;
+        uint16_t bitsPerSample = 0;
+        uint16_t samplesPerPixel = 0;
+
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_SUBFILETYPE, &subfileType);
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_COMPRESSION, &compression);
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+
+        const quint64 offset = TIFFCurrentDirOffset(tiff);
+
+        // reduced-resolution copies follow the page they belong to
+        if ((subfileType & FILETYPE_REDUCEDIMAGE) && !mPages.isEmpty()) {
+            mPages.last().reduced << Level{offset, imageSize()};
+            continue;
+        }
+
+        Page page;
+        page.offset = offset;
+        page.size = imageSize();
+        page.compression = compression;
+        page.bitsPerSample = bitsPerSample;
+        page.samplesPerPixel = samplesPerPixel;
+
+        // pyramids store their levels as SubIFDs
+        uint16_t numSubIfds = 0;
+        uint64_t *subIfds = nullptr;
+        if (TIFFGetField(tiff, TIFFTAG_SUBIFD, &numSubIfds, &subIfds) && numSubIfds > 0) {
+            const QVector<uint64_t> levels(subIfds, subIfds + numSubIfds); // invalid once we leave the IFD
+
+            for (uint64_t levelOffset : levels) {
+                if (TIFFSetSubDirectory(tiff, levelOffset))
+                    page.reduced << Level{levelOffset, imageSize()};
+            }
+
+            // continue with the next page
+            if (!TIFFSetSubDirectory(tiff, offset)) {
+                mPages << page;
+                break;
+            }
+        }
+
+        mPages << page;
+
+    } while (TIFFReadDirectory(tiff));
+
+    qDebug() << "[TIFF] indexed" << mPages.size() << "pages in" << dt;
+
+    return !mPages.isEmpty();
+#else
+    return false;
+#endif
+}
+
+QString DkTiffPageIndex::filePath() const
+{
+    return mFilePath;
+}
+
+int DkTiffPageIndex::numPages() const
+{
+    return mPages.size();
+}
+
+DkTiffPageIndex::Page DkTiffPageIndex::page(int pageIdx) const
+{
+    if (pageIdx < 1 || pageIdx > mPages.size())
+        return {};
+
+    return mPages[pageIdx - 1];
+}
+
+QImage DkTiffPageIndex::readPage(int pageIdx) const
+{
+    if (pageIdx < 1 || pageIdx > mPages.size())
+        return {};
+
+    const Page &page = mPages[pageIdx - 1];
+
+    QImage img = readDirectory(page.offset, page.size, 1);
+    if (img.isNull())
+        qWarning() << "[TIFF] cannot read page" << pageIdx << "of" << mFilePath;
+
+    return img;
+}
+
+QImage DkTiffPageIndex::readThumbnail(int pageIdx, int maxSize) const
+{
+    if (pageIdx < 1 || pageIdx > mPages.size() || maxSize <= 0)
+        return {};
+
+    const Page &page = mPages[pageIdx - 1];
+
+    // the smallest reduced-resolution copy that is still large enough
+    const Level *level = nullptr;
+    for (const Level &l : page.reduced) {
+        if (qMax(l.size.width(), l.size.height()) >= maxSize && (!level || l.size.width() < level->size.width()))
+            level = &l;
+    }
+
+    QImage img;
+    if (level)
+        img = readDirectory(level->offset, level->size, 1);
+
+    // otherwise the page is subsampled, twice the size we need keeps the scaling smooth
+    if (img.isNull()) {
+        const int step = qMax(1, qMax(page.size.width(), page.size.height()) / (2 * maxSize));
+        img = readDirectory(page.offset, page.size, step);
+    }
+
+    if (img.isNull()) {
+        qWarning() << "[TIFF] cannot read thumbnail of page" << pageIdx << "of" << mFilePath;
+        return {};
+    }
+
+    if (img.width() <= maxSize && img.height() <= maxSize)
+        return img;
+
+    return img.scaled(maxSize, maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+QImage DkTiffPageIndex::readDirectory(quint64 offset, const QSize &size, int step) const
+{
+#ifdef WITH_LIBTIFF
+    TiffReader reader(mFilePath, buffer());
+    TIFF *tiff = reader.tiff();
+
+    // jump to the directory without reading the ones before
+    if (!tiff || !TIFFSetSubDirectory(tiff, offset) || size.isEmpty())
+        return {};
+
+    const uint32_t width = static_cast<uint32_t>(size.width());
+    const uint32_t height = static_cast<uint32_t>(size.height());
+    const int stopOnError = 1;
+
+    // bands are only stored top down in this orientation
+    uint16_t orientation = ORIENTATION_TOPLEFT;
+    TIFFGetFieldDefaulted(tiff, TIFFTAG_ORIENTATION, &orientation);
+
+    if (step <= 1 || orientation != ORIENTATION_TOPLEFT) {
+        QImage img(size, QImage::Format_ARGB32);
+        if (img.isNull())
+            return {};
+
+        auto *raster = reinterpret_cast<uint32_t *>(img.bits());
+        if (!TIFFReadRGBAImageOriented(tiff, width, height, raster, ORIENTATION_TOPLEFT, stopOnError))
+            return {};
+
+        for (qsizetype idx = 0; idx < qsizetype(width) * height; idx++)
+            raster[idx] = toArgb(raster[idx]);
+
+        return step <= 1 ? img : img.scaled(img.width() / step, img.height() / step);
+    }
+
+    char msg[1024];
+    TIFFRGBAImage rgba;
+    if (!TIFFRGBAImageOK(tiff, msg) || !TIFFRGBAImageBegin(&rgba, tiff, stopOnError, msg)) {
+        qDebug() << "[TIFF]" << msg;
+        return {};
+    }
+    rgba.req_orientation = ORIENTATION_TOPLEFT;
+
+    // whole strips (or rows of tiles) are decoded at once, only the band is kept in memory
+    uint32_t bandHeight = 0;
+    if (TIFFIsTiled(tiff))
+        TIFFGetField(tiff, TIFFTAG_TILELENGTH, &bandHeight);
+    else
+        TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &bandHeight);
+    bandHeight = qBound<uint32_t>(1, bandHeight, height);
+    bandHeight *= qMax<uint32_t>(1, 64 / bandHeight);
+    bandHeight = qMin(bandHeight, height);
+
+    const uint32_t ustep = static_cast<uint32_t>(step);
+    QImage band(static_cast<int>(width), static_cast<int>(bandHeight), QImage::Format_ARGB32);
+    QImage img(static_cast<int>((width + ustep - 1) / ustep),
+               static_cast<int>((height + ustep - 1) / ustep),
+               QImage::Format_ARGB32);
+    bool ok = !band.isNull() && !img.isNull();
+
+    for (uint32_t y0 = 0; ok && y0 < height; y0 += bandHeight) {
+        const uint32_t rows = qMin(bandHeight, height - y0);
+        rgba.row_offset = static_cast<int>(y0);
+        rgba.col_offset = 0;
+        ok = TIFFRGBAImageGet(&rgba, reinterpret_cast<uint32_t *>(band.bits()), width, rows) != 0;
+
+        // keep every step-th row and column of this band
+        for (uint32_t y = (y0 + ustep - 1) / ustep * ustep; ok && y < y0 + rows; y += ustep) {
+            const auto *src = reinterpret_cast<const uint32_t *>(band.constScanLine(static_cast<int>(y - y0)));
+            auto *dst = reinterpret_cast<uint32_t *>(img.scanLine(static_cast<int>(y / ustep)));
+
+            for (int x = 0; x < img.width(); x++)
+                dst[x] = toArgb(src[x * ustep]);
+        }
+    }
+
+    TIFFRGBAImageEnd(&rgba);
+
+    return ok ? img : QImage();
+#else
+    Q_UNUSED(offset);
+    Q_UNUSED(size);
+    Q_UNUSED(step);
+    return {};
+#endif
+}
+}
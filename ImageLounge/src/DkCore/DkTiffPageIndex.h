@@ -0,0 +1,124 @@
+/*******************************************************************************************************
+ DkTiffPageIndex.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QImage>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "nmc_config.h"
+
+namespace nmc
+{
+
+/**
+ * Directory of a multi-page TIFF file.
+ *
+ * The IFDs are walked once and their offsets are kept, so any page can
+ * be decoded without reading the directories before it. Indexes are
+ * cached per file until the file changes. Pages are decoded from a
+ * memory mapped file, hence reading is thread-safe and works for any
+ * file name and for files in zip archives. Zip members are only kept
+ * in memory while pages are read.
+ *
+ * Page numbers are 1-based like in DkBasicLoader.
+ **/
+class DllCoreExport DkTiffPageIndex
+{
+public:
+    struct Level {
+        quint64 offset = 0; // IFD offset
+        QSize size;
+    };
+
+    struct Page {
+        quint64 offset = 0; // IFD offset
+        QSize size;
+        int compression = 0;
+        int bitsPerSample = 0;
+        int samplesPerPixel = 0;
+        QVector<Level> reduced; // reduced-resolution copies (previews, pyramids)
+    };
+
+    /**
+     * Returns the (cached) index of the file or null if it is not a TIFF.
+     **/
+    static QSharedPointer<const DkTiffPageIndex> index(const QString &filePath);
+
+    /**
+     * Returns true for suffixes that are indexed.
+     **/
+    static bool isTiff(const QString &filePath);
+
+    QString filePath() const;
+
+    /**
+     * Returns the number of pages. Reduced-resolution directories (FILETYPE_REDUCEDIMAGE
+     * and SubIFDs) are not pages, they are listed in Page::reduced of their page.
+     **/
+    int numPages() const;
+    Page page(int pageIdx) const;
+
+    /**
+     * Decodes a page to ARGB32.
+     * @return a null image if the page is invalid or cannot be read
+     **/
+    QImage readPage(int pageIdx) const;
+
+    /**
+     * Decodes a page and scales it to fit maxSize. The smallest reduced-resolution
+     * copy that is large enough is used, otherwise the page is subsampled while
+     * it is decoded.
+     **/
+    QImage readThumbnail(int pageIdx, int maxSize) const;
+
+private:
+    explicit DkTiffPageIndex(const QString &filePath);
+
+    bool build();
+    bool isOutdated() const;
+    QSharedPointer<QByteArray> buffer() const;
+
+    /**
+     * Decodes the directory at offset, only every step-th row and column is kept.
+     **/
+    QImage readDirectory(quint64 offset, const QSize &size, int step) const;
+
+    QString mFilePath;
+    QDateTime mModified;
+    qint64 mSize = 0;
+    bool mFromZip = false;
+    mutable QMutex mBufferMutex;
+    mutable QWeakPointer<QByteArray> mBuffer; // zip member, shared by concurrent readers
+    QVector<Page> mPages;
+};
+}
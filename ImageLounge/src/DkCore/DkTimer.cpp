@@ -27,8 +27,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DkTimer.h"
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
 #include <QString>
+#include <QThread>
+#include <QTimer>
+
+#include <memory>
 
 namespace nmc
 {
@@ -123,4 +132,182 @@ int DkTimer::elapsed() const
 {
     return mTimer.elapsed();
 }
+
+// DkStartupTrace --------------------------------------------------------------------
+DkStartupTrace::DkStartupTrace()
+{
+    mClock.start();
+    mThreads.insert(QThread::currentThreadId(), 0);
+}
+
+DkStartupTrace &DkStartupTrace::instance()
+{
+    static DkStartupTrace inst;
+    return inst;
+}
+
+void DkStartupTrace::setOutputPath(const QString &path)
+{
+    QMutexLocker locker(&mMutex);
+    mOutputPath = path;
+}
+
+qint64 DkStartupTrace::now() const
+{
+    return mClock.nsecsElapsed() / 1000;
+}
+
+void DkStartupTrace::addPhase(const QString &name, qint64 start, qint64 duration)
+{
+    if (mFinished)
+        return;
+
+    QMutexLocker locker(&mMutex);
+
+    Qt::HANDLE tid = QThread::currentThreadId();
+    auto thread = mThreads.find(tid);
+    if (thread == mThreads.end())
+        thread = mThreads.insert(tid, mThreads.size());
+
+    mPhases << Phase{name, start, duration, thread.value()};
+}
+
+void DkStartupTrace::finish(const QString &event)
+{
+    // called on every paint, keep it cheap
+    if (mFinished.exchange(true))
+        return;
+
+    QString outputPath;
+    {
+        QMutexLocker locker(&mMutex);
+        mFinishEvent = event;
+        mFinishTime = now();
+        outputPath = mOutputPath;
+    }
+
+    qInfo().nospace() << "[DkStartupTrace] " << qPrintable(event) << " after " << mFinishTime / 1000 << " ms";
+
+    if (!outputPath.isEmpty() && save(outputPath))
+        qInfo() << "[DkStartupTrace] trace written to" << outputPath;
+
+    emit finished();
+}
+
+bool DkStartupTrace::isFinished() const
+{
+    return mFinished;
+}
+
+void DkStartupTrace::runWhenFinished(QObject *context, const std::function<void()> &fn)
+{
+    if (isFinished()) {
+        QTimer::singleShot(0, context, fn);
+        return;
+    }
+
+    // queued since finish() is usually called while painting
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(
+        this,
+        &DkStartupTrace::finished,
+        context,
+        [connection, fn]() {
+            QObject::disconnect(*connection);
+            fn();
+        },
+        Qt::QueuedConnection);
+}
+
+QVector<DkStartupTrace::Phase> DkStartupTrace::phases() const
+{
+    QMutexLocker locker(&mMutex);
+    return mPhases;
+}
+
+QByteArray DkStartupTrace::toJson() const
+{
+    QMutexLocker locker(&mMutex);
+
+    qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+
+    for (const Phase &p : mPhases) {
+        events << QJsonObject{
+            {"name", p.name},
+            {"cat", "startup"},
+            {"ph", "X"},
+            {"ts", p.start},
+            {"dur", p.duration},
+            {"pid", pid},
+            {"tid", p.thread},
+        };
+    }
+
+    if (mFinished) {
+        events << QJsonObject{
+            {"name", mFinishEvent},
+            {"cat", "startup"},
+            {"ph", "i"},
+            {"s", "g"},
+            {"ts", mFinishTime},
+            {"pid", pid},
+            {"tid", 0},
+        };
+    }
+
+    QJsonObject root{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool DkStartupTrace::save(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[DkStartupTrace] cannot write" << path << file.errorString();
+        return false;
+    }
+
+    file.write(toJson());
+
+    if (!file.commit()) {
+        qWarning() << "[DkStartupTrace] cannot write" << path << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void DkStartupTrace::restart()
+{
+    QMutexLocker locker(&mMutex);
+    mPhases.clear();
+    mFinishEvent.clear();
+    mFinishTime = 0;
+    mClock.restart();
+    mFinished = false;
+}
+
+// DkTracePhase --------------------------------------------------------------------
+DkTracePhase::DkTracePhase(const QString &name)
+    : mName(name)
+{
+    if (!DkStartupTrace::instance().isFinished())
+        mStart = DkStartupTrace::instance().now();
+}
+
+DkTracePhase::~DkTracePhase()
+{
+    end();
+}
+
+void DkTracePhase::end()
+{
+    if (mStart < 0)
+        return;
+
+    DkStartupTrace &trace = DkStartupTrace::instance();
+    trace.addPhase(mName, mStart, trace.now() - mStart);
+    mStart = -1;
+}
 }
@@ -28,7 +28,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
 
 #include "nmc_config.h"
 
@@ -64,4 +70,100 @@ protected:
     QElapsedTimer mTimer;
 };
 
+/**
+ * Records named phases of the application startup.
+ *
+ * Phases are recorded until finish() is called, which happens when the
+ * first image is painted. The trace can be written as Chrome trace JSON
+ * (see --trace-startup) and opened in chrome://tracing or Perfetto.
+ **/
+class DllCoreExport DkStartupTrace : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Phase {
+        QString name;
+        qint64 start = 0; // us since the trace started
+        qint64 duration = 0; // us
+        int thread = 0; // 0 is the thread that created the trace
+    };
+
+    static DkStartupTrace &instance();
+
+    // singleton
+    DkStartupTrace(DkStartupTrace const &) = delete;
+    void operator=(DkStartupTrace const &) = delete;
+
+    /**
+     * Write the trace to path once startup is finished.
+     **/
+    void setOutputPath(const QString &path);
+
+    /**
+     * us since the trace started.
+     **/
+    qint64 now() const;
+
+    void addPhase(const QString &name, qint64 start, qint64 duration);
+
+    /**
+     * Stops recording and writes the trace if an output path is set.
+     * @param event name of the event that finished the startup (e.g. "first paint")
+     **/
+    void finish(const QString &event);
+    bool isFinished() const;
+
+    /**
+     * Calls fn (once) in the context's thread when startup is finished.
+     **/
+    void runWhenFinished(QObject *context, const std::function<void()> &fn);
+
+    QVector<Phase> phases() const;
+    QByteArray toJson() const;
+    bool save(const QString &path) const;
+
+    /**
+     * Clears the trace and starts recording again.
+     **/
+    void restart();
+
+signals:
+    void finished() const;
+
+private:
+    DkStartupTrace();
+
+    mutable QMutex mMutex;
+    QElapsedTimer mClock;
+    QVector<Phase> mPhases;
+    QHash<Qt::HANDLE, int> mThreads;
+    QString mOutputPath;
+    QString mFinishEvent;
+    qint64 mFinishTime = 0;
+    std::atomic<bool> mFinished = false;
+};
+
+/**
+ * Adds a phase to the startup trace when it goes out of scope.
+ **/
+class DllCoreExport DkTracePhase
+{
+public:
+    explicit DkTracePhase(const QString &name);
+    ~DkTracePhase();
+
+    DkTracePhase(DkTracePhase const &) = delete;
+    void operator=(DkTracePhase const &) = delete;
+
+    /**
+     * Ends the phase before the end of the scope.
+     **/
+    void end();
+
+private:
+    QString mName;
+    qint64 mStart = -1;
+};
+
 }
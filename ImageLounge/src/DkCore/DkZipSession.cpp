@@ -0,0 +1,174 @@
+/*******************************************************************************************************
+ DkZipSession.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkZipSession.h"
+
+#ifdef WITH_QUAZIP
+
+#include <QDebug>
+#include <QList>
+#include <QThread>
+
+namespace nmc
+{
+
+DkZipSession::DkZipSession(const QFileInfo &zipInfo)
+    : mZipPath(zipInfo.absoluteFilePath())
+    , mModified(zipInfo.lastModified())
+    , mSize(zipInfo.size())
+{
+    auto zip = std::make_unique<QuaZip>(mZipPath);
+    if (!zip->open(QuaZip::mdUnzip)) {
+        qWarning() << "[FileInfo] zip: open failed:" << mZipPath << zip->getZipError();
+        return;
+    }
+
+    QuaZipFileInfo64 info;
+    QuaZipFilePos pos;
+
+    for (bool more = zip->goToFirstFile(); more; more = zip->goToNextFile()) {
+        if (!zip->getCurrentFileInfo(&info) || !zip->getCurrentFilePos(pos)) {
+            qWarning() << "[FileInfo] zip: getCurrentFile failed @index:" << mMembers.size() << mZipPath
+                       << zip->getZipError();
+            continue;
+        }
+
+        // QuaZip locates the first match, so do we
+        const QString key = indexKey(info.name);
+        if (!mIndex.contains(key))
+            mIndex.insert(key, mMembers.size());
+
+        mMembers.append(info);
+        mPositions.append(pos);
+    }
+
+    mIdle.push_back(std::move(zip));
+    mValid = true;
+}
+
+QString DkZipSession::indexKey(const QString &memberPath)
+{
+    if (QuaZip::convertCaseSensitivity(QuaZip::csDefault) == Qt::CaseInsensitive)
+        return memberPath.toLower();
+
+    return memberPath;
+}
+
+bool DkZipSession::isOutdated(const QFileInfo &zipInfo) const
+{
+    return zipInfo.lastModified() != mModified || zipInfo.size() != mSize;
+}
+
+const QuaZipFileInfo64 *DkZipSession::member(const QString &memberPath) const
+{
+    auto it = mIndex.constFind(indexKey(memberPath));
+    return it != mIndex.constEnd() ? &mMembers[*it] : nullptr;
+}
+
+QuaZip *DkZipSession::acquire(const QString &memberPath)
+{
+    auto it = mIndex.constFind(indexKey(memberPath));
+    if (it == mIndex.constEnd())
+        return nullptr;
+
+    std::unique_ptr<QuaZip> zip;
+    {
+        QMutexLocker locker(&mMutex);
+        if (!mIdle.empty()) {
+            zip = std::move(mIdle.back());
+            mIdle.pop_back();
+        }
+    }
+
+    if (!zip) {
+        zip = std::make_unique<QuaZip>(mZipPath);
+        if (!zip->open(QuaZip::mdUnzip)) {
+            qWarning() << "[FileInfo] zip: open failed:" << mZipPath << zip->getZipError();
+            return nullptr;
+        }
+    }
+
+    if (!zip->goToFilePos(mPositions[*it])) {
+        qWarning() << "[FileInfo] zip: locate failed:" << mZipPath << zip->getZipError();
+        return nullptr;
+    }
+
+    return zip.release();
+}
+
+int DkZipSession::numIdle() const
+{
+    QMutexLocker locker(&mMutex);
+    return static_cast<int>(mIdle.size());
+}
+
+void DkZipSession::release(QuaZip *zip)
+{
+    std::unique_ptr<QuaZip> handle(zip);
+
+    QMutexLocker locker(&mMutex);
+    if (mIdle.size() < static_cast<size_t>(QThread::idealThreadCount()))
+        mIdle.push_back(std::move(handle));
+}
+
+QSharedPointer<DkZipSession> DkZipSession::session(const QString &zipPath)
+{
+    static constexpr int maxSessions = 4;
+    static QMutex mutex;
+    static QList<QSharedPointer<DkZipSession>> sessions; // most recent first
+
+    const QFileInfo zipInfo(zipPath);
+
+    QMutexLocker locker(&mutex);
+
+    for (int idx = 0; idx < sessions.size(); idx++) {
+        if (sessions[idx]->zipPath() != zipInfo.absoluteFilePath())
+            continue;
+
+        QSharedPointer<DkZipSession> session = sessions.takeAt(idx);
+        if (session->isOutdated(zipInfo))
+            break;
+
+        sessions.prepend(session);
+        return session;
+    }
+
+    QSharedPointer<DkZipSession> session(new DkZipSession(zipInfo));
+    if (!session->isValid())
+        return {};
+
+    sessions.prepend(session);
+    while (sessions.size() > maxSessions)
+        sessions.removeLast();
+
+    return session;
+}
+
+}
+
+#endif
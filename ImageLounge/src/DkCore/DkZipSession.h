@@ -0,0 +1,119 @@
+/*******************************************************************************************************
+ DkZipSession.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#ifdef WITH_QUAZIP
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+#include <quazip/quazip.h>
+
+#include "nmc_config.h"
+
+namespace nmc
+{
+
+/**
+ * Parsed central directory of a zip file and a pool of open handles.
+ *
+ * Members are located by their central directory position, so reading
+ * one neither reopens the archive nor scans the directory again.
+ * A handle decompresses one member at a time, the pool grows with the
+ * number of threads reading from the archive.
+ *
+ * Names are matched like QuaZip::setCurrentFile() with csDefault does:
+ * case insensitive on Windows, and the first of duplicate members wins.
+ **/
+class DllCoreExport DkZipSession
+{
+public:
+    /**
+     * Returns the (cached) session of the zip file, or null if it cannot be opened.
+     * Sessions are dropped if the zip file changed; only the recently used ones are kept.
+     **/
+    static QSharedPointer<DkZipSession> session(const QString &zipPath);
+
+    explicit DkZipSession(const QFileInfo &zipInfo);
+    Q_DISABLE_COPY(DkZipSession)
+
+    bool isValid() const
+    {
+        return mValid;
+    }
+
+    QString zipPath() const
+    {
+        return mZipPath;
+    }
+
+    // true if the zip file changed since it was parsed
+    bool isOutdated(const QFileInfo &zipInfo) const;
+
+    // all entries in central directory order
+    const QVector<QuaZipFileInfo64> &members() const
+    {
+        return mMembers;
+    }
+
+    const QuaZipFileInfo64 *member(const QString &memberPath) const;
+
+    // returns a handle positioned at memberPath, or nullptr
+    QuaZip *acquire(const QString &memberPath);
+    void release(QuaZip *zip);
+
+    // handles that are open but not in use
+    int numIdle() const;
+
+private:
+    static QString indexKey(const QString &memberPath);
+
+    QString mZipPath;
+    QDateTime mModified;
+    qint64 mSize = 0;
+    bool mValid = false;
+
+    QVector<QuaZipFileInfo64> mMembers;
+    QVector<QuaZipFilePos> mPositions;
+    QHash<QString, int> mIndex;
+
+    mutable QMutex mMutex;
+    std::vector<std::unique_ptr<QuaZip>> mIdle;
+};
+
+}
+
+#endif
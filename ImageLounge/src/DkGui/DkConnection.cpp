@@ -28,11 +28,53 @@
 #include "DkConnection.h"
 
 #include <QByteArray>
+#include <QDataStream>
 #include <QTimer>
 
 namespace nmc
 {
 
+namespace
+{
+// records of a SYNCBATCH message, each has a fixed size
+enum SyncRecord : quint8 {
+    record_affine_transform = 1, // 2 x 6 doubles + canvas size
+    record_transform, // 2 x 9 doubles + canvas size
+    record_move, // relative translation
+    record_position, // 4 x qint32 + opacity + overlaid
+};
+
+void writeTransform(QDataStream &ds, const QTransform &t, bool affine)
+{
+    ds << double(t.m11()) << double(t.m12());
+    if (!affine)
+        ds << double(t.m13());
+    ds << double(t.m21()) << double(t.m22());
+    if (!affine)
+        ds << double(t.m23());
+    ds << double(t.m31()) << double(t.m32());
+    if (!affine)
+        ds << double(t.m33());
+}
+
+QTransform readTransform(QDataStream &ds, bool affine)
+{
+    double m11 = 1.0, m12 = 0.0, m13 = 0.0, m21 = 0.0, m22 = 1.0, m23 = 0.0, m31 = 0.0, m32 = 0.0, m33 = 1.0;
+
+    ds >> m11 >> m12;
+    if (!affine)
+        ds >> m13;
+    ds >> m21 >> m22;
+    if (!affine)
+        ds >> m23;
+    ds >> m31 >> m32;
+    if (!affine)
+        ds >> m33;
+
+    return QTransform(m11, m12, m13, m21, m22, m23, m31, m32, m33);
+}
+}
+
 // DkConnection --------------------------------------------------------------------
 
 DkConnection::DkConnection(QObject *parent)
@@ -44,7 +86,12 @@ DkConnection::DkConnection(QObject *parent)
     connectionCreated = false;
     mSynchronizedTimer = new QTimer(this);
 
+    mFlushTimer = new QTimer(this);
+    mFlushTimer->setSingleShot(true);
+    mFlushTimer->setInterval(16);
+
     connect(mSynchronizedTimer, &QTimer::timeout, this, &DkConnection::synchronizedTimerTimeout);
+    connect(mFlushTimer, &QTimer::timeout, this, &DkConnection::flushTimerTimeout);
     connect(this, &DkConnection::readyRead, this, &DkConnection::processReadyRead);
 
     setReadBufferSize(MaxBufferSize);
@@ -80,6 +127,8 @@ void DkConnection::sendStartSynchronizeMessage()
 void DkConnection::sendStopSynchronizeMessage()
 {
     if (mState == Synchronized) { // only send message if connection is synchronized
+        flushPendingMessages();
+
         // qDebug() << "sending disable synchronize Message to " << this->peerName() << ":" << this->peerPort();
         QByteArray synchronize = "disable synchronizing";
         // QByteArray data = "DISABLESYNCHRONIZE" + SeparatorToken + QByteArray::number(synchronize.size()) +
@@ -111,36 +160,146 @@ void DkConnection::sendNewTitleMessage(const QString &newtitle)
 
 void DkConnection::sendNewPositionMessage(QRect position, bool opacity, bool overlaid)
 {
-    // qDebug() << "sending new Position to " << this->peerName() << ":" << this->peerPort();
-    QByteArray ba;
-    QDataStream ds(&ba, QIODevice::ReadWrite);
-    ds << position;
-    ds << opacity;
-    ds << overlaid;
+    // only the latest window position is of interest
+    mPendingPosition = position;
+    mPendingOpacity = opacity;
+    mPendingOverlaid = overlaid;
+    mHasPendingPosition = true;
 
-    // QByteArray data = "NEWTITLE" + SeparatorToken + QByteArray::number(ba.size()) + SeparatorToken + ba;
-    QByteArray data = "NEWPOSITION";
-    data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
-    write(data);
+    schedulePendingMessages();
 }
 
 void DkConnection::sendNewTransformMessage(QTransform transform, QTransform imgTransform, QPointF canvasSize)
 {
-    // qDebug() << "sending new Transform Message to " << this->peerName() << ":" << this->peerPort();
+    if (canvasSize.isNull()) {
+        // relative transforms just move the view, so they add up
+        mPendingMove += QPointF(transform.dx(), transform.dy());
+        mHasPendingMove = true;
+    } else {
+        // an absolute transform replaces everything that was queued before
+        mPendingTransform = transform;
+        mPendingImgTransform = imgTransform;
+        mPendingCanvasSize = canvasSize;
+        mHasPendingTransform = true;
+
+        mPendingMove = QPointF();
+        mHasPendingMove = false;
+    }
+
+    schedulePendingMessages();
+}
+
+bool DkConnection::hasPendingMessages() const
+{
+    return mHasPendingTransform || mHasPendingMove || mHasPendingPosition;
+}
+
+void DkConnection::schedulePendingMessages()
+{
+    // the first update is written immediately, further updates are coalesced until the next frame
+    if (mFlushTimer->isActive())
+        return;
+
+    flushPendingMessages();
+    mFlushTimer->start();
+}
+
+void DkConnection::flushTimerTimeout()
+{
+    if (hasPendingMessages())
+        schedulePendingMessages();
+}
+
+void DkConnection::flushPendingMessages()
+{
+    if (!hasPendingMessages())
+        return;
+
+    if (!mPeerSupportsSyncBatch) {
+        flushLegacyMessages();
+        return;
+    }
+
     QByteArray ba;
-    QDataStream ds(&ba, QIODevice::ReadWrite);
-    ds << transform;
-    ds << imgTransform;
-    ds << canvasSize;
+    QDataStream ds(&ba, QIODevice::WriteOnly);
+
+    if (mHasPendingTransform) {
+        bool affine = mPendingTransform.isAffine() && mPendingImgTransform.isAffine();
+        ds << quint8(affine ? record_affine_transform : record_transform);
+        writeTransform(ds, mPendingTransform, affine);
+        writeTransform(ds, mPendingImgTransform, affine);
+        ds << double(mPendingCanvasSize.x()) << double(mPendingCanvasSize.y());
+    }
+
+    if (mHasPendingMove) {
+        ds << quint8(record_move);
+        ds << double(mPendingMove.x()) << double(mPendingMove.y());
+    }
 
-    // QByteArray data = "NEWTRANSFORM" + SeparatorToken + QByteArray::number(ba.size()) + SeparatorToken + ba;
-    QByteArray data = "NEWTRANSFORM";
+    if (mHasPendingPosition) {
+        ds << quint8(record_position);
+        ds << qint32(mPendingPosition.x()) << qint32(mPendingPosition.y());
+        ds << qint32(mPendingPosition.width()) << qint32(mPendingPosition.height());
+        ds << quint8(mPendingOpacity) << quint8(mPendingOverlaid);
+    }
+
+    mHasPendingTransform = false;
+    mHasPendingMove = false;
+    mHasPendingPosition = false;
+    mPendingMove = QPointF();
+
+    QByteArray data = "SYNCBATCH";
     data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
     write(data);
 }
 
+void DkConnection::flushLegacyMessages()
+{
+    // peers older than SYNCBATCH only understand one message per update
+    auto writeMessage = [this](const QByteArray &type, const QByteArray &ba) {
+        QByteArray data = type;
+        data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
+        write(data);
+    };
+
+    if (mHasPendingTransform) {
+        QByteArray ba;
+        QDataStream ds(&ba, QIODevice::WriteOnly);
+        ds << mPendingTransform;
+        ds << mPendingImgTransform;
+        ds << mPendingCanvasSize;
+        writeMessage("NEWTRANSFORM", ba);
+    }
+
+    if (mHasPendingMove) {
+        QByteArray ba;
+        QDataStream ds(&ba, QIODevice::WriteOnly);
+        ds << QTransform::fromTranslate(mPendingMove.x(), mPendingMove.y());
+        ds << QTransform();
+        ds << QPointF();
+        writeMessage("NEWTRANSFORM", ba);
+    }
+
+    if (mHasPendingPosition) {
+        QByteArray ba;
+        QDataStream ds(&ba, QIODevice::WriteOnly);
+        ds << mPendingPosition;
+        ds << mPendingOpacity;
+        ds << mPendingOverlaid;
+        writeMessage("NEWPOSITION", ba);
+    }
+
+    mHasPendingTransform = false;
+    mHasPendingMove = false;
+    mHasPendingPosition = false;
+    mPendingMove = QPointF();
+}
+
 void DkConnection::sendNewFileMessage(qint16 op, const QString &filename)
 {
+    // keep the order of view changes and file changes
+    flushPendingMessages();
+
     // qDebug() << "sending new File Message to " << this->peerName() << ":" << this->peerPort();
     QByteArray ba;
     QDataStream ds(&ba, QIODevice::ReadWrite);
@@ -154,6 +313,7 @@ void DkConnection::sendNewFileMessage(qint16 op, const QString &filename)
 void DkConnection::sendNewGoodbyeMessage()
 {
     // qDebug() << "sending good bye to " << peerName() << ":" << this->peerPort();
+    flushPendingMessages();
 
     QByteArray ba = "GoodBye"; // scherz?
     QByteArray data = "GOODBYE";
@@ -177,6 +337,7 @@ bool DkConnection::readProtocolHeader()
     QByteArray newpositionBA = QByteArray("NEWPOSITION").append(SeparatorToken);
     QByteArray newFileBA = QByteArray("NEWFILE").append(SeparatorToken);
     QByteArray goodbyeBA = QByteArray("GOODBYE").append(SeparatorToken);
+    QByteArray syncBatchBA = QByteArray("SYNCBATCH").append(SeparatorToken);
 
     if (mBuffer == greetingBA) {
         // qDebug() << "Greeting received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -202,6 +363,8 @@ bool DkConnection::readProtocolHeader()
     } else if (mBuffer == goodbyeBA) {
         // qDebug() << "Goodbye received from:" << this->peerAddress() << ":" << this->peerPort();
         mCurrentDataType = GoodBye;
+    } else if (mBuffer == syncBatchBA) {
+        mCurrentDataType = SyncBatch;
     } else {
         qDebug() << QString(mBuffer);
         qDebug() << "Undefined received from:" << this->peerAddress() << ":" << this->peerPort();
@@ -459,6 +622,11 @@ void DkConnection::processData()
         }
         break;
     }
+    case SyncBatch: {
+        if (mState == Synchronized)
+            readSyncBatch();
+        break;
+    }
     default:
         break;
     }
@@ -468,6 +636,58 @@ void DkConnection::processData()
     mBuffer.clear();
 }
 
+void DkConnection::readSyncBatch()
+{
+    QDataStream ds(mBuffer);
+
+    while (!ds.atEnd()) {
+        quint8 record = 0;
+        ds >> record;
+
+        switch (record) {
+        case record_affine_transform:
+        case record_transform: {
+            bool affine = record == record_affine_transform;
+            QTransform transform = readTransform(ds, affine);
+            QTransform imgTransform = readTransform(ds, affine);
+            double cx = 0.0, cy = 0.0;
+            ds >> cx >> cy;
+            if (ds.status() != QDataStream::Ok)
+                break;
+
+            emit connectionNewTransform(this, transform, imgTransform, QPointF(cx, cy));
+            continue;
+        }
+        case record_move: {
+            double dx = 0.0, dy = 0.0;
+            ds >> dx >> dy;
+            if (ds.status() != QDataStream::Ok)
+                break;
+
+            emit connectionNewTransform(this, QTransform::fromTranslate(dx, dy), QTransform(), QPointF());
+            continue;
+        }
+        case record_position: {
+            qint32 x = 0, y = 0, width = 0, height = 0;
+            quint8 opacity = 0, overlaid = 0;
+            ds >> x >> y >> width >> height >> opacity >> overlaid;
+            if (ds.status() != QDataStream::Ok)
+                break;
+
+            emit connectionNewPosition(this, QRect(x, y, width, height), opacity != 0, overlaid != 0);
+            continue;
+        }
+        default:
+            qWarning() << "[DkConnection] unknown sync record:" << record;
+            return;
+        }
+
+        // the record was truncated, nothing after it can be trusted
+        qWarning() << "[DkConnection] truncated sync record:" << record;
+        return;
+    }
+}
+
 void DkConnection::synchronizedTimerTimeout()
 {
     mSynchronizedTimer->stop();
@@ -526,6 +746,7 @@ void DkLocalConnection::sendGreetingMessage(const QString &currentTitle)
     QDataStream ds(&ba, QIODevice::ReadWrite);
     ds << mLocalTcpServerPort;
     ds << mCurrentTitle;
+    ds << quint32(capability_sync_batch); // older peers stop reading after the title
 
     // qDebug() << "title: " << mCurrentTitle;
     // qDebug() << "local tcp: " << mLocalTcpServerPort;
@@ -551,6 +772,11 @@ void DkLocalConnection::readGreetingMessage()
     ds >> this->mPeerServerPort;
     ds >> title;
 
+    quint32 capabilities = 0;
+    if (!ds.atEnd())
+        ds >> capabilities;
+    mPeerSupportsSyncBatch = ds.status() == QDataStream::Ok && (capabilities & capability_sync_batch);
+
     // qDebug() << "emitting readyForUse";
     emit connectionReadyForUse(mPeerServerPort, title, this);
 }
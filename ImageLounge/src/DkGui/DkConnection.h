@@ -94,6 +94,7 @@ public slots:
     virtual void sendNewFileMessage(qint16 op, const QString &filename);
     void sendNewGoodbyeMessage();
     void synchronizedPeersListChanged(QList<quint16> newList);
+    void flushPendingMessages();
 
 protected:
     enum ConnectionState {
@@ -101,6 +102,10 @@ protected:
         ReadyForUse,
         Synchronized
     };
+    // announced in the greeting, peers that do not send it get the legacy messages
+    enum Capability : quint32 {
+        capability_sync_batch = 0x1,
+    };
     enum DataType {
         Greeting,
         StartSynchronize,
@@ -110,6 +115,7 @@ protected:
         NewTransform,
         NewFile,
         GoodBye,
+        SyncBatch,
         Undefined
     };
 
@@ -126,6 +132,10 @@ protected:
     {
         return true;
     };
+    bool hasPendingMessages() const;
+    void schedulePendingMessages();
+    void flushLegacyMessages();
+    void readSyncBatch();
 
     ConnectionState mState = WaitingForGreeting;
     DataType mCurrentDataType = Undefined;
@@ -136,17 +146,32 @@ protected:
     quint16 mPeerServerPort = 0;
     bool mIsGreetingMessageSent = false;
     bool mIsSynchronizeMessageSent = false;
+    bool mPeerSupportsSyncBatch = false;
 
 protected slots:
     virtual void processReadyRead();
 
 private slots:
     void synchronizedTimerTimeout();
+    void flushTimerTimeout();
 
 protected:
     QTimer *mSynchronizedTimer;
     QList<quint16> mSynchronizedPeersServerPorts;
     quint16 mPeerId;
+
+    // transforms and positions are coalesced and written as one batch per frame
+    QTimer *mFlushTimer;
+    bool mHasPendingTransform = false;
+    QTransform mPendingTransform;
+    QTransform mPendingImgTransform;
+    QPointF mPendingCanvasSize;
+    bool mHasPendingMove = false;
+    QPointF mPendingMove;
+    bool mHasPendingPosition = false;
+    QRect mPendingPosition;
+    bool mPendingOpacity = false;
+    bool mPendingOverlaid = false;
 };
 
 class DllCoreExport DkLocalConnection : public DkConnection
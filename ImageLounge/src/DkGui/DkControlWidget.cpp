@@ -338,6 +338,7 @@ void DkControlWidget::setCommentSaved(const QString &comment)
         return;
     }
     mViewport->imageContainer()->setMetaData(tr("File comment"));
+    mViewport->imageContainer()->saveMetaDataQueued();
 }
 
 void DkControlWidget::update()
@@ -32,9 +32,12 @@
 #include "DkBasicWidgets.h"
 #include "DkCentralWidget.h"
 #include "DkImageStorage.h"
+#include "DkMetaData.h"
+#include "DkMosaicIndex.h"
 #include "DkPluginManager.h"
 #include "DkSettings.h"
 #include "DkThumbs.h"
+#include "DkTiffPageIndex.h"
 #include "DkTimer.h"
 #include "DkUtils.h"
 #include "DkViewPort.h"
@@ -52,6 +55,7 @@
 #include <QComboBox>
 #include <QCompleter>
 #include <QDialogButtonBox>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QFuture>
@@ -67,14 +71,15 @@
 #include <QMessageBox>
 #include <QMimeData>
 #include <QMouseEvent>
+#include <QMutex>
 #include <QPageSetupDialog>
 #include <QPrintDialog>
 #include <QPrinterInfo>
 #include <QProgressBar>
 #include <QProgressDialog>
 #include <QPushButton>
-#include <QRandomGenerator>
 #include <QScreen>
+#include <QSemaphore>
 #include <QSlider>
 #include <QSpinBox>
 #include <QStandardItemModel>
@@ -82,11 +87,13 @@
 #include <QStringListModel>
 #include <QTableView>
 #include <QTextEdit>
+#include <QThreadPool>
 #include <QTimer>
 #include <QToolBar>
 #include <QToolButton>
 #include <QTreeView>
 #include <QWidget>
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <qmath.h>
 
@@ -98,6 +105,9 @@
 #include <quazip/JlCompress.h>
 #endif
 
+#include <atomic>
+#include <numeric>
+
 namespace nmc
 {
 
@@ -457,6 +467,7 @@ DkAppManagerDialog::DkAppManagerDialog(DkAppManager *manager /* = 0 */,
 
 void DkAppManagerDialog::createLayout()
 {
+    mAppManager->assignIcons();
     QVector<QAction *> appActions = mAppManager->getActions();
 
     mTableModel = new QStandardItemModel(this);
@@ -2619,12 +2630,14 @@ void DkExportTiffDialog::accept()
 
     emit infoMessage("");
 
-    QFuture<int> future = QtConcurrent::run([&, suffix] {
-        QFileInfo sFile(mSaveDirPath, mFileEdit->text() + "-" + suffix);
-        return nmc::DkExportTiffDialog::exportImages(sFile.absoluteFilePath(),
-                                                     mFromPage->value(),
-                                                     mToPage->value(),
-                                                     mOverwrite->isChecked());
+    // widgets must not be accessed from the worker
+    QFileInfo sFile(mSaveDirPath, mFileEdit->text() + "-" + suffix);
+    int from = mFromPage->value();
+    int to = mToPage->value();
+    bool overwrite = mOverwrite->isChecked();
+
+    QFuture<int> future = QtConcurrent::run([this, sFile, from, to, overwrite] {
+        return nmc::DkExportTiffDialog::exportImages(sFile.absoluteFilePath(), from, to, overwrite);
     });
     mWatcher.setFuture(future);
 }
@@ -2645,42 +2658,108 @@ int DkExportTiffDialog::exportImages(const QString &saveFilePath, int from, int
 
     QFileInfo saveInfo(saveFilePath);
 
-    // Do your job
-    for (int idx = from; idx <= to; idx++) {
+    // pages are decoded directly from their directory, so they can be exported in parallel
+    auto index = DkTiffPageIndex::index(mFilePath);
+    if (!index) {
+        emit infoMessage(tr("Sorry, I could not read %1").arg(QFileInfo(mFilePath).fileName()));
+        mProcessing = false;
+        return QDialog::Rejected;
+    }
+
+    // exiv2 reads the metadata of the first directory, every page is saved with its own copy
+    DkMetaDataT metaData;
+    metaData.readMetaData(DkFileInfo(mFilePath));
+
+    QList<int> pages;
+    for (int idx = from; idx <= to; idx++)
+        pages << idx;
+
+    // decoding & encoding is cpu bound, files are written by a second pool so that
+    // the disk is kept busy while the next pages are decoded
+    int numThreads = qMax(1, DkSettingsManager::param().global().numThreads);
+    QThreadPool codecPool;
+    codecPool.setMaxThreadCount(numThreads);
+    QThreadPool writePool;
+    writePool.setMaxThreadCount(2);
+
+    // bounds the number of pages (decoded or encoded) held in memory
+    QSemaphore inFlight(2 * numThreads);
+
+    QMutex progressMutex;
+    int numDone = 0;
+    QElapsedTimer previewTimer;
+    previewTimer.start();
+
+    // the lock keeps progress updates in order, previews are throttled
+    // since each of them would be queued as a full page copy
+    auto pageDone = [&](const QImage &preview) {
+        QMutexLocker locker(&progressMutex);
+        numDone++;
+
+        if (!preview.isNull() && (numDone == 1 || previewTimer.elapsed() > 250)) {
+            emit updateImage(preview);
+            previewTimer.restart();
+        }
+
+        emit updateProgress(from - 1 + numDone);
+    };
+
+    QtConcurrent::blockingMap(&codecPool, pages, [&](int idx) {
+        // user canceled?
+        if (!mProcessing)
+            return;
+
         QFileInfo cInfo(saveInfo.absolutePath(), saveInfo.baseName() + QString::number(idx) + "." + saveInfo.suffix());
         qDebug() << "trying to save: " << cInfo.absoluteFilePath();
 
-        emit updateProgress(idx - 1);
-
         // user wants to overwrite files
         if (cInfo.exists() && overwrite) {
             QFile f(cInfo.absoluteFilePath());
             f.remove();
         } else if (cInfo.exists()) {
             emit infoMessage(tr("%1 exists, skipping...").arg(cInfo.fileName()));
-            continue;
+            pageDone(QImage());
+            return;
         }
 
-        if (!mLoader.loadPageAt(idx)) { // load next
-            emit infoMessage(tr("Sorry, I could not load page: %1").arg(idx));
-            continue;
+        inFlight.acquire();
+
+        QImage img = mProcessing ? index->readPage(idx) : QImage();
+        QSharedPointer<DkMetaDataT> pageMetaData = metaData.copy();
+        if (img.isNull()) {
+            if (mProcessing)
+                emit infoMessage(tr("Sorry, I could not load page: %1").arg(idx));
+            inFlight.release();
+            pageDone(QImage());
+            return;
         }
 
-        QString lSaveFilePath = mLoader.save(cInfo.absoluteFilePath(),
-                                             mLoader.image(),
-                                             90); // TODO: ask user for compression?
-        QFileInfo lSaveInfo = QFileInfo(lSaveFilePath);
+        // TODO: ask user for compression?
+        DkBasicLoader loader;
+        QSharedPointer<QByteArray> ba;
+        if (!mProcessing || !loader.saveToBuffer(cInfo.absoluteFilePath(), img, ba, 90, pageMetaData)) {
+            if (mProcessing)
+                emit infoMessage(tr("Sorry, I could not save: %1").arg(cInfo.fileName()));
+            inFlight.release();
+            pageDone(img);
+            return;
+        }
 
-        if (!lSaveInfo.exists() || !lSaveInfo.isFile())
-            emit infoMessage(tr("Sorry, I could not save: %1").arg(cInfo.fileName()));
+        writePool.start([&, cInfo, ba, img]() {
+            DkBasicLoader writer;
+            if (mProcessing && !writer.writeBufferToFile(cInfo.absoluteFilePath(), ba))
+                emit infoMessage(tr("Sorry, I could not save: %1").arg(cInfo.fileName()));
 
-        emit updateImage(mLoader.image());
-        emit updateProgress(idx);
+            inFlight.release();
+            pageDone(img);
+        });
+    });
 
-        // user canceled?
-        if (!mProcessing)
-            return QDialog::Rejected;
-    }
+    writePool.waitForDone();
+
+    // user canceled?
+    if (!mProcessing)
+        return QDialog::Rejected;
 
     mProcessing = false;
 
@@ -3202,16 +3281,6 @@ int DkMosaicDialog::computeMosaic(const QString &filter, const QString &suffix,
     cv::cvtColor(mImg, mImgLab, cv::COLOR_RGB2Lab);
     std::vector<cv::Mat> channels;
     cv::split(mImgLab, channels);
-    cv::Mat imgL = channels[0];
-
-    // keeps track of the weights
-    cv::Mat cc(numPatches.height(), numPatches.width(), CV_32FC1);
-    cc.setTo(0);
-    cv::Mat ccD(numPatches.height(),
-                numPatches.width(),
-                CV_8UC1); // tells us if we have already computed the real patch
-
-    mFilesUsed.resize(numPatches.height() * numPatches.width());
 
     // destination image
     cv::Mat dImg(patchResD * numPatches.height(), patchResD * numPatches.width(), CV_8UC1);
@@ -3227,158 +3296,88 @@ int DkMosaicDialog::computeMosaic(const QString &filter, const QString &suffix,
     qDebug() << "num patches: " << numPatches.width() << " x " << numPatches.height();
     qDebug() << "mosaic data --------------------------------";
 
-    // progress bar
-    int pIdx = 0;
-    int maxP = numPatches.width() * numPatches.height();
-
-    int iDidNothing = 0;
-    bool force = false;
-    bool useTwice = false;
+    // index the database, only new or modified images are described
+    QStringList fileFilters = suffix.isEmpty() ? DkSettingsManager::param().app().fileFilters : QStringList(suffix);
+    QStringList ignore = filter.isEmpty() ? QStringList() : filter.split(";");
 
-    while (iDidNothing < 10000) {
-        if (!mProcessing)
-            return QDialog::Rejected;
+    emit infoMessage(tr("Indexing the database..."));
+    QStringList files = DkMosaicIndex::findImages(mSavePath, fileFilters, ignore);
 
-        if (iDidNothing > 100) {
-            force = true;
+    DkMosaicIndex index;
+    QString indexPath = DkMosaicIndex::cachePath(mSavePath);
+    index.load(indexPath);
 
-            if (!useTwice)
-                emit infoMessage(tr("Filling empty areas..."));
-        }
-
-        if (iDidNothing > 400 && !useTwice) {
-            emit infoMessage(tr("I need to use some images twice - maybe the database is too small?"));
-            iDidNothing = 0;
-            useTwice = true;
-        } else if (iDidNothing > 400) {
-            emit infoMessage(tr("Sorry, it seems that i cannot create your mosaic with this database."));
-            return QDialog::Rejected;
-        }
+    bool indexed = index.update(files, [this](int done, int total) {
+        if (done % 10 == 0)
+            emit updateProgress(qRound((float)done / total * 50));
+        return mProcessing.load();
+    });
 
-        QString imgPath = getRandomImagePath(mSavePath, filter, suffix);
+    if (!indexed)
+        return QDialog::Rejected;
 
-        if (!useTwice && mFilesUsed.contains(QFileInfo(imgPath))) {
-            iDidNothing++;
-            continue;
-        }
+    index.save(indexPath);
 
-        try {
-            std::optional<LoadThumbnailResult> thumb = loadThumbnail(LoadThumbnailRequest{imgPath});
-            if (thumb) {
-                thumb->thumb = DkImage::createThumb(thumb->thumb);
-            }
+    if (index.size() == 0) {
+        emit infoMessage(tr("Sorry, it seems that i cannot create your mosaic with this database."));
+        return QDialog::Rejected;
+    }
 
-            cv::Mat ccTmp(cc.size(), cc.depth());
+    const int maxP = numPatches.width() * numPatches.height();
+    if (index.size() < maxP)
+        emit infoMessage(tr("I need to use some images twice - maybe the database is too small?"));
 
-            if (!force)
-                ccTmp.setTo(0);
-            else
-                ccTmp = cc.clone();
+    // match all cells at once
+    QRect cropRect(qFloor(shC), qFloor(shR), mImg.cols, mImg.rows);
+    QVector<DkMosaicIndex::Entry> cells = DkMosaicIndex::describeCells(mSrcImg.copy(cropRect), numPatches);
+    QVector<int> assignment = index.assign(cells);
 
-            cv::Mat thumbPatch = createPatch(thumb ? thumb->thumb : QImage(), imgPath, patchResO);
+    mFilesUsed.resize(maxP);
+    for (int idx = 0; idx < maxP; idx++)
+        mFilesUsed[idx] = QFileInfo(index.entries().at(assignment[idx]).filePath);
 
-            if (thumbPatch.rows != patchResO || thumbPatch.cols != patchResO) {
-                iDidNothing++;
-                continue;
-            }
+    // render the patches, cells are independent
+    std::atomic<int> numRendered{0};
+    QVector<int> cellIdx(maxP);
+    std::iota(cellIdx.begin(), cellIdx.end(), 0);
 
-            matchPatch(imgL, thumbPatch, patchResO, ccTmp);
+    QtConcurrent::blockingMap(cellIdx, [&](int idx) {
+        if (!mProcessing)
+            return;
 
-            if (force) {
-                cv::Mat mask = (cc == 0);
-                mask.convertTo(mask, CV_32FC1, 1.0f / 255.0f);
-                ccTmp = ccTmp.mul(mask);
-            }
+        const QString filePath = mFilesUsed[idx].absoluteFilePath();
+        const int r = idx / numPatches.width();
+        const int c = idx % numPatches.width();
 
-            double maxVal = 0;
-            cv::Point maxIdx;
-            cv::minMaxLoc(ccTmp, nullptr, &maxVal, nullptr, &maxIdx);
-            auto *ccPtr = cc.ptr<float>(maxIdx.y);
-
-            if (maxVal > ccPtr[maxIdx.x]) {
-                cv::Mat pPatch = pImg.rowRange(maxIdx.y * patchResO, maxIdx.y * patchResO + patchResO)
-                                     .colRange(maxIdx.x * patchResO, maxIdx.x * patchResO + patchResO);
-                thumbPatch.copyTo(pPatch);
-
-                // visualize
-                if (pIdx % 10 == 0) {
-                    channels[0] = pImg;
-
-                    // debug
-                    cv::Mat imgT3;
-                    cv::merge(channels, imgT3);
-                    cv::cvtColor(imgT3, imgT3, cv::COLOR_Lab2BGR);
-                    emit updateImage(DkImage::mat2QImage(imgT3, mSrcImg));
-                }
+        try {
+            std::optional<LoadThumbnailResult> thumb = loadThumbnail(LoadThumbnailRequest{filePath});
+            QImage thumbImg = thumb ? thumb->thumb : QImage();
 
-                if (ccPtr[maxIdx.x] == 0) {
-                    pIdx++;
-                    emit updateProgress(qRound((float)pIdx / maxP * 100));
-                }
+            cv::Mat pPatch = pImg(cv::Rect(c * patchResO, r * patchResO, patchResO, patchResO));
+            createPatch(thumbImg, filePath, patchResO).copyTo(pPatch);
 
-                // compute it now if we already have the full image loaded
-                if (thumb && thumb->thumb.width() > patchResD && thumb->thumb.height() > patchResD) {
-                    thumbPatch = createPatch(thumb->thumb, imgPath, patchResD);
-
-                    cv::Mat dPatch = dImg.rowRange(maxIdx.y * patchResD, maxIdx.y * patchResD + patchResD)
-                                         .colRange(maxIdx.x * patchResD, maxIdx.x * patchResD + patchResD);
-                    thumbPatch.copyTo(dPatch);
-                    ccD.ptr<unsigned char>(maxIdx.y)[maxIdx.x] = 1;
-                } else
-                    ccD.ptr<unsigned char>(maxIdx.y)[maxIdx.x] = 0;
-
-                // update cc
-                ccPtr[maxIdx.x] = (float)maxVal;
-
-                mFilesUsed[maxIdx.y * numPatchesH + maxIdx.x] = QFileInfo(
-                    imgPath); // replaces additionally the old file
-                iDidNothing = 0;
-            } else
-                iDidNothing++;
+            // createPatch() loads the full image if the thumbnail is too small
+            cv::Mat dPatch = dImg(cv::Rect(c * patchResD, r * patchResD, patchResD, patchResD));
+            createPatch(thumbImg, filePath, patchResD).copyTo(dPatch);
         }
         // catch cv exceptions e.g. out of memory
         catch (...) {
-            iDidNothing++;
+            emit infoMessage(tr("Something is seriously wrong, I could not load: %1").arg(filePath));
         }
 
-        // are we done yet?
-        double minVal = 0;
-        cv::minMaxLoc(cc, &minVal);
-
-        if (minVal > 0)
-            break;
-    }
-
-    pIdx = 0;
-
-    // compute real resolution
-    for (int rIdx = 0; rIdx < ccD.rows; rIdx++) {
-        const unsigned char *ccDPtr = ccD.ptr<unsigned char>(rIdx);
-
-        for (int cIdx = 0; cIdx < ccD.cols; cIdx++) {
-            // is the patch already computed?
-            if (ccDPtr[cIdx])
-                continue;
-
-            QFileInfo cFile = mFilesUsed.at(rIdx * ccD.cols + cIdx);
-
-            if (!cFile.exists()) {
-                emit infoMessage(
-                    tr("Something is seriously wrong, I could not load: %1").arg(cFile.absoluteFilePath()));
-                continue;
-            }
+        int done = ++numRendered;
+        if (done % 10 == 0)
+            emit updateProgress(50 + qRound((float)done / maxP * 50));
+    });
 
-            cv::Mat thumbPatch = createPatch({}, cFile.absoluteFilePath(), patchResD);
+    if (!mProcessing)
+        return QDialog::Rejected;
 
-            cv::Mat dPatch = dImg.rowRange(rIdx * patchResD, rIdx * patchResD + patchResD)
-                                 .colRange(cIdx * patchResD, cIdx * patchResD + patchResD);
-            thumbPatch.copyTo(dPatch);
-            emit updateProgress(qRound((float)pIdx / maxP * 100));
-            pIdx++;
-        }
-    }
-
-    qDebug() << "I fully rendered: " << ccD.rows * ccD.cols - cv::sum(ccD)[0] << " images";
+    channels[0] = pImg;
+    cv::Mat preview;
+    cv::merge(channels, preview);
+    cv::cvtColor(preview, preview, cv::COLOR_Lab2BGR);
+    emit updateImage(DkImage::mat2QImage(preview, mSrcImg));
 
     // create final images
     mOrigImg = mImgLab;
@@ -3392,26 +3391,6 @@ int DkMosaicDialog::computeMosaic(const QString &filter, const QString &suffix,
     return QDialog::Accepted;
 }
 
-void DkMosaicDialog::matchPatch(const cv::Mat &img, const cv::Mat &thumb, int patchRes, cv::Mat &cc)
-{
-    for (int rIdx = 0; rIdx < cc.rows; rIdx++) {
-        auto *ccPtr = cc.ptr<float>(rIdx);
-        const cv::Mat imgStrip = img.rowRange(rIdx * patchRes, rIdx * patchRes + patchRes);
-
-        for (int cIdx = 0; cIdx < cc.cols; cIdx++) {
-            // already computed?
-            if (ccPtr[cIdx] != 0)
-                continue;
-
-            const cv::Mat cPatch = imgStrip.colRange(cIdx * patchRes, cIdx * patchRes + patchRes);
-
-            cv::Mat absDiff;
-            cv::absdiff(cPatch, thumb, absDiff);
-            ccPtr[cIdx] = 1.0f - ((float)cv::sum(absDiff)[0] / (patchRes * patchRes * 255));
-        }
-    }
-}
-
 cv::Mat DkMosaicDialog::createPatch(const QImage &thumb, const QString &filePath, int patchRes)
 {
     QImage img;
@@ -3450,55 +3429,6 @@ cv::Mat DkMosaicDialog::createPatch(const QImage &thumb, const QString &filePath
     return cvThumb;
 }
 
-QString DkMosaicDialog::getRandomImagePath(const QString &cPath, const QString &ignore, const QString &suffix)
-{
-    // TODO: remove hierarchy
-    QStringList fileFilters = (suffix.isEmpty()) ? DkSettingsManager::param().app().fileFilters : QStringList(suffix);
-
-    // get all dirs
-    QFileInfoList entries = QDir(cPath).entryInfoList(QStringList(), QDir::AllDirs | QDir::NoDotAndDotDot);
-    // qDebug() << entries;
-    //  get all files
-    entries += QDir(cPath).entryInfoList(fileFilters);
-    // qDebug() << "current entries: " << e;
-
-    if (!ignore.isEmpty()) {
-        QStringList ignoreList = ignore.split(";");
-        QFileInfoList entriesTmp = entries;
-        entries.clear();
-
-        for (int idx = 0; idx < entriesTmp.size(); idx++) {
-            bool lIgnore = false;
-            QString p = entriesTmp.at(idx).absoluteFilePath();
-
-            for (int iIdx = 0; iIdx < ignoreList.size(); iIdx++) {
-                if (p.contains(ignoreList.at(iIdx))) {
-                    lIgnore = true;
-                    break;
-                }
-            }
-
-            if (!lIgnore)
-                entries.append(entriesTmp.at(idx));
-        }
-    }
-
-    if (entries.isEmpty())
-        return QString();
-
-    int rIdx = qRound(QRandomGenerator::global()->generateDouble() * (entries.size() - 1));
-
-    // qDebug() << "rand index: " << rIdx;
-
-    QFileInfo rPath = entries.at(rIdx);
-    // qDebug() << rPath.absoluteFilePath();
-
-    if (rPath.isDir())
-        return getRandomImagePath(rPath.absoluteFilePath(), ignore, suffix);
-    else
-        return rPath.absoluteFilePath();
-}
-
 void DkMosaicDialog::updatePostProcess()
 {
     if (mMosaicMat.empty() || mProcessing)
@@ -38,6 +38,8 @@
 
 #include "DkBasicLoader.h"
 
+#include <atomic>
+
 class QDir;
 class QStandardItemModel;
 class QStandardItem;
@@ -684,7 +686,7 @@ protected:
     DkBasicLoader mLoader;
     QFutureWatcher<int> mWatcher;
 
-    bool mProcessing = false;
+    std::atomic<bool> mProcessing = false;
 
     enum {
         finished,
@@ -738,8 +740,6 @@ protected:
     void createLayout();
     void enableMosaicSave(bool enable);
     void enableAll(bool enable);
-    QString getRandomImagePath(const QString &cPath, const QString &ignore, const QString &suffix);
-    void matchPatch(const cv::Mat &img, const cv::Mat &thumb, int patchRes, cv::Mat &cc);
     cv::Mat createPatch(const QImage &thumb, const QString &filePath, int patchRes);
 
     void dropEvent(QDropEvent *event) override;
@@ -776,7 +776,7 @@ protected:
 
     bool mUpdatePostProcessing = false;
     bool mPostProcessing = false;
-    bool mProcessing = false;
+    std::atomic<bool> mProcessing = false; // read by the render workers
     QImage mSrcImg;
     cv::Mat mOrigImg;
     cv::Mat mMosaicMat;
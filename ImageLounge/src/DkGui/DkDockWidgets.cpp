@@ -30,9 +30,12 @@
 
 #include "DkBasicLoader.h"
 #include "DkSettings.h"
+#include "DkThumbs.h"
+#include "DkTiffPageIndex.h"
 
 #include <QListWidget>
 #include <QVBoxLayout>
+#include <QtConcurrentMap>
 
 namespace nmc
 {
@@ -101,4 +104,92 @@ void DkHistoryDock::onHistoryListItemClicked(QListWidgetItem *item)
     }
 }
 
+// DkPageDock --------------------------------------------------------------------
+DkPageDock::DkPageDock(const QString &title, QWidget *parent)
+    : DkDockWidget(title, parent)
+{
+    setObjectName("DkPageDock");
+    createLayout();
+
+    connect(&mThumbWatcher, &QFutureWatcherBase::resultReadyAt, this, &DkPageDock::onThumbnailReady);
+}
+
+void DkPageDock::createLayout()
+{
+    const int thumbSize = DkSettingsManager::param().effectiveThumbSize(this);
+
+    mPageList = new QListWidget(this);
+    mPageList->setObjectName("pageList");
+    mPageList->setFocusPolicy(Qt::ClickFocus);
+    mPageList->setViewMode(QListView::IconMode);
+    mPageList->setResizeMode(QListView::Adjust);
+    mPageList->setMovement(QListView::Static);
+    mPageList->setUniformItemSizes(true);
+    mPageList->setIconSize(QSize(thumbSize, thumbSize));
+    connect(mPageList, &QListWidget::itemClicked, this, &DkPageDock::onPageListItemClicked);
+
+    auto *contentWidget = new QWidget(this);
+    auto *layout = new QVBoxLayout(contentWidget);
+    layout->addWidget(mPageList);
+
+    setWidget(contentWidget);
+}
+
+void DkPageDock::updateImage(QSharedPointer<DkImageContainerT> img)
+{
+    QSharedPointer<DkBasicLoader> loader = img ? img->getLoader() : QSharedPointer<DkBasicLoader>();
+    int numPages = loader ? loader->getNumPages() : 0;
+
+    // the index is cached by the loader already
+    auto index = numPages > 1 ? DkTiffPageIndex::index(img->filePath()) : QSharedPointer<const DkTiffPageIndex>();
+
+    if (index != mIndex) {
+        mThumbWatcher.cancel();
+        mPageList->clear();
+        mIndex = index;
+
+        if (!mIndex)
+            return;
+
+        QList<int> pages;
+        for (int idx = 1; idx <= mIndex->numPages(); idx++) {
+            mPageList->addItem(new QListWidgetItem(tr("Page %1").arg(idx)));
+            pages << idx;
+        }
+
+        const int thumbSize = mPageList->iconSize().width();
+        mThumbWatcher.setFuture(QtConcurrent::mapped(DkThumbsThreadPool::pool(), pages, [index, thumbSize](int idx) {
+            return index->readThumbnail(idx, thumbSize);
+        }));
+    }
+
+    if (!mIndex)
+        return;
+
+    QListWidgetItem *item = mPageList->item(loader->getPageIdx() - 1);
+    if (item) {
+        mPageList->setCurrentItem(item);
+        mPageList->scrollToItem(item);
+    }
+}
+
+void DkPageDock::onThumbnailReady(int idx)
+{
+    if (!mIndex || !mThumbWatcher.future().isResultReadyAt(idx))
+        return;
+
+    QListWidgetItem *item = mPageList->item(idx);
+    QImage thumb = mThumbWatcher.resultAt(idx);
+
+    if (item && !thumb.isNull())
+        item->setIcon(QIcon(QPixmap::fromImage(thumb)));
+}
+
+void DkPageDock::onPageListItemClicked(QListWidgetItem *item)
+{
+    int idx = mPageList->row(item);
+    if (idx >= 0)
+        emit loadPageSignal(idx + 1);
+}
+
 }
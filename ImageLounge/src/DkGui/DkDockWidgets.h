@@ -31,11 +31,14 @@
 #include "DkBaseWidgets.h"
 #include "DkImageContainer.h"
 
+#include <QFutureWatcher>
+
 class QListWidget;
 class QListWidgetItem;
 
 namespace nmc
 {
+class DkTiffPageIndex;
 
 class DllCoreExport DkHistoryDock : public DkDockWidget
 {
@@ -56,4 +59,31 @@ protected:
     QListWidget *mHistoryList;
 };
 
+/**
+ * Shows the pages of multi-page files (TIFF) for fast navigation.
+ * Page thumbnails are rendered in the background.
+ **/
+class DllCoreExport DkPageDock : public DkDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DkPageDock(const QString &title = "", QWidget *parent = nullptr);
+
+public slots:
+    void updateImage(QSharedPointer<DkImageContainerT> img);
+    void onPageListItemClicked(QListWidgetItem *item);
+
+signals:
+    void loadPageSignal(int pageIdx) const;
+
+protected:
+    void createLayout();
+    void onThumbnailReady(int idx);
+
+    QSharedPointer<const DkTiffPageIndex> mIndex;
+    QListWidget *mPageList;
+    QFutureWatcher<QImage> mThumbWatcher;
+};
+
 }
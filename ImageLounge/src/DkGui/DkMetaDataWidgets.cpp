@@ -47,6 +47,8 @@
 #include <QPushButton>
 #include <QRegularExpression>
 #include <QScrollArea>
+#include <QSet>
+#include <QShowEvent>
 #include <QTextEdit>
 #include <QTreeView>
 #include <QVBoxLayout>
@@ -75,6 +77,20 @@ void DkMetaDataModel::clear()
 {
     beginResetModel();
     rootItem->clear();
+    mGroups.clear();
+    endResetModel();
+}
+
+/// <summary>
+/// Replaces the current entries with the meta data.
+/// </summary>
+/// <param name="metaData">The meta data.</param>
+void DkMetaDataModel::setMetaData(QSharedPointer<DkMetaDataT> metaData)
+{
+    beginResetModel();
+    rootItem->clear();
+    mGroups.clear();
+    addMetaData(metaData);
     endResetModel();
 }
 
@@ -97,38 +113,10 @@ void DkMetaDataModel::addMetaData(QSharedPointer<DkMetaDataT> metaData)
         createItem(fileKeys.at(idx), lastKey, fileValues.at(idx));
     }
 
-    QStringList exifKeys = metaData->getExifKeys();
-
-    for (int idx = 0; idx < exifKeys.size(); idx++) {
-        QString lastKey = exifKeys.at(idx).split(".").last();
-        QString translatedKey = DkMetaDataHelper::getInstance().translateKey(lastKey);
-        QString exifValue = metaData->getNativeExifValue(exifKeys.at(idx), true);
-        exifValue = DkMetaDataHelper::getInstance().formatSpecialValue(lastKey, exifValue);
-
-        createItem(exifKeys.at(idx), translatedKey, exifValue);
-    }
-
-    QStringList iptcKeys = metaData->getIptcKeys();
-
-    for (int idx = 0; idx < iptcKeys.size(); idx++) {
-        QString lastKey = iptcKeys.at(idx).split(".").last();
-        QString translatedKey = DkMetaDataHelper::getInstance().translateKey(lastKey);
-        QString exifValue = metaData->getIptcValue(iptcKeys.at(idx));
-        exifValue = DkMetaDataHelper::getInstance().formatSpecialValue(lastKey, exifValue);
-
-        createItem(iptcKeys.at(idx), translatedKey, exifValue);
-    }
-
-    QStringList xmpKeys = metaData->getXmpKeys();
-
-    for (int idx = 0; idx < xmpKeys.size(); idx++) {
-        QString lastKey = xmpKeys.at(idx).split(".").last();
-        QString translatedKey = DkMetaDataHelper::getInstance().translateKey(lastKey);
-        QString exifValue = metaData->getXmpValue(xmpKeys.at(idx));
-        exifValue = DkMetaDataHelper::getInstance().formatSpecialValue(lastKey, exifValue);
-
-        createItem(xmpKeys.at(idx), translatedKey, exifValue);
-    }
+    // the snapshot is built once per image, values are already translated & formatted
+    const QVector<DkMetaDataT::Tag> tags = metaData->tags();
+    for (const DkMetaDataT::Tag &tag : tags)
+        createItem(tag.key, tag.name, tag.value);
 
     QStringList qtKeys = metaData->getQtKeys();
 
@@ -144,29 +132,13 @@ void DkMetaDataModel::addMetaData(QSharedPointer<DkMetaDataT> metaData)
 
 void DkMetaDataModel::createItem(const QString &key, const QString &keyName, const QString &value)
 {
-    // Split key first
-    QStringList keyHierarchy = key.split('.');
-
-    if (keyHierarchy.empty()) {
+    if (key.isEmpty()) {
         qDebug() << "no key hierarchy... skipping: " << key;
         return;
     }
 
-    TreeItem *item = rootItem;
-
-    for (int idx = 0; idx < keyHierarchy.size() - 1; idx++) {
-        QString cKey = keyHierarchy.at(idx);
-        TreeItem *cHierarchyItem = item->find(cKey, 0);
-
-        if (!cHierarchyItem) {
-            QVector<QVariant> keyData;
-            keyData << cKey;
-            cHierarchyItem = new TreeItem(keyData, item);
-            item->appendChild(cHierarchyItem);
-        }
-
-        item = cHierarchyItem; // switch to next hierarchy level
-    }
+    // the last part of the key is the entry, everything before is its group
+    TreeItem *item = groupItem(key.left(qMax(key.lastIndexOf('.'), 0)));
 
     QString cleanValue = DkUtils::cleanFraction(value);
 
@@ -184,6 +156,33 @@ void DkMetaDataModel::createItem(const QString &key, const QString &keyName, con
     item->appendChild(dataItem);
 }
 
+/// <summary>
+/// Returns the hierarchy item of a group (e.g. Exif.Image) and creates it if needed.
+/// </summary>
+/// <param name="group">The group key.</param>
+TreeItem *DkMetaDataModel::groupItem(const QString &group)
+{
+    if (group.isEmpty())
+        return rootItem;
+
+    // groups are hashed, searching the tree would make building the model quadratic
+    auto it = mGroups.constFind(group);
+    if (it != mGroups.constEnd())
+        return it.value();
+
+    int parentEnd = group.lastIndexOf('.');
+    TreeItem *parentItem = groupItem(group.left(qMax(parentEnd, 0)));
+
+    QVector<QVariant> keyData;
+    keyData << group.mid(parentEnd + 1);
+
+    auto *item = new TreeItem(keyData, parentItem);
+    parentItem->appendChild(item);
+    mGroups.insert(group, item);
+
+    return item;
+}
+
 QModelIndex DkMetaDataModel::index(int row, int column, const QModelIndex &parent) const
 {
     if (!hasIndex(row, column, parent))
@@ -235,13 +234,10 @@ int DkMetaDataModel::rowCount(const QModelIndex &parent) const
     return parentItem->childCount();
 }
 
-int DkMetaDataModel::columnCount(const QModelIndex &parent) const
+int DkMetaDataModel::columnCount(const QModelIndex &) const
 {
-    if (parent.isValid())
-        return static_cast<TreeItem *>(parent.internalPointer())->columnCount();
-    else
-        return rootItem->columnCount();
-    // return 2;
+    // key & value - TreeItem::columnCount() visits all children
+    return 2;
 }
 
 QVariant DkMetaDataModel::data(const QModelIndex &index, int role) const
@@ -432,19 +428,21 @@ void DkMetaDataDock::onFilterTextChanged(const QString &filterText)
 
 void DkMetaDataDock::updateEntries(QSharedPointer<DkMetaDataT> metadata)
 {
+    mEntriesDirty = false;
+
     int nr = mProxyModel->rowCount(QModelIndex());
     for (int idx = 0; idx < nr; idx++)
         getExpandedItemNames(mProxyModel->index(idx, 0, QModelIndex()), mExpandedNames);
 
-    mModel->deleteLater();
-    mModel = new DkMetaDataModel(this);
-    mModel->addMetaData(metadata);
-    mProxyModel->setSourceModel(mModel);
-
     mTreeView->setUpdatesEnabled(false);
+
+    // the model is reset rather than recreated, so the proxy & view keep their state
+    mModel->setMetaData(metadata);
+
+    const QSet<QString> expandedNames(mExpandedNames.begin(), mExpandedNames.end());
     nr = mProxyModel->rowCount();
     for (int idx = 0; idx < nr; idx++)
-        expandRows(mProxyModel->index(idx, 0, QModelIndex()), mExpandedNames);
+        expandRows(mProxyModel->index(idx, 0, QModelIndex()), expandedNames);
 
     mTreeView->setUpdatesEnabled(true);
 
@@ -454,17 +452,31 @@ void DkMetaDataDock::updateEntries(QSharedPointer<DkMetaDataT> metadata)
     //	treeView->setColumnWidth(1, 1000);
 }
 
+void DkMetaDataDock::showEvent(QShowEvent *event)
+{
+    // entries are only built while the dock is visible
+    if (mEntriesDirty)
+        updateEntries(mMetaData);
+
+    DkDockWidget::showEvent(event);
+}
+
 void DkMetaDataDock::setImage(QSharedPointer<DkImageContainerT> imgC)
 {
     if (!imgC) {
-        mProxyModel->setSourceModel(new DkMetaDataModel(this));
+        mMetaData.clear();
+        mEntriesDirty = false;
+        mModel->clear();
         return;
     }
 
     const auto metadata = imgC->getMetaData();
+    mMetaData = metadata;
 
     if (isVisible())
         updateEntries(metadata);
+    else
+        mEntriesDirty = true;
 
     // Only load the EXIF thumbnail, so do not use DkThumbLoader.
     // We already have the metadata, no need to read file again,
@@ -500,7 +512,8 @@ void DkMetaDataDock::setImage(QSharedPointer<DkImageContainerT> imgC)
 
 void DkMetaDataDock::getExpandedItemNames(const QModelIndex &index, QStringList &expandedNames)
 {
-    if (!mTreeView || !index.isValid())
+    // leaves cannot be expanded - skipping them keeps this linear in the number of groups
+    if (!mTreeView || !index.isValid() || !mProxyModel->hasChildren(index))
         return;
 
     QString entryName = mProxyModel->data(index, Qt::DisplayRole).toString();
@@ -516,9 +529,9 @@ void DkMetaDataDock::getExpandedItemNames(const QModelIndex &index, QStringList
         getExpandedItemNames(mProxyModel->index(idx, 0, index), expandedNames);
 }
 
-void DkMetaDataDock::expandRows(const QModelIndex &index, const QStringList &expandedNames)
+void DkMetaDataDock::expandRows(const QModelIndex &index, const QSet<QString> &expandedNames)
 {
-    if (!index.isValid())
+    if (!index.isValid() || !mProxyModel->hasChildren(index))
         return;
 
     if (expandedNames.contains(mProxyModel->data(index).toString())) {
@@ -528,7 +541,7 @@ void DkMetaDataDock::expandRows(const QModelIndex &index, const QStringList &exp
     for (int idx = 0; idx < mProxyModel->rowCount(index); idx++) {
         QModelIndex cIndex = mProxyModel->index(idx, 0, index);
 
-        if (expandedNames.contains(mProxyModel->data(cIndex).toString())) {
+        if (mProxyModel->hasChildren(cIndex) && expandedNames.contains(mProxyModel->data(cIndex).toString())) {
             mTreeView->setExpanded(cIndex, true);
             expandRows(cIndex, expandedNames);
         }
@@ -882,48 +895,11 @@ void DkMetaDataHUD::updateMetaData(const QSharedPointer<DkMetaDataT> metaData)
         }
     }
 
-    QStringList exifKeys = metaData->getExifKeys();
-
-    for (int idx = 0; idx < exifKeys.size(); idx++) {
-        QString cKey = exifKeys.at(idx);
-
-        if (mKeyValues.contains(cKey)) {
-            QString lastKey = cKey.split(".").last();
-            QString exifValue = metaData->getNativeExifValue(exifKeys.at(idx), true);
-            exifValue = DkMetaDataHelper::getInstance().formatSpecialValue(lastKey, exifValue);
-
-            mEntryKeyLabels.append(createKeyLabel(cKey));
-            mEntryValueLabels.append(createValueLabel(exifValue));
-        }
-    }
-
-    QStringList iptcKeys = metaData->getIptcKeys();
-
-    for (int idx = 0; idx < iptcKeys.size(); idx++) {
-        QString cKey = iptcKeys.at(idx);
-
-        if (mKeyValues.contains(cKey)) {
-            QString lastKey = iptcKeys.at(idx).split(".").last();
-            QString exifValue = metaData->getIptcValue(iptcKeys.at(idx));
-            exifValue = DkMetaDataHelper::getInstance().formatSpecialValue(lastKey, exifValue);
-
-            mEntryKeyLabels.append(createKeyLabel(cKey));
-            mEntryValueLabels.append(createValueLabel(exifValue));
-        }
-    }
-
-    QStringList xmpKeys = metaData->getXmpKeys();
-
-    for (int idx = 0; idx < xmpKeys.size(); idx++) {
-        QString cKey = xmpKeys.at(idx);
-
-        if (mKeyValues.contains(cKey)) {
-            QString lastKey = xmpKeys.at(idx).split(".").last();
-            QString exifValue = metaData->getXmpValue(xmpKeys.at(idx));
-            exifValue = DkMetaDataHelper::getInstance().formatSpecialValue(lastKey, exifValue);
-
-            mEntryKeyLabels.append(createKeyLabel(cKey));
-            mEntryValueLabels.append(createValueLabel(exifValue));
+    const QVector<DkMetaDataT::Tag> tags = metaData->tags();
+    for (const DkMetaDataT::Tag &tag : tags) {
+        if (mKeyValues.contains(tag.key)) {
+            mEntryKeyLabels.append(createKeyLabel(tag.key));
+            mEntryValueLabels.append(createValueLabel(tag.value));
         }
     }
 
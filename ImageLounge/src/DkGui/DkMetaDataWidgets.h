@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <QHash>
+#include <QSet>
 #include <QSortFilterProxyModel>
 #include <QTextEdit>
 
@@ -66,12 +68,15 @@ public:
     // virtual bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole);
 
     virtual void addMetaData(QSharedPointer<DkMetaDataT> metaData);
+    void setMetaData(QSharedPointer<DkMetaDataT> metaData);
     void clear();
 
 protected:
     TreeItem *rootItem;
+    QHash<QString, TreeItem *> mGroups;
 
     void createItem(const QString &key, const QString &keyName, const QString &value);
+    TreeItem *groupItem(const QString &group);
 };
 
 class DkMetaDataProxyModel : public QSortFilterProxyModel
@@ -103,9 +108,10 @@ protected:
     void updateEntries(QSharedPointer<DkMetaDataT> metadata);
     void writeSettings();
     void readSettings();
+    void showEvent(QShowEvent *event) override;
 
     void getExpandedItemNames(const QModelIndex &index, QStringList &expandedNames);
-    void expandRows(const QModelIndex &index, const QStringList &expandedNames);
+    void expandRows(const QModelIndex &index, const QSet<QString> &expandedNames);
 
     QTreeView *mTreeView = nullptr;
     DkMetaDataProxyModel *mProxyModel = nullptr;
@@ -113,6 +119,9 @@ protected:
     DkMetaDataModel *mModel = nullptr;
     QLabel *mThumbNailLabel = nullptr;
     QStringList mExpandedNames;
+
+    QSharedPointer<DkMetaDataT> mMetaData;
+    bool mEntriesDirty = false;
 };
 
 class DkMetaDataSelection : public DkWidget
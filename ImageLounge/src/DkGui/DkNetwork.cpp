@@ -28,12 +28,18 @@
 #include "DkNetwork.h"
 
 #include "DkActionManager.h"
+#include "DkSettings.h"
+#include "DkSharedImage.h"
 #include "DkTimer.h"
 
 #include <QApplication>
+#include <QDir>
+#include <QFileInfo>
 #include <QList>
+#include <QLockFile>
 #include <QMimeData>
 #include <QScreen>
+#include <QStandardPaths>
 #include <QTimer>
 
 namespace nmc
@@ -152,10 +158,7 @@ void DkClientManager::sendTitle(const QString &newTitle)
         if (!peer)
             continue;
 
-        // TODO: why not call the method directly?
-        connect(this, &DkClientManager::sendNewTitleMessage, peer->mConnection, &DkConnection::sendNewTitleMessage);
-        emit sendNewTitleMessage(newTitle);
-        disconnect(this, &DkClientManager::sendNewTitleMessage, peer->mConnection, &DkConnection::sendNewTitleMessage);
+        peer->mConnection->sendNewTitleMessage(newTitle);
     }
 }
 
@@ -166,15 +169,7 @@ void DkClientManager::sendTransform(QTransform transform, QTransform imgTransfor
         if (!peer)
             continue;
 
-        connect(this,
-                &DkClientManager::sendNewTransformMessage,
-                peer->mConnection,
-                &DkConnection::sendNewTransformMessage);
-        emit sendNewTransformMessage(transform, imgTransform, canvasSize);
-        disconnect(this,
-                   &DkClientManager::sendNewTransformMessage,
-                   peer->mConnection,
-                   &DkConnection::sendNewTransformMessage);
+        peer->mConnection->sendNewTransformMessage(transform, imgTransform, canvasSize);
     }
 }
 
@@ -185,15 +180,7 @@ void DkClientManager::sendPosition(QRect newRect, bool overlaid)
         if (!peer)
             continue;
 
-        connect(this,
-                &DkClientManager::sendNewPositionMessage,
-                peer->mConnection,
-                &DkConnection::sendNewPositionMessage);
-        emit sendNewPositionMessage(newRect, true, overlaid);
-        disconnect(this,
-                   &DkClientManager::sendNewPositionMessage,
-                   peer->mConnection,
-                   &DkConnection::sendNewPositionMessage);
+        peer->mConnection->sendNewPositionMessage(newRect, true, overlaid);
     }
 }
 
@@ -204,9 +191,7 @@ void DkClientManager::sendNewFile(qint16 op, const QString &filename)
         if (!peer)
             continue;
 
-        connect(this, &DkClientManager::sendNewFileMessage, peer->mConnection, &DkConnection::sendNewFileMessage);
-        emit sendNewFileMessage(op, filename);
-        disconnect(this, &DkClientManager::sendNewFileMessage, peer->mConnection, &DkConnection::sendNewFileMessage);
+        peer->mConnection->sendNewFileMessage(op, filename);
     }
 }
 
@@ -282,9 +267,15 @@ void DkClientManager::sendGoodByeToAll()
 
 // DkLocalClientManager --------------------------------------------------------------------
 
-DkLocalClientManager::DkLocalClientManager(const QString &title, QObject *parent)
+DkLocalClientManager::DkLocalClientManager(const QString &title, QObject *parent, const QString &registryPath)
     : DkClientManager(title, parent)
+    , mRegistry(registryPath)
 {
+    // synchronized instances likely open the same files
+    connect(this, &DkLocalClientManager::synchronizedPeersListChanged, this, [](const QList<quint16> &ports) {
+        DkSharedImage::instance().setEnabled(!ports.isEmpty() && DkSettingsManager::param().sync().shareImages);
+    });
+
     startServer();
 }
 
@@ -350,15 +341,31 @@ void DkLocalClientManager::searchForOtherClients()
 {
     Q_ASSERT(mServer);
 
+    quint16 serverPort = mServer->serverPort();
+
+    if (serverPort && mRegistry.registerPort(serverPort)) {
+        for (quint16 port : mRegistry.livePorts()) {
+            if (port != serverPort)
+                connectToPort(port);
+        }
+        return;
+    }
+
+    // no registry, try all ports an instance might listen on
     for (int i = local_tcp_port_start; i <= local_tcp_port_end; i++) {
-        if (i == mServer->serverPort())
+        if (i == serverPort)
             continue;
 
-        DkConnection *connection = createConnection();
-        connection->connectToHost(QHostAddress::LocalHost, (qint16)i);
+        connectToPort((quint16)i);
     }
 }
 
+void DkLocalClientManager::connectToPort(quint16 port)
+{
+    DkConnection *connection = createConnection();
+    connection->connectToHost(QHostAddress::LocalHost, port);
+}
+
 void DkLocalClientManager::connectionSynchronized(QList<quint16> synchronizedPeersOfOtherClient,
                                                   DkConnection *connection)
 {
@@ -491,15 +498,7 @@ void DkLocalClientManager::sendArrangeInstances(bool overlaid)
             continue;
 
         QRect newPosition = QRect(curX, curY, width, height);
-        connect(this,
-                &DkLocalClientManager::sendNewPositionMessage,
-                peer->mConnection,
-                &DkConnection::sendNewPositionMessage);
-        emit sendNewPositionMessage(newPosition, false, overlaid);
-        disconnect(this,
-                   &DkLocalClientManager::sendNewPositionMessage,
-                   peer->mConnection,
-                   &DkConnection::sendNewPositionMessage);
+        peer->mConnection->sendNewPositionMessage(newPosition, false, overlaid);
 
         count++;
         if (count < instancesPerRow)
@@ -553,6 +552,72 @@ DkLocalConnection *DkLocalClientManager::createConnection()
     return connection;
 }
 
+// DkPeerRegistry --------------------------------------------------------------------
+DkPeerRegistry::DkPeerRegistry(const QString &dirPath)
+    : mDirPath(dirPath)
+{
+}
+
+DkPeerRegistry::~DkPeerRegistry() = default;
+
+QString DkPeerRegistry::defaultPath()
+{
+    // the runtime location is private to the user (session)
+    QString path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (path.isEmpty())
+        path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+
+    return QDir(path).filePath("nomacs-peers");
+}
+
+bool DkPeerRegistry::registerPort(quint16 port)
+{
+    if (mDirPath.isEmpty() || !QDir().mkpath(mDirPath)) {
+        qWarning() << "[DkPeerRegistry] cannot create" << mDirPath;
+        return false;
+    }
+
+    auto lock = std::make_unique<QLockFile>(QDir(mDirPath).filePath(QString("%1.lock").arg(port)));
+    lock->setStaleLockTime(0); // stale only if the owning process is gone
+
+    if (!lock->tryLock(0)) {
+        qWarning() << "[DkPeerRegistry] cannot lock port" << port << "error:" << lock->error();
+        return false;
+    }
+
+    mLock = std::move(lock);
+    return true;
+}
+
+QList<quint16> DkPeerRegistry::livePorts() const
+{
+    QList<quint16> ports;
+
+    QDir dir(mDirPath);
+    const QStringList files = dir.entryList({"*.lock"}, QDir::Files);
+
+    for (const QString &fileName : files) {
+        bool ok = false;
+        quint16 port = QFileInfo(fileName).baseName().toUShort(&ok);
+        if (!ok)
+            continue;
+
+        QLockFile lock(dir.filePath(fileName));
+        lock.setStaleLockTime(0);
+
+        // we only get the lock if the instance is gone - unlocking removes its entry
+        if (lock.tryLock(0)) {
+            lock.unlock();
+            continue;
+        }
+
+        if (lock.error() == QLockFile::LockFailedError)
+            ports << port;
+    }
+
+    return ports;
+}
+
 // DkLocalTcpServer --------------------------------------------------------------------
 DkLocalTcpServer::DkLocalTcpServer(QObject *parent)
     : QTcpServer(parent)
@@ -35,6 +35,9 @@
 
 #include "DkConnection.h"
 
+#include <memory>
+
+class QLockFile;
 class QMimeData;
 
 namespace nmc
@@ -120,7 +123,28 @@ private:
     QMultiHash<quint16, DkPeer *> peerList;
 };
 
-class DkClientManager : public QObject
+/**
+ * Lists the local instances of the current user.
+ * Every instance holds a lock file named after its server port,
+ * lock files of instances that crashed are removed when the registry is read.
+ **/
+class DllCoreExport DkPeerRegistry
+{
+public:
+    explicit DkPeerRegistry(const QString &dirPath = defaultPath());
+    ~DkPeerRegistry();
+
+    static QString defaultPath();
+
+    bool registerPort(quint16 port);
+    QList<quint16> livePorts() const;
+
+private:
+    QString mDirPath;
+    std::unique_ptr<QLockFile> mLock;
+};
+
+class DllCoreExport DkClientManager : public QObject
 {
     Q_OBJECT
 public:
@@ -138,10 +162,6 @@ signals:
     void sendGreetingMessage(const QString &title);
     void sendSynchronizeMessage();
     void sendDisableSynchronizeMessage();
-    void sendNewTitleMessage(const QString &newtitle);
-    void sendNewPositionMessage(QRect position, bool opacity, bool overlaid);
-    void sendNewTransformMessage(QTransform transform, QTransform imgTransform, QPointF canvasSize);
-    void sendNewFileMessage(qint16 op, const QString &filename);
     void sendNewImageMessage(QImage image, const QString &title);
     void sendNewUpcomingImageMessage(const QString &imageTitle);
     void sendGoodByeMessage();
@@ -191,12 +211,14 @@ protected:
     QList<DkConnection *> mStartUpConnections;
 };
 
-class DkLocalClientManager : public DkClientManager
+class DllCoreExport DkLocalClientManager : public DkClientManager
 {
     Q_OBJECT
 
 public:
-    explicit DkLocalClientManager(const QString &title, QObject *parent = nullptr);
+    explicit DkLocalClientManager(const QString &title,
+                                  QObject *parent = nullptr,
+                                  const QString &registryPath = DkPeerRegistry::defaultPath());
     QList<DkPeer *> getPeerList() override;
     quint16 getServerPort() const;
 
@@ -224,8 +246,10 @@ private slots:
 private:
     DkLocalConnection *createConnection() final; // called from constructor, prevent override in subclasses
     void searchForOtherClients();
+    void connectToPort(quint16 port);
 
     DkLocalTcpServer *mServer;
+    DkPeerRegistry mRegistry;
 };
 
 class DkLocalTcpServer : public QTcpServer
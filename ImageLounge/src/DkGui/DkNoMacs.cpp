@@ -107,10 +107,15 @@ DkNoMacs::DkNoMacs(QWidget *parent, Qt::WindowFlags flags)
 
     mMenu = new DkMenuBar(this, -1);
 
+    DkTracePhase actionsPhase("create actions");
     DkActionManager &am = DkActionManager::instance();
     am.createActions(this);
+    actionsPhase.end();
+
+    DkTracePhase menusPhase("create menus");
     am.createMenus(mMenu);
     am.enableImageActions(false);
+    menusPhase.end();
 
     mOpenDialog = nullptr;
     mSaveDialog = nullptr;
@@ -170,7 +175,9 @@ void DkNoMacs::init()
     // grabGesture(Qt::SwipeGesture);
 
     // load the window at the same position as last time
+    DkTracePhase settingsPhase("restore window");
     readSettings();
+    settingsPhase.end();
     installEventFilter(this);
 
     if (DkSettings::normalMode(DkSettingsManager::param().app().appMode) != DkSettings::mode_frameless) {
@@ -302,6 +309,9 @@ void DkNoMacs::createActions()
     connect(am.action(DkActionManager::menu_panel_history), &QAction::toggled, this, [this](bool show) {
         showHistoryDock(show);
     });
+    connect(am.action(DkActionManager::menu_panel_pages), &QAction::toggled, this, [this](bool show) {
+        showPageDock(show);
+    });
     connect(am.action(DkActionManager::menu_panel_log), &QAction::toggled, this, [this](bool show) {
         showLogDock(show);
     });
@@ -714,6 +724,7 @@ void DkNoMacs::toggleDocks(bool hide)
         showMetaDataDock(false, false);
         showEditDock(false, false);
         showHistoryDock(false, false);
+        showPageDock(false, false);
         showLogDock(false, false);
         DkToolBarManager::inst().show(false);
         DkStatusBarManager::instance().show(false, false);
@@ -726,10 +737,14 @@ void DkNoMacs::toggleDocks(bool hide)
 
 void DkNoMacs::restoreDocks()
 {
+    // shows up in the startup trace only if docks delay the first image
+    DkTracePhase phase("restore docks");
+
     showExplorer(DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showExplorer), false);
     showMetaDataDock(DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showMetaDataDock), false);
     showEditDock(DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showEditDock), false);
     showHistoryDock(DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showHistoryDock), false);
+    showPageDock(DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showPageDock), false);
     showLogDock(DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showLogDock), false);
 }
 
@@ -1093,6 +1108,37 @@ void DkNoMacs::showHistoryDock(bool show, bool saveSettings)
         mHistoryDock->updateImage(getTabWidget()->getCurrentImage());
 }
 
+void DkNoMacs::showPageDock(bool show, bool saveSettings)
+{
+    if (!show && !mPageDock)
+        return;
+
+    if (!mPageDock) {
+        mPageDock = new DkPageDock(tr("Pages"), this);
+        mPageDock->registerAction(DkActionManager::instance().action(DkActionManager::menu_panel_pages));
+        mPageDock->setDisplaySettings(&DkSettingsManager::param().app().showPageDock);
+        addDockWidget(mPageDock->getDockLocationSettings(Qt::RightDockWidgetArea), mPageDock);
+
+        connect(getTabWidget(), &DkCentralWidget::imageUpdatedSignal, mPageDock, &DkPageDock::updateImage);
+        connect(mPageDock, &DkPageDock::loadPageSignal, this, [this](int pageIdx) {
+            QSharedPointer<DkImageContainerT> imgC = getTabWidget()->getCurrentImage();
+            QSharedPointer<DkImageLoader> loader = getTabWidget()->getCurrentImageLoader();
+            if (!imgC || !loader)
+                return;
+
+            // page navigation is relative (see DkImageLoader::getSkippedImage())
+            int skipIdx = pageIdx - imgC->getLoader()->getPageIdx();
+            if (skipIdx != 0)
+                loader->changeFile(skipIdx);
+        });
+    }
+
+    mPageDock->setVisible(show, saveSettings);
+
+    if (show && getTabWidget()->getCurrentImage())
+        mPageDock->updateImage(getTabWidget()->getCurrentImage());
+}
+
 void DkNoMacs::showLogDock(bool show, bool saveSettings)
 {
     if (!show && !mLogDock)
@@ -1618,16 +1664,11 @@ void DkNoMacs::onWindowLoaded()
     DefaultSettings settings;
     bool firstTime = settings.value("AppSettings/firstTime.nomacs.3", true).toBool();
 
-    if (DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showExplorer))
-        showExplorer(true);
-    if (DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showMetaDataDock))
-        showMetaDataDock(true);
-    if (DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showEditDock))
-        showEditDock(true);
-    if (DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showHistoryDock))
-        showHistoryDock(true);
-    if (DkDockWidget::testDisplaySettings(DkSettingsManager::param().app().showLogDock))
-        showLogDock(true);
+    // docks are not needed for the first image, create them once it is painted
+    DkStartupTrace::instance().runWhenFinished(this, [this]() {
+        if (!DkSettingsManager::param().app().hideAllPanels)
+            restoreDocks();
+    });
 
     if (firstTime) {
         // here are some first time requests
@@ -1647,7 +1688,8 @@ void DkNoMacs::onWindowLoaded()
     getTabWidget()->loadSettings();
 
     bool hidePanels = DkSettingsManager::param().app().hideAllPanels;
-    toggleDocks(hidePanels);
+    if (hidePanels)
+        toggleDocks(true);
 
     // it can be confusing when panels aren't showing on startup
     if (hidePanels) {
@@ -2160,8 +2202,10 @@ DkNoMacsIpl::DkNoMacsIpl(QWidget *parent, Qt::WindowFlags flags)
     DkSettingsManager::param().app().appMode = DkSettings::mode_default;
 
     // init members
+    DkTracePhase centralPhase("create viewport");
     auto *cw = new DkCentralWidget(this);
     setCentralWidget(cw);
+    centralPhase.end();
 
     init();
     setAcceptDrops(true);
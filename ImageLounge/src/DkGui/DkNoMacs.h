@@ -50,6 +50,7 @@ class DkExplorer;
 class DkMetaDataDock;
 class DkEditDock;
 class DkHistoryDock;
+class DkPageDock;
 class DkLogDock;
 class DkExportTiffDialog;
 class DkUpdater;
@@ -110,6 +111,7 @@ public slots:
     void showMetaDataDock(bool show, bool saveSettings = true);
     void showEditDock(bool show, bool saveSettings = true);
     void showHistoryDock(bool show, bool saveSettings = true);
+    void showPageDock(bool show, bool saveSettings = true);
     void showLogDock(bool show, bool saveSettings = true);
     void showThumbsDock(bool show);
     void thumbsDockAreaChanged();
@@ -226,6 +228,7 @@ protected:
     DkMetaDataDock *mMetaDataDock = nullptr;
     DkEditDock *mEditDock = nullptr;
     DkHistoryDock *mHistoryDock = nullptr;
+    DkPageDock *mPageDock = nullptr;
     DkLogDock *mLogDock = nullptr;
     DkDockWidget *mThumbsDock = nullptr;
     DkExportTiffDialog *mExportTiffDialog = nullptr;
@@ -1640,10 +1640,24 @@ void DkAdvancedPreference::createLayout()
     cbSaveExif->setChecked(DkSettingsManager::param().metaData().saveExifOrientation);
     connect(cbSaveExif, &QCheckBox::toggled, this, &DkAdvancedPreference::onSaveExifToggled);
 
+    auto *cbSaveInstantly = new QCheckBox(tr("Save Ratings and Comments Immediately"), this);
+    cbSaveInstantly->setToolTip(tr("If checked, ratings and comments are written in the background\n")
+                                + tr("without asking to save the image."));
+    cbSaveInstantly->setChecked(DkSettingsManager::param().metaData().saveMetaDataInstantly);
+    connect(cbSaveInstantly, &QCheckBox::toggled, this, &DkAdvancedPreference::onSaveInstantlyToggled);
+
+    auto *cbSidecar = new QCheckBox(tr("Save Metadata to XMP Sidecar Files"), this);
+    cbSidecar->setToolTip(tr("If checked, metadata is read from and written to an .xmp file next to the image\n")
+                          + tr("NOTE: this allows for rating RAW images without touching them."));
+    cbSidecar->setChecked(DkSettingsManager::param().metaData().useXmpSidecar);
+    connect(cbSidecar, &QCheckBox::toggled, this, &DkAdvancedPreference::onSidecarToggled);
+
     auto *loadFileGroup = new DkGroupWidget(tr("File Loading/Saving"), this);
     loadFileGroup->addWidget(cbSaveDeleted);
     loadFileGroup->addWidget(cbIgnoreExif);
     loadFileGroup->addWidget(cbSaveExif);
+    loadFileGroup->addWidget(cbSaveInstantly);
+    loadFileGroup->addWidget(cbSidecar);
 
     // batch processing
     auto *sbNumThreads = new QSpinBox(this);
@@ -1727,6 +1741,18 @@ void DkAdvancedPreference::onSaveExifToggled(bool checked) const
         DkSettingsManager::param().metaData().saveExifOrientation = checked;
 }
 
+void DkAdvancedPreference::onSaveInstantlyToggled(bool checked) const
+{
+    if (DkSettingsManager::param().metaData().saveMetaDataInstantly != checked)
+        DkSettingsManager::param().metaData().saveMetaDataInstantly = checked;
+}
+
+void DkAdvancedPreference::onSidecarToggled(bool checked) const
+{
+    if (DkSettingsManager::param().metaData().useXmpSidecar != checked)
+        DkSettingsManager::param().metaData().useXmpSidecar = checked;
+}
+
 void DkAdvancedPreference::onUseLogToggled(bool checked) const
 {
     if (DkSettingsManager::param().app().useLogFile != checked) {
@@ -257,6 +257,8 @@ public slots:
     void onSaveDeletedToggled(bool checked) const;
     void onIgnoreExifToggled(bool checked) const;
     void onSaveExifToggled(bool checked) const;
+    void onSaveInstantlyToggled(bool checked) const;
+    void onSidecarToggled(bool checked) const;
     void onUseLogToggled(bool checked) const;
     void onUseNativeToggled(bool checked) const;
     void onLogFolderClicked() const;
@@ -0,0 +1,177 @@
+/*******************************************************************************************************
+ DkSingleInstance.cpp
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#include "DkSingleInstance.h"
+
+#include "DkSettings.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+namespace nmc
+{
+
+namespace
+{
+const quint32 requestMagic = 0x4e4d4f50; // NMOP
+const char requestAccepted = 1;
+}
+
+DkSingleInstance::DkSingleInstance(const QString &serverName, QObject *parent)
+    : QObject(parent)
+    , mServerName(serverName)
+{
+    mServer = new QLocalServer(this);
+    mServer->setSocketOptions(QLocalServer::UserAccessOption);
+
+    connect(mServer, &QLocalServer::newConnection, this, &DkSingleInstance::newConnection);
+}
+
+DkSingleInstance::~DkSingleInstance() = default;
+
+QString DkSingleInstance::defaultServerName()
+{
+    return serverName(QDir::homePath());
+}
+
+QString DkSingleInstance::serverName(const QString &homePath)
+{
+    // local server names are global on some platforms
+    QByteArray user = QCryptographicHash::hash(homePath.toUtf8(), QCryptographicHash::Md5).toHex().left(12);
+    return "nomacs-" + QString::fromLatin1(user);
+}
+
+bool DkSingleInstance::parseArguments(const QStringList &arguments, Request &request)
+{
+    request = Request();
+
+    for (int idx = 1; idx < arguments.size(); idx++) {
+        const QString &arg = arguments[idx];
+
+        if (arg == "--new-tab")
+            request.newTab = true;
+        else if (arg == "--single-instance")
+            request.force = true;
+        else if (arg.startsWith('-'))
+            return false;
+        else if (!arg.isEmpty())
+            request.files << QFileInfo(arg).absoluteFilePath();
+    }
+
+    return true;
+}
+
+bool DkSingleInstance::isEnabled()
+{
+    DefaultSettings settings;
+    return settings.value("AppSettings/singleInstance", false).toBool();
+}
+
+bool DkSingleInstance::forward(const QStringList &arguments, const QString &serverName, int timeout)
+{
+    Request request;
+    if (!parseArguments(arguments, request))
+        return false;
+
+    if (!request.force && !isEnabled())
+        return false;
+
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected(timeout))
+        return false; // we are the first instance
+
+    QDataStream ds(&socket);
+    ds << requestMagic << request.files << request.newTab;
+
+    if (!socket.waitForBytesWritten(timeout) || !socket.waitForReadyRead(timeout)) {
+        qWarning() << "[DkSingleInstance] the running instance does not respond:" << socket.errorString();
+        return false;
+    }
+
+    char reply = 0;
+    return socket.getChar(&reply) && reply == requestAccepted;
+}
+
+bool DkSingleInstance::listen()
+{
+    // someone else is serving already (pipe names can be taken twice on Windows)
+    QLocalSocket probe;
+    probe.connectToServer(mServerName);
+    if (probe.waitForConnected(100))
+        return false;
+
+    if (mServer->listen(mServerName))
+        return true;
+
+    // a crashed instance left its socket behind
+    QLocalServer::removeServer(mServerName);
+
+    if (!mServer->listen(mServerName)) {
+        qWarning() << "[DkSingleInstance] cannot listen on" << mServerName << mServer->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void DkSingleInstance::newConnection()
+{
+    while (QLocalSocket *socket = mServer->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            QDataStream ds(socket);
+            ds.startTransaction();
+
+            quint32 magic = 0;
+            QStringList files;
+            bool newTab = false;
+            ds >> magic >> files >> newTab;
+
+            if (!ds.commitTransaction())
+                return; // wait for more data
+
+            if (magic != requestMagic) {
+                socket->abort();
+                return;
+            }
+
+            socket->putChar(requestAccepted);
+            socket->flush();
+            socket->disconnectFromServer();
+
+            emit openRequested(files, newTab);
+        });
+    }
+}
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************************************
+ DkSingleInstance.h
+ Created on:	19.10.2026
+
+ nomacs is a fast and small image viewer with the capability of synchronizing multiple instances
+
+ Copyright (C) 2011-2014 Markus Diem <markus@nomacs.org>
+ Copyright (C) 2011-2014 Stefan Fiel <stefan@nomacs.org>
+ Copyright (C) 2011-2014 Florian Kleber <florian@nomacs.org>
+
+ This file is part of nomacs.
+
+ nomacs is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ nomacs is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ *******************************************************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+
+#include "nmc_config.h"
+
+class QLocalServer;
+
+namespace nmc
+{
+/**
+ * Single instance mode.
+ *
+ * A new process hands its files to the running instance and quits before
+ * settings, plugins or windows are initialized. The running instance
+ * listens on a local server that is private to the user.
+ **/
+class DllCoreExport DkSingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Request {
+        QStringList files; // absolute paths
+        bool newTab = false; // open in new tabs instead of replacing the current image
+        bool force = false; // --single-instance, independent of the settings
+    };
+
+    explicit DkSingleInstance(const QString &serverName = defaultServerName(), QObject *parent = nullptr);
+    ~DkSingleInstance() override;
+
+    static QString defaultServerName();
+
+    /**
+     * The server of the user with the given home directory.
+     **/
+    static QString serverName(const QString &homePath);
+
+    /**
+     * Parses the command line, returns false if it contains anything but
+     * files and the single instance options - these are handled by a new process.
+     **/
+    static bool parseArguments(const QStringList &arguments, Request &request);
+
+    /**
+     * Reads the single instance option without loading all settings.
+     **/
+    static bool isEnabled();
+
+    /**
+     * Sends the files of the command line to a running instance.
+     * Returns true if the running instance accepted them, i.e. this process can quit.
+     **/
+    static bool forward(const QStringList &arguments,
+                        const QString &serverName = defaultServerName(),
+                        int timeout = 1000);
+
+    bool listen();
+
+signals:
+    void openRequested(const QStringList &files, bool newTab) const;
+
+private:
+    void newConnection();
+
+    QString mServerName;
+    QLocalServer *mServer;
+};
+}
@@ -39,6 +39,7 @@
 #include "DkSettings.h"
 #include "DkStatusBar.h"
 #include "DkThumbsWidgets.h" // needed in the connects -> shall we move them to mController?
+#include "DkTimer.h"
 #include "DkToolbars.h"
 #include "DkUtils.h"
 #include "DkWidgets.h"
@@ -76,15 +77,6 @@ DkViewPort::DkViewPort(DkThumbLoader *thumbLoader, QWidget *parent)
     mRepeatZoomTimer = new QTimer(this);
     mAnimationTimer = new QTimer(this);
 
-    // try loading a custom file
-    mImgBg.load(QFileInfo(QApplication::applicationDirPath(), "bg.png").absoluteFilePath());
-    if (mImgBg.isNull() && DkSettingsManager::param().global().showLogoImage) {
-        QColor col = Qt::black;
-        col.setAlpha(90);
-        mImgBg = DkImage::loadIcon(":/nomacs/img/nomacs-bg.svg", col).pixmap(80).toImage();
-        mImgBg.setDevicePixelRatio(1.0); // handle device scaling ourselves
-    }
-
     mRepeatZoomTimer->setInterval(20);
     connect(mRepeatZoomTimer, &QTimer::timeout, this, &DkViewPort::repeatZoom);
 
@@ -926,6 +918,8 @@ void DkViewPort::paintEvent(QPaintEvent *event)
 
         // now disable world matrix for overlay display
         painter.setWorldMatrixEnabled(false);
+
+        DkStartupTrace::instance().finish("first paint");
     } else {
         if (!mDisabledBackground)
             eraseBackground(painter);
@@ -964,10 +958,31 @@ void DkViewPort::leaveEvent(QEvent *event)
 }
 
 // drawing functions --------------------------------------------------------------------
+void DkViewPort::loadBackgroundImage() const
+{
+    mImgBgLoaded = true;
+
+    // the frameless viewport brings its own
+    if (!mImgBg.isNull())
+        return;
+
+    // try loading a custom file
+    mImgBg.load(QFileInfo(QApplication::applicationDirPath(), "bg.png").absoluteFilePath());
+    if (mImgBg.isNull() && DkSettingsManager::param().global().showLogoImage) {
+        QColor col = Qt::black;
+        col.setAlpha(90);
+        mImgBg = DkImage::loadIcon(":/nomacs/img/nomacs-bg.svg", col).pixmap(80).toImage();
+        mImgBg.setDevicePixelRatio(1.0); // handle device scaling ourselves
+    }
+}
+
 void DkViewPort::eraseBackground(QPainter &painter) const
 {
     DkBaseViewPort::eraseBackground(painter);
 
+    if (!mImgBgLoaded)
+        loadBackgroundImage();
+
     // draw logo/bg.png in the bottom-right corner, 1:1 pixels unless too big
     painter.save();
     painter.setWorldMatrixEnabled(false);
@@ -110,6 +110,7 @@ protected:
     void resetView() override;
     void togglePattern(bool show) override;
     void eraseBackground(QPainter &painter) const override;
+    void loadBackgroundImage() const;
     void getPixelInfo(const QPoint &pos);
 
     // events
@@ -124,7 +125,9 @@ protected:
     void leaveEvent(QEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
 
-    QImage mImgBg;
+    // the logo is not needed when starting with an image, it is loaded on first use
+    mutable QImage mImgBg;
+    mutable bool mImgBgLoaded = false;
 
     DkControlWidget *mController = nullptr;
 
@@ -43,16 +43,20 @@
 #include <QObject>
 #include <QTextStream>
 #include <QThread>
+#include <QTimer>
 #include <QTranslator>
 
 #include "DkCachedThumb.h"
 #include "DkCentralWidget.h"
+#include "DkIconAtlas.h"
+#include "DkMetaDataWriter.h"
 #include "DkNoMacs.h"
 #include "DkPluginManager.h"
 #include "DkPong.h"
 #include "DkProcess.h"
 #include "DkSettings.h"
 #include "DkShortcuts.h"
+#include "DkSingleInstance.h"
 #include "DkThemeManager.h"
 #include "DkTimer.h"
 #include "DkUtils.h"
@@ -71,6 +75,9 @@ int main(int argc, char *argv[])
 {
 #endif
 
+    // starts the clock of the startup trace
+    nmc::DkStartupTrace::instance();
+
     QCoreApplication::setOrganizationName("nomacs");
     QCoreApplication::setOrganizationDomain("https://nomacs.org");
     QCoreApplication::setApplicationName("Image Lounge");
@@ -85,18 +92,16 @@ int main(int argc, char *argv[])
     app.setDesktopFileName("org.nomacs.ImageLounge");
 #endif
 
+    // single instance mode: hand the files to the running instance before anything heavy is initialized
+    if (nmc::DkSingleInstance::forward(app.arguments()))
+        return 0;
+
     // init settings
+    nmc::DkTracePhase settingsPhase("settings");
     nmc::DkSettingsManager::instance().init();
     nmc::DkMetaDataHelper::initialize(); // this line makes the XmpParser thread-save - so don't delete it even if you
                                          // seem to know what you do
-    // uncomment this for the single instance feature...
-    //// check for single instance
-    // nmc::DkRunGuard guard;
-    //
-    // if (!guard.tryRunning()) {
-    //	qDebug() << "nomacs is already running - quitting...";
-    //	return 0;
-    // }
+    settingsPhase.end();
 
     // CMD parser --------------------------------------------------------------------
     QCommandLineParser parser;
@@ -151,12 +156,28 @@ int main(int argc, char *argv[])
     QCommandLineOption aboutOpt(QStringList("about"), QObject::tr("Print build information"));
     parser.addOption(aboutOpt);
 
+    QCommandLineOption traceStartupOpt(QStringList("trace-startup"),
+                                       QObject::tr("Write the startup phases to <trace.json> (Chrome trace format)."),
+                                       QObject::tr("trace.json"));
+    parser.addOption(traceStartupOpt);
+
+    QCommandLineOption singleInstanceOpt(QStringList("single-instance"),
+                                         QObject::tr("Open the files in the running nomacs if there is one."));
+    parser.addOption(singleInstanceOpt);
+
+    QCommandLineOption newTabOpt(QStringList("new-tab"),
+                                 QObject::tr("Open the files in new tabs of the running nomacs (single instance)."));
+    parser.addOption(newTabOpt);
+
     QCommandLineOption skipStartupOpt(QStringList("skip-startup"));
     skipStartupOpt.setFlags(QCommandLineOption::HiddenFromHelp);
     parser.addOption(skipStartupOpt);
 
     parser.process(app);
 
+    if (parser.isSet(traceStartupOpt))
+        nmc::DkStartupTrace::instance().setOutputPath(parser.value(traceStartupOpt));
+
     // CMD parser --------------------------------------------------------------------
     nmc::DkPluginManager::createPluginsPath();
 
@@ -217,8 +238,11 @@ int main(int argc, char *argv[])
         out << "qt-imageformats:" << QImageReader::supportedImageFormats().join(",") << "\n";
 
         nmc::DkPluginManager::instance().loadPlugins();
-        for (auto &plugin : nmc::DkPluginManager::instance().getPlugins())
-            out << "plugin:" << plugin->pluginPath() << "\n";
+        for (auto &plugin : nmc::DkPluginManager::instance().getPlugins()) {
+            // plugins are loaded on first use, force it here
+            if (plugin->load())
+                out << "plugin:" << plugin->pluginPath() << "\n";
+        }
     }
 
     if (noUI)
@@ -272,7 +296,9 @@ int main(int argc, char *argv[])
     nmc::DkTimer dt;
 
     // bring up theme before any widgets
+    nmc::DkTracePhase themePhase("theme");
     nmc::DkThemeManager::instance().applyTheme();
+    themePhase.end();
 
     if (!parser.isSet(skipStartupOpt) //
         && nmc::DkSettingsManager::param().resources().thumbDiskCache
@@ -281,6 +307,7 @@ int main(int argc, char *argv[])
     }
 
     // initialize nomacs
+    nmc::DkTracePhase windowPhase("create window");
     const int modeType = nmc::DkSettings::normalMode(mode);
     if (modeType == nmc::DkSettings::mode_frameless) {
         w = new nmc::DkNoMacsFrameless();
@@ -294,6 +321,7 @@ int main(int argc, char *argv[])
     } else {
         w = new nmc::DkNoMacsIpl();
     }
+    windowPhase.end();
 
     qInfo() << "init window: appMode:" << nmc::DkSettingsManager::param().app().currentAppMode
             << "maximized:" << w->isMaximized() << "fullscreen:" << w->isFullScreen() << "geometry:" << w->geometry()
@@ -304,6 +332,7 @@ int main(int argc, char *argv[])
     w->setWindowOpacity(0.0);
 #endif
 
+    nmc::DkTracePhase showPhase("show window");
     if (nmc::DkSettings::modeIsFullscreen(mode))
         w->showFullScreen();
     else if (w->windowState() & Qt::WindowMaximized)
@@ -334,6 +363,7 @@ int main(int argc, char *argv[])
     // If we try again with a visible window, it *could* work correctly (GNOME)
     if (maximized && !w->isMaximized())
         w->showMaximized();
+    showPhase.end();
 
     if (w)
         w->onWindowLoaded();
@@ -350,6 +380,29 @@ int main(int argc, char *argv[])
 
     nmc::DkCentralWidget *cw = w->getTabWidget();
 
+    // files of later launches arrive here in single instance mode
+    nmc::DkSingleInstance singleInstance;
+    if ((parser.isSet(singleInstanceOpt) || nmc::DkSettingsManager::param().app().singleInstance)
+        && singleInstance.listen()) {
+        QObject::connect(&singleInstance,
+                         &nmc::DkSingleInstance::openRequested,
+                         w,
+                         [w](const QStringList &files, bool newTab) {
+                             nmc::DkCentralWidget *tabs = w->getTabWidget();
+                             for (int idx = 0; idx < files.size(); idx++) {
+                                 if (newTab || idx > 0)
+                                     tabs->loadToTab(files[idx]);
+                                 else
+                                     tabs->load(files[idx]);
+                             }
+
+                             if (w->isMinimized())
+                                 w->showNormal();
+                             w->raise();
+                             w->activateWindow();
+                         });
+    }
+
     bool loading = false;
 
     for (auto &filePath : parser.positionalArguments()) {
@@ -368,6 +421,15 @@ int main(int argc, char *argv[])
     if (!loading && nmc::DkSettingsManager::param().app().showRecentFiles)
         w->showRecentFilesOnStartUp();
 
+    // the startup finishes with the first image painted
+    if (!loading)
+        nmc::DkStartupTrace::instance().finish("window shown");
+    else {
+        QTimer::singleShot(5000, [] {
+            nmc::DkStartupTrace::instance().finish("timeout");
+        });
+    }
+
     if (w->isFullScreen())
         w->enterFullScreen();
 
@@ -396,6 +458,12 @@ int main(int argc, char *argv[])
                               QMessageBox::Ok);
     }
 
+    // finish pending ratings & comments
+    nmc::DkMetaDataWriter::instance().waitForFinished();
+
+    // keep the icons rendered in this session
+    nmc::DkIconAtlas::instance().save();
+
     // restore message handler, workaround for: https://github.com/nomacs/nomacs/issues/874
     qInstallMessageHandler(nullptr);
 
@@ -0,0 +1,147 @@
+#include "DkBasicLoader.h"
+#include "DkSettings.h"
+
+#include <QImage>
+
+#include <gtest/gtest.h>
+
+using namespace nmc;
+
+static QImage createTestImage(int size)
+{
+    QImage img(size, size, QImage::Format_RGB32);
+    for (int y = 0; y < size; y++) {
+        auto *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < size; x++)
+            line[x] = qRgb(x % 256, y % 256, (x * y) % 256);
+    }
+
+    return img;
+}
+
+static QImage paintRect(const QImage &src, int idx)
+{
+    QImage img = src.copy();
+    for (int y = idx * 20; y < idx * 20 + 16; y++) {
+        for (int x = idx * 20; x < idx * 20 + 16; x++)
+            img.setPixel(x, y, qRgb(255, 0, 0));
+    }
+
+    return img;
+}
+
+class DkEditHistoryTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mHistoryMemory = DkSettingsManager::param().resources().historyMemory;
+    }
+
+    void TearDown() override
+    {
+        DkSettingsManager::param().resources().historyMemory = mHistoryMemory;
+    }
+
+    float mHistoryMemory = 0;
+};
+
+TEST_F(DkEditHistoryTest, MetaDataEditsShareImage)
+{
+    DkSettingsManager::param().resources().historyMemory = 128;
+
+    DkBasicLoader loader;
+    loader.setEditImage(createTestImage(512), "Original Image");
+    const qint64 bytes = loader.historyMemoryUsage();
+    EXPECT_EQ(bytes, 512 * 512 * 4);
+
+    loader.setEditMetaData("Rating");
+    loader.setEditMetaData("Comment");
+
+    EXPECT_EQ(loader.history()->size(), 3);
+    EXPECT_EQ(loader.historyMemoryUsage(), bytes);
+}
+
+TEST_F(DkEditHistoryTest, HiddenStatesAreCompressed)
+{
+    // the original and the current state fit, all others must be compressed
+    DkSettingsManager::param().resources().historyMemory = 2.5f;
+
+    DkBasicLoader loader;
+    loader.setEditImage(createTestImage(512), "Original Image");
+
+    QVector<QImage> states{loader.image()};
+    for (int idx = 1; idx <= 6; idx++) {
+        states << paintRect(states.last(), idx);
+        loader.setEditImage(states.last(), "Paint");
+    }
+
+    // nothing is dropped
+    ASSERT_EQ(loader.history()->size(), 7);
+    EXPECT_LE(loader.historyMemoryUsage(), 2.5 * 1024 * 1024);
+    EXPECT_TRUE(loader.history()->at(1).isPacked());
+    EXPECT_FALSE(loader.history()->last().isPacked());
+
+    // undo restores the exact pixels
+    for (int idx = 5; idx >= 0; idx--) {
+        loader.undo();
+        EXPECT_EQ(loader.historyIndex(), idx);
+        EXPECT_EQ(loader.image(), states[idx]);
+        EXPECT_LE(loader.historyMemoryUsage(), 2.5 * 1024 * 1024);
+    }
+
+    loader.setHistoryIndex(6);
+    EXPECT_EQ(loader.image(), states[6]);
+}
+
+TEST(DkPackedImage, TruncatedStripsFailToUnpack)
+{
+    const QImage img = createTestImage(512);
+
+    DkPackedImage packed(img, QImage());
+    ASSERT_EQ(packed.numStrips(), 8);
+    EXPECT_EQ(packed.unpack(), img);
+
+    // the compressed stream ends early
+    const QByteArray strip = packed.strip(3);
+    packed.setStrip(3, strip.left(strip.size() / 2));
+    EXPECT_TRUE(packed.unpack().isNull());
+
+    // a valid stream with fewer rows than the strip covers
+    packed.setStrip(3, qCompress(qUncompress(strip).left(img.bytesPerLine() * 10)));
+    EXPECT_TRUE(packed.unpack().isNull());
+
+    packed.setStrip(3, strip);
+    EXPECT_EQ(packed.unpack(), img);
+}
+
+TEST_F(DkEditHistoryTest, KeepsStateIfUndoIsCorrupt)
+{
+    DkSettingsManager::param().resources().historyMemory = 2.5f;
+
+    DkBasicLoader loader;
+    loader.setEditImage(createTestImage(512), "Original Image");
+
+    QVector<QImage> states{loader.image()};
+    for (int idx = 1; idx <= 6; idx++) {
+        states << paintRect(states.last(), idx);
+        loader.setEditImage(states.last(), "Paint");
+    }
+
+    QSharedPointer<DkPackedImage> packed = loader.history()->at(2).packed();
+    ASSERT_TRUE(packed);
+
+    // truncate the strip that contains the painted rectangle
+    const QByteArray strip = packed->strip(0);
+    ASSERT_FALSE(strip.isNull());
+    packed->setStrip(0, strip.left(strip.size() / 2));
+
+    loader.setHistoryIndex(2);
+    EXPECT_EQ(loader.historyIndex(), 6);
+    EXPECT_EQ(loader.image(), states[6]);
+
+    // other states are not affected
+    loader.setHistoryIndex(3);
+    EXPECT_EQ(loader.historyIndex(), 3);
+    EXPECT_EQ(loader.image(), states[3]);
+}
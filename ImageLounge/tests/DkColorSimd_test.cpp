@@ -0,0 +1,141 @@
+#include "DkColorSimd.h"
+#include "DkImageStorage.h"
+
+#include <QColorSpace>
+#include <QImage>
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace nmc;
+
+TEST(DkColorSimd, MatchesScalar)
+{
+    const int n = 1003; // not a multiple of any vector width
+    std::vector<float> r(n), g(n), b(n);
+    std::vector<uint8_t> pixels(4 * n);
+    for (int idx = 0; idx < n; idx++) {
+        r[idx] = idx / float(n);
+        g[idx] = (idx % 7) / 6.0f;
+        b[idx] = 1.2f - 1.4f * idx / n; // some values are out of range
+        for (int c = 0; c < 4; c++)
+            pixels[4 * idx + c] = static_cast<uint8_t>(idx * (c + 3) + c);
+    }
+    r[5] = NAN;
+
+    std::vector<float> decodeLut(256);
+    for (int idx = 0; idx < 256; idx++)
+        decodeLut[idx] = std::pow(idx / 255.0f, 2.2f);
+
+    // a linear table quantizes, a curved one exercises the interpolation
+    const int encodeSize = 1000;
+    std::vector<float> encodeLut(encodeSize + 2);
+    for (int idx = 0; idx <= encodeSize; idx++)
+        encodeLut[idx] = std::sqrt(idx / float(encodeSize)) * 65535.0f;
+    encodeLut[encodeSize + 1] = encodeLut[encodeSize];
+
+    const float weights[3] = {0.2126729f, 0.7151522f, 0.0721750f};
+    std::vector<float> yRef(n), c0Ref(n), c1Ref(n), c2Ref(n);
+    std::vector<uint16_t> qRef(n);
+    DkColorSimd::luma(DkColorSimd::isa_scalar)(r.data(), g.data(), b.data(), yRef.data(), n, weights);
+    DkColorSimd::decode(DkColorSimd::isa_scalar)(pixels.data(),
+                                                 c0Ref.data(),
+                                                 c1Ref.data(),
+                                                 c2Ref.data(),
+                                                 n,
+                                                 decodeLut.data());
+    DkColorSimd::encode(DkColorSimd::isa_scalar)(yRef.data(), qRef.data(), n, encodeLut.data(), encodeSize);
+    EXPECT_EQ(qRef[5], 0);
+    EXPECT_EQ(c2Ref[1], decodeLut[pixels[6]]);
+
+    for (int isa = DkColorSimd::isa_scalar; isa < DkColorSimd::isa_end; isa++) {
+        auto i = static_cast<DkColorSimd::Isa>(isa);
+        if (!DkColorSimd::isSupported(i))
+            continue;
+
+        std::vector<float> y(n), c0(n), c1(n), c2(n);
+        std::vector<uint16_t> q(n);
+        DkColorSimd::luma(i)(r.data(), g.data(), b.data(), y.data(), n, weights);
+        DkColorSimd::decode(i)(pixels.data(), c0.data(), c1.data(), c2.data(), n, decodeLut.data());
+        DkColorSimd::encode(i)(yRef.data(), q.data(), n, encodeLut.data(), encodeSize);
+
+        for (int idx = 0; idx < n; idx++) {
+            if (idx != 5)
+                EXPECT_NEAR(y[idx], yRef[idx], 1e-6f) << "isa " << isa << " at " << idx;
+            EXPECT_EQ(c0[idx], c0Ref[idx]) << "isa " << isa << " at " << idx;
+            EXPECT_EQ(c1[idx], c1Ref[idx]) << "isa " << isa << " at " << idx;
+            EXPECT_EQ(c2[idx], c2Ref[idx]) << "isa " << isa << " at " << idx;
+            EXPECT_EQ(q[idx], qRef[idx]) << "isa " << isa << " at " << idx;
+        }
+    }
+}
+
+#if WITH_OPENCV
+
+// the conversion in double precision, the weights are the Y rows of the rgb to XYZ (D65) matrices
+static QImage referenceGray(const QImage &img)
+{
+    const QColorSpace cs = img.colorSpace();
+    double w[3] = {0.2126729, 0.7151522, 0.0721750};
+    if (cs.primaries() == QColorSpace::Primaries::DciP3D65)
+        w[0] = 0.2289746, w[1] = 0.6917385, w[2] = 0.0792869;
+    else if (cs.primaries() == QColorSpace::Primaries::AdobeRgb)
+        w[0] = 0.2973450, w[1] = 0.6273636, w[2] = 0.0752915;
+
+    auto toLinear = [&cs](int v) {
+        const double c = v / 255.0;
+        if (cs.transferFunction() == QColorSpace::TransferFunction::Gamma)
+            return std::pow(c, double(cs.gamma()));
+        return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+    };
+
+    QImage gray(img.size(), QImage::Format_Grayscale16);
+    for (int y = 0; y < img.height(); y++) {
+        auto *dst = reinterpret_cast<uint16_t *>(gray.scanLine(y));
+        for (int x = 0; x < img.width(); x++) {
+            const QRgb px = img.pixel(x, y);
+            const double v = w[0] * toLinear(qRed(px)) + w[1] * toLinear(qGreen(px)) + w[2] * toLinear(qBlue(px));
+            dst[x] = static_cast<uint16_t>(std::lround(std::pow(qBound(0.0, v, 1.0), 1.0 / 2.2) * 65535.0));
+        }
+    }
+
+    return gray;
+}
+
+// 8 bit input is decoded exactly, so the result must be within 1 LSB of the exact conversion
+TEST(DkColorSimd, GrayscaleMatchesExactConversion)
+{
+    const QColorSpace spaces[] = {QColorSpace::SRgb, QColorSpace::DisplayP3, QColorSpace::AdobeRgb};
+    const QImage::Format formats[] = {QImage::Format_RGB32, QImage::Format_RGBA8888, QImage::Format_RGB888};
+
+    // every channel value, dark mixtures included
+    QImage src(256, 64, QImage::Format_RGB32);
+    for (int y = 0; y < src.height(); y++) {
+        for (int x = 0; x < src.width(); x++)
+            src.setPixel(x, y, qRgb(x, (x * 7 + y * 3) % 256, y < 8 ? y : 255 - y * 4));
+    }
+
+    for (QImage::Format format : formats) {
+        for (const QColorSpace &cs : spaces) {
+            QImage img = src.convertToFormat(format);
+            img.setColorSpace(cs);
+            QImage gray = DkImage::grayscaleImage(img);
+            ASSERT_EQ(gray.format(), QImage::Format_Grayscale16);
+
+            QImage expected = referenceGray(img);
+            int maxDiff = 0;
+            for (int y = 0; y < img.height(); y++) {
+                const auto *line = reinterpret_cast<const uint16_t *>(gray.constScanLine(y));
+                const auto *ref = reinterpret_cast<const uint16_t *>(expected.constScanLine(y));
+                for (int x = 0; x < img.width(); x++)
+                    maxDiff = qMax(maxDiff, qAbs(line[x] - ref[x]));
+            }
+
+            EXPECT_LE(maxDiff, 1) << cs.description().toStdString() << " format " << format;
+        }
+    }
+}
+
+#endif
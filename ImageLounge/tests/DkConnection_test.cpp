@@ -0,0 +1,280 @@
+#include "DkConnection.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QTcpServer>
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+
+using namespace nmc;
+
+// a peer from before SYNCBATCH: its greeting ends after the title
+class DkLegacyConnection : public DkLocalConnection
+{
+public:
+    QList<int> receivedTypes;
+
+    void sendGreetingMessage(const QString &currentTitle) override
+    {
+        QByteArray ba;
+        QDataStream ds(&ba, QIODevice::WriteOnly);
+        ds << getLocalTcpServerPort();
+        ds << currentTitle;
+
+        QByteArray data = "GREETING";
+        data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
+        if (write(data) == data.size())
+            mIsGreetingMessageSent = true;
+    }
+
+    bool receivedSyncBatch() const
+    {
+        return receivedTypes.contains(SyncBatch);
+    }
+
+protected:
+    void processData() override
+    {
+        receivedTypes << mCurrentDataType;
+        DkLocalConnection::processData();
+    }
+};
+
+// accepts a single peer as local connection, like DkLocalTcpServer does
+class DkTestServer : public QTcpServer
+{
+public:
+    std::unique_ptr<DkLocalConnection> connection;
+    bool legacy = false;
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        if (legacy)
+            connection = std::make_unique<DkLegacyConnection>();
+        else
+            connection = std::make_unique<DkLocalConnection>();
+        connection->setSocketDescriptor(socketDescriptor);
+    }
+};
+
+static bool waitFor(const std::function<bool()> &done, int timeout = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done() && timer.elapsed() < timeout)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+
+    return done();
+}
+
+class DkConnectionTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        connectPeers();
+    }
+
+    void connectPeers()
+    {
+        ASSERT_TRUE(mServer.listen(QHostAddress::LocalHost));
+        mSender.setLocalTcpServerPort(1);
+        mSender.connectToHost(QHostAddress::LocalHost, mServer.serverPort());
+        ASSERT_TRUE(mSender.waitForConnected(5000));
+        ASSERT_TRUE(waitFor([this]() {
+            return mServer.connection != nullptr;
+        }));
+
+        mReceiver = mServer.connection.get();
+        mReceiver->setLocalTcpServerPort(2);
+
+        bool synchronized = false;
+        auto c = QObject::connect(&mSender, &DkConnection::connectionStartSynchronize, [&synchronized]() {
+            synchronized = true;
+        });
+
+        mSender.sendGreetingMessage("sender");
+        ASSERT_TRUE(waitFor([this]() {
+            return mSender.getPeerPort() != 0 && mReceiver->getPeerPort() != 0;
+        }));
+
+        mSender.sendStartSynchronizeMessage();
+        ASSERT_TRUE(waitFor([&synchronized]() {
+            return synchronized;
+        }));
+
+        QObject::disconnect(c);
+    }
+
+    DkTestServer mServer;
+    DkLocalConnection mSender;
+    DkLocalConnection *mReceiver = nullptr;
+};
+
+class DkLegacyConnectionTest : public DkConnectionTest
+{
+protected:
+    void SetUp() override
+    {
+        mServer.legacy = true;
+        connectPeers();
+    }
+};
+
+TEST_F(DkConnectionTest, CoalescesTransformBurst)
+{
+    const int numTransforms = 10000;
+
+    int numReceived = 0;
+    QTransform lastReceived;
+    QElapsedTimer latency;
+    qint64 latencyMs = -1;
+
+    QObject::connect(mReceiver,
+                     &DkConnection::connectionNewTransform,
+                     [&](DkConnection *, QTransform transform, QTransform, QPointF) {
+                         numReceived++;
+                         lastReceived = transform;
+                         if (transform.dx() == numTransforms)
+                             latencyMs = latency.elapsed();
+                     });
+
+    // a mouse drag delivers events faster than frames are painted
+    for (int idx = 1; idx <= numTransforms; idx++) {
+        // measure from sending the last transform until it is received
+        if (idx == numTransforms)
+            latency.start();
+
+        mSender.sendNewTransformMessage(QTransform::fromTranslate(idx, -idx), QTransform::fromScale(2, 2), {0.5, 0.5});
+
+        if (idx % 100 == 0)
+            QCoreApplication::processEvents();
+    }
+
+    ASSERT_TRUE(waitFor([&]() {
+        return latencyMs >= 0;
+    }));
+
+    RecordProperty("messages", numReceived);
+    RecordProperty("latency_ms", static_cast<int>(latencyMs));
+
+    EXPECT_LT(numReceived, numTransforms / 100);
+    EXPECT_EQ(lastReceived, QTransform::fromTranslate(numTransforms, -numTransforms));
+    EXPECT_LT(latencyMs, 1000);
+}
+
+TEST_F(DkConnectionTest, AccumulatesRelativeMoves)
+{
+    QPointF moved;
+    int numAbsolute = 0;
+
+    QObject::connect(mReceiver,
+                     &DkConnection::connectionNewTransform,
+                     [&](DkConnection *, QTransform transform, QTransform, QPointF canvasSize) {
+                         if (canvasSize.isNull())
+                             moved += QPointF(transform.dx(), transform.dy());
+                         else
+                             numAbsolute++;
+                     });
+
+    QTransform perspective;
+    perspective.setMatrix(1, 0, 0.001, 0, 1, 0, 0, 0, 1);
+    mSender.sendNewTransformMessage(perspective, QTransform(), {0.5, 0.5});
+
+    for (int idx = 0; idx < 100; idx++)
+        mSender.sendNewTransformMessage(QTransform::fromTranslate(1, 2), QTransform(), QPointF());
+
+    ASSERT_TRUE(waitFor([&]() {
+        return moved == QPointF(100, 200);
+    }));
+    EXPECT_EQ(numAbsolute, 1);
+}
+
+TEST_F(DkConnectionTest, KeepsOrderOfFileChanges)
+{
+    QStringList received;
+
+    QObject::connect(mReceiver, &DkConnection::connectionNewPosition, [&](DkConnection *, QRect rect, bool, bool) {
+        received << QString("position %1").arg(rect.width());
+    });
+    QObject::connect(mReceiver, &DkConnection::connectionNewFile, [&](DkConnection *, qint16, const QString &file) {
+        received << file;
+    });
+
+    mSender.sendNewPositionMessage(QRect(0, 0, 10, 10), false, false);
+    mSender.sendNewPositionMessage(QRect(0, 0, 20, 20), false, false);
+    mSender.sendNewFileMessage(0, "a.jpg");
+    mSender.sendNewPositionMessage(QRect(0, 0, 30, 30), false, false);
+
+    ASSERT_TRUE(waitFor([&]() {
+        return received.size() >= 4;
+    }));
+    EXPECT_EQ(received, QStringList({"position 10", "position 20", "a.jpg", "position 30"}));
+}
+
+TEST_F(DkConnectionTest, DropsTruncatedBatch)
+{
+    int numTransforms = 0;
+    QStringList files;
+
+    QObject::connect(mReceiver, &DkConnection::connectionNewTransform, [&]() {
+        numTransforms++;
+    });
+    QObject::connect(mReceiver, &DkConnection::connectionNewFile, [&](DkConnection *, qint16, const QString &file) {
+        files << file;
+    });
+
+    // a move record (type 3) needs two doubles, the peer sends one
+    QByteArray ba;
+    QDataStream ds(&ba, QIODevice::WriteOnly);
+    ds << quint8(3) << double(42.0);
+
+    QByteArray data = "SYNCBATCH";
+    data.append(SeparatorToken).append(QByteArray::number(ba.size())).append(SeparatorToken).append(ba);
+    mSender.write(data);
+
+    mSender.sendNewFileMessage(0, "a.jpg");
+
+    ASSERT_TRUE(waitFor([&]() {
+        return !files.isEmpty();
+    }));
+    EXPECT_EQ(numTransforms, 0);
+    EXPECT_EQ(files, QStringList({"a.jpg"}));
+}
+
+TEST_F(DkLegacyConnectionTest, SendsLegacyMessages)
+{
+    auto *legacy = static_cast<DkLegacyConnection *>(mReceiver);
+
+    QPointF moved;
+    QTransform absolute;
+    QRect position;
+
+    QObject::connect(mReceiver,
+                     &DkConnection::connectionNewTransform,
+                     [&](DkConnection *, QTransform transform, QTransform, QPointF canvasSize) {
+                         if (canvasSize.isNull())
+                             moved += QPointF(transform.dx(), transform.dy());
+                         else
+                             absolute = transform;
+                     });
+    QObject::connect(mReceiver, &DkConnection::connectionNewPosition, [&](DkConnection *, QRect rect, bool, bool) {
+        position = rect;
+    });
+
+    mSender.sendNewTransformMessage(QTransform::fromScale(2, 2), QTransform(), {0.5, 0.5});
+    for (int idx = 0; idx < 10; idx++)
+        mSender.sendNewTransformMessage(QTransform::fromTranslate(1, 2), QTransform(), QPointF());
+    mSender.sendNewPositionMessage(QRect(0, 0, 30, 30), false, false);
+
+    ASSERT_TRUE(waitFor([&]() {
+        return moved == QPointF(10, 20) && position.width() == 30;
+    }));
+    EXPECT_EQ(absolute, QTransform::fromScale(2, 2));
+    EXPECT_FALSE(legacy->receivedSyncBatch());
+}
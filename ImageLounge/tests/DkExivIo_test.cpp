@@ -0,0 +1,208 @@
+#include "DkExivIo.h"
+#include "DkFileInfo.h"
+#include "DkMetaData.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+#ifdef WITH_QUAZIP
+#include <quazip/quazipfile.h>
+#include <quazip/quazipnewinfo.h>
+#endif
+
+using namespace nmc;
+
+// noise does not compress, so the image data dwarfs the header
+static QString createLargeJpg(QTemporaryDir &tempDir)
+{
+    QImage img(1500, 1500, QImage::Format_RGB32);
+    QRandomGenerator rng(42);
+    for (int y = 0; y < img.height(); y++) {
+        auto *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < img.width(); x++)
+            line[x] = rng.generate();
+    }
+
+    const QString filePath = tempDir.filePath("large.jpg");
+    EXPECT_TRUE(img.save(filePath, "JPG", 100));
+
+    auto exivImg = Exiv2::ImageFactory::open(filePath.toStdString());
+    exivImg->readMetadata();
+    exivImg->exifData()["Exif.Image.Orientation"] = static_cast<uint16_t>(6);
+    exivImg->exifData()["Exif.Photo.DateTimeOriginal"] = "2026:10:19 12:00:00";
+    exivImg->writeMetadata();
+
+    return filePath;
+}
+
+// baseline gray TIFF with the IFD in front of a single uncompressed strip
+static QString createLargeTiff(QTemporaryDir &tempDir, quint32 width, quint32 height)
+{
+    const QString filePath = tempDir.filePath("large.tif");
+
+    QFile file(filePath);
+    EXPECT_TRUE(file.open(QFile::WriteOnly));
+
+    QDataStream ds(&file);
+    ds.setByteOrder(QDataStream::LittleEndian);
+
+    const quint16 numEntries = 9;
+    const quint32 dataOffset = 8 + 2 + numEntries * 12 + 4;
+    const quint16 typeShort = 3;
+    const quint16 typeLong = 4;
+
+    auto entry = [&ds](quint16 tag, quint16 type, quint32 value) {
+        ds << tag << type << quint32(1);
+        if (type == typeShort)
+            ds << quint16(value) << quint16(0);
+        else
+            ds << value;
+    };
+
+    ds << quint8('I') << quint8('I') << quint16(42) << quint32(8);
+    ds << numEntries;
+    entry(256, typeLong, width); // ImageWidth
+    entry(257, typeLong, height); // ImageLength
+    entry(258, typeShort, 8); // BitsPerSample
+    entry(259, typeShort, 1); // Compression
+    entry(262, typeShort, 1); // PhotometricInterpretation
+    entry(273, typeLong, dataOffset); // StripOffsets
+    entry(274, typeShort, 6); // Orientation
+    entry(278, typeLong, height); // RowsPerStrip
+    entry(279, typeLong, width * height); // StripByteCounts
+    ds << quint32(0);
+
+    EXPECT_EQ(file.pos(), dataOffset);
+    file.write(QByteArray(int(width * height), char(0x80)));
+
+    return filePath;
+}
+
+TEST(DkExivIo, ReadsJpegHeaderOnly)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createLargeJpg(tempDir);
+
+    QFile file(filePath);
+    ASSERT_TRUE(file.open(QFile::ReadOnly));
+    const QByteArray data = file.readAll();
+    const int headerSize = data.indexOf("\xff\xda");
+    ASSERT_GT(headerSize, 0);
+    ASSERT_GT(data.size(), 100 * headerSize);
+
+    auto *io = new DkExivIo(DkFileInfo(filePath));
+    auto exivImg = Exiv2::ImageFactory::open(DkExivIo::Ptr(io));
+    ASSERT_TRUE(exivImg);
+    exivImg->readMetadata();
+
+    const Exiv2::ExifData &exifData = exivImg->exifData();
+    auto pos = exifData.findKey(Exiv2::ExifKey("Exif.Image.Orientation"));
+    ASSERT_NE(pos, exifData.end());
+    EXPECT_EQ(pos->toString(), "6");
+
+    RecordProperty("file_size", data.size());
+    RecordProperty("bytes_read", static_cast<int>(io->bytesRead()));
+
+    // the format probes read a few bytes on top of the header
+    EXPECT_LE(io->bytesRead(), headerSize + 4096);
+    EXPECT_EQ(io->bytesMapped(), 0);
+    EXPECT_FALSE(io->isopen());
+}
+
+TEST(DkExivIo, MapsTiffInsteadOfReading)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const quint32 width = 4096;
+    const quint32 height = 2048;
+    const QString filePath = createLargeTiff(tempDir, width, height);
+
+    auto *io = new DkExivIo(DkFileInfo(filePath));
+    auto exivImg = Exiv2::ImageFactory::open(DkExivIo::Ptr(io));
+    ASSERT_TRUE(exivImg);
+    exivImg->readMetadata();
+
+    EXPECT_EQ(exivImg->pixelWidth(), width);
+    EXPECT_EQ(exivImg->pixelHeight(), height);
+
+    const Exiv2::ExifData &exifData = exivImg->exifData();
+    auto pos = exifData.findKey(Exiv2::ExifKey("Exif.Image.Orientation"));
+    ASSERT_NE(pos, exifData.end());
+    EXPECT_EQ(pos->toString(), "6");
+
+    RecordProperty("file_size", static_cast<int>(QFileInfo(filePath).size()));
+    RecordProperty("bytes_read", static_cast<int>(io->bytesRead()));
+
+    // exiv2 parses TIFFs from a mapping: the pages of the strip are never touched
+    EXPECT_LE(io->bytesRead(), 4096);
+}
+
+#ifdef WITH_QUAZIP
+TEST(DkExivIo, InflatesZipMembersUpToTheHeader)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    QFile jpg(createLargeJpg(tempDir));
+    ASSERT_TRUE(jpg.open(QFile::ReadOnly));
+    const QByteArray data = jpg.readAll();
+    const int headerSize = data.indexOf("\xff\xda");
+    ASSERT_GT(headerSize, 0);
+
+    const QString zipPath = tempDir.filePath("photos.zip");
+    {
+        QuaZip zip(zipPath);
+        ASSERT_TRUE(zip.open(QuaZip::mdCreate));
+        QuaZipFile file(&zip);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly, QuaZipNewInfo("large.jpg")));
+        file.write(data);
+        file.close();
+        zip.close();
+        ASSERT_EQ(zip.getZipError(), UNZ_OK);
+    }
+
+    const DkFileInfoList members = DkFileInfo::readZipArchive(zipPath);
+    ASSERT_EQ(members.size(), 1);
+
+    auto *io = new DkExivIo(members.first());
+    auto exivImg = Exiv2::ImageFactory::open(DkExivIo::Ptr(io));
+    ASSERT_TRUE(exivImg);
+    exivImg->readMetadata();
+
+    const Exiv2::ExifData &exifData = exivImg->exifData();
+    auto pos = exifData.findKey(Exiv2::ExifKey("Exif.Image.Orientation"));
+    ASSERT_NE(pos, exifData.end());
+    EXPECT_EQ(pos->toString(), "6");
+
+    RecordProperty("member_size", data.size());
+    RecordProperty("bytes_read", static_cast<int>(io->bytesRead()));
+
+    // members cannot seek: fetch() inflates in 64 KB chunks up to what exiv2 parsed
+    const qint64 maxRead = headerSize + 64 * 1024 + 4096;
+    ASSERT_GT(data.size(), 10 * maxRead);
+    EXPECT_LE(io->bytesRead(), maxRead);
+    EXPECT_EQ(io->bytesMapped(), 0);
+}
+#endif
+
+TEST(DkExivIo, LoadsMetaDataFromPath)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    DkMetaDataT md;
+    md.readMetaData(DkFileInfo(createLargeJpg(tempDir)));
+
+    EXPECT_TRUE(md.isLoaded());
+    EXPECT_EQ(md.getOrientationDegrees(), 90);
+    EXPECT_EQ(md.getNativeExifValue("Exif.Photo.DateTimeOriginal", false), "2026:10:19 12:00:00");
+}
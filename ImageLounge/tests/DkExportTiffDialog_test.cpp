@@ -0,0 +1,130 @@
+#include "DkDialog.h"
+#include "DkMetaData.h"
+
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#ifdef WITH_LIBTIFF
+#include <tiffio.h>
+
+using namespace nmc;
+
+// page idx (1-based) has size (idx * 10) x (idx * 5)
+static QString createMultiPageTiff(QTemporaryDir &tempDir, int numPages)
+{
+    const QString filePath = tempDir.filePath("scan.tif");
+
+    TIFF *tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "w");
+    EXPECT_NE(tiff, nullptr);
+
+    for (int idx = 1; idx <= numPages; idx++) {
+        QImage img(idx * 10, idx * 5, QImage::Format_RGB888);
+        img.fill(QColor::fromHsv(idx * 40 % 360, 200, 200));
+
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, img.width());
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, img.height());
+        TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+        TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+        TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, FILETYPE_PAGE);
+        TIFFSetField(tiff, TIFFTAG_ARTIST, "nomacs");
+
+        for (int y = 0; y < img.height(); y++)
+            TIFFWriteScanline(tiff, img.scanLine(y), y, 0);
+
+        TIFFWriteDirectory(tiff);
+    }
+
+    TIFFClose(tiff);
+
+    return filePath;
+}
+
+TEST(DkExportTiffDialog, ExportsPageRange)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    DkExportTiffDialog dialog;
+    dialog.setFile(createMultiPageTiff(tempDir, 9));
+
+    // pages are exported by worker threads, the signals are emitted from there
+    std::atomic<int> numUpdates = 0;
+    std::atomic<int> lastProgress = 0;
+    QObject::connect(&dialog, &DkExportTiffDialog::updateProgress, [&](int progress) {
+        numUpdates++;
+        lastProgress = progress;
+    });
+
+    const QString savePath = tempDir.filePath("page-.png");
+    ASSERT_EQ(dialog.exportImages(savePath, 2, 8, false), QDialog::Accepted);
+
+    for (int idx = 1; idx <= 9; idx++) {
+        const QString pagePath = tempDir.filePath(QString("page-%1.png").arg(idx));
+        const bool exported = idx >= 2 && idx <= 8;
+
+        ASSERT_EQ(QFile::exists(pagePath), exported) << pagePath.toStdString();
+        if (exported)
+            EXPECT_EQ(QImageReader(pagePath).size(), QSize(idx * 10, idx * 5));
+    }
+
+    // one update per page, the last one reports the last page
+    EXPECT_EQ(numUpdates, 7);
+    EXPECT_EQ(lastProgress, 8);
+}
+
+TEST(DkExportTiffDialog, SkipsExistingPages)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    DkExportTiffDialog dialog;
+    dialog.setFile(createMultiPageTiff(tempDir, 3));
+
+    // a page that was exported before is kept unless overwriting is checked
+    const QString existing = tempDir.filePath("page-2.png");
+    ASSERT_TRUE(QImage(1, 1, QImage::Format_RGB32).save(existing));
+
+    std::atomic<int> numMessages = 0;
+    QObject::connect(&dialog, &DkExportTiffDialog::infoMessage, [&]() {
+        numMessages++;
+    });
+
+    const QString savePath = tempDir.filePath("page-.png");
+    ASSERT_EQ(dialog.exportImages(savePath, 1, 3, false), QDialog::Accepted);
+    EXPECT_EQ(QImageReader(existing).size(), QSize(1, 1));
+    EXPECT_EQ(numMessages, 1);
+
+    ASSERT_EQ(dialog.exportImages(savePath, 1, 3, true), QDialog::Accepted);
+    EXPECT_EQ(QImageReader(existing).size(), QSize(20, 10));
+}
+
+TEST(DkExportTiffDialog, KeepsMetaData)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    DkExportTiffDialog dialog;
+    dialog.setFile(createMultiPageTiff(tempDir, 3));
+
+    const QString savePath = tempDir.filePath("page-.jpg");
+    ASSERT_EQ(dialog.exportImages(savePath, 1, 3, false), QDialog::Accepted);
+
+    for (int idx = 1; idx <= 3; idx++) {
+        const QString pagePath = tempDir.filePath(QString("page-%1.jpg").arg(idx));
+
+        DkMetaDataT md;
+        md.readMetaData(DkFileInfo(pagePath));
+        EXPECT_EQ(md.getNativeExifValue("Exif.Image.Artist", false), "nomacs") << pagePath.toStdString();
+    }
+}
+
+#endif // WITH_LIBTIFF
@@ -0,0 +1,174 @@
+#include "DkIconAtlas.h"
+
+#include <QFile>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+using namespace nmc;
+
+// anti-aliased edges and semi-transparent fills
+static const char *kCircle = R"(<svg xmlns="http://www.w3.org/2000/svg" width="24" height="24">
+<circle cx="12" cy="12" r="9" fill="#000"/>
+<rect x="3" y="10" width="18" height="4" fill="#000" fill-opacity="0.4"/>
+</svg>)";
+
+static const char *kSquare = R"(<svg xmlns="http://www.w3.org/2000/svg" width="24" height="24">
+<rect x="5" y="5" width="14" height="14" fill="#000" transform="rotate(20 12 12)"/>
+</svg>)";
+
+struct Variant {
+    QSize size;
+    QColor color;
+};
+
+static const QVector<Variant> kVariants = {
+    {QSize(16, 16), Qt::red},
+    {QSize(24, 24), Qt::white},
+    {QSize(48, 48), QColor()},
+    {QSize(31, 17), QColor(0, 128, 255, 100)},
+};
+
+static QString writeSvg(const QTemporaryDir &dir, const char *svg)
+{
+    QString path = dir.filePath("icon.svg");
+
+    QFile file(path);
+    EXPECT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(svg);
+
+    return path;
+}
+
+static QImage renderDirect(const QString &path, const QSize &size, const QColor &color)
+{
+    QImage img(size, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+
+    QPainter painter(&img);
+    QSvgRenderer(path).render(&painter, img.rect());
+
+    if (color.isValid()) {
+        painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        painter.fillRect(img.rect(), color);
+    }
+
+    return img;
+}
+
+TEST(DkIconAtlas, MatchesDirectRendering)
+{
+    QTemporaryDir dir;
+    QString svg = writeSvg(dir, kCircle);
+    QString atlasPath = dir.filePath("icons.atlas");
+
+    {
+        DkIconAtlas atlas(atlasPath);
+        atlas.setTheme("test");
+
+        for (const Variant &v : kVariants)
+            EXPECT_EQ(atlas.icon(svg, v.size, 1.0, v.color), renderDirect(svg, v.size, v.color));
+
+        EXPECT_EQ(atlas.numRendered(), kVariants.size());
+        ASSERT_TRUE(atlas.save());
+    }
+
+    DkIconAtlas atlas(atlasPath);
+    atlas.setTheme("test");
+    ASSERT_EQ(atlas.numIcons(), kVariants.size());
+
+    for (const Variant &v : kVariants) {
+        QImage img = atlas.icon(svg, v.size, 1.0, v.color);
+        EXPECT_EQ(img, renderDirect(svg, v.size, v.color)) << v.size.width() << "x" << v.size.height();
+    }
+
+    // everything came from the atlas
+    EXPECT_EQ(atlas.numRendered(), 0);
+}
+
+TEST(DkIconAtlas, RendersChangedSvgs)
+{
+    QTemporaryDir dir;
+    QString svg = writeSvg(dir, kCircle);
+    QString atlasPath = dir.filePath("icons.atlas");
+
+    {
+        DkIconAtlas atlas(atlasPath);
+        atlas.icon(svg, QSize(24, 24), 1.0, Qt::black);
+        ASSERT_TRUE(atlas.save());
+    }
+
+    writeSvg(dir, kSquare);
+
+    DkIconAtlas atlas(atlasPath);
+    EXPECT_EQ(atlas.icon(svg, QSize(24, 24), 1.0, Qt::black), renderDirect(svg, QSize(24, 24), Qt::black));
+    EXPECT_EQ(atlas.numRendered(), 1);
+}
+
+TEST(DkIconAtlas, ThemeChangeDropsIcons)
+{
+    QTemporaryDir dir;
+    QString svg = writeSvg(dir, kCircle);
+    QString atlasPath = dir.filePath("icons.atlas");
+
+    {
+        DkIconAtlas atlas(atlasPath);
+        atlas.setTheme("light");
+        atlas.icon(svg, QSize(24, 24), 1.0, Qt::black);
+        ASSERT_TRUE(atlas.save());
+    }
+
+    DkIconAtlas atlas(atlasPath);
+    atlas.setTheme("light");
+    EXPECT_EQ(atlas.numIcons(), 1);
+
+    atlas.setTheme("dark");
+    EXPECT_EQ(atlas.numIcons(), 0);
+}
+
+TEST(DkIconAtlas, KeepsDevicePixelRatio)
+{
+    QTemporaryDir dir;
+    QString svg = writeSvg(dir, kCircle);
+    QString atlasPath = dir.filePath("icons.atlas");
+
+    {
+        DkIconAtlas atlas(atlasPath);
+        QImage img = atlas.icon(svg, QSize(48, 48), 2.0, Qt::black);
+        EXPECT_EQ(img.devicePixelRatio(), 2.0);
+        ASSERT_TRUE(atlas.save());
+    }
+
+    DkIconAtlas atlas(atlasPath);
+    QImage img = atlas.icon(svg, QSize(48, 48), 2.0, Qt::black);
+    EXPECT_EQ(img.devicePixelRatio(), 2.0);
+    EXPECT_EQ(img.size(), QSize(48, 48));
+    EXPECT_EQ(atlas.numRendered(), 0);
+}
+
+TEST(DkIconAtlas, DropsLeastRecentlyUsed)
+{
+    QTemporaryDir dir;
+    QString svg = writeSvg(dir, kCircle);
+
+    // room for three 16x16 icons
+    DkIconAtlas atlas(dir.filePath("icons.atlas"), 3 * 16 * 16);
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::red);
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::green);
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::blue);
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::red);
+    EXPECT_EQ(atlas.numRendered(), 3);
+
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::white);
+    EXPECT_EQ(atlas.numIcons(), 3);
+    EXPECT_EQ(atlas.numPixels(), 3 * 16 * 16);
+
+    // green was used least recently
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::red);
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::blue);
+    EXPECT_EQ(atlas.numRendered(), 4);
+    atlas.icon(svg, QSize(16, 16), 1.0, Qt::green);
+    EXPECT_EQ(atlas.numRendered(), 5);
+}
@@ -0,0 +1,144 @@
+#include "DkBasicLoader.h"
+#include "DkFileInfo.h"
+#include "DkImageCache.h"
+
+#include <QImage>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+using namespace nmc;
+
+static QString createPng(QTemporaryDir &tempDir, const QString &name, int size = 64)
+{
+    QImage img(size, size, QImage::Format_RGB32);
+    img.fill(Qt::darkCyan);
+
+    const QString filePath = tempDir.filePath(name);
+    EXPECT_TRUE(img.save(filePath, "PNG"));
+
+    return filePath;
+}
+
+static DkImageCache::Entry createEntry(int size)
+{
+    DkImageCache::Entry entry;
+    entry.image = QImage(size, size, QImage::Format_RGB32);
+    entry.image.fill(Qt::white);
+
+    return entry;
+}
+
+class DkImageCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        DkImageCache::instance().clear();
+        DkImageCache::instance().setMaxMemory(1024 * 1024);
+    }
+
+    void TearDown() override
+    {
+        DkImageCache::instance().clear();
+        DkImageCache::instance().setMaxMemory(-1);
+    }
+};
+
+TEST_F(DkImageCacheTest, LoadersShareDecodedImage)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createPng(tempDir, "shared.png");
+    const DkLoadOptions options = DkLoadOption::highquality | DkLoadOption::cached;
+
+    DkBasicLoader a;
+    DkBasicLoader b;
+    ASSERT_TRUE(a.loadGeneral(filePath, options));
+    ASSERT_TRUE(b.loadGeneral(filePath, options));
+
+    // the second tab must not hold its own copy of the pixels
+    EXPECT_EQ(a.image().constBits(), b.image().constBits());
+    EXPECT_EQ(DkImageCache::instance().size(), 1);
+    EXPECT_EQ(DkImageCache::instance().memoryUsage(), a.image().sizeInBytes());
+    EXPECT_EQ(DkImageCache::instance().pinnedMemory(), a.image().sizeInBytes());
+
+    // loaders that do not ask for the cache decode on their own
+    DkBasicLoader c;
+    ASSERT_TRUE(c.loadGeneral(filePath, DkLoadOption::highquality));
+    EXPECT_NE(a.image().constBits(), c.image().constBits());
+}
+
+TEST_F(DkImageCacheTest, KeyFollowsFileIdentity)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createPng(tempDir, "identity.png");
+
+    DkImageCache::Key key = DkImageCache::key(DkFileInfo(filePath), 0, 0);
+    ASSERT_TRUE(key.isValid());
+    EXPECT_EQ(key, DkImageCache::key(DkFileInfo(filePath), 0, 0));
+    EXPECT_NE(qHash(key), qHash(DkImageCache::key(DkFileInfo(filePath), 2, 0)));
+
+    EXPECT_FALSE(DkImageCache::key(DkFileInfo(tempDir.filePath("missing.png")), 0, 0).isValid());
+
+    // replaced files must not hit old entries
+    DkImageCache::instance().insert(key, createEntry(16));
+    createPng(tempDir, "identity.png", 32);
+
+    DkImageCache::Entry entry;
+    EXPECT_FALSE(DkImageCache::instance().find(DkImageCache::key(DkFileInfo(filePath), 0, 0), entry));
+}
+
+TEST_F(DkImageCacheTest, EvictsUnusedImagesFirst)
+{
+    auto key = [](int idx) {
+        DkImageCache::Key k;
+        k.path = QString("image-%1.png").arg(idx);
+        k.size = 1;
+        return k;
+    };
+
+    // 256x256 RGB32 = 256 kB, four fit into the cache
+    DkImageCache::Entry displayed = createEntry(256);
+    DkImageCache::instance().insert(key(0), displayed);
+
+    for (int idx = 1; idx < 4; idx++)
+        DkImageCache::instance().insert(key(idx), createEntry(256));
+
+    EXPECT_EQ(DkImageCache::instance().size(), 4);
+    EXPECT_EQ(DkImageCache::instance().memoryUsage(), 1024 * 1024);
+
+    // the oldest entry is still displayed, the next one is evicted instead
+    DkImageCache::instance().insert(key(4), createEntry(256));
+
+    DkImageCache::Entry entry;
+    EXPECT_TRUE(DkImageCache::instance().find(key(0), entry));
+    EXPECT_FALSE(DkImageCache::instance().find(key(1), entry));
+    EXPECT_EQ(DkImageCache::instance().memoryUsage(), 1024 * 1024);
+
+    // images larger than the budget are never cached
+    DkImageCache::instance().insert(key(5), createEntry(1024));
+    EXPECT_FALSE(DkImageCache::instance().find(key(5), entry));
+}
+
+TEST_F(DkImageCacheTest, PinnedMemoryIgnoresOwnImages)
+{
+    DkImageCache::Key own;
+    own.path = "own.png";
+    own.size = 1;
+
+    DkImageCache::Key other = own;
+    other.path = "other.png";
+
+    // both images are still displayed, one by the caller and one by another tab
+    DkImageCache::Entry ownEntry = createEntry(256);
+    DkImageCache::Entry otherEntry = createEntry(256);
+    DkImageCache::instance().insert(own, ownEntry);
+    DkImageCache::instance().insert(other, otherEntry);
+
+    EXPECT_EQ(DkImageCache::instance().pinnedMemory(), 512 * 1024);
+    EXPECT_EQ(DkImageCache::instance().pinnedMemory({ownEntry.image.cacheKey()}), 256 * 1024);
+}
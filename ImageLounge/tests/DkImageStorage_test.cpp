@@ -0,0 +1,86 @@
+#include "DkImageStorage.h"
+#include "DkMath.h"
+
+#include <QImage>
+#include <QTransform>
+
+#include <gtest/gtest.h>
+
+using namespace nmc;
+
+static DkRotatingRect rotatedRect(const QRectF &rect, double angle)
+{
+    QTransform t;
+    t.translate(rect.center().x(), rect.center().y());
+    t.rotate(angle);
+    t.translate(-rect.center().x(), -rect.center().y());
+
+    // getTransform() expects the corners top left, bottom left, bottom right, top right
+    QPolygonF poly = t.map(QPolygonF({rect.topLeft(), rect.bottomLeft(), rect.bottomRight(), rect.topRight()}));
+    DkRotatingRect r;
+    r.setPoly(poly);
+    return r;
+}
+
+TEST(DkImageStorage, RotatedCropKeepsFormat)
+{
+    QImage img(400, 300, QImage::Format_RGBA64);
+    img.fill(QColor(10, 200, 60));
+
+    QImage crop = DkImage::cropToImage(img, rotatedRect(QRectF(100, 80, 200, 140), 7.5));
+
+    ASSERT_EQ(crop.format(), QImage::Format_RGBA64);
+    EXPECT_NEAR(crop.width(), 200, 1);
+    EXPECT_NEAR(crop.height(), 140, 1);
+
+    // the crop is inside the image, nothing is filled
+    for (int y = 0; y < crop.height(); y++) {
+        for (int x = 0; x < crop.width(); x++) {
+            QRgba64 c = crop.pixelColor(x, y).rgba64();
+            ASSERT_NEAR(c.red(), 10 * 257, 1);
+            ASSERT_NEAR(c.green(), 200 * 257, 1);
+            ASSERT_EQ(c.alpha(), 65535);
+        }
+    }
+}
+
+TEST(DkImageStorage, CropOutsideIsFilled)
+{
+    QImage img(64, 64, QImage::Format_RGB888);
+    img.fill(Qt::white);
+
+    QImage crop = DkImage::cropToImage(img, rotatedRect(QRectF(32, 32, 64, 64), 0), Qt::red);
+
+    ASSERT_EQ(crop.format(), QImage::Format_RGB888);
+    ASSERT_EQ(crop.size(), QSize(64, 64));
+    EXPECT_EQ(crop.pixel(0, 0), qRgb(255, 255, 255));
+    EXPECT_EQ(crop.pixel(31, 31), qRgb(255, 255, 255));
+    EXPECT_EQ(crop.pixel(32, 0), qRgb(255, 0, 0));
+    EXPECT_EQ(crop.pixel(63, 63), qRgb(255, 0, 0));
+}
+
+TEST(DkImageStorage, RotationHasNoDarkFringe)
+{
+    QImage img(120, 80, QImage::Format_ARGB32);
+    img.fill(Qt::white);
+
+    QImage rotated = DkImage::rotateImage(img, 30);
+    ASSERT_FALSE(rotated.isNull());
+    ASSERT_TRUE(rotated.hasAlphaChannel());
+
+    // corners are transparent, edges blend alpha but never color
+    EXPECT_EQ(qAlpha(rotated.pixel(0, 0)), 0);
+    int numTransparent = 0;
+    for (int y = 0; y < rotated.height(); y++) {
+        for (int x = 0; x < rotated.width(); x++) {
+            QRgb c = rotated.pixel(x, y);
+            if (qAlpha(c) < 8) {
+                numTransparent++;
+                continue;
+            }
+            ASSERT_GE(qRed(c), 250) << x << "," << y;
+            ASSERT_GE(qBlue(c), 250) << x << "," << y;
+        }
+    }
+    EXPECT_GT(numTransparent, 0);
+}
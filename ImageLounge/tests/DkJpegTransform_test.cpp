@@ -0,0 +1,266 @@
+#include "DkJpegTransform.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QTransform>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace nmc;
+
+// grayscale JPEGs decode without chroma upsampling which is not symmetric
+static QImage createTestImage(int width, int height, bool gray = false)
+{
+    QImage img(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++)
+            img.setPixel(x, y, qRgb(x * 255 / width, y * 255 / height, (x + y) % 2 ? 255 : 0));
+    }
+
+    return gray ? img.convertToFormat(QImage::Format_Grayscale8) : img;
+}
+
+// smooth colors, chroma subsampling is then (almost) symmetric
+static QImage createColorImage(int width, int height)
+{
+    QImage img(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++)
+            img.setPixel(x, y, qRgb(x * 255 / width, y * 255 / height, (x + y) * 255 / (width + height)));
+    }
+
+    return img;
+}
+
+static QByteArray encodeJpeg(const QImage &img)
+{
+    QByteArray ba;
+    QBuffer buffer(&ba);
+    buffer.open(QIODevice::WriteOnly);
+    EXPECT_TRUE(img.save(&buffer, "JPG", 90));
+
+    return ba;
+}
+
+static QByteArray applyTransform(const QByteArray &src, DkJpegTransform::Transform t)
+{
+    DkJpegTransform transform;
+    EXPECT_TRUE(transform.setSource(src));
+    EXPECT_TRUE(transform.addTransform(t));
+
+    QByteArray dst;
+    EXPECT_TRUE(transform.apply(dst)) << transform.errorString().toStdString();
+
+    return dst;
+}
+
+static int maxDifference(const QImage &a, const QImage &b)
+{
+    int diff = 0;
+    for (int y = 0; y < a.height(); y++) {
+        for (int x = 0; x < a.width(); x++) {
+            diff = qMax(diff, qAbs(qGray(a.pixel(x, y)) - qGray(b.pixel(x, y))));
+        }
+    }
+
+    return diff;
+}
+
+// largest difference of all color channels
+static int maxColorDifference(const QImage &a, const QImage &b)
+{
+    int diff = 0;
+    for (int y = 0; y < a.height(); y++) {
+        for (int x = 0; x < a.width(); x++) {
+            const QRgb pa = a.pixel(x, y);
+            const QRgb pb = b.pixel(x, y);
+            diff = qMax(diff, qAbs(qRed(pa) - qRed(pb)));
+            diff = qMax(diff, qAbs(qGreen(pa) - qGreen(pb)));
+            diff = qMax(diff, qAbs(qBlue(pa) - qBlue(pb)));
+        }
+    }
+
+    return diff;
+}
+
+// rewrites all quantization tables with 16 bit precision and raises one value above 255
+static QByteArray toPreciseTables(const QByteArray &src)
+{
+    QByteArray dst = src.left(2);
+    int pos = 2;
+
+    while (pos + 4 <= src.size()) {
+        const auto marker = static_cast<uchar>(src[pos + 1]);
+        const int length = (static_cast<uchar>(src[pos + 2]) << 8) | static_cast<uchar>(src[pos + 3]);
+
+        if (marker != 0xDB) {
+            // the scan data follows SOS, copy the rest as is
+            const int end = marker == 0xDA ? src.size() : pos + 2 + length;
+            dst.append(src.mid(pos, end - pos));
+            pos = end;
+            continue;
+        }
+
+        QByteArray tables;
+        for (int i = pos + 4; i + 65 <= pos + 2 + length; i += 65) {
+            tables.append(static_cast<char>(0x10 | (src[i] & 0x0F)));
+            for (int k = 0; k < 64; k++) {
+                const int q = k == 63 ? 300 : static_cast<uchar>(src[i + 1 + k]);
+                tables.append(static_cast<char>(q >> 8));
+                tables.append(static_cast<char>(q & 0xFF));
+            }
+        }
+
+        dst.append(static_cast<char>(0xFF));
+        dst.append(static_cast<char>(0xDB));
+        dst.append(static_cast<char>((tables.size() + 2) >> 8));
+        dst.append(static_cast<char>((tables.size() + 2) & 0xFF));
+        dst.append(tables);
+        pos += 2 + length;
+    }
+
+    return dst;
+}
+
+TEST(DkJpegTransform, RotateMatchesPixelRotation)
+{
+    QByteArray src = encodeJpeg(createTestImage(128, 64, true));
+    QByteArray dst = applyTransform(src, DkJpegTransform::transform_rotate_90);
+
+    QImage expected = QImage::fromData(src).transformed(QTransform().rotate(90));
+    QImage result = QImage::fromData(dst);
+
+    ASSERT_EQ(result.size(), QSize(64, 128));
+    // only IDCT rounding may differ
+    EXPECT_LE(maxDifference(result, expected), 4);
+}
+
+TEST(DkJpegTransform, ColorTransformsMatchPixelTransforms)
+{
+    QByteArray src = encodeJpeg(createColorImage(128, 64));
+    const QImage decoded = QImage::fromData(src);
+    ASSERT_FALSE(decoded.isNull());
+
+    const QImage rotated = QImage::fromData(applyTransform(src, DkJpegTransform::transform_rotate_90));
+    ASSERT_EQ(rotated.size(), QSize(64, 128));
+    EXPECT_LE(maxColorDifference(rotated, decoded.transformed(QTransform().rotate(90))), 6);
+
+    const QImage flipped = QImage::fromData(applyTransform(src, DkJpegTransform::transform_flip_h));
+    ASSERT_EQ(flipped.size(), decoded.size());
+    EXPECT_LE(maxColorDifference(flipped, decoded.transformed(QTransform().scale(-1, 1))), 6);
+
+    DkJpegTransform transform;
+    ASSERT_TRUE(transform.setSource(src));
+    ASSERT_TRUE(transform.setCrop(QRect(32, 16, 50, 40)));
+
+    QByteArray dst;
+    ASSERT_TRUE(transform.apply(dst));
+
+    const QImage cropped = QImage::fromData(dst);
+    ASSERT_EQ(cropped.size(), QSize(50, 40));
+    EXPECT_LE(maxColorDifference(cropped, decoded.copy(32, 16, 50, 40)), 6);
+}
+
+TEST(DkJpegTransform, PreciseTablesAreNotBaseline)
+{
+    QByteArray src = toPreciseTables(encodeJpeg(createColorImage(64, 64)));
+    ASSERT_FALSE(QImage::fromData(src).isNull());
+
+    QByteArray dst = applyTransform(src, DkJpegTransform::transform_rotate_90);
+
+    // 16 bit quantization tables require an extended sequential frame
+    EXPECT_TRUE(dst.contains("\xff\xc1"));
+    EXPECT_FALSE(dst.contains("\xff\xc0"));
+
+    const QImage expected = QImage::fromData(src).transformed(QTransform().rotate(90));
+    const QImage result = QImage::fromData(dst);
+    ASSERT_EQ(result.size(), expected.size());
+    EXPECT_LE(maxColorDifference(result, expected), 6);
+}
+
+TEST(DkJpegTransform, FullRotationIsBitExact)
+{
+    QByteArray src = encodeJpeg(createTestImage(96, 48));
+    QByteArray reference = applyTransform(src, DkJpegTransform::transform_none);
+
+    QByteArray dst = src;
+    for (int idx = 0; idx < 4; idx++)
+        dst = applyTransform(dst, DkJpegTransform::transform_rotate_90);
+
+    EXPECT_EQ(dst, reference);
+}
+
+TEST(DkJpegTransform, ComposesOrientation)
+{
+    EXPECT_EQ(DkJpegTransform::fromOrientation(90, true), DkJpegTransform::transform_transpose);
+    EXPECT_EQ(DkJpegTransform::fromOrientation(-90, false), DkJpegTransform::transform_rotate_270);
+
+    for (int t = 0; t < DkJpegTransform::transform_end; t++) {
+        int degrees = 0;
+        bool mirrored = false;
+        DkJpegTransform::toOrientation(static_cast<DkJpegTransform::Transform>(t), degrees, mirrored);
+        EXPECT_EQ(DkJpegTransform::fromOrientation(degrees, mirrored), t);
+    }
+}
+
+TEST(DkJpegTransform, RejectsPartialEdgeBlocks)
+{
+    QByteArray src = encodeJpeg(createTestImage(100, 60));
+
+    DkJpegTransform transform;
+    ASSERT_TRUE(transform.setSource(src));
+    transform.addTransform(DkJpegTransform::transform_flip_h);
+    EXPECT_FALSE(transform.isPerfect());
+
+    QByteArray dst;
+    EXPECT_FALSE(transform.apply(dst));
+
+    transform.setTrim(true);
+    ASSERT_TRUE(transform.apply(dst));
+    EXPECT_EQ(QImage::fromData(dst).size(), QSize(96, 60));
+}
+
+TEST(DkJpegTransform, CropsAlignedRectangles)
+{
+    QByteArray src = encodeJpeg(createTestImage(128, 128, true));
+
+    DkJpegTransform transform;
+    ASSERT_TRUE(transform.setSource(src));
+    EXPECT_FALSE(transform.setCrop(QRect(3, 0, 32, 32)));
+    EXPECT_TRUE(transform.setCrop(QRect(32, 16, 50, 70)));
+    EXPECT_EQ(transform.size(), QSize(50, 70));
+
+    QByteArray dst;
+    ASSERT_TRUE(transform.apply(dst));
+
+    QImage expected = QImage::fromData(src).copy(32, 16, 50, 70);
+    QImage result = QImage::fromData(dst);
+    ASSERT_EQ(result.size(), expected.size());
+    EXPECT_LE(maxDifference(result, expected), 4);
+}
+
+TEST(DkJpegTransform, RejectsOversubscribedHuffmanTable)
+{
+    QByteArray src = encodeJpeg(createTestImage(64, 64, true));
+
+    // three 1 bit codes in the first table, the symbol count stays the same
+    const int dht = src.indexOf("\xff\xc4");
+    ASSERT_GT(dht, 0);
+    auto *counts = reinterpret_cast<uchar *>(src.data()) + dht + 5;
+    int numSymbols = 0;
+    for (int k = 0; k < 16; k++)
+        numSymbols += counts[k];
+    ASSERT_GE(numSymbols, 3);
+
+    std::fill(counts, counts + 16, 0);
+    counts[0] = 3;
+    counts[15] = static_cast<uchar>(numSymbols - 3);
+
+    DkJpegTransform transform;
+    QByteArray dst;
+    bool applied = transform.setSource(src) && transform.addTransform(DkJpegTransform::transform_rotate_90)
+        && transform.apply(dst);
+    EXPECT_FALSE(applied);
+}
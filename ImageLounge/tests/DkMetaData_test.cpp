@@ -1,6 +1,10 @@
+#include "DkBasicLoader.h"
 #include "DkFileInfo.h"
 #include "DkMetaData.h"
+#include "DkMetaDataWriter.h"
 
+#include <QElapsedTimer>
+#include <QFile>
 #include <QImage>
 #include <QTemporaryDir>
 
@@ -19,6 +23,54 @@ static QString createEmptyMetadataPng(QTemporaryDir &tempDir)
     return filePath;
 }
 
+static QString createEmptyMetadataJpg(QTemporaryDir &tempDir)
+{
+    QImage img(64, 64, QImage::Format_RGB32);
+    img.fill(Qt::darkGreen);
+
+    const QString filePath = tempDir.filePath("empty-metadata.jpg");
+    EXPECT_TRUE(img.save(filePath, "JPG"));
+
+    return filePath;
+}
+
+// PNG stores XMP in an iTXt chunk, so it is not limited to a single JPEG segment
+static QString createLargeMetadataPng(QTemporaryDir &tempDir, int numTags)
+{
+    const QString filePath = createEmptyMetadataPng(tempDir);
+
+    auto img = Exiv2::ImageFactory::open(filePath.toStdString());
+    img->readMetadata();
+
+    Exiv2::XmpData &xmpData = img->xmpData();
+    for (int idx = 0; idx < numTags; idx++)
+        xmpData["Xmp.xmp.Tag" + std::to_string(idx)] = "value " + std::to_string(idx);
+    xmpData["Xmp.xmp.Rating"] = "3";
+
+    Exiv2::ExifData &exifData = img->exifData();
+    exifData["Exif.Image.Orientation"] = static_cast<uint16_t>(6);
+    exifData["Exif.Photo.DateTimeOriginal"] = "2026:10:19 12:00:00";
+
+    img->writeMetadata();
+
+    return filePath;
+}
+
+static QByteArray readFile(const QString &filePath)
+{
+    QFile file(filePath);
+    EXPECT_TRUE(file.open(QFile::ReadOnly));
+    return file.readAll();
+}
+
+static int readRating(const QString &filePath, bool useSidecar = false)
+{
+    DkMetaDataT md;
+    md.setUseSidecar(useSidecar);
+    md.readMetaData(DkFileInfo(filePath));
+    return md.getRating();
+}
+
 TEST(DkMetadata, SetExifValueOnEmptyMetadata)
 {
     QTemporaryDir tempDir;
@@ -139,3 +191,175 @@ TEST(DkMetaData, ClearExifStateResetsDirtyFlagAfterRatingChange)
     EXPECT_TRUE(meta.isDirty());
     EXPECT_EQ(meta.getRating(), -1);
 }
+
+TEST(DkMetaData, RatingIsUpdatedInPlace)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createEmptyMetadataJpg(tempDir);
+
+    {
+        // there are no metadata segments yet, so the file is rewritten
+        DkMetaDataT md;
+        md.readMetaData(DkFileInfo(filePath));
+        ASSERT_TRUE(md.setRating(3));
+        EXPECT_FALSE(md.saveMetaDataInPlace(DkFileInfo(filePath)));
+        EXPECT_TRUE(md.saveMetaData(DkFileInfo(filePath)));
+    }
+
+    const QByteArray before = readFile(filePath);
+    const int sos = before.indexOf("\xff\xda");
+    ASSERT_GT(sos, 0);
+
+    {
+        DkMetaDataT md;
+        md.readMetaData(DkFileInfo(filePath));
+        ASSERT_TRUE(md.setRating(4));
+        EXPECT_TRUE(md.saveMetaDataInPlace(DkFileInfo(filePath)));
+        EXPECT_FALSE(md.isDirty());
+    }
+
+    // only the header changed
+    const QByteArray after = readFile(filePath);
+    ASSERT_EQ(after.size(), before.size());
+    EXPECT_EQ(after.mid(sos), before.mid(sos));
+    EXPECT_NE(after, before);
+    EXPECT_EQ(readRating(filePath), 4);
+}
+
+TEST(DkMetaData, InPlaceUpdateClearsFileBuffer)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createEmptyMetadataJpg(tempDir);
+    {
+        // add the metadata segments
+        DkMetaDataT md;
+        md.readMetaData(DkFileInfo(filePath));
+        ASSERT_TRUE(md.setRating(3));
+        ASSERT_TRUE(md.saveMetaData(DkFileInfo(filePath)));
+    }
+
+    DkBasicLoader loader;
+    ASSERT_TRUE(loader.loadGeneral(filePath));
+    ASSERT_TRUE(loader.getMetaData()->setRating(4));
+
+    // the container's buffer
+    QSharedPointer<QByteArray> buffer(new QByteArray(readFile(filePath)));
+    QSharedPointer<QByteArray> ba = buffer;
+    loader.saveMetaData(filePath, ba);
+
+    EXPECT_EQ(readRating(filePath), 4);
+    EXPECT_TRUE(buffer->isEmpty());
+}
+
+TEST(DkMetaData, SidecarKeepsImageUntouched)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createEmptyMetadataJpg(tempDir);
+    const QByteArray before = readFile(filePath);
+
+    DkMetaDataT md;
+    md.setUseSidecar(true);
+    md.readMetaData(DkFileInfo(filePath));
+    ASSERT_TRUE(md.setRating(2));
+    EXPECT_TRUE(md.saveMetaData(DkFileInfo(filePath)));
+
+    EXPECT_EQ(readFile(filePath), before);
+    EXPECT_TRUE(QFile::exists(tempDir.filePath("empty-metadata.xmp")));
+    EXPECT_EQ(readRating(filePath, true), 2);
+    EXPECT_EQ(readRating(filePath), -1);
+}
+
+TEST(DkMetaData, WriterCoalescesRatings)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createEmptyMetadataJpg(tempDir);
+
+    QSharedPointer<DkMetaDataT> md(new DkMetaDataT());
+    md->readMetaData(DkFileInfo(filePath));
+
+    DkMetaDataWriter &writer = DkMetaDataWriter::instance();
+    writer.waitForFinished();
+    const int numWrites = writer.numWrites();
+
+    // hold the writer so that the worker cannot pick up the first rating before the burst is queued
+    writer.setHold(true);
+
+    for (int rating = 1; rating <= 5; rating++) {
+        ASSERT_TRUE(md->setRating(rating));
+        writer.enqueue(DkFileInfo(filePath), md);
+    }
+
+    writer.waitForFinished();
+    EXPECT_TRUE(writer.isPending(filePath));
+    EXPECT_EQ(writer.numWrites(), numWrites);
+
+    writer.setHold(false);
+    writer.waitForFinished();
+
+    EXPECT_FALSE(writer.isPending(filePath));
+    EXPECT_EQ(writer.numWrites(), numWrites + 1);
+    EXPECT_EQ(readRating(filePath), 5);
+}
+
+// reads the metadata and looks up every xmp tag like the metadata dock does, returns the time in ns
+static qint64 lookupAllTags(const QString &filePath, DkMetaDataT &md, int &numFound)
+{
+    QElapsedTimer dt;
+    dt.start();
+
+    md.readMetaData(DkFileInfo(filePath));
+    const QVector<DkMetaDataT::Tag> tags = md.tags();
+
+    // this is what the metadata dock used to do: one findKey() per tag
+    numFound = 0;
+    for (const DkMetaDataT::Tag &tag : tags) {
+        if (tag.family == DkMetaDataT::family_xmp && !md.getXmpValue(tag.key).isEmpty())
+            numFound++;
+    }
+
+    return dt.nsecsElapsed();
+}
+
+TEST(DkMetaData, TagSnapshotIsLinear)
+{
+    QTemporaryDir smallDir;
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(smallDir.isValid() && tempDir.isValid());
+
+    const int numSmall = 1000;
+    const int numTags = 8 * numSmall;
+
+    DkMetaDataT small;
+    int numFoundSmall = 0;
+    const qint64 elapsedSmall = lookupAllTags(createLargeMetadataPng(smallDir, numSmall), small, numFoundSmall);
+
+    DkMetaDataT md;
+    int numFound = 0;
+    const qint64 elapsed = lookupAllTags(createLargeMetadataPng(tempDir, numTags), md, numFound);
+
+    EXPECT_EQ(numFoundSmall, numSmall + 1);
+    EXPECT_EQ(md.tags().size(), numTags + 3);
+    EXPECT_EQ(numFound, numTags + 1);
+    EXPECT_EQ(md.getXmpValue("Xmp.xmp.Tag4711"), "value 4711");
+    EXPECT_EQ(md.getRating(), 3);
+    EXPECT_EQ(md.getOrientationDegrees(), 90);
+    EXPECT_EQ(md.getExifValue("DateTimeOriginal"), "2026:10:19 12:00:00");
+
+    // 8x the tags: linear lookups take ~8x as long, quadratic ones ~64x
+    const qint64 minElapsed = 1000000; // 1 ms, timer resolution & noise on tiny inputs
+    EXPECT_LT(elapsed, 24 * qMax(elapsedSmall, minElapsed))
+        << numSmall << " tags: " << elapsedSmall / 1000 << " us, " << numTags << " tags: " << elapsed / 1000 << " us";
+
+    // edits invalidate the snapshot
+    ASSERT_TRUE(md.setRating(5));
+    EXPECT_EQ(md.getRating(), 5);
+    EXPECT_EQ(md.getXmpValue("Xmp.xmp.Rating"), "5");
+}
@@ -0,0 +1,110 @@
+#include "DkMosaicIndex.h"
+
+#include <QFile>
+#include <QImage>
+#include <QSet>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+using namespace nmc;
+
+static DkMosaicIndex::Entry flatEntry(const QString &name, uint8_t l)
+{
+    DkMosaicIndex::Entry e;
+    e.filePath = name;
+    e.lab = {float(l), 128.0f, 128.0f};
+    e.signature.fill(l);
+    return e;
+}
+
+TEST(DkMosaicIndex, SaveLoadRoundTrip)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    DkMosaicIndex index({flatEntry("a.jpg", 10), flatEntry("b.jpg", 200)});
+    ASSERT_EQ(index.size(), 2);
+
+    QString path = dir.path() + "/copy.idx";
+    ASSERT_TRUE(index.save(path));
+
+    DkMosaicIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    ASSERT_EQ(loaded.size(), 2);
+    EXPECT_EQ(loaded.entries()[1].filePath, "b.jpg");
+    EXPECT_EQ(loaded.entries()[1].signature, index.entries()[1].signature);
+}
+
+TEST(DkMosaicIndex, RejectsCorruptCount)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    // save creates missing directories, cachePath() does not touch the disk
+    QString path = dir.path() + "/mosaic/corrupt.idx";
+    ASSERT_TRUE(DkMosaicIndex({flatEntry("a.jpg", 10)}).save(path));
+
+    // magic, version and signature size come first, then the number of entries
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    ASSERT_TRUE(file.seek(12));
+    ASSERT_EQ(file.write(QByteArray("\x7f\xff\xff\xff", 4)), 4);
+    file.close();
+
+    DkMosaicIndex loaded({flatEntry("b.jpg", 20)});
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_EQ(loaded.size(), 1);
+}
+
+TEST(DkMosaicIndex, AssignsNearestUniqueEntries)
+{
+    QVector<DkMosaicIndex::Entry> entries;
+    for (int idx = 0; idx < 256; idx += 4)
+        entries.append(flatEntry(QString::number(idx), uint8_t(idx)));
+    DkMosaicIndex index(entries);
+
+    // two cells want the same entry, one of them gets the second best
+    QVector<DkMosaicIndex::Entry> cells = {flatEntry("c0", 100), flatEntry("c1", 100), flatEntry("c2", 13)};
+    QVector<int> assignment = index.assign(cells);
+
+    ASSERT_EQ(assignment.size(), 3);
+    EXPECT_EQ(QSet<int>(assignment.begin(), assignment.end()).size(), 3);
+    EXPECT_EQ(assignment[0], 25); // 100
+    EXPECT_TRUE(assignment[1] == 24 || assignment[1] == 26); // 96 or 104
+    EXPECT_EQ(assignment[2], 3); // 12
+}
+
+TEST(DkMosaicIndex, RepeatsEntriesIfTooFew)
+{
+    DkMosaicIndex index({flatEntry("dark", 20), flatEntry("bright", 230)});
+
+    QVector<DkMosaicIndex::Entry> cells;
+    for (int idx = 0; idx < 10; idx++)
+        cells.append(flatEntry("c", idx % 2 ? 240 : 10));
+
+    QVector<int> assignment = index.assign(cells);
+    for (int idx = 0; idx < cells.size(); idx++)
+        EXPECT_EQ(assignment[idx], idx % 2 ? 1 : 0);
+}
+
+#ifdef WITH_OPENCV
+TEST(DkMosaicIndex, DescribesCells)
+{
+    QImage img(64, 32, QImage::Format_RGB32);
+    img.fill(Qt::black);
+    for (int y = 0; y < 32; y++) {
+        for (int x = 32; x < 64; x++)
+            img.setPixel(x, y, qRgb(255, 255, 255));
+    }
+
+    QVector<DkMosaicIndex::Entry> cells = DkMosaicIndex::describeCells(img, QSize(2, 1));
+    ASSERT_EQ(cells.size(), 2);
+    EXPECT_LT(cells[0].lab[0], 5.0f);
+    EXPECT_GT(cells[1].lab[0], 250.0f);
+
+    std::optional<DkMosaicIndex::Entry> e = DkMosaicIndex::describe(img);
+    ASSERT_TRUE(e);
+    EXPECT_LT(e->signature.front(), e->signature.back()); // left is dark, right is bright
+}
+#endif
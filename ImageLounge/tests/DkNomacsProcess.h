@@ -0,0 +1,97 @@
+#pragma once
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QSettings>
+#include <QTemporaryDir>
+
+#include <functional>
+
+#ifdef NMC_EXECUTABLE
+
+/**
+ * Runs the nomacs executable like a user would: on the offscreen platform,
+ * with its settings and caches in a temporary home.
+ **/
+class DkNomacsProcess
+{
+public:
+    DkNomacsProcess()
+    {
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.insert("QT_QPA_PLATFORM", "offscreen");
+        env.insert("HOME", mHome.path());
+        env.insert("XDG_CONFIG_HOME", configPath());
+        env.insert("XDG_CACHE_HOME", QDir(mHome.path()).filePath(".cache"));
+        env.insert("XDG_DATA_HOME", QDir(mHome.path()).filePath(".local/share"));
+
+        mProcess.setProcessEnvironment(env);
+        mProcess.setStandardOutputFile(QProcess::nullDevice());
+        mProcess.setStandardErrorFile(QProcess::nullDevice());
+    }
+
+    ~DkNomacsProcess()
+    {
+        if (mProcess.state() != QProcess::NotRunning) {
+            mProcess.kill();
+            mProcess.waitForFinished();
+        }
+    }
+
+    bool isValid() const
+    {
+        return mHome.isValid();
+    }
+
+    QString homePath() const
+    {
+        return mHome.path();
+    }
+
+    QString filePath(const QString &fileName) const
+    {
+        return mHome.filePath(fileName);
+    }
+
+    // written before the start: ~/.config/nomacs/Image Lounge.conf
+    void setValue(const QString &key, const QVariant &value)
+    {
+        QSettings settings(QDir(configPath()).filePath("nomacs/Image Lounge.conf"), QSettings::IniFormat);
+        settings.setValue(key, value);
+    }
+
+    bool start(const QStringList &arguments)
+    {
+        mProcess.start(NMC_EXECUTABLE, arguments);
+        return mProcess.waitForStarted();
+    }
+
+    QProcess &process()
+    {
+        return mProcess;
+    }
+
+    // processes events, the test may be the other end of a connection
+    static bool waitFor(const std::function<bool()> &done, int timeout = 20000)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (!done() && timer.elapsed() < timeout)
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+        return done();
+    }
+
+private:
+    QString configPath() const
+    {
+        return QDir(mHome.path()).filePath(".config");
+    }
+
+    QTemporaryDir mHome;
+    QProcess mProcess;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "../plugins/PaintPlugin/src/DkPaintLayer.h"
+
+#include <QPainterPath>
+#include <QPen>
+
+#include <gtest/gtest.h>
+
+using namespace nmp;
+
+// a wide stroke crossing several tiles
+static void drawStroke(QPainter &painter)
+{
+    QPainterPath path(QPointF(20.5, 30.25));
+    path.cubicTo(QPointF(300, -50), QPointF(250, 500), QPointF(580.5, 370));
+    path.lineTo(QPointF(40, 350));
+
+    painter.setPen(QPen(QColor(200, 30, 90, 180), 13, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    painter.drawPath(path);
+}
+
+static QImage transparentImage(const QSize &size)
+{
+    QImage img(size, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+    return img;
+}
+
+// largest difference of all channels
+static int maxDifference(const QImage &a, const QImage &b)
+{
+    int diff = 0;
+    for (int y = 0; y < a.height(); y++) {
+        for (int x = 0; x < a.width(); x++) {
+            const QRgb pa = a.pixel(x, y);
+            const QRgb pb = b.pixel(x, y);
+            diff = qMax(diff, qAbs(qRed(pa) - qRed(pb)));
+            diff = qMax(diff, qAbs(qGreen(pa) - qGreen(pb)));
+            diff = qMax(diff, qAbs(qBlue(pa) - qBlue(pb)));
+            diff = qMax(diff, qAbs(qAlpha(pa) - qAlpha(pb)));
+        }
+    }
+
+    return diff;
+}
+
+TEST(DkPaintLayer, MatchesDirectPainting)
+{
+    const QSize size(600, 400);
+
+    QImage expected = transparentImage(size);
+    {
+        QPainter painter(&expected);
+        painter.setRenderHint(QPainter::Antialiasing);
+        drawStroke(painter);
+    }
+
+    DkPaintLayer layer;
+    layer.reset(size);
+    layer.paint(QRect(QPoint(), size), drawStroke);
+
+    QImage result = transparentImage(size);
+    {
+        QPainter painter(&result);
+        layer.draw(painter, QRectF(QPointF(), size));
+    }
+
+    // tiles are drawn at integer offsets, only the antialiasing may round differently
+    EXPECT_LE(maxDifference(result, expected), 1);
+    EXPECT_NE(result, transparentImage(size));
+}
+
+TEST(DkPaintLayer, ClearsTiles)
+{
+    const QSize size(600, 400);
+
+    DkPaintLayer layer;
+    layer.reset(size);
+    layer.paint(QRect(QPoint(), size), drawStroke);
+
+    // the tile aligned area is cleared, clipped to the image
+    EXPECT_EQ(layer.clear(QRect(300, 300, 10, 10)), QRect(256, 256, 256, 144));
+
+    QImage result = transparentImage(size);
+    {
+        QPainter painter(&result);
+        layer.draw(painter, QRectF(QPointF(), size));
+    }
+
+    EXPECT_EQ(result.copy(256, 256, 256, 144), transparentImage(QSize(256, 144)));
+    EXPECT_NE(result.copy(0, 0, 256, 256), transparentImage(QSize(256, 256)));
+}
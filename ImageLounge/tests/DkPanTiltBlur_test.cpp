@@ -0,0 +1,88 @@
+#include "../plugins/FakeMiniaturesPlugin/src/DkPanTiltBlur.h"
+
+#include <QtGlobal>
+
+#include <opencv2/imgproc.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace nmp;
+
+// a straightforward version of the filter: distances from cv::distanceTransform and box sums per pixel
+static cv::Mat referenceBlur(const cv::Mat &src, const cv::Rect &focus, int maxKernel)
+{
+    cv::Mat mask(src.size(), CV_8UC1, cv::Scalar(255));
+    mask(focus).setTo(0);
+
+    cv::Mat dist;
+    cv::distanceTransform(mask, dist, cv::DIST_C, 3);
+
+    double maxDist = 0;
+    cv::minMaxLoc(dist, nullptr, &maxDist);
+    const float kernelScale = maxKernel * 0.5f / qRound(maxDist);
+
+    const int cn = src.channels();
+    cv::Mat dst(src.size(), src.type());
+
+    for (int y = 0; y < src.rows; y++) {
+        for (int x = 0; x < src.cols; x++) {
+            const float ksf = qRound(dist.at<float>(y, x)) * kernelScale;
+            int ks = qRound(ksf);
+            if (ksf > 0 && ksf < 2)
+                ks = 2;
+
+            const cv::Rect box = cv::Rect(x - ks, y - ks, 2 * ks + 1, 2 * ks + 1) & cv::Rect(0, 0, src.cols, src.rows);
+
+            for (int c = 0; c < cn; c++) {
+                double sum = 0;
+                for (int by = box.y; by < box.br().y; by++) {
+                    for (int bx = box.x; bx < box.br().x; bx++)
+                        sum += src.ptr<unsigned char>(by)[bx * cn + c];
+                }
+
+                dst.ptr<unsigned char>(y)[x * cn + c] = cv::saturate_cast<unsigned char>(sum / box.area());
+            }
+        }
+    }
+
+    return dst;
+}
+
+TEST(DkPanTiltBlur, MatchesReference)
+{
+    for (int cn : {1, 3, 4}) {
+        cv::Mat src(48, 64, CV_8UC(cn));
+        cv::randu(src, cv::Scalar::all(0), cv::Scalar::all(256));
+
+        const cv::Rect focus(10, 20, 30, 8);
+        const cv::Mat result = blurPanTilt(src, focus, 12);
+        const cv::Mat expected = referenceBlur(src, focus, 12);
+
+        ASSERT_EQ(result.size(), src.size());
+        ASSERT_EQ(result.type(), src.type());
+
+        // the filter divides in float, the reference in double
+        EXPECT_LE(cv::norm(result, expected, cv::NORM_INF), 1) << cn << " channels";
+
+        // the focus stays sharp
+        EXPECT_EQ(cv::norm(result(focus), src(focus), cv::NORM_INF), 0) << cn << " channels";
+    }
+}
+
+TEST(DkPanTiltBlur, KeepsUniformImages)
+{
+    cv::Mat src(40, 40, CV_8UC3, cv::Scalar(12, 200, 77));
+
+    const cv::Mat result = blurPanTilt(src, cv::Rect(0, 30, 40, 5), 20);
+    EXPECT_EQ(cv::norm(result, src, cv::NORM_INF), 0);
+}
+
+TEST(DkPanTiltBlur, NothingToBlur)
+{
+    cv::Mat src(16, 16, CV_8UC1);
+    cv::randu(src, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    EXPECT_EQ(cv::norm(blurPanTilt(src, cv::Rect(0, 0, 16, 16), 8), src, cv::NORM_INF), 0);
+    EXPECT_EQ(cv::norm(blurPanTilt(src, cv::Rect(), 8), src, cv::NORM_INF), 0);
+    EXPECT_EQ(cv::norm(blurPanTilt(src, cv::Rect(4, 4, 4, 4), 0), src, cv::NORM_INF), 0);
+}
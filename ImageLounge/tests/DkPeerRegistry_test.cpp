@@ -0,0 +1,101 @@
+#include "DkNetwork.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSysInfo>
+#include <QTcpServer>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace nmc;
+
+// counts connection attempts to a port that belongs to a crashed instance
+class DkCountingServer : public QTcpServer
+{
+public:
+    int numConnections = 0;
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        numConnections++;
+        QTcpSocket socket;
+        socket.setSocketDescriptor(socketDescriptor);
+    }
+};
+
+static bool waitFor(const std::function<bool()> &done, int timeout = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done() && timer.elapsed() < timeout)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+
+    return done();
+}
+
+// a lock file as left behind by a process that does not exist anymore
+static void writeStaleEntry(const QString &dirPath, quint16 port)
+{
+    QFile file(QDir(dirPath).filePath(QString("%1.lock").arg(port)));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(QString("%1\nnomacs\n%2\n").arg(INT_MAX).arg(QSysInfo::machineHostName()).toUtf8());
+}
+
+TEST(DkPeerRegistry, RemovesStaleEntries)
+{
+    QTemporaryDir dir;
+
+    DkPeerRegistry registry(dir.path());
+    ASSERT_TRUE(registry.registerPort(1234));
+
+    writeStaleEntry(dir.path(), 4321);
+    EXPECT_EQ(registry.livePorts(), QList<quint16>({1234}));
+    EXPECT_FALSE(QFile::exists(dir.filePath("4321.lock")));
+
+    // a second instance cannot take a port that is alive
+    DkPeerRegistry other(dir.path());
+    EXPECT_FALSE(other.registerPort(1234));
+}
+
+TEST(DkPeerRegistry, DiscoversLiveInstancesOnly)
+{
+    QTemporaryDir dir;
+
+    DkCountingServer deadInstance;
+    ASSERT_TRUE(deadInstance.listen(QHostAddress::LocalHost));
+    writeStaleEntry(dir.path(), deadInstance.serverPort());
+
+    const int numInstances = 3;
+    std::vector<std::unique_ptr<DkLocalClientManager>> managers;
+    for (int idx = 0; idx < numInstances; idx++) {
+        managers.push_back(std::make_unique<DkLocalClientManager>("instance", nullptr, dir.path()));
+        ASSERT_NE(managers.back()->getServerPort(), 0);
+    }
+
+    // every instance knows all others
+    EXPECT_TRUE(waitFor([&managers]() {
+        for (auto &m : managers) {
+            if (m->getPeerList().size() != numInstances - 1)
+                return false;
+        }
+        return true;
+    }));
+
+    for (auto &m : managers)
+        EXPECT_EQ(m->getPeerList().size(), numInstances - 1);
+
+    EXPECT_EQ(deadInstance.numConnections, 0);
+    EXPECT_EQ(QDir(dir.path()).entryList({"*.lock"}, QDir::Files).size(), numInstances);
+
+    managers.clear();
+    EXPECT_TRUE(QDir(dir.path()).entryList({"*.lock"}, QDir::Files).isEmpty());
+}
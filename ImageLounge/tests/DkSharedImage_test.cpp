@@ -0,0 +1,165 @@
+#include "DkBasicLoader.h"
+#include "DkSharedImage.h"
+
+#include <QColorSpace>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+using namespace nmc;
+
+class DkSharedImageTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        DkSharedImage::instance().setEnabled(true);
+
+        mKey.path = "/shared/image.png";
+        mKey.modified = 1000;
+        mKey.size = 4096;
+
+        QImage img(123, 45, QImage::Format_ARGB32);
+        for (int y = 0; y < img.height(); y++) {
+            for (int x = 0; x < img.width(); x++)
+                img.setPixel(x, y, qRgba(x, y, x ^ y, 128 + y));
+        }
+        img.setColorSpace(QColorSpace::SRgb);
+
+        mEntry.image = img;
+        mEntry.editName = "rotated";
+        mEntry.numPages = 3;
+        mEntry.pageIdx = 2;
+    }
+
+    void TearDown() override
+    {
+        DkSharedImage::instance().setEnabled(false);
+    }
+
+    DkImageCache::Key mKey;
+    DkImageCache::Entry mEntry;
+};
+
+TEST_F(DkSharedImageTest, PublishAndAttach)
+{
+    DkSharedImage &shared = DkSharedImage::instance();
+    ASSERT_TRUE(shared.publish(mKey, mEntry));
+
+    DkImageCache::Entry entry;
+    ASSERT_TRUE(shared.find(mKey, entry));
+
+    EXPECT_EQ(entry.image, mEntry.image);
+    EXPECT_EQ(entry.image.colorSpace(), mEntry.image.colorSpace());
+    EXPECT_EQ(entry.editName, mEntry.editName);
+    EXPECT_EQ(entry.numPages, mEntry.numPages);
+    EXPECT_EQ(entry.pageIdx, mEntry.pageIdx);
+
+    // mapped, not copied
+    EXPECT_NE(entry.image.constBits(), mEntry.image.constBits());
+
+    // writing detaches from the read-only segment
+    entry.image.setPixel(0, 0, qRgba(1, 2, 3, 4));
+
+    DkImageCache::Entry other;
+    ASSERT_TRUE(shared.find(mKey, other));
+    EXPECT_EQ(other.image, mEntry.image);
+}
+
+TEST_F(DkSharedImageTest, IgnoresModifiedFiles)
+{
+    DkSharedImage &shared = DkSharedImage::instance();
+    ASSERT_TRUE(shared.publish(mKey, mEntry));
+
+    DkImageCache::Key modified = mKey;
+    modified.modified++;
+
+    DkImageCache::Entry entry;
+    EXPECT_FALSE(shared.find(modified, entry));
+}
+
+TEST_F(DkSharedImageTest, KeepsSegmentWhileMapped)
+{
+    DkSharedImage &shared = DkSharedImage::instance();
+    ASSERT_TRUE(shared.publish(mKey, mEntry));
+
+    DkImageCache::Entry entry;
+    ASSERT_TRUE(shared.find(mKey, entry));
+
+    // the publishing instance closes
+    shared.release(mKey);
+    EXPECT_EQ(shared.numPublished(), 0);
+    EXPECT_EQ(entry.image, mEntry.image);
+
+    // the receiving instance closes
+    entry = DkImageCache::Entry();
+
+    DkImageCache::Entry gone;
+    EXPECT_FALSE(shared.find(mKey, gone));
+}
+
+TEST_F(DkSharedImageTest, LimitsPublishedImages)
+{
+    DkSharedImage &shared = DkSharedImage::instance();
+
+    for (int idx = 0; idx < 5; idx++) {
+        DkImageCache::Key key = mKey;
+        key.page = idx;
+        ASSERT_TRUE(shared.publish(key, mEntry));
+    }
+
+    EXPECT_LE(shared.numPublished(), 2);
+
+    DkImageCache::Entry entry;
+    EXPECT_FALSE(shared.find(mKey, entry));
+
+    shared.setEnabled(false);
+    EXPECT_EQ(shared.numPublished(), 0);
+    EXPECT_FALSE(shared.publish(mKey, mEntry));
+}
+
+TEST_F(DkSharedImageTest, LoaderPublishesOnRequestOnly)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = tempDir.filePath("prefetched.png");
+    ASSERT_TRUE(mEntry.image.save(filePath, "PNG"));
+
+    // prefetching decodes the image but must not publish it
+    DkBasicLoader loader;
+    ASSERT_TRUE(loader.loadGeneral(filePath, DkLoadOption::normal | DkLoadOption::cached));
+    EXPECT_EQ(DkSharedImage::instance().numPublished(), 0);
+
+    // the displayed image is published
+    EXPECT_TRUE(loader.publishImage());
+    EXPECT_EQ(DkSharedImage::instance().numPublished(), 1);
+}
+
+#if GTEST_HAS_DEATH_TEST
+TEST_F(DkSharedImageTest, RemovesSegmentsOfCrashedInstances)
+{
+    const QString lockPath = QDir(DkSharedImage::registryPath()).filePath(DkSharedImage::segmentKey(mKey) + ".lock");
+
+    // the publisher exits without releasing anything
+    EXPECT_EXIT(
+        {
+            DkSharedImage::instance().publish(mKey, mEntry);
+            std::_Exit(QFile::exists(lockPath) ? 0 : 1);
+        },
+        ::testing::ExitedWithCode(0),
+        "");
+
+    EXPECT_TRUE(QFile::exists(lockPath));
+    EXPECT_EQ(DkSharedImage::instance().removeStaleSegments(), 1);
+    EXPECT_FALSE(QFile::exists(lockPath));
+
+    DkImageCache::Entry entry;
+    EXPECT_FALSE(DkSharedImage::instance().find(mKey, entry));
+}
+#endif
@@ -0,0 +1,225 @@
+#include "DkNoMacs.h"
+#include "DkNomacsProcess.h"
+#include "DkSettings.h"
+#include "DkSingleInstance.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+using namespace nmc;
+
+static bool waitFor(const std::function<bool()> &done, int timeout = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done() && timer.elapsed() < timeout)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+
+    return done();
+}
+
+static int numWindows()
+{
+    int num = 0;
+    for (QWidget *w : QApplication::topLevelWidgets()) {
+        if (qobject_cast<DkNoMacs *>(w))
+            num++;
+    }
+
+    return num;
+}
+
+// the client blocks until the server answers, so it runs in its own thread like a second process
+static bool forwardInThread(const QStringList &arguments, const QString &serverName)
+{
+    std::atomic<bool> done{false};
+    bool forwarded = false;
+
+    std::thread client([&]() {
+        forwarded = DkSingleInstance::forward(arguments, serverName);
+        done = true;
+    });
+
+    waitFor([&done]() {
+        return done.load();
+    });
+    client.join();
+
+    return forwarded;
+}
+
+static QString serverName()
+{
+    return QString("nomacs-test-%1").arg(QCoreApplication::applicationPid());
+}
+
+// forward() reads the option from the settings, every test starts with it disabled
+class DkSingleInstanceTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        DefaultSettings settings;
+        mEnabled = settings.value(mKey);
+        settings.setValue(mKey, false);
+    }
+
+    void TearDown() override
+    {
+        DefaultSettings settings;
+        if (mEnabled.isValid())
+            settings.setValue(mKey, mEnabled);
+        else
+            settings.remove(mKey);
+    }
+
+    const QString mKey = "AppSettings/singleInstance";
+    QVariant mEnabled;
+};
+
+TEST_F(DkSingleInstanceTest, ForwardsArguments)
+{
+    DkSingleInstance server(serverName());
+    ASSERT_TRUE(server.listen());
+
+    int numRequests = 0;
+    QStringList files;
+    bool newTab = false;
+    QObject::connect(&server, &DkSingleInstance::openRequested, [&](const QStringList &f, bool t) {
+        numRequests++;
+        files = f;
+        newTab = t;
+    });
+
+    int windowsBefore = numWindows();
+
+    EXPECT_TRUE(forwardInThread({"nomacs", "--single-instance", "a.jpg", "--new-tab", "sub/b.png"}, serverName()));
+    EXPECT_TRUE(waitFor([&numRequests]() {
+        return numRequests > 0;
+    }));
+
+    EXPECT_EQ(numRequests, 1);
+    EXPECT_EQ(files, QStringList({QFileInfo("a.jpg").absoluteFilePath(), QFileInfo("sub/b.png").absoluteFilePath()}));
+    EXPECT_TRUE(newTab);
+
+    // the client path never builds a window
+    EXPECT_EQ(numWindows(), windowsBefore);
+}
+
+TEST_F(DkSingleInstanceTest, StartsNormallyOtherwise)
+{
+    // no running instance
+    EXPECT_FALSE(forwardInThread({"nomacs", "--single-instance", "a.jpg"}, serverName()));
+
+    DkSingleInstance server(serverName());
+    ASSERT_TRUE(server.listen());
+
+    int numRequests = 0;
+    QObject::connect(&server, &DkSingleInstance::openRequested, [&numRequests]() {
+        numRequests++;
+    });
+
+    // options that only a new process can handle
+    EXPECT_FALSE(forwardInThread({"nomacs", "--single-instance", "-m", "frameless", "a.jpg"}, serverName()));
+
+    // single instance mode is opt-in
+    EXPECT_FALSE(forwardInThread({"nomacs", "a.jpg"}, serverName()));
+
+    QCoreApplication::processEvents();
+    EXPECT_EQ(numRequests, 0);
+}
+
+TEST_F(DkSingleInstanceTest, EnabledInSettings)
+{
+    DkSingleInstance server(serverName());
+    ASSERT_TRUE(server.listen());
+
+    EXPECT_FALSE(forwardInThread({"nomacs", "a.jpg"}, serverName()));
+
+    DefaultSettings().setValue(mKey, true);
+    EXPECT_TRUE(forwardInThread({"nomacs", "a.jpg"}, serverName()));
+}
+
+TEST_F(DkSingleInstanceTest, KeepsRunningServer)
+{
+    DkSingleInstance first(serverName());
+    ASSERT_TRUE(first.listen());
+
+    DkSingleInstance second(serverName());
+    EXPECT_FALSE(second.listen());
+}
+
+#ifdef NMC_EXECUTABLE
+
+// the server of a nomacs process, which has its own home
+static QString serverName(const DkNomacsProcess &nomacs)
+{
+    return DkSingleInstance::serverName(QDir::cleanPath(nomacs.homePath()));
+}
+
+// main() hands the files over and quits before it initializes anything
+static void expectForwarded(DkNomacsProcess &nomacs, const QStringList &arguments, const QString &filePath)
+{
+    DkSingleInstance server(serverName(nomacs));
+    ASSERT_TRUE(server.listen());
+
+    QStringList files;
+    QObject::connect(&server, &DkSingleInstance::openRequested, [&files](const QStringList &f) {
+        files << f;
+    });
+
+    ASSERT_TRUE(nomacs.start(arguments));
+    EXPECT_TRUE(DkNomacsProcess::waitFor([&nomacs]() {
+        return nomacs.process().state() == QProcess::NotRunning;
+    }));
+
+    EXPECT_EQ(files, QStringList(filePath));
+    EXPECT_EQ(nomacs.process().exitStatus(), QProcess::NormalExit);
+    EXPECT_EQ(nomacs.process().exitCode(), 0);
+}
+
+TEST_F(DkSingleInstanceTest, NewProcessForwards)
+{
+    DkNomacsProcess nomacs;
+    ASSERT_TRUE(nomacs.isValid());
+
+    const QString filePath = nomacs.filePath("a.jpg");
+    expectForwarded(nomacs, {"--single-instance", filePath}, filePath);
+
+    // the settings were never loaded or written
+    EXPECT_FALSE(QFileInfo::exists(nomacs.filePath(".config/nomacs/Image Lounge.conf")));
+}
+
+TEST_F(DkSingleInstanceTest, NewProcessForwardsIfEnabled)
+{
+    DkNomacsProcess nomacs;
+    ASSERT_TRUE(nomacs.isValid());
+    nomacs.setValue("AppSettings/singleInstance", true);
+
+    const QString filePath = nomacs.filePath("a.jpg");
+    expectForwarded(nomacs, {filePath}, filePath);
+}
+
+TEST_F(DkSingleInstanceTest, NewProcessStartsWithoutInstance)
+{
+    DkNomacsProcess nomacs;
+    ASSERT_TRUE(nomacs.isValid());
+    nomacs.setValue("AppSettings/firstTime.nomacs.3", false);
+
+    ASSERT_TRUE(nomacs.start({"--single-instance", nomacs.filePath("a.jpg")}));
+
+    // nobody answered, so the process became the running instance
+    EXPECT_TRUE(DkNomacsProcess::waitFor([&nomacs]() {
+        return forwardInThread({"nomacs", "--single-instance", "b.jpg"}, serverName(nomacs));
+    }));
+    EXPECT_EQ(nomacs.process().state(), QProcess::Running);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "../plugins/AffineTransformations/src/DkSkewEstimator.h"
+
+#include <QPainter>
+#include <QRandomGenerator>
+
+#include <gtest/gtest.h>
+
+using namespace nmp;
+
+// a 150 dpi scan: paragraphs of word boxes, rotated by angle
+static QImage createPage(const QSize &size, double angle)
+{
+    QImage page(size, QImage::Format_RGB32);
+    page.fill(Qt::white);
+
+    QRandomGenerator rng(42);
+    QPainter p(&page);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.translate(page.width() / 2, page.height() / 2);
+    p.rotate(angle);
+    p.translate(-page.width() / 2, -page.height() / 2);
+    p.setPen(Qt::NoPen);
+    p.setBrush(Qt::black);
+
+    for (int y = 150; y < page.height() - 150; y += 30) {
+        if (rng.bounded(8) == 0)
+            continue; // paragraph break
+
+        for (int x = 125; x < page.width() - 125;) {
+            const int w = 20 + rng.bounded(80);
+            p.drawRect(x, y, qMin(w, page.width() - 125 - x), 14);
+            x += w + 12;
+        }
+    }
+
+    return page;
+}
+
+// the plugin applies QTransform::rotate(angle), which levels the page again
+TEST(DkSkewEstimator, EstimatesRotatedPages)
+{
+    for (const QSize &size : {QSize(1240, 1754), QSize(1754, 1240)}) {
+        for (double angle : {-4.0, -1.5, 0.0, 0.7, 3.2}) {
+            DkSkewEstimator::Result r = DkSkewEstimator::estimate(createPage(size, angle));
+            EXPECT_NEAR(r.angle, -angle, 0.1) << size.width() << "x" << size.height() << " rotated by " << angle;
+
+            EXPECT_FALSE(r.lines.isEmpty());
+            EXPECT_EQ(r.lines.size(), r.lineTypes.size());
+            EXPECT_TRUE(r.lineTypes.contains(1));
+        }
+    }
+}
+
+TEST(DkSkewEstimator, BlankPageIsNotRotated)
+{
+    QImage page(1240, 1754, QImage::Format_RGB32);
+    page.fill(Qt::white);
+
+    EXPECT_EQ(DkSkewEstimator::estimate(page).angle, 0.0);
+}
+
+TEST(DkSkewEstimator, BatchMatchesSinglePages)
+{
+    QVector<QImage> pages;
+    for (double angle : {-2.0, 1.0, 2.5})
+        pages << createPage(QSize(1240, 1754), angle);
+
+    QVector<DkSkewEstimator::Result> results = DkSkewEstimator::estimate(pages);
+    ASSERT_EQ(results.size(), pages.size());
+
+    for (int idx = 0; idx < pages.size(); idx++)
+        EXPECT_DOUBLE_EQ(results[idx].angle, DkSkewEstimator::estimate(pages[idx]).angle);
+}
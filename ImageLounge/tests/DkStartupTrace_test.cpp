@@ -0,0 +1,97 @@
+#include "DkNomacsProcess.h"
+#include "DkSettings.h"
+#include "DkTimer.h"
+
+#include <QBitArray>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <gtest/gtest.h>
+
+using namespace nmc;
+
+class DkStartupTraceTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        // the trace is a singleton, leave it like a finished startup
+        DkStartupTrace::instance().finish("test");
+    }
+};
+
+TEST_F(DkStartupTraceTest, RecordsPhasesUntilFinished)
+{
+    DkStartupTrace &trace = DkStartupTrace::instance();
+    trace.restart();
+
+    {
+        DkTracePhase phase("before");
+    }
+
+    trace.finish("done");
+
+    {
+        DkTracePhase phase("after");
+    }
+
+    QVector<DkStartupTrace::Phase> phases = trace.phases();
+    ASSERT_EQ(phases.size(), 1);
+    EXPECT_EQ(phases.first().name, "before");
+
+    QJsonArray events = QJsonDocument::fromJson(trace.toJson()).object().value("traceEvents").toArray();
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_EQ(events.at(0).toObject().value("ph").toString(), "X");
+    EXPECT_EQ(events.at(1).toObject().value("name").toString(), "done");
+}
+
+#ifdef NMC_EXECUTABLE
+
+// starts nomacs with --trace-startup, everything before the first paint is on the critical path
+TEST_F(DkStartupTraceTest, ImageIsPaintedBeforeDocks)
+{
+    DkNomacsProcess nomacs;
+    ASSERT_TRUE(nomacs.isValid());
+
+    const QString imgPath = nomacs.filePath("startup.jpg");
+    const QString tracePath = nomacs.filePath("trace.json");
+
+    QImage img(640, 480, QImage::Format_RGB32);
+    img.fill(Qt::darkCyan);
+    ASSERT_TRUE(img.save(imgPath));
+
+    // no welcome dialog, but a dock that is restored
+    nomacs.setValue("AppSettings/firstTime.nomacs.3", false);
+    nomacs.setValue("AppSettings/showExplorer", QBitArray(DkSettings::mode_end, true));
+
+    ASSERT_TRUE(nomacs.start({"--trace-startup", tracePath, imgPath}));
+    ASSERT_TRUE(DkNomacsProcess::waitFor([&]() {
+        return QFile::exists(tracePath) || nomacs.process().state() == QProcess::NotRunning;
+    }));
+
+    QFile file(tracePath);
+    ASSERT_TRUE(file.open(QFile::ReadOnly)) << "nomacs exited with " << nomacs.process().exitCode();
+    const QJsonArray events = QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+
+    QStringList names;
+    QString finishEvent;
+    for (const QJsonValue &e : events) {
+        const QJsonObject event = e.toObject();
+        if (event.value("ph").toString() == "X")
+            names << event.value("name").toString();
+        else
+            finishEvent = event.value("name").toString();
+    }
+
+    EXPECT_EQ(finishEvent, "first paint");
+    EXPECT_TRUE(names.contains("decode image")) << names.join(", ").toStdString();
+    EXPECT_LE(names.size(), 12) << names.join(", ").toStdString();
+
+    // the docks follow the first paint
+    EXPECT_FALSE(names.contains("restore docks")) << names.join(", ").toStdString();
+}
+
+#endif
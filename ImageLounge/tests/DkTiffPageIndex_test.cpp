@@ -0,0 +1,284 @@
+#include "DkBasicLoader.h"
+#include "DkTiffPageIndex.h"
+
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+#include <cstdarg>
+
+#ifdef WITH_LIBTIFF
+#include <tiffio.h>
+
+using namespace nmc;
+
+static QColor pageColor(int idx)
+{
+    return QColor::fromHsv(idx * 40 % 360, 200, 200);
+}
+
+// page idx (1-based) has size (idx * 10) x (idx * 5)
+static QString createMultiPageTiff(QTemporaryDir &tempDir, int numPages)
+{
+    const QString filePath = tempDir.filePath("pages.tif");
+
+    TIFF *tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "w");
+    EXPECT_NE(tiff, nullptr);
+
+    for (int idx = 1; idx <= numPages; idx++) {
+        QImage img(idx * 10, idx * 5, QImage::Format_RGB888);
+        img.fill(pageColor(idx));
+
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, img.width());
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, img.height());
+        TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+        TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tiff, TIFFTAG_COMPRESSION, idx % 2 ? COMPRESSION_LZW : COMPRESSION_NONE);
+        TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, FILETYPE_PAGE);
+
+        for (int y = 0; y < img.height(); y++)
+            TIFFWriteScanline(tiff, img.scanLine(y), y, 0);
+
+        TIFFWriteDirectory(tiff);
+    }
+
+    TIFFClose(tiff);
+
+    return filePath;
+}
+
+TEST(DkTiffPageIndex, IndexesAllPages)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createMultiPageTiff(tempDir, 12);
+
+    auto index = DkTiffPageIndex::index(filePath);
+    ASSERT_TRUE(index);
+    EXPECT_EQ(index->numPages(), 12);
+    EXPECT_EQ(index->page(3).size, QSize(30, 15));
+    EXPECT_EQ(index->page(3).compression, COMPRESSION_LZW);
+    EXPECT_EQ(index->page(4).compression, COMPRESSION_NONE);
+    EXPECT_EQ(index->page(13).size, QSize());
+
+    // the index is built once per file
+    EXPECT_EQ(DkTiffPageIndex::index(filePath), index);
+}
+
+TEST(DkTiffPageIndex, ReadsPagesInAnyOrder)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createMultiPageTiff(tempDir, 8);
+
+    auto index = DkTiffPageIndex::index(filePath);
+    ASSERT_TRUE(index);
+
+    for (int idx : {8, 1, 5, 2}) {
+        QImage img = index->readPage(idx);
+        ASSERT_EQ(img.size(), QSize(idx * 10, idx * 5));
+        EXPECT_EQ(img.pixel(3, 2), pageColor(idx).rgb());
+    }
+
+    EXPECT_TRUE(index->readPage(0).isNull());
+    EXPECT_TRUE(index->readPage(9).isNull());
+
+    QImage thumb = index->readThumbnail(8, 40);
+    EXPECT_EQ(thumb.size(), QSize(40, 20));
+}
+
+// a large page followed by a reduced-resolution copy of another color
+static QString createPageWithPreview(QTemporaryDir &tempDir, const QSize &size, bool withPreview)
+{
+    const QString filePath = tempDir.filePath(withPreview ? "preview.tif" : "large.tif");
+
+    TIFF *tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "w");
+    EXPECT_NE(tiff, nullptr);
+
+    QList<QPair<QSize, QColor>> levels = {{size, Qt::darkGreen}};
+    if (withPreview)
+        levels << qMakePair(size / 8, QColor(Qt::darkRed));
+
+    for (const auto &l : levels) {
+        QImage img(l.first, QImage::Format_RGB888);
+        img.fill(l.second);
+
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, img.width());
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, img.height());
+        TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+        TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+        TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 16);
+        TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, l.first == size ? FILETYPE_PAGE : FILETYPE_REDUCEDIMAGE);
+
+        for (int y = 0; y < img.height(); y++)
+            TIFFWriteScanline(tiff, img.scanLine(y), y, 0);
+
+        TIFFWriteDirectory(tiff);
+    }
+
+    TIFFClose(tiff);
+
+    return filePath;
+}
+
+TEST(DkTiffPageIndex, ThumbnailsUseReducedImages)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    auto index = DkTiffPageIndex::index(createPageWithPreview(tempDir, QSize(1600, 800), true));
+    ASSERT_TRUE(index);
+
+    // the preview is not a page of its own
+    EXPECT_EQ(index->numPages(), 1);
+    ASSERT_EQ(index->page(1).reduced.size(), 1);
+    EXPECT_EQ(index->page(1).reduced[0].size, QSize(200, 100));
+
+    QImage thumb = index->readThumbnail(1, 100);
+    EXPECT_EQ(thumb.size(), QSize(100, 50));
+    EXPECT_EQ(thumb.pixel(50, 25), QColor(Qt::darkRed).rgb());
+
+    // the preview is too small for large thumbnails
+    thumb = index->readThumbnail(1, 400);
+    EXPECT_EQ(thumb.size(), QSize(400, 200));
+    EXPECT_EQ(thumb.pixel(200, 100), QColor(Qt::darkGreen).rgb());
+
+    EXPECT_EQ(index->readPage(1).size(), QSize(1600, 800));
+}
+
+TEST(DkTiffPageIndex, ThumbnailsSubsampleLargePages)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    auto index = DkTiffPageIndex::index(createPageWithPreview(tempDir, QSize(2000, 1000), false));
+    ASSERT_TRUE(index);
+    EXPECT_TRUE(index->page(1).reduced.isEmpty());
+
+    QImage thumb = index->readThumbnail(1, 100);
+    ASSERT_EQ(thumb.size(), QSize(100, 50));
+    EXPECT_EQ(thumb.pixel(0, 0), QColor(Qt::darkGreen).rgb());
+    EXPECT_EQ(thumb.pixel(99, 49), QColor(Qt::darkGreen).rgb());
+}
+
+static void writeDirectory(TIFF *tiff, const QSize &size, const QColor &color, uint32_t subfileType)
+{
+    QImage img(size, QImage::Format_RGB888);
+    img.fill(color);
+
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, img.width());
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, img.height());
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, subfileType);
+
+    for (int y = 0; y < img.height(); y++)
+        TIFFWriteScanline(tiff, img.scanLine(y), y, 0);
+
+    TIFFWriteDirectory(tiff);
+}
+
+// 4 directories in the main chain and one SubIFD, but 3 pages
+static QString createPagesWithPreviews(QTemporaryDir &tempDir)
+{
+    const QString filePath = tempDir.filePath("previews.tif");
+
+    TIFF *tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "w");
+    EXPECT_NE(tiff, nullptr);
+
+    // a reduced-resolution directory that follows its page
+    writeDirectory(tiff, QSize(400, 200), pageColor(1), FILETYPE_PAGE);
+    writeDirectory(tiff, QSize(100, 50), Qt::darkRed, FILETYPE_REDUCEDIMAGE);
+
+    // a reduced-resolution SubIFD, libtiff writes the next directory as the SubIFD
+    toff_t subIfd = 0;
+    TIFFSetField(tiff, TIFFTAG_SUBIFD, 1, &subIfd);
+    writeDirectory(tiff, QSize(300, 150), pageColor(2), FILETYPE_PAGE);
+    writeDirectory(tiff, QSize(75, 38), Qt::darkRed, FILETYPE_REDUCEDIMAGE);
+
+    writeDirectory(tiff, QSize(200, 100), pageColor(3), FILETYPE_PAGE);
+
+    TIFFClose(tiff);
+
+    return filePath;
+}
+
+// reduced-resolution directories are folded into their page, they do not count as pages
+TEST(DkTiffPageIndex, PreviewsAreNotPages)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createPagesWithPreviews(tempDir);
+
+    TIFF *tiff = TIFFOpen(QFile::encodeName(filePath).constData(), "r");
+    ASSERT_NE(tiff, nullptr);
+    EXPECT_EQ(TIFFNumberOfDirectories(tiff), 4);
+    TIFFClose(tiff);
+
+    auto index = DkTiffPageIndex::index(filePath);
+    ASSERT_TRUE(index);
+    ASSERT_EQ(index->numPages(), 3);
+    EXPECT_EQ(index->page(1).reduced.size(), 1);
+    EXPECT_EQ(index->page(2).reduced.size(), 1);
+    EXPECT_EQ(index->page(3).reduced.size(), 0);
+
+    for (int idx = 1; idx <= 3; idx++)
+        EXPECT_EQ(index->readPage(idx).pixel(1, 1), pageColor(idx).rgb()) << idx;
+
+    // the loader navigates the same pages
+    DkBasicLoader loader;
+    ASSERT_TRUE(loader.loadGeneral(filePath));
+    EXPECT_EQ(loader.getNumPages(), 3);
+
+    ASSERT_TRUE(loader.loadPageAt(3));
+    EXPECT_EQ(loader.image().size(), QSize(200, 100));
+}
+
+static void ignoreTiffError(const char *, const char *, va_list)
+{
+}
+
+TEST(DkTiffPageIndex, KeepsGlobalHandlers)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString filePath = createMultiPageTiff(tempDir, 2);
+
+    TIFFErrorHandler previousError = TIFFSetErrorHandler(ignoreTiffError);
+    TIFFErrorHandler previousWarning = TIFFSetWarningHandler(ignoreTiffError);
+
+    auto index = DkTiffPageIndex::index(filePath);
+    ASSERT_TRUE(index);
+    EXPECT_FALSE(index->readPage(2).isNull());
+
+    // other TIFF readers (e.g. Qt's image plugin) still get their messages
+    EXPECT_EQ(TIFFSetErrorHandler(previousError), ignoreTiffError);
+    EXPECT_EQ(TIFFSetWarningHandler(previousWarning), ignoreTiffError);
+}
+
+TEST(DkTiffPageIndex, RejectsOtherFiles)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString pngPath = tempDir.filePath("page.png");
+    ASSERT_TRUE(QImage(8, 8, QImage::Format_RGB32).save(pngPath));
+
+    EXPECT_FALSE(DkTiffPageIndex::index(pngPath));
+    EXPECT_FALSE(DkTiffPageIndex::index(tempDir.filePath("missing.tif")));
+}
+
+#endif // WITH_LIBTIFF
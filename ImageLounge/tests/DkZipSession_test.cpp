@@ -0,0 +1,168 @@
+#include "DkFileInfo.h"
+#include "DkZipSession.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QPair>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <gtest/gtest.h>
+
+#ifdef WITH_QUAZIP
+#include <quazip/quazipfile.h>
+#include <quazip/quazipnewinfo.h>
+
+using namespace nmc;
+
+using ZipMembers = QList<QPair<QString, QByteArray>>;
+
+// members are written in order, names may repeat
+static bool writeZip(const QString &zipPath, const ZipMembers &members)
+{
+    QuaZip zip(zipPath);
+    if (!zip.open(QuaZip::mdCreate))
+        return false;
+
+    for (const auto &m : members) {
+        QuaZipFile file(&zip);
+        if (!file.open(QIODevice::WriteOnly, QuaZipNewInfo(m.first)))
+            return false;
+
+        file.write(m.second);
+        file.close();
+        if (file.getZipError() != UNZ_OK)
+            return false;
+    }
+
+    zip.close();
+    return zip.getZipError() == UNZ_OK;
+}
+
+static QByteArray readMember(QuaZip *zip)
+{
+    QuaZipFile file(zip);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    return file.readAll();
+}
+
+TEST(DkZipSession, SessionsAreShared)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString zipPath = tempDir.filePath("shared.zip");
+    ASSERT_TRUE(writeZip(zipPath, {{"a.txt", "alpha"}, {"b.txt", "beta"}}));
+
+    QSharedPointer<DkZipSession> session = DkZipSession::session(zipPath);
+    ASSERT_TRUE(session);
+    EXPECT_EQ(session->members().size(), 2);
+
+    // the listing and member reads use the cached directory
+    EXPECT_EQ(DkZipSession::session(zipPath), session);
+    EXPECT_EQ(DkFileInfo::readZipArchive(zipPath).size(), 2);
+    EXPECT_EQ(DkZipSession::session(zipPath), session);
+
+    EXPECT_FALSE(DkZipSession::session(tempDir.filePath("missing.zip")));
+}
+
+TEST(DkZipSession, InvalidatedWhenArchiveChanges)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString zipPath = tempDir.filePath("changed.zip");
+    ASSERT_TRUE(writeZip(zipPath, {{"a.txt", "before"}}));
+
+    QSharedPointer<DkZipSession> session = DkZipSession::session(zipPath);
+    ASSERT_TRUE(session);
+
+    ASSERT_TRUE(writeZip(zipPath, {{"b.txt", "x"}, {"a.txt", "after the change"}}));
+    {
+        // mtime resolution can be coarse, the size changes anyway
+        QFile file(zipPath);
+        ASSERT_TRUE(file.open(QFile::ReadWrite));
+        file.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime);
+    }
+
+    QSharedPointer<DkZipSession> changed = DkZipSession::session(zipPath);
+    ASSERT_TRUE(changed);
+    EXPECT_NE(changed, session);
+    EXPECT_TRUE(session->isOutdated(QFileInfo(zipPath)));
+    EXPECT_EQ(changed->members().size(), 2);
+
+    const DkFileInfoList infos = DkFileInfo::readZipArchive(zipPath);
+    ASSERT_EQ(infos.size(), 2);
+    EXPECT_EQ(infos[1].fileName(), "a.txt");
+
+    std::unique_ptr<QIODevice> io = infos[1].getIODevice();
+    ASSERT_TRUE(io);
+    EXPECT_EQ(io->readAll(), "after the change");
+}
+
+TEST(DkZipSession, FirstMatchWins)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString zipPath = tempDir.filePath("duplicates.zip");
+    ASSERT_TRUE(writeZip(zipPath, {{"img.txt", "first"}, {"other.txt", "-"}, {"img.txt", "second one"}}));
+
+    DkZipSession session{QFileInfo(zipPath)};
+    ASSERT_TRUE(session.isValid());
+    EXPECT_EQ(session.members().size(), 3);
+
+    const QuaZipFileInfo64 *info = session.member("img.txt");
+    ASSERT_NE(info, nullptr);
+    EXPECT_EQ(info->uncompressedSize, 5u);
+
+    QuaZip *zip = session.acquire("img.txt");
+    ASSERT_NE(zip, nullptr);
+    EXPECT_EQ(readMember(zip), "first");
+    session.release(zip);
+
+    // same rules as QuaZip::setCurrentFile(name, csDefault)
+    const bool insensitive = QuaZip::convertCaseSensitivity(QuaZip::csDefault) == Qt::CaseInsensitive;
+    EXPECT_EQ(session.member("IMG.TXT") != nullptr, insensitive);
+    EXPECT_EQ(session.member("missing.txt"), nullptr);
+}
+
+TEST(DkZipSession, PoolsHandles)
+{
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+
+    const QString zipPath = tempDir.filePath("pool.zip");
+    ASSERT_TRUE(writeZip(zipPath, {{"a.txt", "alpha"}, {"b.txt", "beta"}}));
+
+    DkZipSession session{QFileInfo(zipPath)};
+    ASSERT_TRUE(session.isValid());
+    EXPECT_EQ(session.numIdle(), 1); // the handle that parsed the directory
+
+    // concurrent readers get their own handles
+    QuaZip *za = session.acquire("a.txt");
+    QuaZip *zb = session.acquire("b.txt");
+    ASSERT_NE(za, nullptr);
+    ASSERT_NE(zb, nullptr);
+    EXPECT_NE(za, zb);
+    EXPECT_EQ(session.numIdle(), 0);
+
+    EXPECT_EQ(readMember(zb), "beta");
+    EXPECT_EQ(readMember(za), "alpha");
+
+    session.release(za);
+    session.release(zb);
+    EXPECT_EQ(session.numIdle(), qMin(2, QThread::idealThreadCount()));
+
+    // released handles are reused
+    QuaZip *zc = session.acquire("b.txt");
+    EXPECT_TRUE(zc == za || zc == zb);
+    EXPECT_EQ(readMember(zc), "beta");
+    session.release(zc);
+
+    EXPECT_EQ(session.acquire("missing.txt"), nullptr);
+}
+
+#endif
@@ -0,0 +1,28 @@
+#include "DkSettings.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+// widgets need an application, the offscreen platform works without a display
+int main(int argc, char **argv)
+{
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    // keep the user's settings untouched
+    QTemporaryDir home;
+    qputenv("HOME", QFile::encodeName(home.path()));
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(QDir(home.path()).filePath(".config")));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(QDir(home.path()).filePath(".cache")));
+    QStandardPaths::setTestModeEnabled(true);
+    QApplication app(argc, argv);
+
+    nmc::DkSettingsManager::instance().init();
+
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}